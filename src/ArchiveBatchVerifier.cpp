@@ -0,0 +1,110 @@
+//----------------------------------------------------------------------
+// See ArchiveBatchVerifier.h
+//----------------------------------------------------------------------
+
+#include "ArchiveBatchVerifier.h"
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+#include "Metrics.h"
+#include "TraceRecorder.h"
+#include "VerificationWorkerPool.h"
+#include "MultiBufferSHA1.h"
+
+#include <memory>     // unique_ptr
+#include <algorithm>  // min
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor maps the archive and checks its header and index
+//   throws std::runtime_error if the file cannot be mapped or is not a valid archive
+ArchiveBatchVerifier::ArchiveBatchVerifier(const std::string& archive_filepath) : m_reader(archive_filepath){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - nothing to do at present
+ArchiveBatchVerifier::~ArchiveBatchVerifier(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// parses and verifies every record, spreading the work across threadCount threads
+//   results are returned in archive order regardless of thread count
+std::vector<BatchVerifier::Result> ArchiveBatchVerifier::verifyAll(const size_t threadCount, const bool captureKeyData,
+                                                                   KeyFingerprintIndex* pKeyIndex) const {
+    const EnrollmentArchiveReader& reader = this->m_reader;
+    const size_t recordCount = reader.getRecordCount();
+    std::vector<BatchVerifier::Result> results(recordCount);
+
+    // same scheme as BatchVerifier::verifyAll(): groups of records hashed together,
+    // one lazily created verifier per worker, each item writing only its own result slots
+    VerificationWorkerPool workerPool(threadCount);
+    std::vector<std::unique_ptr<CoolkeyRSAVerifier>> verifiers(workerPool.getThreadCount());
+    const size_t groupSize = MultiBufferSHA1::MAX_LANES;
+    const size_t groupCount = (recordCount + groupSize - 1) / groupSize;
+    const bool fingerprintKeys = (pKeyIndex != nullptr);
+    workerPool.run(groupCount, [&reader, &results, &verifiers, recordCount, groupSize, captureKeyData, fingerprintKeys](const size_t itemIndex, const size_t workerIndex){
+        std::unique_ptr<CoolkeyRSAVerifier>& pVerifier = verifiers[workerIndex];
+        if (pVerifier.get() == nullptr){
+            pVerifier.reset(new CoolkeyRSAVerifier());
+        }
+
+        BatchVerifier::Input inputs[MultiBufferSHA1::MAX_LANES];
+        BatchVerifier::Result* pLoadedResults[MultiBufferSHA1::MAX_LANES];
+        size_t loadedCount = 0;
+
+        const size_t first = itemIndex * groupSize;
+        const size_t count = std::min(groupSize, recordCount - first);
+        for (size_t i = first; i < first + count; i++){
+            BatchVerifier::Result& result = results[i];
+
+            // stage 1: fetch the record from the mapping, checking its checksum
+            EnrollmentArchiveReader::Record record;
+            const char* pError = nullptr;
+            TraceRecorder::setRecordId(reader.getLineNumber(i));
+            StageTimer readTimer(Metrics::STAGE_READ);
+            const bool fetched = reader.tryGetRecord(i, record, pError);
+            readTimer.stop();
+            if (fetched == false){
+                result.m_lineNumber = reader.getLineNumber(i);
+                result.m_outcome = RETCODE_INPUT_ERROR;
+                result.m_message = pError;
+                continue;
+            }
+            result.m_lineNumber = record.m_lineNumber;
+
+            BatchVerifier::Input& input = inputs[loadedCount];
+            input.m_pIobufData = record.m_pIobufData;
+            input.m_iobufSize = record.m_iobufSize;
+            input.m_pWrappedKeyData = record.m_pWrappedKeyData;
+            input.m_wrappedKeySize = record.m_wrappedKeySize;
+            pLoadedResults[loadedCount] = &result;
+            ++loadedCount;
+        }
+
+        BatchVerifier::verifyInputs(inputs, pLoadedResults, loadedCount, *pVerifier, captureKeyData, fingerprintKeys);
+    });
+
+    if (pKeyIndex != nullptr){
+        BatchVerifier::checkKeyIndex(results, *pKeyIndex);
+    }
+    for (size_t i = 0; i < recordCount; i++){
+        Metrics::countOutcome(results[i].m_outcome);
+    }
+
+    return results;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// processes every record, writing one result line per record to out in archive order
+//   returns the highest outcome code of all records (0 if every record verified)
+int ArchiveBatchVerifier::run(std::ostream& out, const size_t threadCount) const {
+    return BatchVerifier::writeResults(this->verifyAll(threadCount), out);
+}
+
+//----------------------------------------------------------------------
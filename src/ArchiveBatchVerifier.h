@@ -0,0 +1,72 @@
+//----------------------------------------------------------------------
+// ArchiveBatchVerifier - Parses and verifies every Coolkey RSA key
+//                        generation result stored in a binary enrollment
+//                        archive (see EnrollmentArchive.h).
+//
+// Records are passed to the parser as slices of the archive mapping, so
+// no hex decoding or copying takes place.  Results carry the manifest
+// line numbers kept in the archive index, making the output identical to
+// BatchVerifier's for the same records.
+//----------------------------------------------------------------------
+
+#ifndef ArchiveBatchVerifierH_Included
+#define ArchiveBatchVerifierH_Included
+
+//----------------------------------------------------------------------
+
+class ArchiveBatchVerifier;
+
+//----------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <ostream>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "BatchVerifier.h"
+#include "EnrollmentArchiveReader.h"
+
+//----------------------------------------------------------------------
+
+class ArchiveBatchVerifier{
+    private:
+        // prevent copying and assignment
+        ArchiveBatchVerifier(const ArchiveBatchVerifier& src);
+        ArchiveBatchVerifier operator=(const ArchiveBatchVerifier& rhs);
+
+    protected:
+        EnrollmentArchiveReader m_reader;     // the mapped archive
+
+    public:
+        // constructor maps the archive and checks its header and index
+        //   throws std::runtime_error if the file cannot be mapped or is not a valid archive
+        explicit ArchiveBatchVerifier(const std::string& archive_filepath);
+
+        // destructor - unmaps the archive
+        virtual ~ArchiveBatchVerifier();
+
+
+        // getter for the number of records
+        size_t getRecordCount() const { return this->m_reader.getRecordCount(); }
+
+        // parses and verifies every record, spreading the work across threadCount threads
+        //   (0 selects one thread per hardware thread)
+        //   damaged records are reported as input errors; results are returned in archive order
+        //   captureKeyData copies the key fields of every parsed record into its result
+        //   pKeyIndex, if set, flags verified keys already in the index and records the others
+        //   (see BatchVerifier::checkKeyIndex)
+        std::vector<BatchVerifier::Result> verifyAll(const size_t threadCount = 1, const bool captureKeyData = false,
+                                                     KeyFingerprintIndex* pKeyIndex = nullptr) const;
+
+        // processes every record, writing one result line per record to out in archive order
+        //   line format matches BatchVerifier::run()
+        //   returns the highest outcome code of all records (0 if every record verified)
+        int run(std::ostream& out, const size_t threadCount = 1) const;
+};
+
+//----------------------------------------------------------------------
+
+#endif
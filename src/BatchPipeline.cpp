@@ -0,0 +1,411 @@
+//----------------------------------------------------------------------
+// See BatchPipeline.h
+//----------------------------------------------------------------------
+
+#include "BatchPipeline.h"
+
+//----------------------------------------------------------------------
+
+#include "BoundedQueue.h"
+#include "ByteArena.h"
+#include "CKYStartEnrollmentOutputProcessor.h"
+#include "Metrics.h"
+#include "MultiBufferSHA1.h"
+#include "OpenSSLThreading.h"
+#include "VerificationWorkerPool.h"
+
+#include <algorithm>  // min
+#include <atomic>
+#include <chrono>
+#include <exception>  // exception_ptr
+#include <iomanip>
+#include <memory>     // unique_ptr
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------
+// a group of records in flight: its loaded fields and its results
+
+class BatchPipeline::Group{
+    public:
+        size_t m_index;                                                   // group number in manifest order
+        size_t m_count;                                                   // records in the group
+        ByteArena m_arena;                                                // decoded fields of the records, reset on reuse
+        BatchVerifier::Input m_inputs[MultiBufferSHA1::MAX_LANES];        // the records that loaded
+        BatchVerifier::Result* m_pLoadedResults[MultiBufferSHA1::MAX_LANES];
+        size_t m_loadedCount;
+        BatchVerifier::Result m_results[MultiBufferSHA1::MAX_LANES];      // results of every record
+
+        Group() : m_index(0), m_count(0), m_loadedCount(0) {}
+};
+
+//----------------------------------------------------------------------
+
+namespace{
+    uint64_t nanosecondsSince(const std::chrono::steady_clock::time_point start){
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+
+    // waits out a full or empty queue: yields the processor at first, then sleeps
+    //   (stages usually wait on each other for a whole group's work, far longer than spinning pays for)
+    class Backoff{
+        protected:
+            unsigned m_attempts;
+
+        public:
+            Backoff() : m_attempts(0) {}
+
+            void wait(){
+                if (this->m_attempts < 64){
+                    ++this->m_attempts;
+                    std::this_thread::yield();
+                }else{
+                    std::this_thread::sleep_for(std::chrono::microseconds(50));
+                }
+            }
+    };
+
+    // appends a value, waiting while the queue is full; the wait is added to waitNanoseconds
+    template <typename T>
+    void pushWaiting(BoundedQueue<T>& queue, const T& value, uint64_t& waitNanoseconds){
+        if (queue.tryPush(value) == true){
+            return;
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Backoff backoff;
+        do{
+            backoff.wait();
+        }while (queue.tryPush(value) == false);
+        waitNanoseconds += nanosecondsSince(start);
+    }
+
+    // removes a value, waiting while the queue is empty; the wait is added to waitNanoseconds
+    //   returns false once the queue is empty and closed
+    template <typename T>
+    bool popWaiting(BoundedQueue<T>& queue, T& value, uint64_t& waitNanoseconds){
+        if (queue.tryPop(value) == true){
+            return true;
+        }
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        Backoff backoff;
+        bool popped = false;
+        for (;;){
+            // values pushed before the close are still there
+            if (queue.isClosed() == true){
+                popped = queue.tryPop(value);
+                break;
+            }
+            backoff.wait();
+            if (queue.tryPop(value) == true){
+                popped = true;
+                break;
+            }
+        }
+        waitNanoseconds += nanosecondsSince(start);
+        return popped;
+    }
+
+    // samples the depth of a queue just pushed to
+    template <typename T>
+    void sampleDepth(const BoundedQueue<T>& queue, const BatchPipeline::Queue queueIndex, BatchPipeline::QueueStatistics& statistics){
+        const uint64_t depth = queue.getSize();
+        statistics.m_depthSum += depth;
+        ++statistics.m_depthSamples;
+        if (depth > statistics.m_depthMax){
+            statistics.m_depthMax = depth;
+        }
+        Metrics::recordQueueDepth(queueIndex, depth);
+    }
+
+    // adds the totals of one thread to those of the run
+    void mergeStageStatistics(BatchPipeline::StageStatistics& total, const BatchPipeline::StageStatistics& thread){
+        total.m_groupCount += thread.m_groupCount;
+        total.m_activeNanoseconds += thread.m_activeNanoseconds;
+        for (size_t wait = 0; wait < BatchPipeline::WAIT_COUNT; ++wait){
+            total.m_waitNanoseconds[wait] += thread.m_waitNanoseconds[wait];
+        }
+    }
+
+    void mergeQueueStatistics(BatchPipeline::QueueStatistics& total, const BatchPipeline::QueueStatistics& thread){
+        total.m_depthSum += thread.m_depthSum;
+        total.m_depthSamples += thread.m_depthSamples;
+        if (thread.m_depthMax > total.m_depthMax){
+            total.m_depthMax = thread.m_depthMax;
+        }
+    }
+
+    // reports the waits of one thread to Metrics
+    void countStalls(const BatchPipeline::Stage stage, const BatchPipeline::StageStatistics& thread){
+        for (size_t wait = 0; wait < BatchPipeline::WAIT_COUNT; ++wait){
+            if (thread.m_waitNanoseconds[wait] > 0){
+                Metrics::countPipelineStall(stage, wait, thread.m_waitNanoseconds[wait]);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor
+//   a loadThreadCount of 0 selects 1; a verifyThreadCount of 0 selects one per hardware thread
+BatchPipeline::BatchPipeline(const BatchVerifier& batchVerifier, const size_t loadThreadCount, const size_t verifyThreadCount,
+                             const size_t queueCapacity) : m_batchVerifier(batchVerifier),
+                                                           m_loadThreadCount((loadThreadCount == 0) ? 1 : loadThreadCount),
+                                                           m_verifyThreadCount((verifyThreadCount == 0) ? VerificationWorkerPool::getDefaultThreadCount() : verifyThreadCount),
+                                                           m_queueCapacity((queueCapacity == 0) ? DEFAULT_QUEUE_CAPACITY : queueCapacity){
+    OpenSSLThreading::initialize();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - nothing to do at present
+BatchPipeline::~BatchPipeline(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the label of a stage
+const char* BatchPipeline::getStageName(const Stage stage){
+    switch (stage){
+        case STAGE_LOAD:        return "load";
+        case STAGE_VERIFY:      return "verify";
+        case STAGE_EMIT:        return "emit";
+        default:                return "unknown";
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// processes every record, writing the results to writer in manifest order
+//   returns the highest outcome code of all records (0 if every record verified)
+//   throws std::runtime_error if a verifier cannot be created or the key index cannot grow
+int BatchPipeline::run(ResultWriter& writer, KeyFingerprintIndex* pKeyIndex){
+    const std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+    const std::vector<BatchVerifier::Record>& records = this->m_batchVerifier.getRecords();
+    const size_t groupSize = MultiBufferSHA1::MAX_LANES;
+    const size_t groupCount = (records.size() + groupSize - 1) / groupSize;
+    const bool captureKeyData = writer.needsKeyData();
+    const bool fingerprintKeys = (pKeyIndex != nullptr);
+
+    // one verifier per verify thread, created before any thread starts so that a failure is simply thrown
+    std::vector<std::unique_ptr<CoolkeyRSAVerifier>> verifiers(this->m_verifyThreadCount);
+    for (size_t i = 0; i < verifiers.size(); ++i){
+        verifiers[i].reset(new CoolkeyRSAVerifier());
+    }
+
+    // every group index claimed but not yet emitted holds a group of the pool, so the indices in flight
+    //   span fewer than poolSize groups and the reorder buffer can be a ring of that size
+    BoundedQueue<Group*> loadedQueue(this->m_queueCapacity);
+    BoundedQueue<Group*> verifiedQueue(this->m_queueCapacity);
+    const size_t poolSize = loadedQueue.getCapacity() + verifiedQueue.getCapacity() + this->m_loadThreadCount + this->m_verifyThreadCount;
+    std::unique_ptr<Group[]> pGroups(new Group[poolSize]);
+    BoundedQueue<Group*> freeQueue(poolSize);
+    for (size_t i = 0; i < poolSize; ++i){
+        freeQueue.tryPush(&pGroups[i]);
+    }
+
+    Statistics statistics;
+    statistics.m_recordCount = records.size();
+    statistics.m_stages[STAGE_LOAD].m_threadCount = this->m_loadThreadCount;
+    statistics.m_stages[STAGE_VERIFY].m_threadCount = this->m_verifyThreadCount;
+    statistics.m_stages[STAGE_EMIT].m_threadCount = 1;
+    statistics.m_queues[QUEUE_LOADED].m_capacity = loadedQueue.getCapacity();
+    statistics.m_queues[QUEUE_VERIFIED].m_capacity = verifiedQueue.getCapacity();
+    std::mutex statisticsMutex;
+
+    // first exception thrown on any thread; results stop being written once it is set
+    std::mutex exceptionMutex;
+    std::exception_ptr firstException;
+    std::atomic<bool> failed(false);
+    auto recordException = [&exceptionMutex, &firstException, &failed](){
+        std::lock_guard<std::mutex> lock(exceptionMutex);
+        if (!firstException){
+            firstException = std::current_exception();
+        }
+        failed.store(true);
+    };
+
+    // stage 1: load - claims the next group of records and decodes their fields
+    std::atomic<size_t> nextGroupIndex(0);
+    std::atomic<size_t> loadThreadsLeft(this->m_loadThreadCount);
+    auto loadBody = [&](){
+        const std::chrono::steady_clock::time_point threadStart = std::chrono::steady_clock::now();
+        StageStatistics stage;
+        QueueStatistics queue;
+        for (;;){
+            // a free group first, then the records - see poolSize
+            Group* pGroup = nullptr;
+            popWaiting(freeQueue, pGroup, stage.m_waitNanoseconds[WAIT_OUTPUT]);
+            const size_t groupIndex = nextGroupIndex.fetch_add(1);
+            if (groupIndex >= groupCount){
+                freeQueue.tryPush(pGroup);
+                break;
+            }
+            Group& group = *pGroup;
+            group.m_index = groupIndex;
+            group.m_count = std::min(groupSize, records.size() - groupIndex * groupSize);
+            group.m_loadedCount = 0;
+            group.m_arena.reset();
+            try{
+                const BatchVerifier::Record* const pRecords = &records[groupIndex * groupSize];
+                for (size_t i = 0; i < group.m_count; ++i){
+                    BatchVerifier::Result& result = group.m_results[i];
+                    result.reset();
+                    if (BatchVerifier::loadRecord(pRecords[i], group.m_arena, group.m_inputs[group.m_loadedCount], result) == false){
+                        continue;
+                    }
+                    group.m_pLoadedResults[group.m_loadedCount] = &result;
+                    ++group.m_loadedCount;
+                }
+            }catch (...){
+                recordException();
+            }
+            ++stage.m_groupCount;
+            pushWaiting(loadedQueue, pGroup, stage.m_waitNanoseconds[WAIT_OUTPUT]);
+            sampleDepth(loadedQueue, QUEUE_LOADED, queue);
+        }
+        if (loadThreadsLeft.fetch_sub(1) == 1){
+            loadedQueue.close();
+        }
+        stage.m_activeNanoseconds = nanosecondsSince(threadStart);
+        countStalls(STAGE_LOAD, stage);
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        mergeStageStatistics(statistics.m_stages[STAGE_LOAD], stage);
+        mergeQueueStatistics(statistics.m_queues[QUEUE_LOADED], queue);
+    };
+
+    // stage 2: verify - parses, hashes and verifies a group with the thread's own verifier
+    std::atomic<size_t> verifyThreadsLeft(this->m_verifyThreadCount);
+    auto verifyBody = [&](const size_t threadIndex){
+        const std::chrono::steady_clock::time_point threadStart = std::chrono::steady_clock::now();
+        StageStatistics stage;
+        QueueStatistics queue;
+        Group* pGroup = nullptr;
+        while (popWaiting(loadedQueue, pGroup, stage.m_waitNanoseconds[WAIT_INPUT]) == true){
+            try{
+                BatchVerifier::verifyInputs(pGroup->m_inputs, pGroup->m_pLoadedResults, pGroup->m_loadedCount, *verifiers[threadIndex],
+                                            captureKeyData, fingerprintKeys);
+            }catch (...){
+                recordException();
+            }
+            ++stage.m_groupCount;
+            pushWaiting(verifiedQueue, pGroup, stage.m_waitNanoseconds[WAIT_OUTPUT]);
+            sampleDepth(verifiedQueue, QUEUE_VERIFIED, queue);
+        }
+        if (verifyThreadsLeft.fetch_sub(1) == 1){
+            verifiedQueue.close();
+        }
+        OpenSSLThreading::cleanupThread();
+        stage.m_activeNanoseconds = nanosecondsSince(threadStart);
+        countStalls(STAGE_VERIFY, stage);
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        mergeStageStatistics(statistics.m_stages[STAGE_VERIFY], stage);
+        mergeQueueStatistics(statistics.m_queues[QUEUE_VERIFIED], queue);
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(this->m_loadThreadCount + this->m_verifyThreadCount);
+    for (size_t i = 0; i < this->m_loadThreadCount; ++i){
+        threads.push_back(std::thread(loadBody));
+    }
+    for (size_t i = 0; i < this->m_verifyThreadCount; ++i){
+        threads.push_back(std::thread(verifyBody, i));
+    }
+
+    // stage 3: emit (this thread) - writes groups as soon as every earlier one has been written
+    //   the key index is consulted here, so that duplicates are resolved in manifest order
+    int worstOutcome = RETCODE_SUCCESS;
+    {
+        const std::chrono::steady_clock::time_point threadStart = std::chrono::steady_clock::now();
+        StageStatistics stage;
+        std::vector<Group*> reorderBuffer(poolSize, nullptr);
+        size_t nextEmitIndex = 0;
+        writer.writeHeader();
+        Group* pGroup = nullptr;
+        while (popWaiting(verifiedQueue, pGroup, stage.m_waitNanoseconds[WAIT_INPUT]) == true){
+            reorderBuffer[pGroup->m_index % poolSize] = pGroup;
+            while (nextEmitIndex < groupCount && reorderBuffer[nextEmitIndex % poolSize] != nullptr){
+                Group* const pNext = reorderBuffer[nextEmitIndex % poolSize];
+                reorderBuffer[nextEmitIndex % poolSize] = nullptr;
+                if (pKeyIndex != nullptr && failed.load() == false){
+                    try{
+                        BatchVerifier::checkKeyIndex(pNext->m_results, pNext->m_count, *pKeyIndex);
+                    }catch (...){
+                        recordException();
+                    }
+                }
+                if (failed.load() == false){
+                    for (size_t i = 0; i < pNext->m_count; ++i){
+                        const BatchVerifier::Result& result = pNext->m_results[i];
+                        Metrics::countOutcome(result.m_outcome);
+                        writer.write(result);
+                        if (result.m_outcome > worstOutcome){
+                            worstOutcome = result.m_outcome;
+                        }
+                    }
+                }
+                ++stage.m_groupCount;
+                ++nextEmitIndex;
+                freeQueue.tryPush(pNext);
+            }
+        }
+        writer.flush();
+        stage.m_activeNanoseconds = nanosecondsSince(threadStart);
+        countStalls(STAGE_EMIT, stage);
+        std::lock_guard<std::mutex> lock(statisticsMutex);
+        mergeStageStatistics(statistics.m_stages[STAGE_EMIT], stage);
+    }
+
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); it++){
+        it->join();
+    }
+    statistics.m_elapsedNanoseconds = nanosecondsSince(runStart);
+    this->m_statistics = statistics;
+
+    if (firstException){
+        std::rethrow_exception(firstException);
+    }
+    return worstOutcome;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// writes the statistics of the last run, one line per stage and queue
+//   busy is the share of a stage's thread time not spent waiting; the busiest stage is the bottleneck
+void BatchPipeline::writeStatistics(std::ostream& out) const {
+    const Statistics& statistics = this->m_statistics;
+    const std::ios::fmtflags savedFlags = out.flags();
+    const std::streamsize savedPrecision = out.precision();
+    out << std::fixed << std::setprecision(1);
+
+    out << "pipeline: " << statistics.m_recordCount << " records in "
+        << static_cast<double>(statistics.m_elapsedNanoseconds) / 1e6 << " ms" << std::endl;
+    for (size_t i = 0; i < STAGE_COUNT; ++i){
+        const StageStatistics& stage = statistics.m_stages[i];
+        const double active = (stage.m_activeNanoseconds > 0) ? static_cast<double>(stage.m_activeNanoseconds) : 1.0;
+        const double input = 100.0 * static_cast<double>(stage.m_waitNanoseconds[WAIT_INPUT]) / active;
+        const double output = 100.0 * static_cast<double>(stage.m_waitNanoseconds[WAIT_OUTPUT]) / active;
+        const double busy = std::max(0.0, 100.0 - input - output);
+        out << "  stage " << std::left << std::setw(7) << getStageName(static_cast<Stage>(i)) << std::right
+            << std::setw(3) << stage.m_threadCount << " threads  " << std::setw(8) << stage.m_groupCount << " groups"
+            << "  busy " << std::setw(5) << busy << "%"
+            << "  waiting for input " << std::setw(5) << input << "%"
+            << "  for output " << std::setw(5) << output << "%" << std::endl;
+    }
+    const char* const queueNames[QUEUE_COUNT] = { "loaded", "verified" };
+    for (size_t i = 0; i < QUEUE_COUNT; ++i){
+        const QueueStatistics& queue = statistics.m_queues[i];
+        const double meanDepth = (queue.m_depthSamples > 0) ? static_cast<double>(queue.m_depthSum) / static_cast<double>(queue.m_depthSamples) : 0.0;
+        out << "  queue " << std::left << std::setw(9) << queueNames[i] << std::right
+            << "capacity " << std::setw(4) << queue.m_capacity
+            << "  mean depth " << std::setw(6) << meanDepth
+            << "  max " << std::setw(4) << queue.m_depthMax << std::endl;
+    }
+
+    out.flags(savedFlags);
+    out.precision(savedPrecision);
+}
+
+//----------------------------------------------------------------------
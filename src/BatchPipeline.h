@@ -0,0 +1,154 @@
+//----------------------------------------------------------------------
+// BatchPipeline - Runs the records of a manifest through separate load,
+//                 verify and emit stages, each on its own threads, so that
+//                 field file reads and hex decoding overlap with RSA
+//                 verification and with writing the results.
+//
+// Records travel in groups of MultiBufferSHA1::MAX_LANES, hashed together
+// as in BatchVerifier::verifyAll():
+//
+//   load   (N threads)   reads '@' field files and decodes the hex fields
+//   verify (M threads)   parses, hashes and verifies the records
+//   emit   (the caller)  restores manifest order, checks the key index and
+//                        writes the result lines
+//
+// Stages hand groups on through bounded lock-free queues (BoundedQueue).
+// A fixed pool of groups circulates through the stages: load takes a free
+// group before it claims the next records, so a slow stage holds the
+// stages before it back rather than letting memory grow, and the emit
+// stage's reorder buffer never holds more than the pool.  A group keeps
+// its decode arena (ByteArena) and its results across reuses, so once the
+// pool has warmed up, records that verify are processed without allocating.
+// Each stage totals the time its threads waited for input (queue empty)
+// or output (queue full, or no free group), and every push samples the
+// depth of the queue; the stage that waits least is the bottleneck.
+//----------------------------------------------------------------------
+
+#ifndef BatchPipelineH_Included
+#define BatchPipelineH_Included
+
+//----------------------------------------------------------------------
+
+class BatchPipeline;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+
+#include "BatchVerifier.h"
+#include "KeyFingerprintIndex.h"
+#include "ResultWriter.h"
+
+//----------------------------------------------------------------------
+
+class BatchPipeline{
+    public:
+        // stages (and their Metrics labels: load, verify, emit)
+        enum Stage{
+            STAGE_LOAD = 0,
+            STAGE_VERIFY,
+            STAGE_EMIT,
+            STAGE_COUNT
+        };
+
+        // what a stage thread waited for
+        enum Wait{
+            WAIT_INPUT = 0,                   // its input queue was empty
+            WAIT_OUTPUT,                      // its output queue was full (load: no free group)
+            WAIT_COUNT
+        };
+
+        // queues between the stages
+        enum Queue{
+            QUEUE_LOADED = 0,                 // load -> verify
+            QUEUE_VERIFIED,                   // verify -> emit
+            QUEUE_COUNT
+        };
+
+        // default capacity of each queue, in groups
+        const static size_t DEFAULT_QUEUE_CAPACITY = 32;
+
+        // totals of one stage
+        class StageStatistics{
+            public:
+                size_t m_threadCount;
+                uint64_t m_groupCount;                      // groups processed
+                uint64_t m_activeNanoseconds;               // summed thread lifetimes
+                uint64_t m_waitNanoseconds[WAIT_COUNT];     // summed waits
+
+                StageStatistics() : m_threadCount(0), m_groupCount(0), m_activeNanoseconds(0) { this->m_waitNanoseconds[WAIT_INPUT] = this->m_waitNanoseconds[WAIT_OUTPUT] = 0; }
+        };
+
+        // depth samples of one queue
+        class QueueStatistics{
+            public:
+                size_t m_capacity;
+                uint64_t m_depthSum;
+                uint64_t m_depthSamples;
+                uint64_t m_depthMax;
+
+                QueueStatistics() : m_capacity(0), m_depthSum(0), m_depthSamples(0), m_depthMax(0) {}
+        };
+
+        // totals of the last run
+        class Statistics{
+            public:
+                size_t m_recordCount;
+                uint64_t m_elapsedNanoseconds;
+                StageStatistics m_stages[STAGE_COUNT];
+                QueueStatistics m_queues[QUEUE_COUNT];
+
+                Statistics() : m_recordCount(0), m_elapsedNanoseconds(0) {}
+        };
+
+        // a group of records in flight (defined in the implementation)
+        class Group;
+
+    private:
+        // prevent copying and assignment
+        BatchPipeline(const BatchPipeline& src);
+        BatchPipeline operator=(const BatchPipeline& rhs);
+
+    protected:
+        const BatchVerifier& m_batchVerifier;         // records to process - must outlive this
+        size_t m_loadThreadCount;
+        size_t m_verifyThreadCount;
+        size_t m_queueCapacity;                       // groups per queue
+        Statistics m_statistics;                      // totals of the last run
+
+    public:
+        // constructor
+        //   a loadThreadCount of 0 selects 1; a verifyThreadCount of 0 selects one per hardware thread
+        BatchPipeline(const BatchVerifier& batchVerifier, const size_t loadThreadCount = 1, const size_t verifyThreadCount = 0,
+                      const size_t queueCapacity = DEFAULT_QUEUE_CAPACITY);
+
+        // destructor
+        virtual ~BatchPipeline();
+
+
+        // getters
+        size_t getLoadThreadCount() const { return this->m_loadThreadCount; }
+        size_t getVerifyThreadCount() const { return this->m_verifyThreadCount; }
+        const Statistics& getStatistics() const { return this->m_statistics; }
+
+        // returns the label of a stage
+        static const char* getStageName(const Stage stage);
+
+
+        // processes every record, writing the results to writer in manifest order (header first, flushed at the end)
+        //   the output is that of writer.writeAll(batchVerifier.verifyAll(...)) with the same key index
+        //   returns the highest outcome code of all records (0 if every record verified)
+        //   throws std::runtime_error if a verifier cannot be created or the key index cannot grow
+        //   (no results are written after the failure)
+        int run(ResultWriter& writer, KeyFingerprintIndex* pKeyIndex = nullptr);
+
+        // writes the statistics of the last run, one line per stage and queue
+        void writeStatistics(std::ostream& out) const;
+};
+
+//----------------------------------------------------------------------
+
+#endif
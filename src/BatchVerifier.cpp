@@ -0,0 +1,431 @@
+//----------------------------------------------------------------------
+// See BatchVerifier.h
+//----------------------------------------------------------------------
+
+#include "BatchVerifier.h"
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "LineScanner.h"
+#include "Metrics.h"
+#include "TraceRecorder.h"
+#include "VerificationWorkerPool.h"
+#include "MultiBufferSHA1.h"
+#include "ResultWriter.h"
+
+#include <cstdint>
+#include <cstring>    // memcpy
+#include <memory>     // unique_ptr
+#include <algorithm>  // min
+
+namespace{
+    // whitespace that separates manifest fields (that of std::isspace in the "C" locale)
+    inline bool IsManifestSpace(const char c){
+        return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+    }
+
+    // returns the offset of the first whitespace character in line at or after offset (line.size() if none)
+    //   fields are long runs of hex digits, so eight characters are tested at a time for any byte
+    //   below 0x21 (every whitespace character is); only such words are examined one character at a time
+    size_t FindManifestSpace(const TextView& line, size_t offset){
+        const uint64_t ONES = 0x0101010101010101ULL;
+        const uint64_t HIGH_BITS = 0x8080808080808080ULL;
+        const size_t end = line.size();
+        while (offset < end){
+            while (end - offset >= sizeof(uint64_t)){
+                uint64_t word;
+                std::memcpy(&word, line.data() + offset, sizeof(word));
+                if (((word - ONES * 0x21) & ~word & HIGH_BITS) != 0){
+                    break;
+                }
+                offset += sizeof(word);
+            }
+            const size_t stop = std::min(end, offset + sizeof(uint64_t));
+            for (; offset < stop; ++offset){
+                if (IsManifestSpace(line[offset]) == true){
+                    return offset;
+                }
+            }
+        }
+        return end;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor reads the rest of a stream as the manifest
+//   blank lines and lines starting with '#' are skipped
+//   throws std::runtime_error if the manifest cannot be read
+BatchVerifier::BatchVerifier(std::istream& manifest){
+    try{
+        this->m_pManifest.reset(new MappedFile(manifest));
+    }catch (std::runtime_error&){
+        throw std::runtime_error("Unable to read batch manifest.");
+    }
+    this->parseManifest();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor maps the manifest file (or reads it, if it cannot be mapped)
+//   blank lines and lines starting with '#' are skipped
+//   throws std::runtime_error if the manifest cannot be opened or read
+BatchVerifier::BatchVerifier(const std::string& manifest_filepath){
+    try{
+        this->m_pManifest.reset(new MappedFile(manifest_filepath, MappedFile::ACCESS_SEQUENTIAL));
+    }catch (std::runtime_error&){
+        throw std::runtime_error("Unable to open manifest file.");
+    }
+    this->parseManifest();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - nothing to do at present
+BatchVerifier::~BatchVerifier(){
+
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// splits the manifest text into records; fields are views into m_pManifest
+void BatchVerifier::parseManifest(){
+    StageTimer readTimer(Metrics::STAGE_READ);
+    LineScanner scanner(this->m_pManifest->getText(), this->m_pManifest->getSize());
+    TextView line;
+    while (scanner.nextLine(line) == true){
+        // split line into whitespace-separated fields
+        Record record;
+        record.m_lineNumber = scanner.getLineNumber();
+        record.m_fieldCount = 0;
+        size_t offset = 0;
+        for (;;){
+            while (offset < line.size() && IsManifestSpace(line[offset]) == true){
+                ++offset;
+            }
+            if (offset == line.size()){
+                break;
+            }
+            const size_t start = offset;
+            offset = FindManifestSpace(line, offset);
+            if (record.m_fieldCount < Record::MAX_FIELDS){
+                record.m_fields[record.m_fieldCount] = line.substr(start, offset - start);
+            }
+            ++record.m_fieldCount;
+        }
+
+        // skip blank lines and comments
+        if (record.m_fieldCount == 0 || record.m_fields[0][0] == '#'){
+            continue;
+        }
+
+        this->m_records.push_back(record);
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// loads the data of one manifest field (inline ASCII-hex or '@' file reference)
+//   throws std::runtime_error if a referenced file cannot be read or the data is invalid
+std::vector<byte> BatchVerifier::loadField(const TextView& field){
+    if (field.empty() == false && field[0] == '@'){
+        // the referenced file holds the data on its first line
+        StageTimer readTimer(Metrics::STAGE_READ);
+        const MappedFile file(field.substr(1, field.size() - 1).toString(), MappedFile::ACCESS_SEQUENTIAL);
+        LineScanner scanner(file.getText(), file.getSize());
+        TextView line;
+        scanner.nextLine(line);
+        readTimer.stop();
+        StageTimer decodeTimer(Metrics::STAGE_DECODE);
+        return Convert_ASCIIHex_To_Byte(line.data(), line.size());
+    }else{
+        StageTimer decodeTimer(Metrics::STAGE_DECODE);
+        return Convert_ASCIIHex_To_Byte(field.data(), field.size());
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// loads the data of one manifest field into memory drawn from arena
+//   throws std::runtime_error if a referenced file cannot be read or the data is invalid
+void BatchVerifier::loadField(const TextView& field, ByteArena& arena, const byte*& pData, size_t& size){
+    if (field.empty() == false && field[0] == '@'){
+        // the referenced file holds the data on its first line
+        StageTimer readTimer(Metrics::STAGE_READ);
+        const MappedFile file(field.substr(1, field.size() - 1).toString(), MappedFile::ACCESS_SEQUENTIAL);
+        LineScanner scanner(file.getText(), file.getSize());
+        TextView line;
+        scanner.nextLine(line);
+        readTimer.stop();
+        StageTimer decodeTimer(Metrics::STAGE_DECODE);
+        byte* const pOut = arena.allocate((line.size() + 1) / 2);
+        size = Convert_ASCIIHex_To_Byte(line.data(), line.size(), pOut);
+        pData = pOut;
+    }else{
+        StageTimer decodeTimer(Metrics::STAGE_DECODE);
+        byte* const pOut = arena.allocate((field.size() + 1) / 2);
+        size = Convert_ASCIIHex_To_Byte(field.data(), field.size(), pOut);
+        pData = pOut;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// loads both fields of a record; never throws
+//   returns false, with result set to RETCODE_INPUT_ERROR, if the record is malformed or cannot be loaded
+bool BatchVerifier::loadRecord(const Record& record, ByteArena& arena, Input& input, Result& result){
+    result.m_lineNumber = record.m_lineNumber;
+    TraceRecorder::setRecordId(record.m_lineNumber);
+    try{
+        if (record.m_fieldCount != 2){
+            throw std::runtime_error("Malformed manifest line; expected <iobuf> <wrappedkey>.");
+        }
+        loadField(record.m_fields[0], arena, input.m_pIobufData, input.m_iobufSize);
+        loadField(record.m_fields[1], arena, input.m_pWrappedKeyData, input.m_wrappedKeySize);
+    }catch (std::runtime_error& ex){
+        result.m_outcome = RETCODE_INPUT_ERROR;
+        result.m_message = (ex.what() == nullptr) ? "<null>" : ex.what();
+        return false;
+    }catch (...){
+        result.m_outcome = RETCODE_INPUT_ERROR;
+        result.m_message = "Unknown exception thrown.";
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// parses and verifies one record; never throws
+BatchVerifier::Result BatchVerifier::verifyRecord(const Record& record){
+    try{
+        CoolkeyRSAVerifier verifier;
+        return verifyRecord(record, verifier);
+    }catch (std::runtime_error& ex){
+        Result result;
+        result.m_lineNumber = record.m_lineNumber;
+        result.m_outcome = RETCODE_VERIFY_ERROR;
+        result.m_message = (ex.what() == nullptr) ? "<null>" : ex.what();
+        return result;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// parses and verifies one record with the given (reused) verifier; never throws
+BatchVerifier::Result BatchVerifier::verifyRecord(const Record& record, CoolkeyRSAVerifier& verifier){
+    Result result;
+    ByteArena arena;
+    verifyRecords(&record, 1, verifier, arena, &result);
+    return result;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// parses and verifies a group of records, hashing them together; never throws
+void BatchVerifier::verifyRecords(const Record* pRecords, const size_t count, CoolkeyRSAVerifier& verifier, ByteArena& arena,
+                                  Result* pResults, const bool captureKeyData, const bool fingerprintKeys){
+    Input inputs[MultiBufferSHA1::MAX_LANES];
+    Result* pLoadedResults[MultiBufferSHA1::MAX_LANES];
+    size_t loadedCount = 0;
+
+    for (size_t i = 0; i < count; i++){
+        Result& result = pResults[i];
+
+        // stage 1: load input data
+        if (loadRecord(pRecords[i], arena, inputs[loadedCount], result) == false){
+            continue;
+        }
+
+        pLoadedResults[loadedCount] = &result;
+        ++loadedCount;
+    }
+
+    verifyInputs(inputs, pLoadedResults, loadedCount, verifier, captureKeyData, fingerprintKeys);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// parses and verifies a group of loaded inputs, hashing them together; never throws
+void BatchVerifier::verifyInputs(const Input* pInputs, Result* const* ppResults, const size_t count, CoolkeyRSAVerifier& verifier,
+                                 const bool captureKeyData, const bool fingerprintKeys){
+    CoolkeyRSAKeyGenResultView views[MultiBufferSHA1::MAX_LANES];
+    size_t parsedIndexes[MultiBufferSHA1::MAX_LANES];
+    MultiBufferSHA1::Message messages[MultiBufferSHA1::MAX_LANES];
+    size_t parsedCount = 0;
+
+    for (size_t i = 0; i < count; i++){
+        const Input& input = pInputs[i];
+        Result& result = *ppResults[i];
+
+        // stage 2: parse RSA key gen result blob in place
+        //   malformed records are common in replay corpora, so this path reports failures through status
+        //   codes rather than exceptions and formats the message only once a record has failed
+        CoolkeyRSAKeyGenResultView& view = views[i];
+        TraceRecorder::setRecordId(result.m_lineNumber);
+        StageTimer parseTimer(Metrics::STAGE_PARSE);
+        const CoolkeyStatus parseStatus = view.tryParse(input.m_pIobufData, input.m_iobufSize);
+        parseTimer.stop();
+        if (parseStatus.isOk() == false){
+            result.m_outcome = RETCODE_PARSE_ERROR;
+            result.m_message = parseStatus.getMessage();
+            continue;
+        }
+        if (captureKeyData == true){
+            const CoolkeyRSAKeyBlobView& blob = view.getBlob();
+            result.m_hasKeyData = true;
+            result.m_keyLengthBits = blob.getKeyLengthBits();
+            result.m_exponent.assign(blob.getExponentData(), blob.getExponentData() + blob.getExponentLength());
+            result.m_modulus.assign(blob.getModulusData(), blob.getModulusData() + blob.getModulusLength());
+            result.m_proof.assign(view.getProofData(), view.getProofData() + view.getProofSize());
+        }
+
+        // signed message is (key blob + wrapped key)
+        MultiBufferSHA1::Message& message = messages[parsedCount];
+        message.m_pPart1 = view.getBlob().getBlobData();
+        message.m_part1Length = view.getBlob().getBlobSize();
+        message.m_pPart2 = input.m_pWrappedKeyData;
+        message.m_part2Length = input.m_wrappedKeySize;
+        parsedIndexes[parsedCount] = i;
+        ++parsedCount;
+    }
+
+    // stage 3: hash every parsed record at once (timed as an equal share per record)
+    byte digests[MultiBufferSHA1::MAX_LANES][MultiBufferSHA1::DIGEST_LENGTH];
+    if (parsedCount > 0){
+        TraceRecorder::setRecordId(ppResults[parsedIndexes[0]]->m_lineNumber);
+    }
+    StageTimer digestTimer(Metrics::STAGE_DIGEST, parsedCount);
+    MultiBufferSHA1::hash(messages, parsedCount, digests);
+    digestTimer.stop();
+
+    // stage 4: verify RSA key gen result blobs
+    //   failure to create the OpenSSL key counts as a parse error
+    for (size_t i = 0; i < parsedCount; i++){
+        const size_t inputIndex = parsedIndexes[i];
+        const CoolkeyRSAKeyGenResultView& view = views[inputIndex];
+        Result& result = *ppResults[inputIndex];
+        TraceRecorder::setRecordId(result.m_lineNumber);
+
+        const CoolkeyStatus verifyStatus = verifier.verifyDigest(view.getBlob(), view.getProofData(), view.getProofSize(), digests[i]);
+        if (verifyStatus.isOk() == false){
+            result.m_outcome = (verifyStatus.getCategory() == CoolkeyStatus::CATEGORY_KEY) ? RETCODE_PARSE_ERROR : RETCODE_VERIFY_ERROR;
+            result.m_message = verifyStatus.getMessage();
+            continue;
+        }
+
+        // the key index itself is consulted later, in manifest order (see checkKeyIndex)
+        if (fingerprintKeys == true){
+            if (KeyFingerprintIndex::tryComputeFingerprint(view.getBlob(), result.m_fingerprint) == false){
+                result.m_outcome = RETCODE_VERIFY_ERROR;
+                result.m_message = "Unable to compute key fingerprint.";
+                continue;
+            }
+            result.m_hasFingerprint = true;
+        }
+
+        result.m_outcome = RETCODE_SUCCESS;
+        result.m_message = "Successfully validated RSA key gen result!";
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// looks up the fingerprinted results in a key index, in order, recording the keys not yet in it
+//   keys found become RETCODE_WEAK_KEY
+void BatchVerifier::checkKeyIndex(std::vector<Result>& results, KeyFingerprintIndex& keyIndex){
+    if (results.empty() == false){
+        checkKeyIndex(results.data(), results.size(), keyIndex);
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// as above, for count results starting at pResults
+void BatchVerifier::checkKeyIndex(Result* pResults, const size_t count, KeyFingerprintIndex& keyIndex){
+    std::vector<Result*> fingerprinted;
+    std::vector<const byte*> fingerprints;
+    for (size_t i = 0; i < count; i++){
+        if (pResults[i].m_hasFingerprint == true){
+            fingerprinted.push_back(&pResults[i]);
+            fingerprints.push_back(pResults[i].m_fingerprint);
+        }
+    }
+    if (fingerprinted.empty() == true){
+        return;
+    }
+
+    // one locked pass over the index for the whole batch
+    std::vector<KeyFingerprintIndex::Entry> entries(fingerprinted.size());
+    std::unique_ptr<bool[]> pFound(new bool[fingerprinted.size()]);
+    keyIndex.findOrInsertAll(fingerprints.data(), fingerprints.size(), entries.data(), pFound.get());
+    for (size_t i = 0; i < fingerprinted.size(); i++){
+        if (pFound[i] == true){
+            fingerprinted[i]->m_outcome = RETCODE_WEAK_KEY;
+            fingerprinted[i]->m_message = KeyFingerprintIndex::describeDuplicate(entries[i]);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// parses and verifies every record, spreading the work across threadCount threads
+//   results are returned in manifest order regardless of thread count
+std::vector<BatchVerifier::Result> BatchVerifier::verifyAll(const size_t threadCount, const bool captureKeyData,
+                                                            KeyFingerprintIndex* pKeyIndex) const {
+    std::vector<Result> results(this->m_records.size());
+
+    // each item writes only its own result slot, so no locking is required
+    const std::vector<Record>& records = this->m_records;
+    VerificationWorkerPool workerPool(threadCount);
+    // every worker reuses one verifier (created on first use, on the worker's own thread)
+    //   and one arena for the decoded fields, reset after each group
+    std::vector<std::unique_ptr<CoolkeyRSAVerifier>> verifiers(workerPool.getThreadCount());
+    std::vector<std::unique_ptr<ByteArena>> arenas(workerPool.getThreadCount());
+    // work items are groups of records that are hashed together
+    const size_t groupSize = MultiBufferSHA1::MAX_LANES;
+    const size_t groupCount = (records.size() + groupSize - 1) / groupSize;
+    const bool fingerprintKeys = (pKeyIndex != nullptr);
+    workerPool.run(groupCount, [&records, &results, &verifiers, &arenas, groupSize, captureKeyData, fingerprintKeys](const size_t itemIndex, const size_t workerIndex){
+        std::unique_ptr<CoolkeyRSAVerifier>& pVerifier = verifiers[workerIndex];
+        if (pVerifier.get() == nullptr){
+            pVerifier.reset(new CoolkeyRSAVerifier());
+            arenas[workerIndex].reset(new ByteArena());
+        }
+        const size_t first = itemIndex * groupSize;
+        const size_t count = std::min(groupSize, records.size() - first);
+        verifyRecords(&records[first], count, *pVerifier, *arenas[workerIndex], &results[first], captureKeyData, fingerprintKeys);
+        arenas[workerIndex]->reset();
+    });
+
+    // duplicates are resolved in manifest order, so the first occurrence of a key is the one recorded
+    if (pKeyIndex != nullptr){
+        checkKeyIndex(results, *pKeyIndex);
+    }
+    for (size_t i = 0; i < results.size(); i++){
+        Metrics::countOutcome(results[i].m_outcome);
+    }
+
+    return results;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// processes every record, writing one result line per record to out in manifest order
+//   returns the highest outcome code of all records (0 if every record verified)
+int BatchVerifier::run(std::ostream& out, const size_t threadCount) const {
+    return writeResults(this->verifyAll(threadCount), out);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// writes one result line per result to out
+//   returns the highest outcome code of all results (0 if every record verified)
+int BatchVerifier::writeResults(const std::vector<Result>& results, std::ostream& out){
+    ResultWriter writer(out, ResultWriter::FORMAT_TEXT);
+    return writer.writeAll(results);
+}
+
+//----------------------------------------------------------------------
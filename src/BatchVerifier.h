@@ -0,0 +1,187 @@
+//----------------------------------------------------------------------
+// BatchVerifier - Parses and verifies many Coolkey RSA key generation
+//                 results listed in a manifest file within a single
+//                 process.
+//----------------------------------------------------------------------
+
+#ifndef BatchVerifierH_Included
+#define BatchVerifierH_Included
+
+//----------------------------------------------------------------------
+
+class BatchVerifier;
+
+//----------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "ByteArena.h"
+#include "CoolkeyRSAVerifier.h"
+#include "KeyFingerprintIndex.h"
+#include "MappedFile.h"
+#include "TextView.h"
+
+//----------------------------------------------------------------------
+
+class BatchVerifier{
+    public:
+        // one manifest line: an iobuf field and a wrappedkey field
+        //   each field is either ASCII-hex data or '@' followed by the path of a
+        //   file that contains ASCII-hex data on a single line
+        class Record{
+            public:
+                const static size_t MAX_FIELDS = 2;
+
+                size_t m_lineNumber;             // line number within the manifest (1-based)
+                size_t m_fieldCount;             // number of whitespace-separated fields on the line
+                TextView m_fields[MAX_FIELDS];   // the first fields, as views into the manifest text
+        };
+
+        // outcome of processing one record
+        class Result{
+            public:
+                size_t m_lineNumber;             // line number within the manifest (1-based)
+                int m_outcome;                   // one of the RETCODE_* program constants
+                std::string m_message;           // human-readable description of the outcome
+
+                // key data, captured only on request (see verifyAll) from records whose iobuf parsed
+                bool m_hasKeyData;               // true if the fields below are set
+                size_t m_keyLengthBits;          // key length header of the key blob
+                std::vector<byte> m_exponent;    // public exponent
+                std::vector<byte> m_modulus;     // modulus
+                std::vector<byte> m_proof;       // key proof (signature)
+
+                // key fingerprint, computed only on request (see verifyAll) for verified records
+                bool m_hasFingerprint;           // true if m_fingerprint is set
+                byte m_fingerprint[KeyFingerprintIndex::FINGERPRINT_LENGTH];
+
+                Result() : m_lineNumber(0), m_outcome(0), m_hasKeyData(false), m_keyLengthBits(0), m_hasFingerprint(false) {}
+
+                // returns the result to its constructed state, keeping the capacity of the message and key data
+                //   (a result reused for one record after another stops allocating once its buffers have grown)
+                void reset(){
+                    this->m_lineNumber = 0;
+                    this->m_outcome = 0;
+                    this->m_message.clear();
+                    this->m_hasKeyData = false;
+                    this->m_keyLengthBits = 0;
+                    this->m_exponent.clear();
+                    this->m_modulus.clear();
+                    this->m_proof.clear();
+                    this->m_hasFingerprint = false;
+                }
+        };
+
+        // the loaded data of one record; points at memory owned by the caller
+        class Input{
+            public:
+                const byte* m_pIobufData;        // iobuf bytes
+                size_t m_iobufSize;              // byte length of iobuf
+                const byte* m_pWrappedKeyData;   // wrappedkey bytes
+                size_t m_wrappedKeySize;         // byte length of wrappedkey
+        };
+
+    private:
+        // prevent copying and assignment
+        BatchVerifier(const BatchVerifier& src);
+        BatchVerifier operator=(const BatchVerifier& rhs);
+
+    protected:
+        std::unique_ptr<MappedFile> m_pManifest; // manifest text; records point into it - read in constructor
+        std::vector<Record> m_records;           // records read from the manifest - read in constructor
+
+        // splits the manifest text into records
+        void parseManifest();
+
+    public:
+        // constructor reads the rest of a stream (such as a pipe or std::cin) as the manifest
+        //   blank lines and lines starting with '#' are skipped
+        //   throws std::runtime_error if the manifest cannot be read
+        BatchVerifier(std::istream& manifest);
+
+        // constructor maps the manifest file (or reads it, if it cannot be mapped)
+        //   blank lines and lines starting with '#' are skipped
+        //   throws std::runtime_error if the manifest cannot be opened or read
+        explicit BatchVerifier(const std::string& manifest_filepath);
+
+        // destructor
+        virtual ~BatchVerifier();
+
+
+        // getters for manifest records
+        size_t getRecordCount() const { return this->m_records.size(); }
+        const std::vector<Record>& getRecords() const { return this->m_records; }
+
+
+        // loads the data of one manifest field (inline ASCII-hex or '@' file reference)
+        //   inline data is decoded straight from the view; referenced files are mapped
+        //   throws std::runtime_error if a referenced file cannot be read or the data is invalid
+        static std::vector<byte> loadField(const TextView& field);
+
+        // as above, decoding into memory drawn from arena; pData and size receive the decoded bytes
+        //   (valid until the arena is reset)
+        static void loadField(const TextView& field, ByteArena& arena, const byte*& pData, size_t& size);
+
+        // loads both fields of a record into arena, pointing input at them and setting the line number of result; never throws
+        //   returns false, with result set to RETCODE_INPUT_ERROR, if the record is malformed or cannot be loaded
+        static bool loadRecord(const Record& record, ByteArena& arena, Input& input, Result& result);
+
+        // parses and verifies one record; never throws
+        static Result verifyRecord(const Record& record);
+
+        // as above, reusing the OpenSSL state of verifier (which must not be shared between threads)
+        static Result verifyRecord(const Record& record, CoolkeyRSAVerifier& verifier);
+
+        // parses and verifies count records, writing the outcome of pRecords[i] to pResults[i]; never throws
+        //   the SHA-1 digests of the group are computed together with MultiBufferSHA1 before each
+        //   proof is checked with verifier; count must not exceed MultiBufferSHA1::MAX_LANES
+        //   the decoded fields are drawn from arena, which the caller may reset once the call returns
+        //   captureKeyData copies the key fields of every parsed record into its result
+        //   fingerprintKeys computes the key fingerprint of every verified record (see KeyFingerprintIndex)
+        static void verifyRecords(const Record* pRecords, const size_t count, CoolkeyRSAVerifier& verifier, ByteArena& arena,
+                                  Result* pResults, const bool captureKeyData = false, const bool fingerprintKeys = false);
+
+        // parses and verifies count loaded inputs, writing the outcome of pInputs[i] to *ppResults[i]; never throws
+        //   the line numbers of the results are left to the caller
+        //   count must not exceed MultiBufferSHA1::MAX_LANES
+        static void verifyInputs(const Input* pInputs, Result* const* ppResults, const size_t count, CoolkeyRSAVerifier& verifier,
+                                 const bool captureKeyData = false, const bool fingerprintKeys = false);
+
+        // looks up the fingerprinted results in a key index, in order, recording the keys not yet in it
+        //   keys found (recorded earlier, or by an earlier result) become RETCODE_WEAK_KEY
+        //   throws std::runtime_error if the index has to grow and cannot be written
+        static void checkKeyIndex(std::vector<Result>& results, KeyFingerprintIndex& keyIndex);
+
+        // as above, for count results starting at pResults
+        static void checkKeyIndex(Result* pResults, const size_t count, KeyFingerprintIndex& keyIndex);
+
+        // writes one result line per result to out (see ResultWriter::FORMAT_TEXT)
+        //   line format: <manifest line number> TAB <outcome code> TAB <message>
+        //   returns the highest outcome code of all results (0 if every record verified)
+        static int writeResults(const std::vector<Result>& results, std::ostream& out);
+
+        // parses and verifies every record, spreading the work across threadCount threads
+        //   (0 selects one thread per hardware thread)
+        //   results are returned in manifest order regardless of thread count
+        //   captureKeyData copies the key fields of every parsed record into its result
+        //   pKeyIndex, if set, flags verified keys already in the index and records the others (see checkKeyIndex)
+        std::vector<Result> verifyAll(const size_t threadCount = 1, const bool captureKeyData = false,
+                                      KeyFingerprintIndex* pKeyIndex = nullptr) const;
+
+        // processes every record, writing one result line per record to out in manifest order
+        //   line format: <manifest line number> TAB <outcome code> TAB <message>
+        //   returns the highest outcome code of all records (0 if every record verified)
+        int run(std::ostream& out, const size_t threadCount = 1) const;
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,137 @@
+//----------------------------------------------------------------------
+// BoundedQueue - Fixed-capacity lock-free queue for handing work between
+//                threads (any number of producers and consumers).
+//
+// A ring of cells, each with a sequence number that tells producers and
+// consumers whose turn the cell is (D. Vyukov's bounded MPMC queue): a
+// push or pop is one compare-and-swap on the shared position plus a
+// release store on the cell, and never blocks.  A full queue makes
+// tryPush() fail, which is how a slow consumer pushes back on its
+// producers; the waiting policy is left to the caller.  With a single
+// producer and a single consumer the compare-and-swaps never retry.
+//----------------------------------------------------------------------
+
+#ifndef BoundedQueueH_Included
+#define BoundedQueueH_Included
+
+//----------------------------------------------------------------------
+
+template <typename T> class BoundedQueue;
+
+//----------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <memory>     // unique_ptr
+#include <stdexcept>
+
+//----------------------------------------------------------------------
+
+template <typename T>
+class BoundedQueue{
+    private:
+        // prevent copying and assignment
+        BoundedQueue(const BoundedQueue& src);
+        BoundedQueue operator=(const BoundedQueue& rhs);
+
+    protected:
+        // one slot of the ring; m_sequence == position: free for the push at position,
+        //   m_sequence == position + 1: holds the value for the pop at position
+        class Cell{
+            public:
+                std::atomic<size_t> m_sequence;
+                T m_value;
+        };
+
+        std::unique_ptr<Cell[]> m_pCells;
+        size_t m_mask;                                       // capacity - 1
+        char m_padding1[64];                                 // keep the positions on separate cache lines
+        std::atomic<size_t> m_pushPosition;
+        char m_padding2[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<size_t> m_popPosition;
+        char m_padding3[64 - sizeof(std::atomic<size_t>)];
+        std::atomic<bool> m_closed;                          // set once no more values will be pushed
+
+    public:
+        // constructor - capacity is rounded up to a power of two (at least 2)
+        explicit BoundedQueue(const size_t capacity) : m_mask(0), m_pushPosition(0), m_popPosition(0), m_closed(false){
+            size_t roundedCapacity = 2;
+            while (roundedCapacity < capacity){
+                roundedCapacity *= 2;
+            }
+            this->m_pCells.reset(new Cell[roundedCapacity]);
+            this->m_mask = roundedCapacity - 1;
+            for (size_t i = 0; i < roundedCapacity; ++i){
+                this->m_pCells[i].m_sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // destructor
+        virtual ~BoundedQueue(){}
+
+
+        // getter for the capacity
+        size_t getCapacity() const { return this->m_mask + 1; }
+
+        // returns the number of values queued (a snapshot; exact only when no thread is pushing or popping)
+        size_t getSize() const {
+            const size_t popPosition = this->m_popPosition.load(std::memory_order_relaxed);
+            const size_t pushPosition = this->m_pushPosition.load(std::memory_order_relaxed);
+            return (pushPosition > popPosition) ? pushPosition - popPosition : 0;
+        }
+
+        // appends a value; returns false if the queue is full
+        bool tryPush(const T& value){
+            size_t position = this->m_pushPosition.load(std::memory_order_relaxed);
+            for (;;){
+                Cell& cell = this->m_pCells[position & this->m_mask];
+                const size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                const ptrdiff_t difference = static_cast<ptrdiff_t>(sequence - position);
+                if (difference == 0){
+                    if (this->m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) == true){
+                        cell.m_value = value;
+                        cell.m_sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }else if (difference < 0){
+                    // the cell still holds the value pushed one lap earlier
+                    return false;
+                }else{
+                    position = this->m_pushPosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // removes the oldest value into value; returns false if the queue is empty
+        bool tryPop(T& value){
+            size_t position = this->m_popPosition.load(std::memory_order_relaxed);
+            for (;;){
+                Cell& cell = this->m_pCells[position & this->m_mask];
+                const size_t sequence = cell.m_sequence.load(std::memory_order_acquire);
+                const ptrdiff_t difference = static_cast<ptrdiff_t>(sequence - (position + 1));
+                if (difference == 0){
+                    if (this->m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed) == true){
+                        value = cell.m_value;
+                        cell.m_sequence.store(position + this->m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                }else if (difference < 0){
+                    return false;
+                }else{
+                    position = this->m_popPosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // marks the queue as finished: consumers that find it empty and closed can stop
+        //   every push must have completed before the call
+        void close(){ this->m_closed.store(true, std::memory_order_release); }
+
+        // returns true once close() has been called; an empty queue that is closed stays empty
+        //   (consumers should try one more pop after seeing it closed, since values may precede the close)
+        bool isClosed() const { return this->m_closed.load(std::memory_order_acquire); }
+};
+
+//----------------------------------------------------------------------
+
+#endif
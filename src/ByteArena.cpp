@@ -0,0 +1,61 @@
+//----------------------------------------------------------------------
+// See ByteArena.h
+//----------------------------------------------------------------------
+
+#include "ByteArena.h"
+
+//----------------------------------------------------------------------
+
+#include <algorithm>  // max
+#include <limits>
+#include <new>        // bad_alloc
+#include <utility>    // move
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor
+//   a blockSize of 0 selects DEFAULT_BLOCK_SIZE
+ByteArena::ByteArena(const size_t blockSize) : m_blockSize(blockSize), m_blockIndex(0), m_offset(0), m_capacity(0){
+    if (this->m_blockSize == 0){
+        this->m_blockSize = DEFAULT_BLOCK_SIZE;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - the blocks free themselves
+ByteArena::~ByteArena(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// returns size bytes from the current block, moving on to the next block (or adding one) if they do not fit
+//   throws std::bad_alloc if a new block cannot be allocated (or size cannot be rounded up to ALIGNMENT)
+byte* ByteArena::allocate(const size_t size){
+    // rounding up would wrap around to a tiny size
+    if (size > std::numeric_limits<size_t>::max() - ALIGNMENT){
+        throw std::bad_alloc();
+    }
+    const size_t roundedSize = (size == 0) ? ALIGNMENT : ((size + ALIGNMENT - 1) & ~(ALIGNMENT - 1));
+    while (this->m_blockIndex < this->m_blocks.size()){
+        Block& block = this->m_blocks[this->m_blockIndex];
+        if (block.m_size - this->m_offset >= roundedSize){
+            byte* const pData = block.m_pData.get() + this->m_offset;
+            this->m_offset += roundedSize;
+            return pData;
+        }
+        ++this->m_blockIndex;
+        this->m_offset = 0;
+    }
+
+    // every block is in use - add one (operator new[] memory is aligned for any fundamental type)
+    Block block;
+    block.m_size = std::max(this->m_blockSize, roundedSize);
+    block.m_pData.reset(new byte[block.m_size]);
+    this->m_blocks.push_back(std::move(block));
+    this->m_capacity += this->m_blocks.back().m_size;
+    this->m_blockIndex = this->m_blocks.size() - 1;
+    this->m_offset = roundedSize;
+    return this->m_blocks.back().m_pData.get();
+}
@@ -0,0 +1,82 @@
+//----------------------------------------------------------------------
+// ByteArena - Bump allocator for the short-lived buffers of one record
+//             (or one group of records): the decoded iobuf and wrappedkey
+//             bytes that the parsed views point into.
+//
+// Memory comes from a list of blocks.  allocate() hands out the next
+// bytes of the current block and moves on to the next block (adding one
+// if needed) when it does not fit; reset() rewinds to the first block in
+// constant time and keeps every block, so a worker that resets its arena
+// after each record stops allocating once the arena has grown to the
+// largest record it has seen.
+//----------------------------------------------------------------------
+
+#ifndef ByteArenaH_Included
+#define ByteArenaH_Included
+
+//----------------------------------------------------------------------
+
+class ByteArena;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <memory>     // unique_ptr
+#include <vector>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class ByteArena{
+    public:
+        // default size of a block; an allocation larger than the block size gets a block of its own
+        const static size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+        // alignment of every allocation
+        const static size_t ALIGNMENT = 16;
+
+    private:
+        // prevent copying and assignment
+        ByteArena(const ByteArena& src);
+        ByteArena operator=(const ByteArena& rhs);
+
+    protected:
+        // one block of memory
+        class Block{
+            public:
+                std::unique_ptr<byte[]> m_pData;
+                size_t m_size;
+        };
+
+        size_t m_blockSize;                      // size of new blocks
+        std::vector<Block> m_blocks;             // blocks allocated so far, kept across resets
+        size_t m_blockIndex;                     // block allocations are taken from
+        size_t m_offset;                         // bytes of the current block handed out
+        size_t m_capacity;                       // total size of m_blocks
+
+    public:
+        // constructor - no memory is allocated until the first allocate()
+        //   a blockSize of 0 selects DEFAULT_BLOCK_SIZE
+        explicit ByteArena(const size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+        // destructor
+        virtual ~ByteArena();
+
+
+        // getters
+        size_t getBlockCount() const { return this->m_blocks.size(); }
+        size_t getCapacity() const { return this->m_capacity; }
+
+        // returns size bytes (aligned to ALIGNMENT), valid until the next reset() or the arena's destruction
+        //   throws std::bad_alloc if a new block cannot be allocated, or size is within ALIGNMENT of SIZE_MAX
+        byte* allocate(const size_t size);
+
+        // releases every allocation at once; the blocks are kept for reuse
+        void reset() { this->m_blockIndex = 0; this->m_offset = 0; }
+};
+
+//----------------------------------------------------------------------
+
+#endif
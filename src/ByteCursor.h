@@ -0,0 +1,76 @@
+//----------------------------------------------------------------------
+// ByteCursor - Bounds-checked sequential reader over a borrowed byte
+//              buffer.  Multi-byte integers are read in big endian
+//              (network) byte order one byte at a time, so no unaligned
+//              loads are performed and machine endianness is irrelevant.
+//----------------------------------------------------------------------
+
+#ifndef ByteCursorH_Included
+#define ByteCursorH_Included
+
+//----------------------------------------------------------------------
+
+class ByteCursor;
+
+//----------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstddef>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class ByteCursor{
+    protected:
+        const byte* m_pData;                  // borrowed buffer - must outlive this
+        size_t m_size;                        // byte length of buffer
+        size_t m_offset;                      // offset of next byte to read
+
+    public:
+        // constructor - cursor starts at the beginning of the buffer
+        ByteCursor(const byte* pData, const size_t size) : m_pData(pData), m_size(size), m_offset(0) {}
+
+
+        // getters for cursor position
+        size_t getOffset() const { return this->m_offset; }
+        size_t getRemaining() const { return this->m_size - this->m_offset; }
+
+
+        // read methods return false (and do not advance) if insufficient data remains
+
+        // reads one byte
+        bool readByte(byte& value){
+            if (this->getRemaining() < 1){
+                return false;
+            }
+            value = this->m_pData[this->m_offset];
+            this->m_offset += 1;
+            return true;
+        }
+
+        // reads a big endian 16-bit unsigned integer
+        bool readUint16(uint16_t& value){
+            if (this->getRemaining() < 2){
+                return false;
+            }
+            value = static_cast<uint16_t>((this->m_pData[this->m_offset] << 8) | this->m_pData[this->m_offset + 1]);
+            this->m_offset += 2;
+            return true;
+        }
+
+        // returns a pointer to the next length bytes without copying them
+        bool readBytes(const size_t length, const byte*& pBytes){
+            if (this->getRemaining() < length){
+                return false;
+            }
+            pBytes = this->m_pData + this->m_offset;
+            this->m_offset += length;
+            return true;
+        }
+};
+
+//----------------------------------------------------------------------
+
+#endif
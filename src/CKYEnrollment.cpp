@@ -0,0 +1,213 @@
+//----------------------------------------------------------------------
+// See CKYEnrollment.h and CKYEnrollmentStatus.h
+//----------------------------------------------------------------------
+
+#include "CKYEnrollment.h"
+
+//----------------------------------------------------------------------
+
+#include <new>
+
+#include "CKYEnrollmentStatus.h"
+#include "CoolkeyRSAKeyBlobView.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "CoolkeyRSAVerifier.h"
+#include "CoolkeyStatus.h"
+#include "HexDecoder.h"
+#include "OpenSSLThreading.h"
+
+//----------------------------------------------------------------------
+
+namespace{
+    // bytes decoded per step once the caller's buffer is full (to detect overflow)
+    const size_t OVERFLOW_PROBE_SIZE = 64;
+}
+
+//----------------------------------------------------------------------
+// prepares OpenSSL for use from several threads
+void CKY_Initialize(void){
+    try{
+        OpenSSLThreading::initialize();
+    }catch (...){
+        // nothing sensible to report - OpenSSL will still work single threaded
+    }
+}
+
+//----------------------------------------------------------------------
+// parses the key gen result in data into *result without copying
+CKY_Status CKY_ParseKeyGenResult(const unsigned char* data, size_t size, int extraDataOkay,
+                                 CKY_KeyGenResult* result){
+    if (result == nullptr || (data == nullptr && size != 0)){
+        return CKY_ERROR_INVALID_ARGUMENT;
+    }
+
+    CoolkeyRSAKeyGenResultView view;
+    if (view.tryParse(data, size, extraDataOkay != 0).isOk() == false){
+        return CKY_ERROR_PARSE;
+    }
+
+    const CoolkeyRSAKeyBlobView& blob = view.getBlob();
+    result->blob = blob.getBlobData();
+    result->blobSize = blob.getBlobSize();
+    result->keyEncoding = blob.getKeyEncoding();
+    result->keyType = blob.getKeyType();
+    result->keyLengthBits = blob.getKeyLengthBits();
+    result->modulus = blob.getModulusData();
+    result->modulusLength = blob.getModulusLength();
+    result->exponent = blob.getExponentData();
+    result->exponentLength = blob.getExponentLength();
+    result->proof = view.getProofData();
+    result->proofSize = view.getProofSize();
+    return CKY_OK;
+}
+
+//----------------------------------------------------------------------
+// reusable verification state
+struct CKY_Verifier{
+    CoolkeyRSAVerifier m_verifier;
+};
+
+//----------------------------------------------------------------------
+// verifies the proof of a parsed key gen result with the given challenge key
+CKY_Status CKY_VerifyKeyGenResult(const CKY_KeyGenResult* result,
+                                  const unsigned char* challengeKey, size_t challengeKeySize){
+    CKY_Verifier* verifier = nullptr;
+    const CKY_Status createStatus = CKY_CreateVerifier(&verifier);
+    if (createStatus != CKY_OK){
+        return createStatus;
+    }
+    const CKY_Status status = CKY_VerifyKeyGenResultWith(verifier, result, challengeKey, challengeKeySize);
+    CKY_FreeVerifier(verifier);
+    return status;
+}
+
+//----------------------------------------------------------------------
+// creates verification state that CKY_VerifyKeyGenResultWith() reuses
+CKY_Status CKY_CreateVerifier(CKY_Verifier** verifier){
+    if (verifier == nullptr){
+        return CKY_ERROR_INVALID_ARGUMENT;
+    }
+    *verifier = nullptr;
+    try{
+        *verifier = new CKY_Verifier();
+    }catch (std::bad_alloc&){
+        return CKY_ERROR_OUT_OF_MEMORY;
+    }catch (...){
+        // OpenSSL objects could not be created
+        return CKY_ERROR_INTERNAL;
+    }
+    return CKY_OK;
+}
+
+//----------------------------------------------------------------------
+// frees verification state created by CKY_CreateVerifier()
+void CKY_FreeVerifier(CKY_Verifier* verifier){
+    delete verifier;
+}
+
+//----------------------------------------------------------------------
+// verifies the proof of a parsed key gen result, reusing the state of verifier
+CKY_Status CKY_VerifyKeyGenResultWith(CKY_Verifier* verifier, const CKY_KeyGenResult* result,
+                                      const unsigned char* challengeKey, size_t challengeKeySize){
+    if (verifier == nullptr || result == nullptr || result->blob == nullptr || result->proof == nullptr ||
+        (challengeKey == nullptr && challengeKeySize != 0)){
+        return CKY_ERROR_INVALID_ARGUMENT;
+    }
+
+    // re-parse the (exactly sized) blob so a hand-filled result cannot smuggle in inconsistent fields
+    CoolkeyRSAKeyBlobView view;
+    if (view.tryParse(result->blob, result->blobSize).isOk() == false){
+        return CKY_ERROR_PARSE;
+    }
+
+    return CKYEnrollmentStatus::fromVerification(verifier->m_verifier.verify(view, result->proof, result->proofSize, challengeKey, challengeKeySize));
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// returns the CKY_Status of a verification outcome (see CKYEnrollmentStatus.h)
+CKY_Status CKYEnrollmentStatus::fromVerification(const CoolkeyStatus& status){
+    switch (status.getCategory()){
+        case CoolkeyStatus::CATEGORY_NONE:
+            return CKY_OK;
+        case CoolkeyStatus::CATEGORY_PARSE:
+            return CKY_ERROR_PARSE;
+        case CoolkeyStatus::CATEGORY_KEY:
+            // the key's BIGNUMs could not be allocated
+            return CKY_ERROR_OUT_OF_MEMORY;
+        case CoolkeyStatus::CATEGORY_VERIFY:
+            break;
+    }
+    return (status.getCode() == CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH) ? CKY_ERROR_VERIFY_FAILED : CKY_ERROR_INTERNAL;
+}
+
+//----------------------------------------------------------------------
+// decodes length characters of ASCII-hex text into out
+CKY_Status CKY_DecodeHex(const char* text, size_t length,
+                         unsigned char* out, size_t outCapacity, size_t* outLength,
+                         size_t* errorOffset){
+    if (outLength == nullptr || (text == nullptr && length != 0) || (out == nullptr && outCapacity != 0)){
+        return CKY_ERROR_INVALID_ARGUMENT;
+    }
+    *outLength = 0;
+
+    HexStreamDecoder decoder;
+    size_t written = 0;
+    size_t consumed = 0;
+    bool valid = true;
+    while (valid == true && consumed < length){
+        size_t chunkLength;
+        size_t decodedLength = 0;
+        if (written < outCapacity){
+            // feed() writes at most (chunkLength + 1) / 2 bytes, which must fit the remaining space
+            const size_t space = outCapacity - written;
+            chunkLength = length - consumed;
+            if (space <= chunkLength / 2){
+                chunkLength = 2 * space - 1;
+            }
+            valid = decoder.feed(text + consumed, chunkLength, out + written, decodedLength);
+            written += decodedLength;
+        }else{
+            // buffer is full - any further byte means it was too small
+            byte probe[OVERFLOW_PROBE_SIZE];
+            chunkLength = 2 * OVERFLOW_PROBE_SIZE - 1;
+            if (chunkLength > length - consumed){
+                chunkLength = length - consumed;
+            }
+            valid = decoder.feed(text + consumed, chunkLength, probe, decodedLength);
+            if (decodedLength != 0){
+                *outLength = written;
+                return CKY_ERROR_BUFFER_TOO_SMALL;
+            }
+        }
+        consumed += chunkLength;
+    }
+
+    *outLength = written;
+    if (valid == false || decoder.finish() == false){
+        if (errorOffset != nullptr){
+            *errorOffset = decoder.getErrorOffset();
+        }
+        return (decoder.isErrorUnpairedDigit() == true) ? CKY_ERROR_HEX_ODD_LENGTH : CKY_ERROR_HEX_INVALID_CHARACTER;
+    }
+    return CKY_OK;
+}
+
+//----------------------------------------------------------------------
+// returns a static, printable description of status
+const char* CKY_StatusString(CKY_Status status){
+    switch (status){
+        case CKY_OK:                          return "Success.";
+        case CKY_ERROR_INVALID_ARGUMENT:      return "Invalid argument.";
+        case CKY_ERROR_HEX_INVALID_CHARACTER: return "ASCII-hex text contains an invalid character.";
+        case CKY_ERROR_HEX_ODD_LENGTH:        return "ASCII-hex text contains an odd number of hex digits.";
+        case CKY_ERROR_BUFFER_TOO_SMALL:      return "Output buffer is too small.";
+        case CKY_ERROR_PARSE:                 return "Unable to parse key gen result.";
+        case CKY_ERROR_VERIFY_FAILED:         return "Key gen result proof did not verify.";
+        case CKY_ERROR_OUT_OF_MEMORY:         return "Out of memory.";
+        case CKY_ERROR_INTERNAL:              return "Internal error.";
+    }
+    return "Unknown status.";
+}
+
+//----------------------------------------------------------------------
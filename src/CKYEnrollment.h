@@ -0,0 +1,113 @@
+/*----------------------------------------------------------------------
+ * CKYEnrollment - C interface to the Coolkey key gen result parser and
+ *                 verifier for embedding in other programs.
+ *
+ * No function throws or aborts; every failure is reported through the
+ * returned CKY_Status.  Parsing never copies or allocates: the parsed
+ * fields point into the caller's buffer, which must outlive every use of
+ * the CKY_KeyGenResult.  All functions may be called from several
+ * threads at once once CKY_Initialize() has returned.
+ *----------------------------------------------------------------------*/
+
+#ifndef CKYEnrollmentH_Included
+#define CKYEnrollmentH_Included
+
+/*----------------------------------------------------------------------*/
+
+#include <stddef.h>
+
+#if defined(_WIN32) && defined(CKYENROLLMENT_SHARED)
+    #if defined(CKYENROLLMENT_EXPORTS)
+        #define CKY_API __declspec(dllexport)
+    #else
+        #define CKY_API __declspec(dllimport)
+    #endif
+#elif defined(CKYENROLLMENT_SHARED) && defined(__GNUC__)
+    #define CKY_API __attribute__((visibility("default")))
+#else
+    #define CKY_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*----------------------------------------------------------------------*/
+
+/* result codes */
+typedef enum CKY_Status{
+    CKY_OK = 0,                          /* success                                          */
+    CKY_ERROR_INVALID_ARGUMENT,          /* null pointer or otherwise unusable argument      */
+    CKY_ERROR_HEX_INVALID_CHARACTER,     /* ASCII-hex text holds a non-hex, non-separator    */
+    CKY_ERROR_HEX_ODD_LENGTH,            /* ASCII-hex text ends with an unpaired digit       */
+    CKY_ERROR_BUFFER_TOO_SMALL,          /* output buffer cannot hold the result             */
+    CKY_ERROR_PARSE,                     /* key gen result or key blob is malformed          */
+    CKY_ERROR_VERIFY_FAILED,             /* proof does not verify with the challenge key     */
+    CKY_ERROR_OUT_OF_MEMORY,             /* allocation failed                                */
+    CKY_ERROR_INTERNAL                   /* unexpected failure (e.g. OpenSSL object creation) */
+} CKY_Status;
+
+/* parsed key gen result - every pointer refers into the buffer passed to CKY_ParseKeyGenResult */
+typedef struct CKY_KeyGenResult{
+    const unsigned char* blob;           /* key blob (the signed data)    */
+    size_t blobSize;
+    unsigned char keyEncoding;           /* key blob encoding field       */
+    unsigned char keyType;               /* key blob type field           */
+    size_t keyLengthBits;                /* RSA key length in bits        */
+    const unsigned char* modulus;        /* RSA modulus (big endian)      */
+    size_t modulusLength;
+    const unsigned char* exponent;       /* RSA public exponent           */
+    size_t exponentLength;
+    const unsigned char* proof;          /* key proof data (signature)    */
+    size_t proofSize;
+} CKY_KeyGenResult;
+
+/* reusable verification state (OpenSSL contexts); use from one thread at a time */
+typedef struct CKY_Verifier CKY_Verifier;
+
+/*----------------------------------------------------------------------*/
+
+/* prepares OpenSSL for use from several threads; call once before any other function */
+CKY_API void CKY_Initialize(void);
+
+/* parses the key gen result in data into *result without copying
+ *   trailing bytes after the key gen result are rejected unless extraDataOkay is non-zero
+ *   does NOT verify the signature on the key */
+CKY_API CKY_Status CKY_ParseKeyGenResult(const unsigned char* data, size_t size, int extraDataOkay,
+                                         CKY_KeyGenResult* result);
+
+/* verifies the proof of a parsed key gen result with the given challenge (wrapped) key
+ *   creates and frees temporary verification state; see CKY_VerifyKeyGenResultWith()
+ *   returns CKY_ERROR_VERIFY_FAILED only if the proof does not verify (wrong key, tampered data or
+ *   a proof of the wrong size); a failure inside OpenSSL is CKY_ERROR_INTERNAL */
+CKY_API CKY_Status CKY_VerifyKeyGenResult(const CKY_KeyGenResult* result,
+                                          const unsigned char* challengeKey, size_t challengeKeySize);
+
+/* creates verification state that CKY_VerifyKeyGenResultWith() reuses from call to call */
+CKY_API CKY_Status CKY_CreateVerifier(CKY_Verifier** verifier);
+
+/* frees verification state created by CKY_CreateVerifier() (null is ignored) */
+CKY_API void CKY_FreeVerifier(CKY_Verifier* verifier);
+
+/* as CKY_VerifyKeyGenResult(), reusing the state of verifier */
+CKY_API CKY_Status CKY_VerifyKeyGenResultWith(CKY_Verifier* verifier, const CKY_KeyGenResult* result,
+                                              const unsigned char* challengeKey, size_t challengeKeySize);
+
+/* decodes length characters of ASCII-hex text into out, which holds outCapacity bytes
+ *   separator characters (':' ' ' TAB CR LF) are skipped
+ *   *outLength receives the number of bytes written; (length + 1) / 2 bytes always suffice
+ *   on a hex error *errorOffset (if not null) receives the offset of the offending character */
+CKY_API CKY_Status CKY_DecodeHex(const char* text, size_t length,
+                                 unsigned char* out, size_t outCapacity, size_t* outLength,
+                                 size_t* errorOffset);
+
+/* returns a static, printable description of status */
+CKY_API const char* CKY_StatusString(CKY_Status status);
+
+/*----------------------------------------------------------------------*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
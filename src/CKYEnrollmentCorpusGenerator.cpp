@@ -0,0 +1,344 @@
+/*
+ * CKYEnrollmentCorpusGenerator - Writes a batch manifest of synthetic
+ *              SecureStartEnrollment() results for benchmarking and
+ *              testing: valid iobuf/wrappedkey pairs signed with freshly
+ *              generated RSA keys, mixed with deliberately corrupted ones.
+ *
+ * Written by Aaron Curley
+ */
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <random>
+
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#if defined(CKY_OPENSSL3_BACKEND)
+    #include <openssl/core_names.h>
+#endif
+
+#include "CoolkeyRSAKeyBlobView.h"
+#include "HexUtilities.h"
+
+//----------------------------------------------------------------------
+
+namespace{
+    // wrapped (challenge) key length of a Coolkey enrollment
+    const size_t WRAPPED_KEY_LENGTH = 16;
+
+    // key blob fields are 16 bit; OpenSSL refuses to generate keys below 512 bits
+    const size_t MIN_KEY_BITS = 512;
+    const size_t MAX_KEY_BITS = 16384;
+
+    // ways a record is corrupted, each with the batch outcome code it produces
+    enum Corruption{
+        CORRUPT_WRAPPED_KEY = 0,     // one wrappedkey bit flipped                      - 30
+        CORRUPT_PROOF,               // one proof bit flipped                           - 30
+        CORRUPT_TRUNCATED,           // iobuf cut short inside the proof                - 20
+        CORRUPT_ENCODING,            // unsupported key encoding byte                   - 20
+        CORRUPT_HEX,                 // non-hex character in the iobuf field            - 10
+        CORRUPTION_COUNT
+    };
+    const int CORRUPTION_OUTCOMES[CORRUPTION_COUNT] = { RETCODE_VERIFY_ERROR, RETCODE_VERIFY_ERROR, RETCODE_PARSE_ERROR,
+                                                        RETCODE_PARSE_ERROR, RETCODE_INPUT_ERROR };
+
+    // one generated key and its encoded key blob
+    class GeneratedKey{
+        public:
+            EVP_PKEY* m_pKey;
+            std::vector<byte> m_blob;
+    };
+
+    // prints usage information
+    void PrintUsage(){
+        std::cout << PROGRAM_NAME << " corpus generator  -  " << PROGRAM_VERSION << std::endl;
+        std::cout << std::endl;
+        std::cout << "Usage:  CKYEnrollmentCorpusGenerator <record count> [--key-bits <bits>[,<bits>...]] [--keys <count>]" << std::endl;
+        std::cout << "            [--exponent <e>] [--invalid-percent <0-100>] [--seed <n>] [--output <file>] [--expected <file>]" << std::endl;
+        std::cout << "  Writes a batch manifest of signed key gen results (default: stdout)." << std::endl;
+        std::cout << "  --key-bits   modulus sizes, used in turn (default 1024,2048)" << std::endl;
+        std::cout << "  --keys       keys generated per size and used in turn (default 2)" << std::endl;
+        std::cout << "  --exponent   public exponent (default 65537)" << std::endl;
+        std::cout << "  --invalid-percent  share of corrupted records (default 0)" << std::endl;
+        std::cout << "  --seed       seed of the record contents and corruptions (default 1); keys always differ" << std::endl;
+        std::cout << "  --expected   writes <line> TAB <expected outcome code> for every record" << std::endl;
+        std::cout << std::endl;
+    }
+
+    // parses a decimal number; returns false unless the whole text is one
+    template<typename T>
+    bool TryParseNumber(const std::string& text, T& value){
+        std::istringstream stream(text);
+        return (stream >> value) && stream.eof();
+    }
+
+    // appends a big endian 16-bit integer
+    void AppendUint16(std::vector<byte>& out, const size_t value){
+        out.push_back(static_cast<byte>((value >> 8) & 0xFF));
+        out.push_back(static_cast<byte>(value & 0xFF));
+    }
+
+    // appends the big endian bytes of a BIGNUM
+    void AppendBignum(std::vector<byte>& out, const BIGNUM* pNumber){
+        const size_t offset = out.size();
+        out.resize(offset + static_cast<size_t>(BN_num_bytes(pNumber)));
+        BN_bn2bin(pNumber, out.data() + offset);
+    }
+
+    // generates an RSA key and encodes its public half as a Coolkey key blob
+    //   throws std::runtime_error on failure
+    GeneratedKey GenerateKey(const size_t bits, const unsigned long exponent){
+        GeneratedKey generated;
+        generated.m_pKey = nullptr;
+
+        BIGNUM* pExponent = BN_new();
+        EVP_PKEY_CTX* pContext = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+        bool ok = (pExponent != nullptr && pContext != nullptr && BN_set_word(pExponent, exponent) == 1 &&
+                   EVP_PKEY_keygen_init(pContext) == 1 && EVP_PKEY_CTX_set_rsa_keygen_bits(pContext, static_cast<int>(bits)) == 1);
+#if defined(CKY_OPENSSL3_BACKEND)
+        ok = ok && EVP_PKEY_CTX_set1_rsa_keygen_pubexp(pContext, pExponent) == 1;
+#else
+        // the context takes ownership of the exponent
+        ok = ok && EVP_PKEY_CTX_set_rsa_keygen_pubexp(pContext, pExponent) == 1;
+        if (ok == true){
+            pExponent = nullptr;
+        }
+#endif
+        ok = ok && EVP_PKEY_keygen(pContext, &generated.m_pKey) == 1;
+        EVP_PKEY_CTX_free(pContext);
+        BN_free(pExponent);
+        if (ok == false){
+            throw std::runtime_error("Unable to generate an RSA key.");
+        }
+
+        // encoding | key type | u16 key bits | u16 modulus length | modulus | u16 exponent length | exponent
+        std::vector<byte> modulus;
+        std::vector<byte> exponentBytes;
+#if defined(CKY_OPENSSL3_BACKEND)
+        BIGNUM* pN = nullptr;
+        BIGNUM* pE = nullptr;
+        if (EVP_PKEY_get_bn_param(generated.m_pKey, OSSL_PKEY_PARAM_RSA_N, &pN) == 1 &&
+            EVP_PKEY_get_bn_param(generated.m_pKey, OSSL_PKEY_PARAM_RSA_E, &pE) == 1){
+            AppendBignum(modulus, pN);
+            AppendBignum(exponentBytes, pE);
+        }
+        BN_free(pN);
+        BN_free(pE);
+#else
+        RSA* pRSA = EVP_PKEY_get1_RSA(generated.m_pKey);
+        if (pRSA != nullptr){
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+            AppendBignum(modulus, pRSA->n);
+            AppendBignum(exponentBytes, pRSA->e);
+#else
+            const BIGNUM* pN = nullptr;
+            const BIGNUM* pE = nullptr;
+            RSA_get0_key(pRSA, &pN, &pE, nullptr);
+            AppendBignum(modulus, pN);
+            AppendBignum(exponentBytes, pE);
+#endif
+            RSA_free(pRSA);
+        }
+#endif
+        if (modulus.empty() == true || exponentBytes.empty() == true){
+            EVP_PKEY_free(generated.m_pKey);
+            throw std::runtime_error("Unable to read the generated RSA key.");
+        }
+
+        generated.m_blob.push_back(static_cast<byte>(CoolkeyRSAKeyBlobView::KEYENCODING_PLAINTEXT));
+        generated.m_blob.push_back(static_cast<byte>(CoolkeyRSAKeyBlobView::KEYTYPE_RSA_PUBLIC));
+        AppendUint16(generated.m_blob, bits);
+        AppendUint16(generated.m_blob, modulus.size());
+        generated.m_blob.insert(generated.m_blob.end(), modulus.begin(), modulus.end());
+        AppendUint16(generated.m_blob, exponentBytes.size());
+        generated.m_blob.insert(generated.m_blob.end(), exponentBytes.begin(), exponentBytes.end());
+        return generated;
+    }
+
+    // builds the iobuf of a key gen result: u16 blob length | blob | u16 proof length | proof,
+    // where proof is the PKCS#1 v1.5 SHA-1 signature of (blob + wrapped key)
+    //   throws std::runtime_error on failure
+    std::vector<byte> BuildIobuf(const GeneratedKey& key, const std::vector<byte>& wrappedKey){
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+        EVP_MD_CTX* pContext = EVP_MD_CTX_create();
+#else
+        EVP_MD_CTX* pContext = EVP_MD_CTX_new();
+#endif
+        size_t proofLength = static_cast<size_t>(EVP_PKEY_size(key.m_pKey));
+        std::vector<byte> proof(proofLength);
+        const bool ok = (pContext != nullptr &&
+                         EVP_DigestSignInit(pContext, nullptr, EVP_sha1(), nullptr, key.m_pKey) == 1 &&
+                         EVP_DigestSignUpdate(pContext, key.m_blob.data(), key.m_blob.size()) == 1 &&
+                         EVP_DigestSignUpdate(pContext, wrappedKey.data(), wrappedKey.size()) == 1 &&
+                         EVP_DigestSignFinal(pContext, proof.data(), &proofLength) == 1);
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+        EVP_MD_CTX_destroy(pContext);
+#else
+        EVP_MD_CTX_free(pContext);
+#endif
+        if (ok == false){
+            throw std::runtime_error("Unable to sign a key gen result.");
+        }
+        proof.resize(proofLength);
+
+        std::vector<byte> iobuf;
+        iobuf.reserve(2 + key.m_blob.size() + 2 + proof.size());
+        AppendUint16(iobuf, key.m_blob.size());
+        iobuf.insert(iobuf.end(), key.m_blob.begin(), key.m_blob.end());
+        AppendUint16(iobuf, proof.size());
+        iobuf.insert(iobuf.end(), proof.begin(), proof.end());
+        return iobuf;
+    }
+}
+
+//----------------------------------------------------------------------
+// entry point of the corpus generator
+int main(int argc, const char** const argv){
+    size_t recordCount = 0;
+    std::vector<size_t> keyBits;
+    size_t keysPerSize = 2;
+    unsigned long exponent = 65537;
+    unsigned invalidPercent = 0;
+    unsigned long seed = 1;
+    std::string output_filepath;
+    std::string expected_filepath;
+
+    // <record count>, then options as name/value pairs in any order
+    bool argumentsValid = (argc >= 2) && TryParseNumber(argv[1], recordCount) && recordCount > 0;
+    for (int i = 2; i < argc && argumentsValid == true; i += 2){
+        const std::string option(argv[i]);
+        if (i + 1 >= argc){
+            argumentsValid = false;
+        }else if (option == "--key-bits"){
+            keyBits.clear();
+            std::istringstream list(argv[i + 1]);
+            std::string item;
+            while (argumentsValid == true && std::getline(list, item, ',')){
+                size_t bits = 0;
+                argumentsValid = TryParseNumber(item, bits) && bits >= MIN_KEY_BITS && bits <= MAX_KEY_BITS;
+                keyBits.push_back(bits);
+            }
+            argumentsValid = argumentsValid && (keyBits.empty() == false);
+        }else if (option == "--keys"){
+            argumentsValid = TryParseNumber(argv[i + 1], keysPerSize) && keysPerSize > 0;
+        }else if (option == "--exponent"){
+            argumentsValid = TryParseNumber(argv[i + 1], exponent) && exponent >= 3 && (exponent % 2) == 1;
+        }else if (option == "--invalid-percent"){
+            argumentsValid = TryParseNumber(argv[i + 1], invalidPercent) && invalidPercent <= 100;
+        }else if (option == "--seed"){
+            argumentsValid = TryParseNumber(argv[i + 1], seed);
+        }else if (option == "--output"){
+            output_filepath = argv[i + 1];
+        }else if (option == "--expected"){
+            expected_filepath = argv[i + 1];
+        }else{
+            argumentsValid = false;
+        }
+    }
+    if (argumentsValid == false){
+        PrintUsage();
+        return RETCODE_USAGE;
+    }
+    if (keyBits.empty() == true){
+        keyBits.push_back(1024);
+        keyBits.push_back(2048);
+    }
+
+    int retcode = RETCODE_SUCCESS;
+    std::vector<GeneratedKey> keys;
+    try{
+        std::ofstream output_file;
+        if (output_filepath.empty() == false){
+            output_file.open(output_filepath.c_str(), std::ios::out | std::ios::trunc);
+            if (output_file.good() == false){
+                throw std::runtime_error("Unable to create output file '" + output_filepath + "'.");
+            }
+        }
+        std::ostream& out = (output_filepath.empty() == false) ? static_cast<std::ostream&>(output_file) : std::cout;
+        std::ofstream expected_file;
+        if (expected_filepath.empty() == false){
+            expected_file.open(expected_filepath.c_str(), std::ios::out | std::ios::trunc);
+            if (expected_file.good() == false){
+                throw std::runtime_error("Unable to create expected outcome file '" + expected_filepath + "'.");
+            }
+        }
+
+        // keys[size index * keysPerSize + n]
+        for (size_t size = 0; size < keyBits.size(); ++size){
+            for (size_t n = 0; n < keysPerSize; ++n){
+                keys.push_back(GenerateKey(keyBits[size], exponent));
+            }
+        }
+
+        std::mt19937_64 random(seed);
+        std::uniform_int_distribution<unsigned> percent(0, 99);
+        std::uniform_int_distribution<unsigned> byteValue(0, 255);
+        std::uniform_int_distribution<unsigned> corruption(0, CORRUPTION_COUNT - 1);
+        std::string line;
+        for (size_t record = 0; record < recordCount; ++record){
+            // sizes in turn, and the keys of each size in turn
+            const size_t size = record % keyBits.size();
+            const GeneratedKey& key = keys[size * keysPerSize + (record / keyBits.size()) % keysPerSize];
+
+            std::vector<byte> wrappedKey(WRAPPED_KEY_LENGTH);
+            for (size_t i = 0; i < wrappedKey.size(); ++i){
+                wrappedKey[i] = static_cast<byte>(byteValue(random));
+            }
+            std::vector<byte> iobuf(BuildIobuf(key, wrappedKey));
+
+            int expectedOutcome = RETCODE_SUCCESS;
+            int kind = -1;
+            if (percent(random) < invalidPercent){
+                kind = static_cast<int>(corruption(random));
+                expectedOutcome = CORRUPTION_OUTCOMES[kind];
+                const size_t proofOffset = 2 + key.m_blob.size() + 2;
+                switch (kind){
+                    case CORRUPT_WRAPPED_KEY:   wrappedKey[byteValue(random) % wrappedKey.size()] ^= 0x01;                         break;
+                    case CORRUPT_PROOF:         iobuf[proofOffset + byteValue(random) % (iobuf.size() - proofOffset)] ^= 0x80;     break;
+                    case CORRUPT_TRUNCATED:     iobuf.resize(proofOffset + (iobuf.size() - proofOffset) / 2);                     break;
+                    case CORRUPT_ENCODING:      iobuf[2] = 0x01;                                                                   break;
+                    default:                                                                                                       break;
+                }
+            }
+
+            // <iobuf> <wrappedkey> as ASCII-hex
+            line.resize(2 * (iobuf.size() + wrappedKey.size()) + 1);
+            Encode_ASCIIHex(iobuf.data(), iobuf.size(), &line[0]);
+            line[2 * iobuf.size()] = ' ';
+            Encode_ASCIIHex(wrappedKey.data(), wrappedKey.size(), &line[2 * iobuf.size() + 1]);
+            if (kind == CORRUPT_HEX){
+                line[iobuf.size()] = 'g';
+            }
+            out << line << '\n';
+            if (expected_file.is_open() == true){
+                expected_file << (record + 1) << '\t' << expectedOutcome << '\n';
+            }
+        }
+
+        out.flush();
+        expected_file.flush();
+        if (out.good() == false || (expected_file.is_open() == true && expected_file.good() == false)){
+            throw std::runtime_error("Unable to write the corpus.");
+        }
+
+    }catch(std::runtime_error& ex){
+        std::cerr << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what()) << std::endl;
+        retcode = RETCODE_INPUT_ERROR;
+    }
+
+    for (size_t i = 0; i < keys.size(); ++i){
+        EVP_PKEY_free(keys[i].m_pKey);
+    }
+    return retcode;
+}
+
+//----------------------------------------------------------------------
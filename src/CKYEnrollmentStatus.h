@@ -0,0 +1,35 @@
+//----------------------------------------------------------------------
+// Maps the statuses of the C++ parser and verifier onto the CKY_Status
+// codes returned by the C interface (CKYEnrollment.h).
+//----------------------------------------------------------------------
+
+#ifndef CKYEnrollmentStatusH_Included
+#define CKYEnrollmentStatusH_Included
+
+//----------------------------------------------------------------------
+
+class CKYEnrollmentStatus;
+
+//----------------------------------------------------------------------
+
+#include "CKYEnrollment.h"
+#include "CoolkeyStatus.h"
+
+//----------------------------------------------------------------------
+
+class CKYEnrollmentStatus{
+    public:
+        // returns the CKY_Status of a verification outcome
+        //   only a proof that does not verify (VERIFY_SIGNATURE_MISMATCH, which includes a proof of the
+        //   wrong length) is CKY_ERROR_VERIFY_FAILED; digest and OpenSSL failures are CKY_ERROR_INTERNAL
+        static CKY_Status fromVerification(const CoolkeyStatus& status);
+
+    private:
+        // prevent copying and assignment
+        CKYEnrollmentStatus(const CKYEnrollmentStatus& src);
+        CKYEnrollmentStatus operator=(const CKYEnrollmentStatus& rhs);
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,2938 @@
+/*
+ * CKYEnrollmentTests - Pass/fail checks of the parser, verifier and batch
+ *              components, run by CTest (one test per command).
+ *
+ * Every test builds its own inputs - freshly generated and signed key gen
+ * results, random hex text and moduli - and writes its scratch files to
+ * the working directory, removing them again.
+ *
+ * Written by Aaron Curley
+ */
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory> // unique_ptr
+#include <random>
+#include <cstdio> // remove
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <new> // bad_alloc
+
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#if defined(CKY_OPENSSL3_BACKEND)
+    #include <openssl/core_names.h>
+#endif
+
+#if defined(__linux__)
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+#include "ArchiveBatchVerifier.h"
+#include "BatchPipeline.h"
+#include "BatchVerifier.h"
+#include "BoundedQueue.h"
+#include "ByteArena.h"
+#include "CKYEnrollment.h"
+#include "CKYEnrollmentStatus.h"
+#include "ChallengeKeySearch.h"
+#include "CoolkeyRSAKeyBlobView.h"
+#include "CoolkeyRSAKeyGenResult.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "CoolkeyRSAVerifier.h"
+#include "CoolkeyStatus.h"
+#include "EnrollmentArchive.h"
+#include "EnrollmentArchiveReader.h"
+#include "EnrollmentArchiveWriter.h"
+#include "FixedSizeRSA.h"
+#include "HexDecoder.h"
+#include "HexUtilities.h"
+#include "KeyFingerprintIndex.h"
+#include "Metrics.h"
+#include "MultiBufferSHA1.h"
+#include "ResultCache.h"
+#include "ResultWriter.h"
+#include "SharedFactorScan.h"
+#include "TraceRecorder.h"
+#include "VerificationDaemon.h"
+#include "VerificationWorkerPool.h"
+
+#include "benchmark/FixedKeyGenResult.h"
+#include "benchmark/KeyGenResultDispatcher.h"
+
+//----------------------------------------------------------------------
+
+namespace{
+    // wrapped (challenge) key length of a Coolkey enrollment
+    const size_t WRAPPED_KEY_LENGTH = 16;
+
+    // checks made by the running test
+    size_t g_checkCount = 0;
+
+    // random source of every test (fixed seed: the same inputs apart from the generated keys)
+    std::mt19937 g_random(12345);
+
+    // prints usage information
+    void PrintUsage(){
+        std::cout << PROGRAM_NAME << " tests  -  " << PROGRAM_VERSION << std::endl;
+        std::cout << std::endl;
+        std::cout << "Usage:  CKYEnrollmentTests <test>" << std::endl;
+        std::cout << "  pool            worker pool runs every item once; batch results independent of thread count" << std::endl;
+        std::cout << "  hex             HexDecoder implementations and edge cases" << std::endl;
+        std::cout << "  hex-stream      HexStreamDecoder in random chunks and StringReplaceAll" << std::endl;
+        std::cout << "  status          throwing and status APIs on valid, damaged and truncated records" << std::endl;
+        std::cout << "  verifier        reused and OpenSSL-only CoolkeyRSAVerifier against per-call verification" << std::endl;
+        std::cout << "  sha1            MultiBufferSHA1 implementations against OpenSSL; grouped digest verification" << std::endl;
+        std::cout << "  rsa             FixedSizeRSA implementations bit for bit against OpenSSL" << std::endl;
+        std::cout << "  fixed-records   FixedKeyGenResult records verify as their views do" << std::endl;
+        std::cout << "  archive         manifest/archive agreement and damaged archives" << std::endl;
+        std::cout << "  cache           result cache hits, expiry and the persistent tier" << std::endl;
+        std::cout << "  index           key fingerprint index and batch replays" << std::endl;
+        std::cout << "  shared-factors  batch GCD scan for keys sharing a prime factor" << std::endl;
+        std::cout << "  capi            C interface (CKYEnrollment.h)" << std::endl;
+        std::cout << "  daemon          daemon responses to single, pipelined, malformed and oversized requests" << std::endl;
+        std::cout << "  daemon-cache    daemon requests with the result cache and key index" << std::endl;
+        std::cout << "  pipeline        BatchPipeline output against batch mode; BoundedQueue producers and consumers" << std::endl;
+        std::cout << "  metrics         histogram bucket layout and the Prometheus export" << std::endl;
+        std::cout << "  writer          every output format with quotes, commas, newlines and control characters in messages" << std::endl;
+        std::cout << "  trace           trace file JSON and span nesting per thread" << std::endl;
+        std::cout << "  challenge-key   --find-challenge-key search: hits, misses and malformed candidates" << std::endl;
+        std::cout << "  arena           ByteArena alignment, reset and block reuse, and oversized requests" << std::endl;
+        std::cout << "  shared-result   one parsed key gen result verified from several threads at once" << std::endl;
+        std::cout << "Prints the number of checks made; exits with a non-zero code on the first failure." << std::endl;
+        std::cout << std::endl;
+    }
+
+    // counts a check; throws std::runtime_error naming it if it failed
+    void Check(const bool passed, const std::string& what){
+        ++g_checkCount;
+        if (passed == false){
+            throw std::runtime_error("Check failed: " + what);
+        }
+    }
+
+    // expects action to throw std::runtime_error
+    template<typename Action>
+    void CheckThrows(Action action, const std::string& what){
+        bool thrown = false;
+        try{
+            action();
+        }catch (std::runtime_error&){
+            thrown = true;
+        }
+        Check(thrown, what);
+    }
+
+    // returns length random bytes
+    std::vector<byte> RandomBytes(const size_t length){
+        std::vector<byte> bytes(length);
+        for (size_t i = 0; i < length; ++i){
+            bytes[i] = static_cast<byte>(g_random() & 0xFF);
+        }
+        return bytes;
+    }
+
+    // returns the lowercase ASCII-hex text of bytes
+    std::string ToHex(const std::vector<byte>& bytes){
+        std::string text(2 * bytes.size(), '0');
+        if (bytes.empty() == false){
+            Encode_ASCIIHex(bytes.data(), bytes.size(), &text[0]);
+        }
+        return text;
+    }
+
+    // appends a big endian 16-bit integer
+    void AppendUint16(std::vector<byte>& out, const size_t value){
+        out.push_back(static_cast<byte>((value >> 8) & 0xFF));
+        out.push_back(static_cast<byte>(value & 0xFF));
+    }
+
+    // appends the big endian bytes of a BIGNUM
+    void AppendBignum(std::vector<byte>& out, const BIGNUM* pNumber){
+        const size_t offset = out.size();
+        out.resize(offset + static_cast<size_t>(BN_num_bytes(pNumber)));
+        BN_bn2bin(pNumber, out.data() + offset);
+    }
+
+    // encodes a public key as a Coolkey key blob
+    std::vector<byte> BuildBlob(const size_t keyBits, const std::vector<byte>& modulus, const std::vector<byte>& exponent){
+        std::vector<byte> blob;
+        blob.push_back(static_cast<byte>(CoolkeyRSAKeyBlobView::KEYENCODING_PLAINTEXT));
+        blob.push_back(static_cast<byte>(CoolkeyRSAKeyBlobView::KEYTYPE_RSA_PUBLIC));
+        AppendUint16(blob, keyBits);
+        AppendUint16(blob, modulus.size());
+        blob.insert(blob.end(), modulus.begin(), modulus.end());
+        AppendUint16(blob, exponent.size());
+        blob.insert(blob.end(), exponent.begin(), exponent.end());
+        return blob;
+    }
+
+    // builds the iobuf of a key gen result: u16 blob length | blob | u16 proof length | proof
+    std::vector<byte> BuildIobuf(const std::vector<byte>& blob, const std::vector<byte>& proof){
+        std::vector<byte> iobuf;
+        AppendUint16(iobuf, blob.size());
+        iobuf.insert(iobuf.end(), blob.begin(), blob.end());
+        AppendUint16(iobuf, proof.size());
+        iobuf.insert(iobuf.end(), proof.begin(), proof.end());
+        return iobuf;
+    }
+
+    // a generated RSA key and its Coolkey key blob
+    class TestKey{
+        private:
+            // prevent copying and assignment
+            TestKey(const TestKey& src);
+            TestKey operator=(const TestKey& rhs);
+
+        public:
+            EVP_PKEY* m_pKey;
+            std::vector<byte> m_modulus;
+            std::vector<byte> m_exponent;
+            std::vector<byte> m_blob;
+
+            // generates the key
+            //   throws std::runtime_error on failure
+            TestKey(const size_t bits, const unsigned long exponent) : m_pKey(nullptr){
+                BIGNUM* pExponent = BN_new();
+                EVP_PKEY_CTX* pContext = EVP_PKEY_CTX_new_id(EVP_PKEY_RSA, nullptr);
+                bool ok = (pExponent != nullptr && pContext != nullptr && BN_set_word(pExponent, exponent) == 1 &&
+                           EVP_PKEY_keygen_init(pContext) == 1 && EVP_PKEY_CTX_set_rsa_keygen_bits(pContext, static_cast<int>(bits)) == 1);
+#if defined(CKY_OPENSSL3_BACKEND)
+                ok = ok && EVP_PKEY_CTX_set1_rsa_keygen_pubexp(pContext, pExponent) == 1;
+#else
+                // the context takes ownership of the exponent
+                ok = ok && EVP_PKEY_CTX_set_rsa_keygen_pubexp(pContext, pExponent) == 1;
+                if (ok == true){
+                    pExponent = nullptr;
+                }
+#endif
+                ok = ok && EVP_PKEY_keygen(pContext, &this->m_pKey) == 1;
+                EVP_PKEY_CTX_free(pContext);
+                BN_free(pExponent);
+                if (ok == false){
+                    throw std::runtime_error("Unable to generate an RSA key.");
+                }
+
+#if defined(CKY_OPENSSL3_BACKEND)
+                BIGNUM* pN = nullptr;
+                BIGNUM* pE = nullptr;
+                if (EVP_PKEY_get_bn_param(this->m_pKey, OSSL_PKEY_PARAM_RSA_N, &pN) == 1 &&
+                    EVP_PKEY_get_bn_param(this->m_pKey, OSSL_PKEY_PARAM_RSA_E, &pE) == 1){
+                    AppendBignum(this->m_modulus, pN);
+                    AppendBignum(this->m_exponent, pE);
+                }
+                BN_free(pN);
+                BN_free(pE);
+#else
+                RSA* pRSA = EVP_PKEY_get1_RSA(this->m_pKey);
+                if (pRSA != nullptr){
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+                    AppendBignum(this->m_modulus, pRSA->n);
+                    AppendBignum(this->m_exponent, pRSA->e);
+#else
+                    const BIGNUM* pN = nullptr;
+                    const BIGNUM* pE = nullptr;
+                    RSA_get0_key(pRSA, &pN, &pE, nullptr);
+                    AppendBignum(this->m_modulus, pN);
+                    AppendBignum(this->m_exponent, pE);
+#endif
+                    RSA_free(pRSA);
+                }
+#endif
+                if (this->m_modulus.empty() == true || this->m_exponent.empty() == true){
+                    EVP_PKEY_free(this->m_pKey);
+                    throw std::runtime_error("Unable to read the generated RSA key.");
+                }
+                this->m_blob = BuildBlob(bits, this->m_modulus, this->m_exponent);
+            }
+
+            ~TestKey(){
+                EVP_PKEY_free(this->m_pKey);
+            }
+
+            // returns the iobuf of a key gen result for wrappedKey, signed with this key
+            //   throws std::runtime_error on failure
+            std::vector<byte> sign(const std::vector<byte>& wrappedKey) const {
+                EVP_MD_CTX* pContext = EVP_MD_CTX_create();
+                size_t proofLength = static_cast<size_t>(EVP_PKEY_size(this->m_pKey));
+                std::vector<byte> proof(proofLength);
+                const bool ok = (pContext != nullptr &&
+                                 EVP_DigestSignInit(pContext, nullptr, EVP_sha1(), nullptr, this->m_pKey) == 1 &&
+                                 EVP_DigestSignUpdate(pContext, this->m_blob.data(), this->m_blob.size()) == 1 &&
+                                 EVP_DigestSignUpdate(pContext, wrappedKey.data(), wrappedKey.size()) == 1 &&
+                                 EVP_DigestSignFinal(pContext, proof.data(), &proofLength) == 1);
+                EVP_MD_CTX_destroy(pContext);
+                if (ok == false){
+                    throw std::runtime_error("Unable to sign a key gen result.");
+                }
+                proof.resize(proofLength);
+                return BuildIobuf(this->m_blob, proof);
+            }
+    };
+
+    // one iobuf and wrappedkey pair, and whether it must verify
+    class TestRecord{
+        public:
+            std::vector<byte> m_iobuf;
+            std::vector<byte> m_wrappedKey;
+            bool m_valid;
+    };
+
+    // returns a signed record of key, and copies with an altered wrappedkey, an altered proof and a truncated iobuf
+    std::vector<TestRecord> BuildRecords(const TestKey& key){
+        std::vector<TestRecord> records(4);
+        records[0].m_wrappedKey = RandomBytes(WRAPPED_KEY_LENGTH);
+        records[0].m_iobuf = key.sign(records[0].m_wrappedKey);
+        records[0].m_valid = true;
+        for (size_t i = 1; i < records.size(); ++i){
+            records[i] = records[0];
+            records[i].m_valid = false;
+        }
+        records[1].m_wrappedKey[3] ^= 0x10;
+        records[2].m_iobuf[records[2].m_iobuf.size() - 7] ^= 0x01;
+        records[3].m_iobuf.resize(records[3].m_iobuf.size() - 5);
+        return records;
+    }
+
+    // returns the manifest text of records, one "<iobuf> <wrappedkey>" line each
+    std::string BuildManifest(const std::vector<TestRecord>& records){
+        std::string manifest;
+        for (size_t i = 0; i < records.size(); ++i){
+            manifest += ToHex(records[i].m_iobuf) + " " + ToHex(records[i].m_wrappedKey) + "\n";
+        }
+        return manifest;
+    }
+
+    // removes scratch files when a test ends, whether it passed or not
+    class ScratchFiles{
+        private:
+            // prevent copying and assignment
+            ScratchFiles(const ScratchFiles& src);
+            ScratchFiles operator=(const ScratchFiles& rhs);
+
+        protected:
+            std::vector<std::string> m_filepaths;
+
+        public:
+            ScratchFiles(){
+
+            }
+
+            ~ScratchFiles(){
+                for (size_t i = 0; i < this->m_filepaths.size(); ++i){
+                    std::remove(this->m_filepaths[i].c_str());
+                }
+            }
+
+            // returns the path of a scratch file, removing any left over by an earlier run
+            std::string add(const std::string& filepath){
+                std::remove(filepath.c_str());
+                this->m_filepaths.push_back(filepath);
+                return this->m_filepaths.back();
+            }
+    };
+
+
+    //------------------------------------------------------------------
+    // pool
+
+    // returns the line numbers and outcomes of results, in order
+    std::vector<std::pair<size_t, int> > LinesAndOutcomes(const std::vector<BatchVerifier::Result>& results){
+        std::vector<std::pair<size_t, int> > linesAndOutcomes;
+        for (size_t i = 0; i < results.size(); ++i){
+            linesAndOutcomes.push_back(std::make_pair(results[i].m_lineNumber, results[i].m_outcome));
+        }
+        return linesAndOutcomes;
+    }
+
+    // pool test - every item runs exactly once on a valid worker, and batch results do not depend on the thread count
+    void TestPool(){
+        // item counts below, at and well above the thread counts, so some workers steal and some have nothing to do
+        const size_t threadCounts[] = { 1, 2, 3, 4, 8 };
+        const size_t itemCounts[] = { 0, 1, 2, 3, 7, 64, 1000, 100003 };
+        for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t){
+            const VerificationWorkerPool pool(threadCounts[t]);
+            Check(pool.getThreadCount() == threadCounts[t], "thread count " + std::to_string(threadCounts[t]));
+            for (size_t c = 0; c < sizeof(itemCounts) / sizeof(itemCounts[0]); ++c){
+                const std::string name = std::to_string(threadCounts[t]) + " threads, " + std::to_string(itemCounts[c]) + " items";
+                std::unique_ptr<std::atomic<unsigned int>[]> pRuns(new std::atomic<unsigned int>[itemCounts[c] + 1]);
+                for (size_t i = 0; i <= itemCounts[c]; ++i){
+                    pRuns[i] = 0;
+                }
+                std::atomic<bool> badWorker(false);
+                pool.run(itemCounts[c], [&pRuns, &badWorker, &pool](const size_t itemIndex, const size_t workerIndex){
+                    ++pRuns[itemIndex];
+                    if (workerIndex >= pool.getThreadCount()){
+                        badWorker = true;
+                    }
+                });
+                bool once = true;
+                for (size_t i = 0; i < itemCounts[c]; ++i){
+                    once = once && (pRuns[i] == 1);
+                }
+                Check(once == true, name + ": every item runs exactly once");
+                Check(badWorker == false, name + ": worker indexes in range");
+            }
+
+            // an item that throws does not stop the others; the exception reaches the caller
+            std::unique_ptr<std::atomic<unsigned int>[]> pRuns(new std::atomic<unsigned int>[100]);
+            for (size_t i = 0; i < 100; ++i){
+                pRuns[i] = 0;
+            }
+            CheckThrows([&pool, &pRuns](){
+                pool.run(100, [&pRuns](const size_t itemIndex, const size_t){
+                    ++pRuns[itemIndex];
+                    if ((itemIndex % 10) == 3){
+                        throw std::runtime_error("item failed");
+                    }
+                });
+            }, std::to_string(threadCounts[t]) + " threads: exception rethrown");
+            bool once = true;
+            for (size_t i = 0; i < 100; ++i){
+                once = once && (pRuns[i] == 1);
+            }
+            Check(once == true, std::to_string(threadCounts[t]) + " threads: items after a failure still run once");
+        }
+
+        // batch results are in manifest order and identical for every thread count
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+        std::vector<TestRecord> records;
+        for (size_t i = 0; i < 8; ++i){
+            const std::vector<TestRecord> keyRecords(BuildRecords(((i % 2) == 0) ? key1024 : key2048));
+            records.insert(records.end(), keyRecords.begin(), keyRecords.end());
+        }
+        std::istringstream manifestStream("# comment line\n\n" + BuildManifest(records) + "0g12 00112233445566778899aabbccddeeff\n");
+        const BatchVerifier manifest(manifestStream);
+        const std::vector<std::pair<size_t, int> > expected(LinesAndOutcomes(manifest.verifyAll(1)));
+        Check(expected.size() == records.size() + 1, "every record reported");
+        for (size_t i = 0; i < records.size(); ++i){
+            Check(expected[i].first == 3 + i && (expected[i].second == RETCODE_SUCCESS) == records[i].m_valid,
+                  "single-threaded outcome of line " + std::to_string(3 + i));
+        }
+        Check(expected.back().second == RETCODE_INPUT_ERROR, "bad hex is an input error");
+        for (size_t threads = 2; threads <= 8; threads *= 2){
+            Check(LinesAndOutcomes(manifest.verifyAll(threads)) == expected, std::to_string(threads) + " threads agree with one");
+            std::ostringstream single;
+            std::ostringstream multi;
+            manifest.run(single, 1);
+            manifest.run(multi, threads);
+            Check(multi.str() == single.str(), std::to_string(threads) + " threads write the same results as one");
+        }
+    }
+
+    //------------------------------------------------------------------
+    // hex
+
+    // returns true for the separator characters the decoders skip
+    bool IsSeparator(const char c){
+        return c == ':' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // straightforward decoder following HexDecoder's documented rules, the reference for the others
+    bool ReferenceDecode(const std::string& text, std::vector<byte>& out, size_t& errorOffset){
+        std::vector<byte> decoded;
+        int highNibble = -1;
+        size_t highOffset = 0;
+        for (size_t i = 0; i < text.length(); ++i){
+            const char c = text[i];
+            int nibble = -1;
+            if (c >= '0' && c <= '9'){
+                nibble = c - '0';
+            }else if (c >= 'A' && c <= 'F'){
+                nibble = c - 'A' + 10;
+            }else if (c >= 'a' && c <= 'f'){
+                nibble = c - 'a' + 10;
+            }else if (IsSeparator(c) == true){
+                continue;
+            }else{
+                errorOffset = i;
+                return false;
+            }
+            if (highNibble < 0){
+                highNibble = nibble;
+                highOffset = i;
+            }else{
+                decoded.push_back(static_cast<byte>((highNibble << 4) | nibble));
+                highNibble = -1;
+            }
+        }
+        if (highNibble >= 0){
+            errorOffset = highOffset;
+            return false;
+        }
+        out.insert(out.end(), decoded.begin(), decoded.end());
+        return true;
+    }
+
+    // returns the hex text of bytes in upper, lower or mixed case, with separators inserted at random if asked
+    std::string RandomHexText(const std::vector<byte>& bytes, const bool separators){
+        static const char UPPER[] = "0123456789ABCDEF";
+        static const char LOWER[] = "0123456789abcdef";
+        static const char SEPARATORS[] = ":: \t\r\n";
+        const int caseMode = static_cast<int>(g_random() % 3);
+        std::string text;
+        for (size_t i = 0; i < bytes.size(); ++i){
+            for (int half = 0; half < 2; ++half){
+                if (separators == true){
+                    while ((g_random() % 4) == 0){
+                        text += SEPARATORS[g_random() % (sizeof(SEPARATORS) - 1)];
+                    }
+                }
+                const int nibble = (half == 0) ? (bytes[i] >> 4) : (bytes[i] & 0x0F);
+                const bool upper = (caseMode == 0) || (caseMode == 2 && (g_random() % 2) == 0);
+                text += upper ? UPPER[nibble] : LOWER[nibble];
+            }
+        }
+        if (separators == true && (g_random() % 2) == 0){
+            text += ':';
+        }
+        return text;
+    }
+
+    // calls check(text, what) on valid, separated and invalid hex text of many lengths
+    template<typename CheckFunction>
+    void ForEachHexText(CheckFunction check){
+        // every length around the 32 and 64 character vector steps, plain and with separators
+        for (size_t length = 0; length <= 140; ++length){
+            const std::vector<byte> bytes(RandomBytes(length));
+            check(RandomHexText(bytes, false), "plain length " + std::to_string(length));
+            check(RandomHexText(bytes, true), "separated length " + std::to_string(length));
+        }
+
+        // an invalid character at every position; the characters next to the digit and letter ranges
+        const char INVALID[] = { '/', ';', '@', 'G', '`', 'g', 'z', '\0', '\x7F', '\x80', '\xFF', '\v', '-' };
+        const std::string valid(RandomHexText(RandomBytes(75), false));
+        for (size_t position = 0; position < valid.length(); ++position){
+            std::string text(valid);
+            text[position] = INVALID[position % sizeof(INVALID)];
+            check(text, "invalid at " + std::to_string(position));
+        }
+
+        // an unpaired last digit, alone, after separators and followed by separators
+        const char* const UNPAIRED[] = { "A", "0", "abc", "01:23:4", "0123456789abcdef0123456789abcdef0", "12 ::\n", "::\t f" };
+        for (size_t i = 0; i < sizeof(UNPAIRED) / sizeof(UNPAIRED[0]); ++i){
+            check(UNPAIRED[i], std::string("unpaired '") + UNPAIRED[i] + "'");
+        }
+
+        // text of separators only decodes to nothing
+        check(":: \r\n\t", "separators only");
+    }
+
+    // decodes text with every supported implementation, checking each against the reference decoder
+    void CheckDecoders(const std::string& text, const std::string& what){
+        const std::vector<byte> PREFIX(3, 0xA5);
+        std::vector<byte> expected(PREFIX);
+        size_t expectedErrorOffset = 0;
+        const bool expectedOk = ReferenceDecode(text, expected, expectedErrorOffset);
+
+        for (int impl = 0; impl < HexDecoder::IMPLEMENTATION_COUNT; ++impl){
+            const HexDecoder::Implementation implementation = static_cast<HexDecoder::Implementation>(impl);
+            if (HexDecoder::isSupported(implementation) == false){
+                continue;
+            }
+            const std::string name = std::string(HexDecoder::getImplementationName(implementation)) + " " + what;
+
+            // output is appended on success and left unchanged on failure
+            std::vector<byte> decoded(PREFIX);
+            size_t errorOffset = 0;
+            const bool ok = HexDecoder::decode(implementation, text.data(), text.length(), decoded, errorOffset);
+            Check(ok == expectedOk, name + ": validity");
+            if (ok == true){
+                Check(decoded == expected, name + ": bytes");
+            }else{
+                Check(decoded == PREFIX, name + ": output unchanged on error");
+                Check(errorOffset == expectedErrorOffset, name + ": error offset");
+            }
+        }
+    }
+
+    // hex test - every decoder against the reference on valid, separated and invalid text of many lengths
+    void TestHex(){
+        ForEachHexText(CheckDecoders);
+
+        // the HexUtilities wrappers throw on invalid text
+        const std::vector<byte> bytes(RandomBytes(40));
+        Check(Convert_ASCIIHex_To_Byte(RandomHexText(bytes, true)) == bytes, "Convert_ASCIIHex_To_Byte");
+        CheckThrows([](){ Convert_ASCIIHex_To_Byte(std::string("12G4")); }, "Convert_ASCIIHex_To_Byte rejects 'G'");
+        CheckThrows([](){ Convert_ASCIIHex_To_Byte(std::string("123")); }, "Convert_ASCIIHex_To_Byte rejects an odd digit count");
+        const std::string text(ToHex(bytes));
+        std::vector<byte> buffer((text.length() + 1) / 2);
+        Check(Convert_ASCIIHex_To_Byte(text.data(), text.length(), buffer.data()) == bytes.size() && buffer == bytes,
+              "Convert_ASCIIHex_To_Byte into a buffer");
+    }
+
+    //------------------------------------------------------------------
+    // hex-stream
+
+    // decodes text with HexStreamDecoder on every supported implementation, fed in random chunks,
+    // checking each against the reference decoder
+    void CheckStreamDecoders(const std::string& text, const std::string& what){
+        const std::vector<byte> PREFIX(3, 0xA5);
+        std::vector<byte> expected(PREFIX);
+        size_t expectedErrorOffset = 0;
+        const bool expectedOk = ReferenceDecode(text, expected, expectedErrorOffset);
+
+        for (int impl = 0; impl < HexDecoder::IMPLEMENTATION_COUNT; ++impl){
+            const HexDecoder::Implementation implementation = static_cast<HexDecoder::Implementation>(impl);
+            if (HexDecoder::isSupported(implementation) == false){
+                continue;
+            }
+            const std::string name = std::string(HexDecoder::getImplementationName(implementation)) + " " + what;
+
+            // the stream decoder gives the same bytes and error offset however the text is split
+            HexStreamDecoder streamDecoder(implementation);
+            std::vector<byte> streamed(PREFIX);
+            bool streamOk = true;
+            size_t offset = 0;
+            while (offset < text.length() && streamOk == true){
+                const size_t chunk = std::min<size_t>(text.length() - offset, g_random() % 80);
+                streamOk = streamDecoder.feed(text.data() + offset, chunk, streamed);
+                offset += chunk;
+            }
+            streamOk = streamOk && streamDecoder.finish();
+            Check(streamOk == expectedOk, name + ": stream validity");
+            if (streamOk == true){
+                Check(streamed == expected, name + ": stream bytes");
+            }else{
+                Check(streamDecoder.getErrorOffset() == expectedErrorOffset, name + ": stream error offset");
+                const bool unpaired = (expectedErrorOffset < text.length() &&
+                                       ((text[expectedErrorOffset] >= '0' && text[expectedErrorOffset] <= '9') ||
+                                        (text[expectedErrorOffset] >= 'A' && text[expectedErrorOffset] <= 'F') ||
+                                        (text[expectedErrorOffset] >= 'a' && text[expectedErrorOffset] <= 'f')));
+                Check(streamDecoder.isErrorUnpairedDigit() == unpaired, name + ": stream error kind");
+            }
+        }
+    }
+
+    // hex stream test - HexStreamDecoder against the reference on the hex test's texts split at random, and StringReplaceAll
+    void TestHexStream(){
+        ForEachHexText(CheckStreamDecoders);
+
+        // replacements are made left to right without rescanning replaced text
+        const char* const CASES[][4] = { { "aa:bb:cc", ":", "", "aabbcc" }, { "::::", "::", ":", "::" }, { "aaa", "a", "aa", "aaaaaa" },
+                                         { "abcabc", "abc", "", "" }, { "abc", "", "x", "abc" }, { "", ":", "", "" } };
+        for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); ++i){
+            std::string text(CASES[i][0]);
+            StringReplaceAll(text, CASES[i][1], CASES[i][2]);
+            Check(text == CASES[i][3], std::string("StringReplaceAll on '") + CASES[i][0] + "'");
+        }
+        std::string separated(RandomHexText(RandomBytes(200000), true));
+        StringReplaceAll(separated, ":", "");
+        Check(separated.find(':') == std::string::npos, "StringReplaceAll on a long line");
+    }
+
+    //------------------------------------------------------------------
+    // status
+
+    // returns the records of 1024, 2048 and 1536 bit and exponent 3 keys (see BuildRecords), the first
+    // 1024 bit record truncated at every length, and that record with an unsupported key encoding
+    std::vector<TestRecord> BuildVerificationRecords(){
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+        const TestKey key1536(1536, 65537);
+        const TestKey keyExponent3(1024, 3);
+        const TestKey* const keys[] = { &key1024, &key2048, &key1536, &keyExponent3 };
+
+        std::vector<TestRecord> records;
+        for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k){
+            const std::vector<TestRecord> keyRecords(BuildRecords(*keys[k]));
+            records.insert(records.end(), keyRecords.begin(), keyRecords.end());
+        }
+        for (size_t length = 0; length < records[0].m_iobuf.size(); ++length){
+            records.push_back(records[0]);
+            records.back().m_iobuf.resize(length);
+            records.back().m_valid = false;
+        }
+        records.push_back(records[0]);
+        records.back().m_iobuf[2] = 0x7F;
+        records.back().m_valid = false;
+        return records;
+    }
+
+    // parses and verifies one record with the throwing API; returns true if it verified
+    bool VerifyThrowing(const TestRecord& record){
+        try{
+            const CoolkeyRSAKeyGenResult keyGenResult(record.m_iobuf);
+            keyGenResult.verifySignature(record.m_wrappedKey);
+        }catch (std::runtime_error&){
+            return false;
+        }
+        return true;
+    }
+
+    // parses and verifies one record with the status-returning API; returns true if it verified
+    bool VerifyStatus(const TestRecord& record){
+        CoolkeyRSAKeyGenResultView view;
+        if (view.tryParse(record.m_iobuf.data(), record.m_iobuf.size()).isOk() == false){
+            return false;
+        }
+        return CoolkeyRSAKeyGenResult::tryVerifySignature(view, record.m_wrappedKey.data(), record.m_wrappedKey.size()).isOk();
+    }
+
+    // status test - the throwing and status-returning APIs give the right outcome on valid, damaged and truncated records
+    void TestStatus(){
+        const std::vector<TestRecord> records(BuildVerificationRecords());
+        for (size_t i = 0; i < records.size(); ++i){
+            const std::string name = "record " + std::to_string(i);
+            Check(VerifyStatus(records[i]) == records[i].m_valid, name + ": status API outcome");
+            Check(VerifyThrowing(records[i]) == records[i].m_valid, name + ": throwing API outcome");
+        }
+    }
+
+    //------------------------------------------------------------------
+    // verifier
+
+    // verifier test - reused and OpenSSL-only CoolkeyRSAVerifier state verifies as the per-call path does
+    void TestVerifier(){
+        const std::vector<TestRecord> records(BuildVerificationRecords());
+        CoolkeyRSAVerifier verifier;
+        CoolkeyRSAVerifier openSSLVerifier(false);
+        for (size_t i = 0; i < records.size(); ++i){
+            const TestRecord& record = records[i];
+            CoolkeyRSAKeyGenResultView view;
+            if (view.tryParse(record.m_iobuf.data(), record.m_iobuf.size()).isOk() == false){
+                continue;
+            }
+            const std::string name = "record " + std::to_string(i);
+            const CoolkeyStatus perCall = CoolkeyRSAKeyGenResult::tryVerifySignature(view, record.m_wrappedKey.data(), record.m_wrappedKey.size());
+            const CoolkeyStatus reused = verifier.verify(view, record.m_wrappedKey.data(), record.m_wrappedKey.size());
+            const CoolkeyStatus openSSL = openSSLVerifier.verify(view, record.m_wrappedKey.data(), record.m_wrappedKey.size());
+            Check(perCall.isOk() == record.m_valid, name + ": per-call outcome");
+            Check(reused.getCode() == perCall.getCode(), name + ": reused and per-call verification agree");
+            Check(openSSL.getCode() == perCall.getCode(), name + ": OpenSSL-only and per-call verification agree");
+        }
+    }
+
+    //------------------------------------------------------------------
+    // sha1
+
+    // SHA-1 test - every MultiBufferSHA1 implementation against EVP, for every group size and many lengths,
+    // and grouped digests verifying as the per-call path does
+    void TestSHA1(){
+        EVP_MD_CTX* const pContext = EVP_MD_CTX_create();
+        if (pContext == nullptr){
+            throw std::runtime_error("Unable to create EVP_MD_CTX.");
+        }
+
+        for (size_t count = 1; count <= MultiBufferSHA1::MAX_LANES; ++count){
+            // part lengths straddle the 55/56/64 byte padding boundaries; groups mix long and short messages
+            std::vector<std::vector<byte> > parts(2 * count);
+            std::vector<MultiBufferSHA1::Message> messages(count);
+            for (size_t i = 0; i < parts.size(); ++i){
+                parts[i] = RandomBytes(((g_random() % 4) == 0) ? (g_random() % 600) : (g_random() % 140));
+            }
+            std::vector<byte> expected(count * MultiBufferSHA1::DIGEST_LENGTH);
+            for (size_t i = 0; i < count; ++i){
+                messages[i].m_pPart1 = parts[2 * i].data();
+                messages[i].m_part1Length = parts[2 * i].size();
+                messages[i].m_pPart2 = parts[2 * i + 1].data();
+                messages[i].m_part2Length = parts[2 * i + 1].size();
+                if (EVP_DigestInit_ex(pContext, EVP_sha1(), nullptr) != 1 ||
+                    EVP_DigestUpdate(pContext, messages[i].m_pPart1, messages[i].m_part1Length) != 1 ||
+                    EVP_DigestUpdate(pContext, messages[i].m_pPart2, messages[i].m_part2Length) != 1 ||
+                    EVP_DigestFinal_ex(pContext, expected.data() + i * MultiBufferSHA1::DIGEST_LENGTH, nullptr) != 1){
+                    EVP_MD_CTX_destroy(pContext);
+                    throw std::runtime_error("EVP SHA-1 failed.");
+                }
+            }
+
+            std::vector<byte> digests(count * MultiBufferSHA1::DIGEST_LENGTH);
+            byte (* const pDigests)[MultiBufferSHA1::DIGEST_LENGTH] = reinterpret_cast<byte (*)[MultiBufferSHA1::DIGEST_LENGTH]>(digests.data());
+            for (int impl = 0; impl < MultiBufferSHA1::IMPLEMENTATION_COUNT; ++impl){
+                const MultiBufferSHA1::Implementation implementation = static_cast<MultiBufferSHA1::Implementation>(impl);
+                if (MultiBufferSHA1::isSupported(implementation) == false){
+                    continue;
+                }
+                std::fill(digests.begin(), digests.end(), 0);
+                MultiBufferSHA1::hash(implementation, messages.data(), count, pDigests);
+                Check(digests == expected, std::string(MultiBufferSHA1::getImplementationName(implementation)) +
+                                           " digests of " + std::to_string(count) + " messages");
+            }
+            std::fill(digests.begin(), digests.end(), 0);
+            MultiBufferSHA1::hash(messages.data(), count, pDigests);
+            Check(digests == expected, "best implementation digests of " + std::to_string(count) + " messages");
+        }
+        EVP_MD_CTX_destroy(pContext);
+
+        // digests computed in one group (as batch verification does) give the per-call outcomes
+        const std::vector<TestRecord> records(BuildVerificationRecords());
+        std::vector<CoolkeyRSAKeyGenResultView> views;
+        std::vector<size_t> recordIndexes;
+        for (size_t i = 0; i < records.size() && views.size() < MultiBufferSHA1::MAX_LANES; ++i){
+            CoolkeyRSAKeyGenResultView view;
+            if (view.tryParse(records[i].m_iobuf.data(), records[i].m_iobuf.size()).isOk() == true){
+                views.push_back(view);
+                recordIndexes.push_back(i);
+            }
+        }
+        std::vector<MultiBufferSHA1::Message> messages(views.size());
+        for (size_t v = 0; v < views.size(); ++v){
+            messages[v].m_pPart1 = views[v].getBlob().getBlobData();
+            messages[v].m_part1Length = views[v].getBlob().getBlobSize();
+            messages[v].m_pPart2 = records[recordIndexes[v]].m_wrappedKey.data();
+            messages[v].m_part2Length = records[recordIndexes[v]].m_wrappedKey.size();
+        }
+        byte digests[MultiBufferSHA1::MAX_LANES][MultiBufferSHA1::DIGEST_LENGTH];
+        MultiBufferSHA1::hash(messages.data(), messages.size(), digests);
+        CoolkeyRSAVerifier verifier;
+        for (size_t v = 0; v < views.size(); ++v){
+            const TestRecord& record = records[recordIndexes[v]];
+            const CoolkeyStatus perCall = CoolkeyRSAKeyGenResult::tryVerifySignature(views[v], record.m_wrappedKey.data(), record.m_wrappedKey.size());
+            const CoolkeyStatus grouped = verifier.verifyDigest(views[v].getBlob(), views[v].getProofData(), views[v].getProofSize(), digests[v]);
+            Check(grouped.getCode() == perCall.getCode(), "record " + std::to_string(recordIndexes[v]) + ": digest and per-call verification agree");
+        }
+    }
+    //------------------------------------------------------------------
+    // rsa
+
+    // returns signature ^ 65537 mod modulus computed by OpenSSL as modulus-length big endian bytes
+    //   returns false if the signature is not less than the modulus (which FixedSizeRSA refuses)
+    bool PublicOperationBN(const std::vector<byte>& modulus, const std::vector<byte>& signature, std::vector<byte>& message){
+        BN_CTX* const pContext = BN_CTX_new();
+        BIGNUM* const pModulus = BN_bin2bn(modulus.data(), static_cast<int>(modulus.size()), nullptr);
+        BIGNUM* const pSignature = BN_bin2bn(signature.data(), static_cast<int>(signature.size()), nullptr);
+        BIGNUM* const pExponent = BN_new();
+        BIGNUM* const pMessage = BN_new();
+        if (pContext == nullptr || pModulus == nullptr || pSignature == nullptr || pExponent == nullptr || pMessage == nullptr ||
+            BN_set_word(pExponent, FixedSizeRSA::PUBLIC_EXPONENT) != 1){
+            throw std::runtime_error("Unable to create OpenSSL objects.");
+        }
+        const bool reduced = (BN_ucmp(pSignature, pModulus) < 0);
+        if (reduced == true){
+            if (BN_mod_exp(pMessage, pSignature, pExponent, pModulus, pContext) != 1){
+                throw std::runtime_error("BN_mod_exp failed.");
+            }
+            message.assign(modulus.size(), 0);
+            const size_t messageBytes = static_cast<size_t>(BN_num_bytes(pMessage));
+            BN_bn2bin(pMessage, message.data() + (modulus.size() - messageBytes));
+        }
+        BN_free(pMessage);
+        BN_free(pExponent);
+        BN_free(pSignature);
+        BN_free(pModulus);
+        BN_CTX_free(pContext);
+        return reduced;
+    }
+
+    // RSA test - every FixedSizeRSA implementation against OpenSSL, then verification outcomes with and without it
+    void TestRSA(){
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+
+        // moduli: the generated keys plus random odd 1024 and 2048 bit moduli
+        std::vector<std::vector<byte> > moduli;
+        std::vector<std::vector<byte> > proofs;
+        const TestKey* const keys[] = { &key1024, &key2048 };
+        for (size_t k = 0; k < 2; ++k){
+            Check(FixedSizeRSA::isSupportedKey(keys[k]->m_exponent.data(), keys[k]->m_exponent.size(),
+                                               keys[k]->m_modulus.data(), keys[k]->m_modulus.size()), "generated key is fixed-size");
+            const std::vector<byte> iobuf(keys[k]->sign(RandomBytes(WRAPPED_KEY_LENGTH)));
+            moduli.push_back(keys[k]->m_modulus);
+            proofs.push_back(std::vector<byte>(iobuf.end() - static_cast<std::ptrdiff_t>(keys[k]->m_modulus.size()), iobuf.end()));
+        }
+        for (size_t i = 0; i < 64; ++i){
+            std::vector<byte> modulus(RandomBytes(((i % 2) == 0) ? 1024 / 8 : 2048 / 8));
+            modulus.front() |= 0x80;
+            modulus.back() |= 0x01;
+            moduli.push_back(modulus);
+            proofs.push_back(std::vector<byte>());
+        }
+
+        // signatures: the proof, 0, 1, the modulus and the values just below it, all ones, and random values
+        std::vector<byte> expected;
+        std::vector<byte> actual;
+        for (size_t m = 0; m < moduli.size(); ++m){
+            const std::vector<byte>& modulus = moduli[m];
+            std::vector<std::vector<byte> > signatures;
+            if (proofs[m].empty() == false){
+                signatures.push_back(proofs[m]);
+            }
+            signatures.push_back(std::vector<byte>(modulus.size(), 0));
+            signatures.push_back(std::vector<byte>(modulus.size(), 0));
+            signatures.back().back() = 1;
+            for (byte subtrahend = 2; subtrahend > 0; --subtrahend){
+                signatures.push_back(modulus);
+                signatures.back().back() = static_cast<byte>(signatures.back().back() - subtrahend);
+            }
+            signatures.push_back(modulus);
+            signatures.push_back(std::vector<byte>(modulus.size(), 0xFF));
+            for (size_t r = 0; r < 8; ++r){
+                signatures.push_back(RandomBytes(modulus.size()));
+                if ((r % 2) == 0){
+                    signatures.back().front() &= 0x7F;
+                }
+            }
+
+            for (size_t s = 0; s < signatures.size(); ++s){
+                const bool reduced = PublicOperationBN(modulus, signatures[s], expected);
+                for (int impl = 0; impl < FixedSizeRSA::IMPLEMENTATION_COUNT; ++impl){
+                    const FixedSizeRSA::Implementation implementation = static_cast<FixedSizeRSA::Implementation>(impl);
+                    if (FixedSizeRSA::isSupported(implementation) == false){
+                        continue;
+                    }
+                    actual.assign(modulus.size(), 0);
+                    const bool accepted = FixedSizeRSA::publicOperation(implementation, modulus.data(), modulus.size(), signatures[s].data(), actual.data());
+                    Check(accepted == reduced && (reduced == false || actual == expected),
+                          std::string(FixedSizeRSA::getImplementationName(implementation)) + " matches OpenSSL on modulus " +
+                          std::to_string(m) + ", signature " + std::to_string(s));
+                }
+            }
+        }
+
+        // keys outside the fixed sizes are left to OpenSSL
+        const TestKey key1536(1536, 65537);
+        const TestKey keyExponent3(1024, 3);
+        Check(FixedSizeRSA::isSupportedKey(key1536.m_exponent.data(), key1536.m_exponent.size(),
+                                           key1536.m_modulus.data(), key1536.m_modulus.size()) == false, "1536 bit key is not fixed-size");
+        Check(FixedSizeRSA::isSupportedKey(keyExponent3.m_exponent.data(), keyExponent3.m_exponent.size(),
+                                           keyExponent3.m_modulus.data(), keyExponent3.m_modulus.size()) == false, "exponent 3 key is not fixed-size");
+
+        // verification outcomes with and without the fixed-size path
+        CoolkeyRSAVerifier fixedVerifier(true);
+        CoolkeyRSAVerifier openSSLVerifier(false);
+        const TestKey* const allKeys[] = { &key1024, &key2048, &key1536, &keyExponent3 };
+        for (size_t k = 0; k < sizeof(allKeys) / sizeof(allKeys[0]); ++k){
+            const std::vector<TestRecord> records(BuildRecords(*allKeys[k]));
+            for (size_t i = 0; i < records.size(); ++i){
+                CoolkeyRSAKeyGenResultView view;
+                if (view.tryParse(records[i].m_iobuf.data(), records[i].m_iobuf.size()).isOk() == false){
+                    continue;
+                }
+                const std::string name = "key " + std::to_string(k) + " record " + std::to_string(i);
+                const CoolkeyStatus fixedStatus = fixedVerifier.verify(view, records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size());
+                const CoolkeyStatus openSSLStatus = openSSLVerifier.verify(view, records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size());
+                Check(fixedStatus.getCode() == openSSLStatus.getCode(), name + ": fixed-size and OpenSSL verification agree");
+                Check(fixedStatus.isOk() == records[i].m_valid, name + ": outcome");
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+    // fixed-records
+
+    // collects dispatched key gen results
+    class RecordCollector{
+        public:
+            std::vector<FixedKeyGenResult<1024> > m_records1024;
+            std::vector<FixedKeyGenResult<2048> > m_records2048;
+            size_t m_genericCount;
+
+            RecordCollector() : m_genericCount(0){
+
+            }
+
+            void operator()(const FixedKeyGenResult<1024>& record){ this->m_records1024.push_back(record); }
+            void operator()(const FixedKeyGenResult<2048>& record){ this->m_records2048.push_back(record); }
+            void operator()(const CoolkeyRSAKeyGenResultView&){ ++this->m_genericCount; }
+    };
+
+    // fixed records test - records dispatched to FixedKeyGenResult copies verify exactly as their views do
+    void TestFixedRecords(){
+        const std::vector<TestRecord> records(BuildVerificationRecords());
+        CoolkeyRSAVerifier verifier;
+        size_t fixedCount = 0;
+        for (size_t i = 0; i < records.size(); ++i){
+            const TestRecord& record = records[i];
+            const std::string name = "record " + std::to_string(i);
+            CoolkeyRSAKeyGenResultView view;
+            const bool parsed = view.tryParse(record.m_iobuf.data(), record.m_iobuf.size()).isOk();
+
+            RecordCollector collector;
+            KeyGenResultDispatcher::tryParse(record.m_iobuf.data(), record.m_iobuf.size(), collector);
+            const size_t dispatched = collector.m_records1024.size() + collector.m_records2048.size() + collector.m_genericCount;
+            Check(dispatched == (parsed ? 1 : 0), name + ": dispatched once if it parses");
+            const size_t bits = parsed ? view.getBlob().getKeyLengthBits() : 0;
+            Check(collector.m_records1024.size() == ((bits == 1024) ? 1 : 0) && collector.m_records2048.size() == ((bits == 2048) ? 1 : 0),
+                  name + ": 1024 and 2048 bit keys get fixed-capacity records");
+            CoolkeyRSAKeyGenResultView fixedView;
+            if (collector.m_records1024.empty() == false){
+                fixedView = collector.m_records1024[0].getView();
+            }else if (collector.m_records2048.empty() == false){
+                fixedView = collector.m_records2048[0].getView();
+            }else{
+                continue;
+            }
+            ++fixedCount;
+            const CoolkeyStatus expected = verifier.verify(view, record.m_wrappedKey.data(), record.m_wrappedKey.size());
+            const CoolkeyStatus fixed = verifier.verify(fixedView, record.m_wrappedKey.data(), record.m_wrappedKey.size());
+            Check(fixed.getCode() == expected.getCode(), name + ": fixed-capacity record and view verification agree");
+        }
+        Check(fixedCount > 0, "fixed-capacity records verified");
+    }
+
+    //------------------------------------------------------------------
+    // archive
+
+    // reads and writes whole scratch files
+    std::vector<byte> ReadFileBytes(const std::string& filepath){
+        std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+        std::vector<byte> bytes(file ? static_cast<size_t>(file.tellg()) : 0);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file){
+            throw std::runtime_error("Unable to read '" + filepath + "'.");
+        }
+        return bytes;
+    }
+    void WriteFileBytes(const std::string& filepath, const std::vector<byte>& bytes){
+        std::ofstream file(filepath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        if (!file){
+            throw std::runtime_error("Unable to write '" + filepath + "'.");
+        }
+    }
+
+    // returns the outcome of each result by manifest line number
+    std::vector<int> OutcomesByLine(const std::vector<BatchVerifier::Result>& results, const size_t lineCount){
+        std::vector<int> outcomes(lineCount + 1, -1);
+        for (size_t i = 0; i < results.size(); ++i){
+            if (results[i].m_lineNumber < outcomes.size()){
+                outcomes[results[i].m_lineNumber] = results[i].m_outcome;
+            }
+        }
+        return outcomes;
+    }
+
+    // archive test - an archive verifies as its manifest does, and damage is reported instead of trusted
+    void TestArchive(){
+        ScratchFiles scratch;
+        const std::string archivePath = scratch.add("CKYEnrollmentTests_archive.cka");
+        const std::string damagedPath = scratch.add("CKYEnrollmentTests_damaged.cka");
+
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+        std::vector<TestRecord> records(BuildRecords(key1024));
+        const std::vector<TestRecord> records2048(BuildRecords(key2048));
+        records.insert(records.end(), records2048.begin(), records2048.end());
+        std::string manifestText("# comment line\n\n" + BuildManifest(records) + "0g12 00112233445566778899aabbccddeeff\n");
+        const size_t lineCount = 2 + records.size() + 1;
+
+        std::istringstream manifestStream(manifestText);
+        const BatchVerifier manifest(manifestStream);
+        std::ostringstream skipped;
+        EnrollmentArchiveWriter::convertManifest(manifest, archivePath, skipped);
+        Check(skipped.str().find(std::to_string(lineCount) + "\t" + std::to_string(RETCODE_INPUT_ERROR)) == 0,
+              "the record with bad hex is reported, not archived");
+
+        // same outcome for every archived record, in manifest order
+        const std::vector<BatchVerifier::Result> manifestResults(manifest.verifyAll(2));
+        const ArchiveBatchVerifier archive(archivePath);
+        Check(archive.getRecordCount() == records.size(), "archived record count");
+        const std::vector<BatchVerifier::Result> archiveResults(archive.verifyAll(2));
+        const std::vector<int> expectedOutcomes(OutcomesByLine(manifestResults, lineCount));
+        Check(archiveResults.size() == records.size(), "every archived record reported");
+        for (size_t i = 0; i < archiveResults.size(); ++i){
+            const size_t line = archiveResults[i].m_lineNumber;
+            Check(line == 3 + i, "archived line number " + std::to_string(line));
+            Check(archiveResults[i].m_outcome == expectedOutcomes[line], "archive and manifest agree on line " + std::to_string(line));
+            Check((archiveResults[i].m_outcome == RETCODE_SUCCESS) == records[i].m_valid, "archive outcome of line " + std::to_string(line));
+        }
+
+        // a damaged record (data, or a length field pointing past the record area) is reported as an
+        // input error; the others are unaffected
+        const std::vector<byte> original(ReadFileBytes(archivePath));
+        const size_t indexOffset = static_cast<size_t>(EnrollmentArchive::readUint64(original.data() + EnrollmentArchive::INDEX_OFFSET_OFFSET));
+        const size_t recordOffset = static_cast<size_t>(EnrollmentArchive::readUint64(original.data() + indexOffset + EnrollmentArchive::INDEX_ENTRY_LENGTH));
+        const size_t iobufSize = EnrollmentArchive::readUint32(original.data() + recordOffset);
+        std::vector<std::vector<byte> > damagedRecords;
+        const size_t damageTargets[] = { recordOffset + EnrollmentArchive::RECORD_HEADER_LENGTH + 10,          // iobuf byte
+                                         recordOffset + EnrollmentArchive::RECORD_HEADER_LENGTH + iobufSize,   // wrappedkey byte
+                                         recordOffset,                                                         // iobuf length
+                                         recordOffset + 5 };                                                   // wrappedkey length
+        for (size_t t = 0; t < sizeof(damageTargets) / sizeof(damageTargets[0]); ++t){
+            damagedRecords.push_back(original);
+            damagedRecords.back()[damageTargets[t]] ^= 0x40;
+        }
+        for (size_t field = 0; field < 2; ++field){
+            damagedRecords.push_back(original);
+            EnrollmentArchive::writeUint32(damagedRecords.back().data() + recordOffset + 4 * field, 0xFFFFFFFF);
+        }
+        for (size_t d = 0; d < damagedRecords.size(); ++d){
+            WriteFileBytes(damagedPath, damagedRecords[d]);
+            const std::string name = "damaged record " + std::to_string(d);
+
+            const EnrollmentArchiveReader reader(damagedPath);
+            EnrollmentArchiveReader::Record record;
+            const char* pError = nullptr;
+            Check(reader.tryGetRecord(0, record, pError), name + ": neighbouring record reads");
+            Check(reader.tryGetRecord(1, record, pError) == false && pError != nullptr, name + ": is reported");
+
+            const ArchiveBatchVerifier damagedArchive(damagedPath);
+            const std::vector<BatchVerifier::Result> damagedResults(damagedArchive.verifyAll(1));
+            Check(damagedResults.size() == archiveResults.size(), name + ": every record reported");
+            for (size_t i = 0; i < damagedResults.size() && i < archiveResults.size(); ++i){
+                Check(damagedResults[i].m_lineNumber == archiveResults[i].m_lineNumber, name + ": line numbers kept");
+                Check(damagedResults[i].m_outcome == ((i == 1) ? RETCODE_INPUT_ERROR : archiveResults[i].m_outcome),
+                      name + ": outcome of record " + std::to_string(i));
+            }
+        }
+
+        // damaged headers, indexes and truncated files are refused when the archive is opened
+        std::vector<std::vector<byte> > refused;
+        refused.push_back(std::vector<byte>(original.begin(), original.begin() + EnrollmentArchive::HEADER_LENGTH - 1));
+        refused.push_back(std::vector<byte>(original.begin(), original.end() - 1));
+        refused.push_back(std::vector<byte>(original.begin(), original.begin() + original.size() / 2));
+        refused.push_back(std::vector<byte>());
+        const size_t headerTargets[] = { 0, EnrollmentArchive::VERSION_OFFSET + 3, EnrollmentArchive::RECORD_COUNT_OFFSET + 7,
+                                         EnrollmentArchive::INDEX_OFFSET_OFFSET + 7, EnrollmentArchive::INDEX_CRC_OFFSET,
+                                         EnrollmentArchive::HEADER_CRC_OFFSET + 1, original.size() - 1,
+                                         original.size() - records.size() * EnrollmentArchive::INDEX_ENTRY_LENGTH };
+        for (size_t t = 0; t < sizeof(headerTargets) / sizeof(headerTargets[0]); ++t){
+            refused.push_back(original);
+            refused.back()[headerTargets[t]] ^= 0x01;
+        }
+        for (size_t r = 0; r < refused.size(); ++r){
+            WriteFileBytes(damagedPath, refused[r]);
+            CheckThrows([&damagedPath](){ EnrollmentArchiveReader damagedReader(damagedPath); }, "damaged archive " + std::to_string(r) + " is refused");
+        }
+        CheckThrows([](){ EnrollmentArchiveReader missingReader("CKYEnrollmentTests_missing.cka"); }, "missing archive is refused");
+    }
+
+    //------------------------------------------------------------------
+    // cache
+
+    // flips the bits of mask in one byte of a file, in place
+    void FlipFileByte(const std::string& filepath, const size_t offset, const byte mask){
+        std::fstream file(filepath, std::ios::binary | std::ios::in | std::ios::out);
+        char value = 0;
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.get(value);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(static_cast<char>(value ^ static_cast<char>(mask)));
+        if (!file){
+            throw std::runtime_error("Unable to modify '" + filepath + "'.");
+        }
+    }
+
+    // cache test - hits, misses and expiry in both tiers, damaged or oversized persistent entries, and slots left mid-write
+    void TestCache(){
+        const std::vector<byte> iobuf(RandomBytes(300));
+        const std::vector<byte> wrappedKey(RandomBytes(WRAPPED_KEY_LENGTH));
+        const std::vector<byte> payload(RandomBytes(200));
+        std::vector<byte> found;
+
+        // memory tier
+        {
+            ResultCache cache(64);
+            const ResultCache::Key key = cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size());
+            const ResultCache::Key otherKey = cache.computeKey(iobuf.data(), iobuf.size() - 1, wrappedKey.data(), wrappedKey.size());
+            Check((key == otherKey) == false, "requests differing in one byte get different keys");
+            Check(cache.tryGet(key, found) == false, "empty cache misses");
+            cache.put(key, payload);
+            Check(cache.tryGet(key, found) == true && found == payload, "stored response is found");
+            Check(cache.tryGet(otherKey, found) == false, "other request misses");
+            Check(cache.getLookupCount(ResultCache::LOOKUP_HIT) == 1 && cache.getLookupCount(ResultCache::LOOKUP_MISS) == 2, "lookup counts");
+
+            // the least recently used responses are evicted once every shard is full
+            for (size_t i = 0; i < 64 * ResultCache::SHARD_COUNT; ++i){
+                const std::vector<byte> filler(RandomBytes(32));
+                cache.put(cache.computeKey(filler.data(), filler.size(), nullptr, 0), payload);
+            }
+            Check(cache.tryGet(key, found) == false, "evicted response misses");
+        }
+
+#if defined(__unix__) || defined(__APPLE__)
+        ScratchFiles scratch;
+        const std::string cachePath = scratch.add("CKYEnrollmentTests_cache.rcac");
+        const std::string expiringPath = scratch.add("CKYEnrollmentTests_expiring.rcac");
+
+        // persistent tier: responses survive a restart; oversized ones are kept in memory only
+        const std::vector<byte> largePayload(RandomBytes(ResultCache::MAX_PERSISTENT_PAYLOAD + 1));
+        const std::vector<byte> largeIobuf(RandomBytes(301));
+        {
+            ResultCache cache(64, cachePath);
+            Check(cache.hasPersistentTier(), "persistent tier created");
+            cache.put(cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size()), payload);
+            const ResultCache::Key largeKey = cache.computeKey(largeIobuf.data(), largeIobuf.size(), wrappedKey.data(), wrappedKey.size());
+            cache.put(largeKey, largePayload);
+            Check(cache.tryGet(largeKey, found) == true && found == largePayload, "oversized response is kept in memory");
+        }
+        {
+            ResultCache cache(64, cachePath);
+            const ResultCache::Key key = cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size());
+            Check(cache.tryGet(key, found) == true && found == payload, "persistent response found after a restart");
+            Check(cache.getLookupCount(ResultCache::LOOKUP_PERSISTENT_HIT) == 1, "answered from the persistent tier");
+            Check(cache.tryGet(key, found) == true && cache.getLookupCount(ResultCache::LOOKUP_HIT) == 1, "then answered from memory");
+            const ResultCache::Key largeKey = cache.computeKey(largeIobuf.data(), largeIobuf.size(), wrappedKey.data(), wrappedKey.size());
+            Check(cache.tryGet(largeKey, found) == false, "oversized response was not persisted");
+        }
+
+        // a slot whose payload no longer matches its checksum is a miss
+        const std::vector<byte> file(ReadFileBytes(cachePath));
+        const std::vector<byte>::const_iterator stored = std::search(file.begin(), file.end(), payload.begin(), payload.end());
+        Check(stored != file.end(), "response stored in the persistent file");
+        FlipFileByte(cachePath, static_cast<size_t>(stored - file.begin()) + 7, 0x01);
+        {
+            ResultCache cache(64, cachePath);
+            Check(cache.tryGet(cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size()), found) == false,
+                  "damaged persistent slot misses");
+        }
+
+        // a slot left odd by a writer killed mid-write is emptied (with an even version) when the file is next opened,
+        // and its bucket is written again
+        {
+            ResultCache cache(64, cachePath);
+            cache.put(cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size()), payload);
+        }
+        const size_t SLOT_HEADER_LENGTH = ResultCache::PERSISTENT_SLOT_LENGTH - ResultCache::MAX_PERSISTENT_PAYLOAD;
+        const std::vector<byte> rewrittenFile(ReadFileBytes(cachePath));
+        const size_t slotOffset = static_cast<size_t>(std::search(rewrittenFile.begin(), rewrittenFile.end(), payload.begin(), payload.end()) - rewrittenFile.begin()) - SLOT_HEADER_LENGTH;
+        Check(slotOffset < rewrittenFile.size() && (slotOffset % ResultCache::PERSISTENT_SLOT_LENGTH) == 0, "rewritten response found in its slot");
+        uint64_t slotVersion = 0;
+        std::memcpy(&slotVersion, &rewrittenFile[slotOffset], sizeof(slotVersion));
+        Check(slotVersion != 0 && (slotVersion & 1) == 0, "written slot has an even version");
+        // bit 0 of the version, in host byte order
+        const uint64_t ONE = 1;
+        FlipFileByte(cachePath, slotOffset + ((*reinterpret_cast<const byte*>(&ONE) == 1) ? 0 : sizeof(slotVersion) - 1), 0x01);
+        std::memcpy(&slotVersion, &ReadFileBytes(cachePath)[slotOffset], sizeof(slotVersion));
+        Check((slotVersion & 1) != 0, "slot left mid-write");
+        {
+            ResultCache cache(64, cachePath);
+            Check(cache.tryGet(cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size()), found) == false,
+                  "slot left mid-write misses");
+        }
+        const std::vector<byte> recoveredFile(ReadFileBytes(cachePath));
+        uint64_t recoveredVersion = 0;
+        std::memcpy(&recoveredVersion, &recoveredFile[slotOffset], sizeof(recoveredVersion));
+        Check(recoveredVersion == slotVersion + 1, "slot left mid-write given the next even version on open");
+        Check(std::all_of(recoveredFile.begin() + static_cast<std::ptrdiff_t>(slotOffset + sizeof(recoveredVersion)),
+                          recoveredFile.begin() + static_cast<std::ptrdiff_t>(slotOffset + SLOT_HEADER_LENGTH), [](const byte b){ return b == 0; }),
+              "slot left mid-write emptied on open");
+        {
+            ResultCache cache(64, cachePath);
+            cache.put(cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size()), payload);
+        }
+        {
+            ResultCache cache(64, cachePath);
+            Check(cache.tryGet(cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size()), found) == true && found == payload,
+                  "recovered slot stores responses again");
+        }
+
+        // responses expire in both tiers
+        {
+            ResultCache cache(64, expiringPath, 1);
+            const ResultCache::Key key = cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size());
+            cache.put(key, payload);
+            Check(cache.tryGet(key, found) == true, "response found within its time to live");
+            std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+            Check(cache.tryGet(key, found) == false, "expired response misses in memory");
+        }
+        {
+            ResultCache cache(64, expiringPath, 1);
+            Check(cache.tryGet(cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size()), found) == false,
+                  "expired response misses in the persistent tier");
+        }
+#else
+        std::cout << "persistent tier not supported on this platform; skipped" << std::endl;
+        {
+            ResultCache cache(64, std::string(), 1);
+            const ResultCache::Key key = cache.computeKey(iobuf.data(), iobuf.size(), wrappedKey.data(), wrappedKey.size());
+            cache.put(key, payload);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+            Check(cache.tryGet(key, found) == false, "expired response misses in memory");
+        }
+#endif
+    }
+
+    //------------------------------------------------------------------
+    // index
+
+    // returns the outcomes of results in order
+    std::vector<int> Outcomes(const std::vector<BatchVerifier::Result>& results){
+        std::vector<int> outcomes;
+        for (size_t i = 0; i < results.size(); ++i){
+            outcomes.push_back(results[i].m_outcome);
+        }
+        return outcomes;
+    }
+
+    // index test - fingerprints, recording and lookup across reopening and growth, and replayed batches
+    void TestIndex(){
+        const TestKey key(1024, 65537);
+
+        // leading zero bytes do not change a fingerprint; the exponent does
+        byte fingerprint[KeyFingerprintIndex::FINGERPRINT_LENGTH];
+        byte paddedFingerprint[KeyFingerprintIndex::FINGERPRINT_LENGTH];
+        std::vector<byte> paddedModulus(2, 0);
+        paddedModulus.insert(paddedModulus.end(), key.m_modulus.begin(), key.m_modulus.end());
+        const std::vector<byte> paddedExponent(1, 0);
+        const byte exponent3 = 3;
+        Check(KeyFingerprintIndex::tryComputeFingerprint(key.m_modulus.data(), key.m_modulus.size(),
+                                                         key.m_exponent.data(), key.m_exponent.size(), fingerprint), "fingerprint");
+        std::vector<byte> exponent(paddedExponent);
+        exponent.insert(exponent.end(), key.m_exponent.begin(), key.m_exponent.end());
+        Check(KeyFingerprintIndex::tryComputeFingerprint(paddedModulus.data(), paddedModulus.size(),
+                                                         exponent.data(), exponent.size(), paddedFingerprint) &&
+              std::memcmp(fingerprint, paddedFingerprint, sizeof(fingerprint)) == 0, "leading zero bytes are ignored");
+        Check(KeyFingerprintIndex::tryComputeFingerprint(key.m_modulus.data(), key.m_modulus.size(), &exponent3, 1, paddedFingerprint) &&
+              std::memcmp(fingerprint, paddedFingerprint, sizeof(fingerprint)) != 0, "the exponent is part of the fingerprint");
+
+#if defined(__unix__) || defined(__APPLE__)
+        ScratchFiles scratch;
+        const std::string indexPath = scratch.add("CKYEnrollmentTests_index.kidx");
+        scratch.add(indexPath + ".lock");
+        const std::string replayPath = scratch.add("CKYEnrollmentTests_replay.kidx");
+        scratch.add(replayPath + ".lock");
+        const std::string archivePath = scratch.add("CKYEnrollmentTests_replay.cka");
+
+        // recording, and finding again after reopening
+        const std::vector<byte> otherFingerprint(RandomBytes(KeyFingerprintIndex::FINGERPRINT_LENGTH));
+        KeyFingerprintIndex::Entry entry;
+        {
+            KeyFingerprintIndex index(indexPath);
+            Check(index.find(fingerprint, entry) == false, "new index is empty");
+            Check(index.findOrInsert(fingerprint, entry) == false && entry.m_sequence == 1, "first key recorded");
+            Check(index.findOrInsert(fingerprint, entry) == true && entry.m_sequence == 1, "first key found");
+            Check(index.findOrInsert(otherFingerprint.data(), entry) == false && entry.m_sequence == 2, "second key recorded");
+            Check(index.getCount() == 2, "key count");
+        }
+        {
+            KeyFingerprintIndex index(indexPath, KeyFingerprintIndex::MODE_READ_ONLY);
+            Check(index.isReadOnly(), "read-only mode");
+            Check(index.find(fingerprint, entry) == true && entry.m_sequence == 1, "key found after reopening");
+            const std::vector<byte> newFingerprint(RandomBytes(KeyFingerprintIndex::FINGERPRINT_LENGTH));
+            Check(index.findOrInsert(newFingerprint.data(), entry) == false && index.find(newFingerprint.data(), entry) == false,
+                  "read-only index records nothing");
+            Check(index.getCount() == 2, "read-only key count");
+        }
+        CheckThrows([](){ KeyFingerprintIndex missing("CKYEnrollmentTests_missing.kidx", KeyFingerprintIndex::MODE_READ_ONLY); },
+                    "missing read-only index is refused");
+
+        // growth past half the initial capacity keeps every key; a key repeated within a call is found the second time
+        {
+            KeyFingerprintIndex index(indexPath);
+            const size_t BATCH = 4096;
+            const size_t batchCount = static_cast<size_t>(KeyFingerprintIndex::INITIAL_CAPACITY / 2) / BATCH + 2;
+            std::vector<std::vector<byte> > fingerprints(batchCount);
+            std::vector<KeyFingerprintIndex::Entry> entries(BATCH);
+            std::unique_ptr<bool[]> pFound(new bool[BATCH]);
+            std::vector<const byte*> pointers(BATCH);
+            size_t newCount = 0;
+            for (size_t b = 0; b < batchCount; ++b){
+                fingerprints[b] = RandomBytes(BATCH * KeyFingerprintIndex::FINGERPRINT_LENGTH);
+                for (size_t i = 0; i < BATCH; ++i){
+                    pointers[i] = fingerprints[b].data() + i * KeyFingerprintIndex::FINGERPRINT_LENGTH;
+                }
+                pointers[BATCH - 1] = pointers[0];
+                index.findOrInsertAll(pointers.data(), BATCH, entries.data(), pFound.get());
+                for (size_t i = 0; i < BATCH - 1; ++i){
+                    Check(pFound[i] == false, "random key is new");
+                }
+                Check(pFound[BATCH - 1] == true && entries[BATCH - 1].m_sequence == entries[0].m_sequence, "key repeated within a call is found");
+                newCount += BATCH - 1;
+            }
+            Check(index.getCount() == 2 + newCount, "key count after growth");
+            for (size_t b = 0; b < batchCount; ++b){
+                for (size_t i = 0; i < BATCH - 1; i += 97){
+                    Check(index.find(fingerprints[b].data() + i * KeyFingerprintIndex::FINGERPRINT_LENGTH, entry), "key found after growth");
+                }
+            }
+            Check(index.find(fingerprint, entry) == true && entry.m_sequence == 1, "first key kept through growth");
+        }
+        {
+            KeyFingerprintIndex index(indexPath, KeyFingerprintIndex::MODE_READ_ONLY);
+            Check(index.find(otherFingerprint.data(), entry) == true && entry.m_sequence == 2, "grown index reopens");
+        }
+
+        // batch replay: a key seen earlier in the batch, or in an earlier batch, is flagged;
+        // failed records are not recorded
+        const std::vector<TestRecord> records(BuildRecords(key));
+        std::vector<TestRecord> batch;
+        batch.push_back(records[0]);
+        batch.push_back(records[0]);
+        batch.back().m_wrappedKey = RandomBytes(WRAPPED_KEY_LENGTH);
+        batch.back().m_iobuf = key.sign(batch.back().m_wrappedKey);
+        batch.push_back(records[2]);
+        std::istringstream manifestStream(BuildManifest(batch));
+        const BatchVerifier manifest(manifestStream);
+        std::ostringstream skipped;
+        EnrollmentArchiveWriter::convertManifest(manifest, archivePath, skipped);
+        const ArchiveBatchVerifier archive(archivePath);
+        KeyFingerprintIndex replayIndex(replayPath);
+        const int firstRun[] = { RETCODE_SUCCESS, RETCODE_WEAK_KEY, RETCODE_VERIFY_ERROR };
+        const int replay[] = { RETCODE_WEAK_KEY, RETCODE_WEAK_KEY, RETCODE_VERIFY_ERROR };
+        Check(Outcomes(manifest.verifyAll(1, false, &replayIndex)) == std::vector<int>(firstRun, firstRun + 3), "first batch");
+        Check(Outcomes(manifest.verifyAll(2, false, &replayIndex)) == std::vector<int>(replay, replay + 3), "replayed batch");
+        Check(Outcomes(archive.verifyAll(1, false, &replayIndex)) == std::vector<int>(replay, replay + 3), "replayed archive");
+        Check(replayIndex.getCount() == 1, "only the verified key is recorded");
+#else
+        std::cout << "key index not supported on this platform; skipped" << std::endl;
+#endif
+    }
+
+    //------------------------------------------------------------------
+    // shared-factors
+
+    // returns a random prime of bits bits
+    std::unique_ptr<BIGNUM, void (*)(BIGNUM*)> GeneratePrime(const int bits){
+        std::unique_ptr<BIGNUM, void (*)(BIGNUM*)> pPrime(BN_new(), BN_free);
+        if (pPrime.get() == nullptr || BN_generate_prime_ex(pPrime.get(), bits, 0, nullptr, nullptr, nullptr) != 1){
+            throw std::runtime_error("Unable to generate a prime.");
+        }
+        return pPrime;
+    }
+
+    // returns the manifest line of a key gen result for the modulus p * q (the proof is not checked by the scan)
+    std::string SharedFactorLine(const BIGNUM* pP, const BIGNUM* pQ){
+        BN_CTX* const pContext = BN_CTX_new();
+        BIGNUM* const pModulus = BN_new();
+        if (pContext == nullptr || pModulus == nullptr || BN_mul(pModulus, pP, pQ, pContext) != 1){
+            throw std::runtime_error("BN_mul failed.");
+        }
+        std::vector<byte> modulus;
+        AppendBignum(modulus, pModulus);
+        BN_free(pModulus);
+        BN_CTX_free(pContext);
+        const std::vector<byte> exponent = { 0x01, 0x00, 0x01 };
+        return ToHex(BuildIobuf(BuildBlob(8 * modulus.size(), modulus, exponent), RandomBytes(modulus.size()))) + "\n";
+    }
+
+    // shared factor test - keys sharing a prime are reported, with their partners; other keys are not
+    void TestSharedFactors(){
+        if (SharedFactorScan::isAvailable() == false){
+            std::cout << "built without GMP; skipped" << std::endl;
+            return;
+        }
+
+        const std::unique_ptr<BIGNUM, void (*)(BIGNUM*)> pP(GeneratePrime(512));
+        const std::unique_ptr<BIGNUM, void (*)(BIGNUM*)> pQ(GeneratePrime(512));
+        const std::unique_ptr<BIGNUM, void (*)(BIGNUM*)> pR(GeneratePrime(512));
+        const std::unique_ptr<BIGNUM, void (*)(BIGNUM*)> pS(GeneratePrime(512));
+        const std::unique_ptr<BIGNUM, void (*)(BIGNUM*)> pT(GeneratePrime(512));
+        std::string manifestText;
+        manifestText += SharedFactorLine(pP.get(), pQ.get());   // line 1: shares p with line 2, n with line 4
+        manifestText += SharedFactorLine(pP.get(), pR.get());   // line 2: shares p with lines 1 and 4
+        manifestText += SharedFactorLine(pS.get(), pT.get());   // line 3: independent
+        manifestText += SharedFactorLine(pP.get(), pQ.get());   // line 4: same modulus as line 1
+        manifestText += "0123456789abcdeg\n";                   // line 5: bad hex
+        const std::string truncated(SharedFactorLine(pS.get(), pR.get()));
+        manifestText += truncated.substr(0, 2 * (truncated.length() / 4)) + "\n";   // line 6: truncated key gen result
+
+        std::istringstream manifestStream(manifestText);
+        const BatchVerifier manifest(manifestStream);
+        const size_t memoryLimits[] = { SharedFactorScan::DEFAULT_MEMORY_LIMIT, 1024 };
+        for (size_t m = 0; m < sizeof(memoryLimits) / sizeof(memoryLimits[0]); ++m){
+            const std::string name = "memory limit " + std::to_string(memoryLimits[m]);
+            const SharedFactorScan scan(std::string(), memoryLimits[m]);
+            const std::vector<SharedFactorScan::Result> results(scan.scan(manifest, 2));
+            const std::vector<int> outcomes(OutcomesByLine(results, 6));
+            const int expected[] = { -1, RETCODE_WEAK_KEY, RETCODE_WEAK_KEY, -1, RETCODE_WEAK_KEY, RETCODE_INPUT_ERROR, RETCODE_PARSE_ERROR };
+            Check(outcomes == std::vector<int>(expected, expected + 7), name + ": reported lines");
+            Check(results.size() == 5, name + ": no other lines reported");
+        }
+    }
+
+    //------------------------------------------------------------------
+    // capi
+
+    // C API test - parsing, verification, hex decoding and argument checks through CKYEnrollment.h
+    void TestCAPI(){
+        CKY_Initialize();
+        const TestKey key(1024, 65537);
+        const std::vector<TestRecord> records(BuildRecords(key));
+        const TestRecord& record = records[0];
+
+        CKY_KeyGenResult result;
+        Check(CKY_ParseKeyGenResult(record.m_iobuf.data(), record.m_iobuf.size(), 0, &result) == CKY_OK, "parse");
+        Check(result.keyLengthBits == 1024 && result.keyEncoding == CoolkeyRSAKeyBlobView::KEYENCODING_PLAINTEXT &&
+              result.keyType == CoolkeyRSAKeyBlobView::KEYTYPE_RSA_PUBLIC, "parsed key header");
+        Check(result.modulusLength == key.m_modulus.size() && std::memcmp(result.modulus, key.m_modulus.data(), result.modulusLength) == 0 &&
+              result.exponentLength == key.m_exponent.size() && std::memcmp(result.exponent, key.m_exponent.data(), result.exponentLength) == 0,
+              "parsed key fields");
+        Check(result.blob == record.m_iobuf.data() + 2 && result.blobSize == key.m_blob.size() &&
+              result.proofSize == key.m_modulus.size(), "parsed fields point into the buffer");
+
+        // verification, per call and with reused state
+        CKY_Verifier* pVerifier = nullptr;
+        Check(CKY_CreateVerifier(&pVerifier) == CKY_OK && pVerifier != nullptr, "create verifier");
+        Check(CKY_VerifyKeyGenResult(&result, record.m_wrappedKey.data(), record.m_wrappedKey.size()) == CKY_OK, "verify");
+        Check(CKY_VerifyKeyGenResultWith(pVerifier, &result, record.m_wrappedKey.data(), record.m_wrappedKey.size()) == CKY_OK, "verify with");
+        Check(CKY_VerifyKeyGenResult(&result, records[1].m_wrappedKey.data(), records[1].m_wrappedKey.size()) == CKY_ERROR_VERIFY_FAILED,
+              "wrong challenge key fails");
+        Check(CKY_VerifyKeyGenResultWith(pVerifier, &result, records[1].m_wrappedKey.data(), records[1].m_wrappedKey.size()) == CKY_ERROR_VERIFY_FAILED,
+              "wrong challenge key fails with reused state");
+        Check(CKY_VerifyKeyGenResultWith(pVerifier, &result, record.m_wrappedKey.data(), record.m_wrappedKey.size()) == CKY_OK,
+              "reused state recovers after a failure");
+
+        // only a proof that does not verify is CKY_ERROR_VERIFY_FAILED
+        CKY_KeyGenResult alteredProof;
+        Check(CKY_ParseKeyGenResult(records[2].m_iobuf.data(), records[2].m_iobuf.size(), 0, &alteredProof) == CKY_OK &&
+              CKY_VerifyKeyGenResultWith(pVerifier, &alteredProof, records[2].m_wrappedKey.data(), records[2].m_wrappedKey.size()) == CKY_ERROR_VERIFY_FAILED,
+              "altered proof fails");
+        CKY_KeyGenResult shortProof(result);
+        --shortProof.proofSize;
+        Check(CKY_VerifyKeyGenResultWith(pVerifier, &shortProof, record.m_wrappedKey.data(), record.m_wrappedKey.size()) == CKY_ERROR_VERIFY_FAILED,
+              "proof of the wrong size fails");
+        for (int code = CoolkeyStatus::OK; code <= CoolkeyStatus::VERIFY_INTERNAL_ERROR; ++code){
+            const CoolkeyStatus status(static_cast<CoolkeyStatus::Code>(code));
+            CKY_Status expected = CKY_ERROR_INTERNAL;
+            if (code == CoolkeyStatus::OK){
+                expected = CKY_OK;
+            }else if (code == CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH){
+                expected = CKY_ERROR_VERIFY_FAILED;
+            }else if (status.getCategory() == CoolkeyStatus::CATEGORY_PARSE){
+                expected = CKY_ERROR_PARSE;
+            }else if (status.getCategory() == CoolkeyStatus::CATEGORY_KEY){
+                expected = CKY_ERROR_OUT_OF_MEMORY;
+            }
+            Check(CKYEnrollmentStatus::fromVerification(status) == expected, "C status of verification status " + std::to_string(code));
+        }
+
+        // malformed input and trailing data
+        Check(CKY_ParseKeyGenResult(records[3].m_iobuf.data(), records[3].m_iobuf.size(), 0, &result) == CKY_ERROR_PARSE, "truncated result");
+        std::vector<byte> extended(record.m_iobuf);
+        extended.push_back(0x00);
+        Check(CKY_ParseKeyGenResult(extended.data(), extended.size(), 0, &result) == CKY_ERROR_PARSE, "trailing data rejected");
+        Check(CKY_ParseKeyGenResult(extended.data(), extended.size(), 1, &result) == CKY_OK, "trailing data allowed");
+
+        // null arguments
+        Check(CKY_ParseKeyGenResult(nullptr, record.m_iobuf.size(), 0, &result) == CKY_ERROR_INVALID_ARGUMENT, "parse without data");
+        Check(CKY_ParseKeyGenResult(record.m_iobuf.data(), record.m_iobuf.size(), 0, nullptr) == CKY_ERROR_INVALID_ARGUMENT, "parse without result");
+        Check(CKY_VerifyKeyGenResult(nullptr, record.m_wrappedKey.data(), record.m_wrappedKey.size()) == CKY_ERROR_INVALID_ARGUMENT, "verify without result");
+        Check(CKY_VerifyKeyGenResultWith(nullptr, &result, record.m_wrappedKey.data(), record.m_wrappedKey.size()) == CKY_ERROR_INVALID_ARGUMENT,
+              "verify without verifier");
+        Check(CKY_CreateVerifier(nullptr) == CKY_ERROR_INVALID_ARGUMENT, "create without destination");
+        CKY_FreeVerifier(pVerifier);
+        CKY_FreeVerifier(nullptr);
+
+        // hex decoding
+        byte out[8];
+        size_t outLength = 0;
+        size_t errorOffset = 0;
+        const std::string text("0a:1B 2c");
+        Check(CKY_DecodeHex(text.data(), text.length(), out, sizeof(out), &outLength, &errorOffset) == CKY_OK &&
+              outLength == 3 && out[0] == 0x0A && out[1] == 0x1B && out[2] == 0x2C, "decode hex");
+        Check(CKY_DecodeHex(text.data(), text.length(), out, 3, &outLength, nullptr) == CKY_OK && outLength == 3, "decode hex into an exact buffer");
+        Check(CKY_DecodeHex(text.data(), text.length(), out, 2, &outLength, nullptr) == CKY_ERROR_BUFFER_TOO_SMALL, "buffer too small");
+        Check(CKY_DecodeHex("0x12", 4, out, sizeof(out), &outLength, &errorOffset) == CKY_ERROR_HEX_INVALID_CHARACTER && errorOffset == 1,
+              "invalid character and its offset");
+        Check(CKY_DecodeHex("12:3", 4, out, sizeof(out), &outLength, &errorOffset) == CKY_ERROR_HEX_ODD_LENGTH && errorOffset == 3,
+              "unpaired digit and its offset");
+        Check(CKY_DecodeHex("", 0, nullptr, 0, &outLength, nullptr) == CKY_OK && outLength == 0, "empty text");
+        Check(CKY_DecodeHex(text.data(), text.length(), out, sizeof(out), nullptr, nullptr) == CKY_ERROR_INVALID_ARGUMENT, "decode without length");
+
+        // every status has a description
+        for (int status = CKY_OK; status <= CKY_ERROR_INTERNAL; ++status){
+            const char* const pDescription = CKY_StatusString(static_cast<CKY_Status>(status));
+            Check(pDescription != nullptr && pDescription[0] != '\0', "description of status " + std::to_string(status));
+        }
+        Check(CKY_StatusString(static_cast<CKY_Status>(CKY_ERROR_INTERNAL + 1)) != nullptr, "description of an unknown status");
+    }
+
+    //------------------------------------------------------------------
+    // daemon
+
+#if defined(__linux__)
+    // client connection to the daemon's socket
+    class DaemonClient{
+        private:
+            // prevent copying and assignment
+            DaemonClient(const DaemonClient& src);
+            DaemonClient operator=(const DaemonClient& rhs);
+
+        protected:
+            int m_fd;
+
+        public:
+            // connects to the socket at socketPath
+            //   throws std::runtime_error on failure
+            explicit DaemonClient(const std::string& socketPath) : m_fd(socket(AF_UNIX, SOCK_STREAM, 0)){
+                sockaddr_un address;
+                std::memset(&address, 0, sizeof(address));
+                address.sun_family = AF_UNIX;
+                std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+                if (this->m_fd < 0 || connect(this->m_fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0){
+                    if (this->m_fd >= 0){
+                        close(this->m_fd);
+                    }
+                    throw std::runtime_error("Unable to connect to '" + socketPath + "'.");
+                }
+            }
+
+            ~DaemonClient(){
+                close(this->m_fd);
+            }
+
+            // sends bytes
+            //   throws std::runtime_error on failure
+            void send(const std::vector<byte>& bytes){
+                size_t sent = 0;
+                while (sent < bytes.size()){
+                    const ssize_t count = write(this->m_fd, bytes.data() + sent, bytes.size() - sent);
+                    if (count <= 0){
+                        throw std::runtime_error("Unable to write to the daemon.");
+                    }
+                    sent += static_cast<size_t>(count);
+                }
+            }
+
+            // reads exactly length bytes; returns false if the connection closed first
+            bool receive(byte* pData, const size_t length){
+                size_t received = 0;
+                while (received < length){
+                    const ssize_t count = read(this->m_fd, pData + received, length - received);
+                    if (count <= 0){
+                        return false;
+                    }
+                    received += static_cast<size_t>(count);
+                }
+                return true;
+            }
+
+            // reads one response frame and returns its outcome code, or -1 if the connection closed
+            int receiveOutcome(){
+                byte lengthField[4];
+                if (this->receive(lengthField, sizeof(lengthField)) == false){
+                    return -1;
+                }
+                std::vector<byte> payload(EnrollmentArchive::readUint32(lengthField));
+                if (payload.empty() == true || this->receive(payload.data(), payload.size()) == false){
+                    return -1;
+                }
+                return payload[0];
+            }
+    };
+
+    // returns the request frame of an iobuf and wrappedkey pair
+    std::vector<byte> BuildFrame(const std::vector<byte>& iobuf, const std::vector<byte>& wrappedKey){
+        std::vector<byte> frame(8);
+        EnrollmentArchive::writeUint32(frame.data(), static_cast<uint32_t>(iobuf.size()));
+        EnrollmentArchive::writeUint32(frame.data() + 4, static_cast<uint32_t>(wrappedKey.size()));
+        frame.insert(frame.end(), iobuf.begin(), iobuf.end());
+        frame.insert(frame.end(), wrappedKey.begin(), wrappedKey.end());
+        return frame;
+    }
+
+    // runs daemon's event loop on its own thread while requests(), then stops it
+    //   rethrows what requests() threw; a failed event loop fails the test
+    template<typename Requests>
+    void RunDaemon(VerificationDaemon& daemon, Requests requests){
+        std::string runError;
+        std::thread runner([&daemon, &runError](){
+            try{
+                daemon.run();
+            }catch (std::runtime_error& e){
+                runError = e.what();
+            }
+        });
+        try{
+            requests();
+        }catch (...){
+            VerificationDaemon::requestStop();
+            runner.join();
+            throw;
+        }
+        VerificationDaemon::requestStop();
+        runner.join();
+        Check(runError.empty(), "event loop ran without errors: " + runError);
+    }
+#endif
+
+    // daemon test - responses through the socket to single, pipelined, malformed and oversized requests
+    void TestDaemon(){
+#if defined(__linux__)
+        ScratchFiles scratch;
+        const std::string socketPath = scratch.add("CKYEnrollmentTests_daemon.sock");
+
+        const TestKey key(1024, 65537);
+        const std::vector<TestRecord> records(BuildRecords(key));
+        const std::vector<byte> validFrame(BuildFrame(records[0].m_iobuf, records[0].m_wrappedKey));
+        std::ostringstream log;
+        VerificationDaemon daemon(socketPath, log);
+        RunDaemon(daemon, [&](){
+            {
+                DaemonClient client(socketPath);
+                client.send(validFrame);
+                Check(client.receiveOutcome() == RETCODE_SUCCESS, "valid request verifies");
+                client.send(validFrame);
+                Check(client.receiveOutcome() == RETCODE_SUCCESS, "repeated request verifies");
+                client.send(BuildFrame(records[1].m_iobuf, records[1].m_wrappedKey));
+                Check(client.receiveOutcome() == RETCODE_VERIFY_ERROR, "tampered request fails");
+                client.send(BuildFrame(RandomBytes(40), records[0].m_wrappedKey));
+                Check(client.receiveOutcome() == RETCODE_PARSE_ERROR, "garbage request fails to parse");
+
+                std::vector<byte> oversized(8);
+                EnrollmentArchive::writeUint32(oversized.data(), VerificationDaemon::MAX_FIELD_LENGTH + 1);
+                client.send(oversized);
+                Check(client.receiveOutcome() == RETCODE_INPUT_ERROR, "oversized request is refused");
+                Check(client.receiveOutcome() == -1, "connection closed after an oversized request");
+            }
+            {
+                // pipelined requests are answered in order
+                DaemonClient client(socketPath);
+                std::vector<byte> frames(validFrame);
+                const std::vector<byte> alteredProofFrame(BuildFrame(records[2].m_iobuf, records[2].m_wrappedKey));
+                const std::vector<byte> truncatedFrame(BuildFrame(records[3].m_iobuf, records[3].m_wrappedKey));
+                frames.insert(frames.end(), alteredProofFrame.begin(), alteredProofFrame.end());
+                frames.insert(frames.end(), truncatedFrame.begin(), truncatedFrame.end());
+                frames.insert(frames.end(), validFrame.begin(), validFrame.end());
+                client.send(frames);
+                Check(client.receiveOutcome() == RETCODE_SUCCESS, "first pipelined request verifies");
+                Check(client.receiveOutcome() == RETCODE_VERIFY_ERROR, "second pipelined request fails");
+                Check(client.receiveOutcome() == RETCODE_PARSE_ERROR, "third pipelined request fails to parse");
+                Check(client.receiveOutcome() == RETCODE_SUCCESS, "fourth pipelined request verifies");
+            }
+        });
+#else
+        std::cout << "daemon not supported on this platform; skipped" << std::endl;
+#endif
+    }
+
+    //------------------------------------------------------------------
+    // daemon-cache
+
+    // daemon cache test - cached responses and recorded keys interacting: a newly recorded key is not cached,
+    // so a repeated request finds it recorded; responses that recorded nothing are answered from the cache
+    void TestDaemonCache(){
+#if defined(__linux__)
+        ScratchFiles scratch;
+        const std::string socketPath = scratch.add("CKYEnrollmentTests_daemon_cache.sock");
+        const std::string indexPath = scratch.add("CKYEnrollmentTests_daemon_cache.kidx");
+        scratch.add(indexPath + ".lock");
+
+        const TestKey key(1024, 65537);
+        const TestKey otherKey(1024, 65537);
+        const std::vector<TestRecord> records(BuildRecords(key));
+        const std::vector<TestRecord> otherRecords(BuildRecords(otherKey));
+        const std::vector<byte> validFrame(BuildFrame(records[0].m_iobuf, records[0].m_wrappedKey));
+        const std::vector<byte> tamperedFrame(BuildFrame(records[1].m_iobuf, records[1].m_wrappedKey));
+
+        KeyFingerprintIndex index(indexPath);
+        ResultCache cache(64);
+        std::ostringstream log;
+        VerificationDaemon daemon(socketPath, log, std::string(), &index, &cache);
+        RunDaemon(daemon, [&](){
+            {
+                DaemonClient client(socketPath);
+                client.send(validFrame);
+                Check(client.receiveOutcome() == RETCODE_SUCCESS, "valid request verifies");
+                client.send(validFrame);
+                Check(client.receiveOutcome() == RETCODE_WEAK_KEY, "repeated request finds its key recorded");
+                client.send(tamperedFrame);
+                Check(client.receiveOutcome() == RETCODE_VERIFY_ERROR, "tampered request fails");
+                client.send(tamperedFrame);
+                Check(client.receiveOutcome() == RETCODE_VERIFY_ERROR, "repeated tampered request fails");
+                client.send(validFrame);
+                Check(client.receiveOutcome() == RETCODE_WEAK_KEY, "third valid request finds its key recorded");
+                Check(cache.getLookupCount(ResultCache::LOOKUP_HIT) == 2, "repeated failures are answered from the cache");
+                Check(index.getCount() == 1, "one key recorded");
+            }
+            {
+                // pipelined requests of a new key: the second finds the key the first recorded
+                DaemonClient client(socketPath);
+                const std::vector<byte> frame(BuildFrame(otherRecords[0].m_iobuf, otherRecords[0].m_wrappedKey));
+                std::vector<byte> frames(frame);
+                frames.insert(frames.end(), frame.begin(), frame.end());
+                client.send(frames);
+                Check(client.receiveOutcome() == RETCODE_SUCCESS, "first pipelined request verifies");
+                Check(client.receiveOutcome() == RETCODE_WEAK_KEY, "second pipelined request finds its key recorded");
+            }
+        });
+        Check(index.getCount() == 2, "two keys recorded");
+#else
+        std::cout << "daemon not supported on this platform; skipped" << std::endl;
+#endif
+    }
+
+    //------------------------------------------------------------------
+    // pipeline
+
+    // returns what writer.writeAll() of manifest.verifyAll() writes in format, and its return code
+    std::string BatchOutput(const BatchVerifier& manifest, const ResultWriter::Format format, KeyFingerprintIndex* pKeyIndex, int& retcode){
+        std::ostringstream out;
+        ResultWriter writer(out, format);
+        retcode = writer.writeAll(manifest.verifyAll(1, writer.needsKeyData(), pKeyIndex));
+        return out.str();
+    }
+
+    // returns what a BatchPipeline run writes in format, and its return code
+    std::string PipelineOutput(const BatchVerifier& manifest, const ResultWriter::Format format, const size_t loadThreads,
+                               const size_t verifyThreads, const size_t queueCapacity, KeyFingerprintIndex* pKeyIndex, int& retcode){
+        std::ostringstream out;
+        ResultWriter writer(out, format);
+        BatchPipeline pipeline(manifest, loadThreads, verifyThreads, queueCapacity);
+        retcode = pipeline.run(writer, pKeyIndex);
+        return out.str();
+    }
+
+    // returns text with the times of key index entries ("first seen <time>") blanked, since runs record keys at different times
+    std::string WithoutFirstSeenTimes(std::string text){
+        const std::string FIRST_SEEN("first seen ");
+        for (size_t position = text.find(FIRST_SEEN); position != std::string::npos; position = text.find(FIRST_SEEN, position)){
+            position += FIRST_SEEN.length();
+            const size_t end = text.find(')', position);
+            if (end != std::string::npos){
+                text.replace(position, end - position, "-");
+            }
+        }
+        return text;
+    }
+
+    // pipeline test - BatchPipeline output is byte for byte that of batch mode for any thread counts and queue
+    // capacity, and BoundedQueue hands every value to exactly one consumer
+    void TestPipeline(){
+        ScratchFiles scratch;
+        const std::string fieldPath = scratch.add("CKYEnrollmentTests_pipeline_field.txt");
+
+        // many groups of valid, damaged and repeated records, bad hex and '@' fields
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+        const TestKey keyExponent3(1024, 3);
+        const TestKey* const keys[] = { &key1024, &key2048, &keyExponent3 };
+        std::string manifestText("# comment line\n\n");
+        for (size_t i = 0; i < 60; ++i){
+            const std::vector<TestRecord> records(BuildRecords(*keys[i % 3]));
+            manifestText += BuildManifest(records);
+            if ((i % 7) == 0){
+                manifestText += "0g12 00112233445566778899aabbccddeeff\n";
+            }
+        }
+        const std::vector<TestRecord> fieldRecords(BuildRecords(key2048));
+        const std::string wrappedKeyHex(ToHex(fieldRecords[0].m_wrappedKey));
+        WriteFileBytes(fieldPath, std::vector<byte>(wrappedKeyHex.begin(), wrappedKeyHex.end()));
+        manifestText += ToHex(fieldRecords[0].m_iobuf) + " @" + fieldPath + "\n";
+        manifestText += ToHex(fieldRecords[0].m_iobuf) + " @CKYEnrollmentTests_missing.txt\n";
+        std::istringstream manifestStream(manifestText);
+        const BatchVerifier manifest(manifestStream);
+
+        const size_t threadCounts[][2] = { { 1, 1 }, { 1, 2 }, { 2, 1 }, { 2, 3 }, { 3, 4 } };
+        const size_t queueCapacities[] = { 1, 2, BatchPipeline::DEFAULT_QUEUE_CAPACITY };
+        for (int f = 0; f < ResultWriter::FORMAT_COUNT; ++f){
+            const ResultWriter::Format format = static_cast<ResultWriter::Format>(f);
+            int expectedRetcode = 0;
+            const std::string expected(BatchOutput(manifest, format, nullptr, expectedRetcode));
+            Check(expected.empty() == false, "format " + std::to_string(f) + ": batch output");
+            for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t){
+                for (size_t q = 0; q < sizeof(queueCapacities) / sizeof(queueCapacities[0]); ++q){
+                    const std::string name = "format " + std::to_string(f) + ", " + std::to_string(threadCounts[t][0]) + " load and " +
+                                             std::to_string(threadCounts[t][1]) + " verify threads, queue capacity " + std::to_string(queueCapacities[q]);
+                    int retcode = -1;
+                    Check(PipelineOutput(manifest, format, threadCounts[t][0], threadCounts[t][1], queueCapacities[q], nullptr, retcode) == expected,
+                          name + ": output matches batch mode");
+                    Check(retcode == expectedRetcode, name + ": return code matches batch mode");
+                }
+            }
+        }
+
+#if defined(__unix__) || defined(__APPLE__)
+        // with a key index: each run starts from a new index, so the same keys are flagged in the same records
+        // (with the same entries; only the times they were recorded differ)
+        const std::string indexPath = scratch.add("CKYEnrollmentTests_pipeline.kidx");
+        scratch.add(indexPath + ".lock");
+        int expectedRetcode = 0;
+        std::string expected;
+        {
+            KeyFingerprintIndex index(scratch.add(indexPath));
+            expected = WithoutFirstSeenTimes(BatchOutput(manifest, ResultWriter::FORMAT_TEXT, &index, expectedRetcode));
+        }
+        Check(expectedRetcode == RETCODE_WEAK_KEY, "key index: repeated keys are flagged");
+        for (size_t t = 0; t < sizeof(threadCounts) / sizeof(threadCounts[0]); ++t){
+            for (size_t q = 0; q < sizeof(queueCapacities) / sizeof(queueCapacities[0]); ++q){
+                const std::string name = "key index, " + std::to_string(threadCounts[t][0]) + " load and " +
+                                         std::to_string(threadCounts[t][1]) + " verify threads, queue capacity " + std::to_string(queueCapacities[q]);
+                KeyFingerprintIndex index(scratch.add(indexPath));
+                int retcode = -1;
+                const std::string output(PipelineOutput(manifest, ResultWriter::FORMAT_TEXT, threadCounts[t][0], threadCounts[t][1],
+                                                        queueCapacities[q], &index, retcode));
+                Check(WithoutFirstSeenTimes(output) == expected, name + ": output matches batch mode");
+                Check(retcode == expectedRetcode, name + ": return code matches batch mode");
+                Check(index.getCount() == 3, name + ": the verified keys are recorded");
+            }
+        }
+#endif
+
+        // BoundedQueue: producers and consumers at once, down to the smallest capacity; every value is popped
+        // exactly once, and each consumer sees the values of one producer in the order they were pushed
+        const size_t VALUES_PER_PRODUCER = 5000;
+        const size_t capacities[] = { 1, 2, 3, 64 };
+        const size_t producerCounts[] = { 1, 2, 4 };
+        const size_t consumerCounts[] = { 1, 3 };
+        for (size_t c = 0; c < sizeof(capacities) / sizeof(capacities[0]); ++c){
+            for (size_t p = 0; p < sizeof(producerCounts) / sizeof(producerCounts[0]); ++p){
+                for (size_t k = 0; k < sizeof(consumerCounts) / sizeof(consumerCounts[0]); ++k){
+                    const std::string name = "queue capacity " + std::to_string(capacities[c]) + ", " + std::to_string(producerCounts[p]) +
+                                             " producers, " + std::to_string(consumerCounts[k]) + " consumers";
+                    const size_t valueCount = producerCounts[p] * VALUES_PER_PRODUCER;
+                    BoundedQueue<size_t> queue(capacities[c]);
+                    Check(queue.getCapacity() >= capacities[c] && queue.getCapacity() >= 2, name + ": capacity");
+                    std::unique_ptr<std::atomic<unsigned int>[]> pPops(new std::atomic<unsigned int>[valueCount]);
+                    for (size_t i = 0; i < valueCount; ++i){
+                        pPops[i] = 0;
+                    }
+                    std::atomic<bool> ordered(true);
+
+                    std::vector<std::thread> consumers;
+                    for (size_t i = 0; i < consumerCounts[k]; ++i){
+                        consumers.push_back(std::thread([&queue, &pPops, &ordered, &producerCounts, p](){
+                            std::vector<size_t> lastValue(producerCounts[p], 0);
+                            std::vector<bool> seen(producerCounts[p], false);
+                            for (;;){
+                                size_t value = 0;
+                                if (queue.tryPop(value) == false){
+                                    if (queue.isClosed() == false){
+                                        std::this_thread::yield();
+                                        continue;
+                                    }
+                                    // values pushed before the close may still be queued
+                                    if (queue.tryPop(value) == false){
+                                        break;
+                                    }
+                                }
+                                ++pPops[value];
+                                const size_t producer = value / VALUES_PER_PRODUCER;
+                                if (seen[producer] == true && value <= lastValue[producer]){
+                                    ordered = false;
+                                }
+                                seen[producer] = true;
+                                lastValue[producer] = value;
+                            }
+                        }));
+                    }
+                    std::vector<std::thread> producers;
+                    for (size_t i = 0; i < producerCounts[p]; ++i){
+                        producers.push_back(std::thread([&queue, i](){
+                            for (size_t v = i * VALUES_PER_PRODUCER; v < (i + 1) * VALUES_PER_PRODUCER; ++v){
+                                while (queue.tryPush(v) == false){
+                                    std::this_thread::yield();
+                                }
+                            }
+                        }));
+                    }
+                    for (size_t i = 0; i < producers.size(); ++i){
+                        producers[i].join();
+                    }
+                    queue.close();
+                    for (size_t i = 0; i < consumers.size(); ++i){
+                        consumers[i].join();
+                    }
+
+                    bool once = true;
+                    for (size_t i = 0; i < valueCount; ++i){
+                        once = once && (pPops[i] == 1);
+                    }
+                    Check(once == true, name + ": every value popped exactly once");
+                    Check(ordered == true, name + ": values of each producer popped in order");
+                    size_t value = 0;
+                    Check(queue.tryPop(value) == false && queue.getSize() == 0, name + ": queue empty at the end");
+                }
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+    // metrics
+
+    // metrics test - the log-linear bucket layout, the clamp at 2^MAX_EXPONENT ns, and the cumulative
+    // Prometheus histogram written from recorded latencies
+    void TestMetrics(){
+        // small latencies get one bucket per nanosecond
+        for (uint64_t value = 0; value < 2 * Metrics::SUB_BUCKET_COUNT; ++value){
+            Check(Metrics::getBucketIndex(value) == value && Metrics::getBucketLimit(static_cast<size_t>(value)) == value + 1,
+                  "bucket of " + std::to_string(value) + " ns");
+        }
+
+        // SUB_BUCKET_COUNT equal buckets per power of two
+        for (unsigned exponent = Metrics::SUB_BUCKET_BITS + 1; exponent < Metrics::MAX_EXPONENT; ++exponent){
+            const uint64_t power = static_cast<uint64_t>(1) << exponent;
+            const uint64_t width = power >> Metrics::SUB_BUCKET_BITS;
+            const size_t first = Metrics::getBucketIndex(power);
+            Check(first == (exponent - Metrics::SUB_BUCKET_BITS + 1) * Metrics::SUB_BUCKET_COUNT, "first bucket of 2^" + std::to_string(exponent) + " ns");
+            Check(Metrics::getBucketIndex(power - 1) == first - 1, "2^" + std::to_string(exponent) + " ns starts a new bucket");
+            for (size_t sub = 0; sub < Metrics::SUB_BUCKET_COUNT; ++sub){
+                const uint64_t lower = power + sub * width;
+                const std::string name = "bucket " + std::to_string(sub) + " of 2^" + std::to_string(exponent) + " ns";
+                Check(Metrics::getBucketLimit(first + sub) == lower + width, name + ": limit");
+                Check(Metrics::getBucketIndex(lower) == first + sub && Metrics::getBucketIndex(lower + width - 1) == first + sub, name + ": bounds");
+            }
+        }
+
+        // the buckets are contiguous; the last one ends at 2^MAX_EXPONENT ns and takes every longer latency
+        const uint64_t maxLimit = static_cast<uint64_t>(1) << Metrics::MAX_EXPONENT;
+        bool contiguous = true;
+        for (size_t bucket = 1; bucket < Metrics::BUCKET_COUNT; ++bucket){
+            const uint64_t lower = Metrics::getBucketLimit(bucket - 1);
+            contiguous = contiguous && lower < Metrics::getBucketLimit(bucket) && Metrics::getBucketIndex(lower) == bucket;
+        }
+        Check(contiguous, "buckets are contiguous");
+        Check(Metrics::getBucketLimit(Metrics::BUCKET_COUNT - 1) == maxLimit, "last bucket ends at 2^MAX_EXPONENT ns");
+        const uint64_t overflows[] = { maxLimit - 1, maxLimit, maxLimit + 1, maxLimit << 10, ~static_cast<uint64_t>(0) };
+        for (size_t i = 0; i < sizeof(overflows) / sizeof(overflows[0]); ++i){
+            Check(Metrics::getBucketIndex(overflows[i]) == Metrics::BUCKET_COUNT - 1, "latency " + std::to_string(overflows[i]) + " ns in the last bucket");
+        }
+
+        if (Metrics::isEnabled() == false){
+            std::cout << "built with CKY_METRICS OFF; Prometheus export skipped" << std::endl;
+            return;
+        }
+
+        // each "le" line counts the samples below its bound; +Inf and _count count them all, the overflows included
+        const uint64_t samples[][2] = { { 0, 1 }, { 127, 2 }, { 128, 1 }, { 1000, 3 }, { 1 << 20, 5 }, { (static_cast<uint64_t>(1) << 36) - 1, 1 },
+                                        { static_cast<uint64_t>(1) << 36, 1 }, { maxLimit, 2 }, { maxLimit << 8, 1 } };
+        uint64_t totalCount = 0;
+        double totalSeconds = 0;
+        for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i){
+            Metrics::recordLatency(Metrics::STAGE_REQUEST, samples[i][0], samples[i][1]);
+            totalCount += samples[i][1];
+            totalSeconds += static_cast<double>(samples[i][0]) * static_cast<double>(samples[i][1]) / 1e9;
+        }
+        std::ostringstream out;
+        Metrics::writePrometheus(out);
+        std::istringstream lines(out.str());
+        const std::string prefix = std::string("cky_stage_duration_seconds_bucket{stage=\"") + Metrics::getStageName(Metrics::STAGE_REQUEST) + "\",le=\"";
+        const std::string sumPrefix = std::string("cky_stage_duration_seconds_sum{stage=\"") + Metrics::getStageName(Metrics::STAGE_REQUEST) + "\"} ";
+        const std::string countPrefix = std::string("cky_stage_duration_seconds_count{stage=\"") + Metrics::getStageName(Metrics::STAGE_REQUEST) + "\"} ";
+        std::string line;
+        size_t boundCount = 0;
+        double lastBound = 0;
+        uint64_t lastCumulative = 0;
+        bool infinityFound = false;
+        bool countFound = false;
+        while (std::getline(lines, line)){
+            if (line.compare(0, sumPrefix.length(), sumPrefix) == 0){
+                const double seconds = std::stod(line.substr(sumPrefix.length()));
+                Check(std::fabs(seconds - totalSeconds) <= totalSeconds * 1e-9, "sum of the recorded latencies");
+                continue;
+            }
+            if (line.compare(0, countPrefix.length(), countPrefix) == 0){
+                Check(std::stoull(line.substr(countPrefix.length())) == totalCount, "count of the recorded latencies");
+                countFound = true;
+                continue;
+            }
+            if (line.compare(0, prefix.length(), prefix) != 0){
+                continue;
+            }
+            const size_t quote = line.find('"', prefix.length());
+            Check(quote != std::string::npos && line.compare(quote, 3, "\"} ") == 0, "bucket line format: " + line);
+            const std::string bound = line.substr(prefix.length(), quote - prefix.length());
+            const uint64_t cumulative = std::stoull(line.substr(quote + 3));
+            if (bound == "+Inf"){
+                Check(cumulative == totalCount, "+Inf bucket counts every sample");
+                infinityFound = true;
+                continue;
+            }
+            Check(infinityFound == false, "+Inf bucket is the last");
+
+            // bounds are increasing powers of two (in seconds); the count is that of the samples below the bound
+            const double seconds = std::stod(bound);
+            const double exponent = std::log2(seconds * 1e9);
+            Check(seconds > lastBound && std::fabs(exponent - std::floor(exponent + 0.5)) < 1e-6, "bound " + bound + " is a larger power of two");
+            lastBound = seconds;
+            lastCumulative = cumulative;
+            const uint64_t limit = static_cast<uint64_t>(1) << static_cast<unsigned>(std::floor(exponent + 0.5));
+            uint64_t expected = 0;
+            for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i){
+                expected += (samples[i][0] < limit) ? samples[i][1] : 0;
+            }
+            Check(cumulative == expected, "cumulative count below " + bound + " s");
+            ++boundCount;
+        }
+        Check(boundCount > 0 && infinityFound && countFound, "request histogram written");
+        Check(lastCumulative < totalCount, "samples at and above the last bound only in +Inf");
+    }
+
+    //------------------------------------------------------------------
+    // writer
+
+    // parses a JSON string starting at the opening quote at text[position], leaving position after the closing quote
+    //   returns false if the string is malformed (including unescaped control characters)
+    bool ParseJSONString(const std::string& text, size_t& position, std::string& value){
+        const char HEX_DIGITS[] = "0123456789abcdef";
+        value.clear();
+        if (position >= text.length() || text[position] != '"'){
+            return false;
+        }
+        for (position++; position < text.length(); position++){
+            const unsigned char c = static_cast<unsigned char>(text[position]);
+            if (c == '"'){
+                position++;
+                return true;
+            }
+            if (c < 0x20){
+                return false;
+            }
+            if (c != '\\'){
+                value += static_cast<char>(c);
+                continue;
+            }
+            if (++position >= text.length()){
+                return false;
+            }
+            switch (text[position]){
+                case '"':  value += '"';  break;
+                case '\\': value += '\\'; break;
+                case '/':  value += '/';  break;
+                case 'b':  value += '\b'; break;
+                case 'f':  value += '\f'; break;
+                case 'n':  value += '\n'; break;
+                case 'r':  value += '\r'; break;
+                case 't':  value += '\t'; break;
+                case 'u':{
+                    if (position + 4 >= text.length()){
+                        return false;
+                    }
+                    unsigned long code = 0;
+                    for (size_t i = 1; i <= 4; i++){
+                        const char* const pDigit = strchr(HEX_DIGITS, tolower(static_cast<unsigned char>(text[position + i])));
+                        if (text[position + i] == '\0' || pDigit == nullptr){
+                            return false;
+                        }
+                        code = code * 16 + static_cast<unsigned long>(pDigit - HEX_DIGITS);
+                    }
+                    // the writer only escapes control characters this way
+                    if (code >= 0x80){
+                        return false;
+                    }
+                    value += static_cast<char>(code);
+                    position += 4;
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    // parses text as one flat JSON object of strings, numbers and nulls into members (values of strings decoded,
+    //   others verbatim); returns false unless the whole of text is such an object
+    bool ParseJSONObject(const std::string& text, std::vector<std::pair<std::string, std::string> >& members){
+        members.clear();
+        size_t position = 0;
+        if (text.empty() == true || text[position++] != '{'){
+            return false;
+        }
+        while (position < text.length()){
+            std::pair<std::string, std::string> member;
+            if (ParseJSONString(text, position, member.first) == false || position >= text.length() || text[position++] != ':'){
+                return false;
+            }
+            if (position < text.length() && text[position] == '"'){
+                if (ParseJSONString(text, position, member.second) == false){
+                    return false;
+                }
+            }else if (text.compare(position, 4, "null") == 0){
+                member.second = "null";
+                position += 4;
+            }else{
+                const size_t start = position;
+                while (position < text.length() && isdigit(static_cast<unsigned char>(text[position])) != 0){
+                    position++;
+                }
+                if (position == start){
+                    return false;
+                }
+                member.second = text.substr(start, position - start);
+            }
+            members.push_back(member);
+            if (position >= text.length()){
+                return false;
+            }
+            const char separator = text[position++];
+            if (separator == '}'){
+                return position == text.length();
+            }
+            if (separator != ','){
+                return false;
+            }
+        }
+        return false;
+    }
+
+    // splits text into RFC 4180 CSV records of fields; returns false if a quoted field is malformed or unterminated
+    //   (every record, the last included, must end with a newline)
+    bool ParseCSV(const std::string& text, std::vector<std::vector<std::string> >& records){
+        records.clear();
+        std::vector<std::string> fields(1);
+        bool quoted = false;
+        bool fieldStarted = false;
+        for (size_t position = 0; position < text.length(); position++){
+            const char c = text[position];
+            if (quoted == true){
+                if (c != '"'){
+                    fields.back() += c;
+                }else if (position + 1 < text.length() && text[position + 1] == '"'){
+                    fields.back() += '"';
+                    position++;
+                }else{
+                    quoted = false;
+                    if (position + 1 < text.length() && text[position + 1] != ',' && text[position + 1] != '\n'){
+                        return false;
+                    }
+                }
+            }else if (c == '"'){
+                if (fieldStarted == true){
+                    return false;
+                }
+                quoted = true;
+                fieldStarted = true;
+            }else if (c == ','){
+                fields.push_back(std::string());
+                fieldStarted = false;
+            }else if (c == '\n'){
+                records.push_back(fields);
+                fields.assign(1, std::string());
+                fieldStarted = false;
+            }else{
+                fields.back() += c;
+                fieldStarted = true;
+            }
+        }
+        return quoted == false && fieldStarted == false && fields.size() == 1;
+    }
+
+    // writer test - messages with quotes, commas, newlines and control characters survive every output format:
+    // each JSONL line is a valid JSON object and each CSV record has the header's 8 fields
+    void TestWriter(){
+        const char* const MESSAGES[] = {
+            "Successfully validated key gen result",
+            "quote \" inside",
+            "comma, inside",
+            "newline\ninside",
+            "control \x01\x07\x1f and tab\t and return\r",
+            "backslash \\ and \\\" escaped quote",
+            "\"all\", of\nthem\x02 \\",
+            ""
+        };
+        const size_t MESSAGE_COUNT = sizeof(MESSAGES) / sizeof(MESSAGES[0]);
+        const size_t FIELD_COUNT = 8;
+
+        // every message with and without key data
+        std::vector<BatchVerifier::Result> results;
+        for (size_t i = 0; i < 2 * MESSAGE_COUNT; i++){
+            BatchVerifier::Result result;
+            result.m_lineNumber = i + 1;
+            result.m_outcome = (i % 2 == 0) ? RETCODE_SUCCESS : RETCODE_PARSE_ERROR;
+            result.m_message = MESSAGES[i % MESSAGE_COUNT];
+            if (i < MESSAGE_COUNT){
+                result.m_hasKeyData = true;
+                result.m_keyLengthBits = 1024;
+                result.m_exponent = RandomBytes(3);
+                result.m_modulus = RandomBytes(128);
+                result.m_proof = RandomBytes(128);
+            }
+            results.push_back(result);
+        }
+
+        for (size_t f = 0; f < ResultWriter::FORMAT_COUNT; f++){
+            const ResultWriter::Format format = static_cast<ResultWriter::Format>(f);
+            std::ostringstream out;
+            ResultWriter writer(out, format);
+            Check(writer.writeAll(results) == RETCODE_PARSE_ERROR, "writeAll returns the worst outcome");
+            const std::string text = out.str();
+
+            if (format == ResultWriter::FORMAT_TEXT){
+                // the text format writes messages verbatim, as it always has
+                std::string expected;
+                for (size_t i = 0; i < results.size(); i++){
+                    expected += std::to_string(results[i].m_lineNumber) + "\t" + std::to_string(results[i].m_outcome) + "\t" + results[i].m_message + "\n";
+                }
+                Check(text == expected, "text output is line TAB outcome TAB message");
+
+            }else if (format == ResultWriter::FORMAT_JSONL){
+                // newlines in messages are escaped, so there is exactly one line per result
+                Check(text.empty() == false && text[text.length() - 1] == '\n', "JSONL output ends with a newline");
+                std::vector<std::string> lines;
+                for (size_t start = 0, end; start < text.length(); start = end + 1){
+                    end = text.find('\n', start);
+                    lines.push_back(text.substr(start, end - start));
+                }
+                Check(lines.size() == results.size(), "one JSONL line per result");
+                for (size_t i = 0; i < lines.size() && i < results.size(); i++){
+                    std::vector<std::pair<std::string, std::string> > members;
+                    Check(ParseJSONObject(lines[i], members) == true, "JSONL line " + std::to_string(i + 1) + " is a valid JSON object");
+                    Check(members.size() == FIELD_COUNT, "JSONL object has every field");
+                    if (members.size() != FIELD_COUNT){
+                        continue;
+                    }
+                    Check(members[0].first == "line" && members[0].second == std::to_string(results[i].m_lineNumber), "JSONL line number");
+                    Check(members[1].first == "outcome" && members[1].second == std::to_string(results[i].m_outcome), "JSONL outcome");
+                    Check(members[2].first == "verdict" && members[2].second == ResultWriter::getVerdictName(results[i].m_outcome), "JSONL verdict");
+                    Check(members[5].first == "modulus" && members[5].second == (results[i].m_hasKeyData ? ToHex(results[i].m_modulus) : "null"), "JSONL modulus");
+                    Check(members[7].first == "message" && members[7].second == results[i].m_message, "JSONL message round trips: " + std::to_string(i + 1));
+                }
+
+            }else{
+                std::vector<std::vector<std::string> > records;
+                Check(ParseCSV(text, records) == true, "CSV output is well formed");
+                Check(records.size() == results.size() + 1, "CSV header and one record per result");
+                for (size_t r = 0; r < records.size(); r++){
+                    Check(records[r].size() == FIELD_COUNT, "CSV record " + std::to_string(r) + " has " + std::to_string(FIELD_COUNT) + " fields");
+                }
+                Check(records.empty() == false && records[0].back() == "message", "CSV header ends with message");
+                for (size_t i = 0; i + 1 < records.size() && i < results.size(); i++){
+                    const std::vector<std::string>& record = records[i + 1];
+                    if (record.size() != FIELD_COUNT){
+                        continue;
+                    }
+                    Check(record[0] == std::to_string(results[i].m_lineNumber), "CSV line number");
+                    Check(record[1] == std::to_string(results[i].m_outcome), "CSV outcome");
+                    Check(record[5] == (results[i].m_hasKeyData ? ToHex(results[i].m_modulus) : ""), "CSV modulus");
+                    Check(record[7] == results[i].m_message, "CSV message round trips: " + std::to_string(i + 1));
+                }
+            }
+        }
+    }
+
+    //------------------------------------------------------------------
+    // trace
+
+    // a parsed JSON value; numbers keep their text
+    class JSONValue{
+        public:
+            enum Type{ TYPE_NULL, TYPE_BOOLEAN, TYPE_NUMBER, TYPE_STRING, TYPE_ARRAY, TYPE_OBJECT };
+
+            Type m_type;
+            std::string m_text;                                          // string value, number or literal text
+            std::vector<JSONValue> m_elements;                           // array elements
+            std::vector<std::pair<std::string, JSONValue> > m_members;   // object members, in order
+
+            JSONValue() : m_type(TYPE_NULL) {}
+
+            // returns the member called name, or nullptr
+            const JSONValue* find(const std::string& name) const {
+                for (size_t i = 0; i < this->m_members.size(); i++){
+                    if (this->m_members[i].first == name){
+                        return &this->m_members[i].second;
+                    }
+                }
+                return nullptr;
+            }
+
+            bool is(const Type type) const { return this->m_type == type; }
+    };
+
+    void SkipJSONWhitespace(const std::string& text, size_t& position){
+        while (position < text.length() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\n' || text[position] == '\r')){
+            position++;
+        }
+    }
+
+    // parses the JSON value at text[position] (after any whitespace), leaving position after it
+    //   returns false if the value is malformed
+    bool ParseJSONValue(const std::string& text, size_t& position, JSONValue& value){
+        SkipJSONWhitespace(text, position);
+        if (position >= text.length()){
+            return false;
+        }
+        const char c = text[position];
+        if (c == '"'){
+            value.m_type = JSONValue::TYPE_STRING;
+            return ParseJSONString(text, position, value.m_text);
+        }
+        if (c == '[' || c == '{'){
+            const bool isObject = (c == '{');
+            value.m_type = isObject ? JSONValue::TYPE_OBJECT : JSONValue::TYPE_ARRAY;
+            position++;
+            SkipJSONWhitespace(text, position);
+            if (position < text.length() && text[position] == (isObject ? '}' : ']')){
+                position++;
+                return true;
+            }
+            while (true){
+                if (isObject == true){
+                    std::pair<std::string, JSONValue> member;
+                    SkipJSONWhitespace(text, position);
+                    if (ParseJSONString(text, position, member.first) == false){
+                        return false;
+                    }
+                    SkipJSONWhitespace(text, position);
+                    if (position >= text.length() || text[position++] != ':' || ParseJSONValue(text, position, member.second) == false){
+                        return false;
+                    }
+                    value.m_members.push_back(member);
+                }else{
+                    value.m_elements.push_back(JSONValue());
+                    if (ParseJSONValue(text, position, value.m_elements.back()) == false){
+                        return false;
+                    }
+                }
+                SkipJSONWhitespace(text, position);
+                if (position >= text.length()){
+                    return false;
+                }
+                const char separator = text[position++];
+                if (separator == (isObject ? '}' : ']')){
+                    return true;
+                }
+                if (separator != ','){
+                    return false;
+                }
+            }
+        }
+        const char* const LITERALS[] = { "null", "true", "false" };
+        for (size_t i = 0; i < sizeof(LITERALS) / sizeof(LITERALS[0]); i++){
+            if (text.compare(position, strlen(LITERALS[i]), LITERALS[i]) == 0){
+                value.m_type = (i == 0) ? JSONValue::TYPE_NULL : JSONValue::TYPE_BOOLEAN;
+                value.m_text = LITERALS[i];
+                position += strlen(LITERALS[i]);
+                return true;
+            }
+        }
+
+        // number: -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+        const size_t start = position;
+        if (text[position] == '-'){
+            position++;
+        }
+        const size_t integerStart = position;
+        while (position < text.length() && isdigit(static_cast<unsigned char>(text[position])) != 0){
+            position++;
+        }
+        if (position == integerStart || (text[integerStart] == '0' && position - integerStart > 1)){
+            return false;
+        }
+        if (position < text.length() && text[position] == '.'){
+            const size_t fractionStart = ++position;
+            while (position < text.length() && isdigit(static_cast<unsigned char>(text[position])) != 0){
+                position++;
+            }
+            if (position == fractionStart){
+                return false;
+            }
+        }
+        if (position < text.length() && (text[position] == 'e' || text[position] == 'E')){
+            position++;
+            if (position < text.length() && (text[position] == '+' || text[position] == '-')){
+                position++;
+            }
+            const size_t exponentStart = position;
+            while (position < text.length() && isdigit(static_cast<unsigned char>(text[position])) != 0){
+                position++;
+            }
+            if (position == exponentStart){
+                return false;
+            }
+        }
+        value.m_type = JSONValue::TYPE_NUMBER;
+        value.m_text = text.substr(start, position - start);
+        return true;
+    }
+
+    // returns the nanoseconds of a trace timestamp or duration written as microseconds with three decimals
+    //   (exactly, with no rounding); returns -1 if the number is not written that way
+    int64_t TraceNanoseconds(const JSONValue& value){
+        const size_t point = value.m_text.find('.');
+        if (value.is(JSONValue::TYPE_NUMBER) == false || point == std::string::npos || point == 0 || value.m_text.length() != point + 4 ||
+            value.m_text.find_first_not_of("0123456789.") != std::string::npos){
+            return -1;
+        }
+        return std::stoll(value.m_text.substr(0, point)) * 1000 + std::stoll(value.m_text.substr(point + 1));
+    }
+
+    // trace test - stage spans of batch and pipeline runs (in builds with and without CKY_METRICS) written as a
+    // Chrome trace file that parses as JSON, with one named track per thread whose spans, taken as B/E pairs, match
+    void TestTrace(){
+        ScratchFiles scratch;
+        const std::string tracePath = scratch.add("CKYEnrollmentTests_trace.json");
+        const std::string fieldPath = scratch.add("CKYEnrollmentTests_trace_field.txt");
+
+        // before the manifest is read, so its splitting is traced too
+        TraceRecorder::enable();
+        Check(TraceRecorder::isEnabled() == true, "tracing enabled");
+
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+        const TestKey keyExponent3(1024, 3);
+        const TestKey* const keys[] = { &key1024, &key2048, &keyExponent3 };
+        std::string manifestText;
+        for (size_t i = 0; i < 12; ++i){
+            manifestText += BuildManifest(BuildRecords(*keys[i % 3]));
+        }
+        manifestText += "0g12 00112233445566778899aabbccddeeff\n";
+        const std::vector<TestRecord> fieldRecords(BuildRecords(key2048));
+        const std::string wrappedKeyHex(ToHex(fieldRecords[0].m_wrappedKey));
+        WriteFileBytes(fieldPath, std::vector<byte>(wrappedKeyHex.begin(), wrappedKeyHex.end()));
+        manifestText += ToHex(fieldRecords[0].m_iobuf) + " @" + fieldPath + "\n";
+        const size_t lineCount = static_cast<size_t>(std::count(manifestText.begin(), manifestText.end(), '\n'));
+        std::istringstream manifestStream(manifestText);
+        const BatchVerifier manifest(manifestStream);
+
+        // spans of several threads, from both batch modes
+        const std::vector<BatchVerifier::Result> results(manifest.verifyAll(3));
+        Check(results.size() == lineCount, "every record verified");
+        std::ostringstream pipelineOut;
+        ResultWriter writer(pipelineOut, ResultWriter::FORMAT_TEXT);
+        BatchPipeline pipeline(manifest, 2, 2, 2);
+        pipeline.run(writer, nullptr);
+
+        Check(TraceRecorder::tryWriteChromeTraceFile(tracePath) == true, "trace file written");
+        const std::vector<byte> traceBytes(ReadFileBytes(tracePath));
+        const std::string traceText(traceBytes.begin(), traceBytes.end());
+        std::ostringstream traceOut;
+        TraceRecorder::writeChromeTrace(traceOut);
+        Check(traceText == traceOut.str(), "trace file matches writeChromeTrace");
+
+        // the whole file is one JSON object
+        JSONValue trace;
+        size_t position = 0;
+        Check(ParseJSONValue(traceText, position, trace) == true, "trace is valid JSON");
+        SkipJSONWhitespace(traceText, position);
+        Check(position == traceText.length(), "nothing follows the trace object");
+        Check(trace.is(JSONValue::TYPE_OBJECT), "trace is a JSON object");
+        const JSONValue* const pEvents = trace.find("traceEvents");
+        Check(pEvents != nullptr && pEvents->is(JSONValue::TYPE_ARRAY), "traceEvents array");
+        const JSONValue* const pUnit = trace.find("displayTimeUnit");
+        Check(pUnit != nullptr && pUnit->is(JSONValue::TYPE_STRING) && (pUnit->m_text == "ms" || pUnit->m_text == "ns"), "displayTimeUnit");
+        const JSONValue* const pOtherData = trace.find("otherData");
+        const JSONValue* const pDropped = (pOtherData != nullptr) ? pOtherData->find("droppedSpans") : nullptr;
+        Check(pDropped != nullptr && pDropped->m_text == "0", "no spans dropped");
+
+        // every event, grouped into the tracks of its thread
+        std::vector<std::string> stageNames;
+        for (int stage = 0; stage < Metrics::STAGE_COUNT; ++stage){
+            stageNames.push_back(Metrics::getStageName(static_cast<Metrics::Stage>(stage)));
+        }
+        std::vector<std::string> namedThreads;
+        std::vector<std::pair<std::string, std::vector<std::pair<int64_t, int64_t> > > > tracks;
+        std::vector<std::string> stagesSeen;
+        for (size_t i = 0; i < pEvents->m_elements.size(); ++i){
+            const JSONValue& event = pEvents->m_elements[i];
+            const std::string name = "event " + std::to_string(i);
+            const JSONValue* const pName = event.find("name");
+            const JSONValue* const pPhase = event.find("ph");
+            const JSONValue* const pPid = event.find("pid");
+            const JSONValue* const pTid = event.find("tid");
+            Check(event.is(JSONValue::TYPE_OBJECT) && pName != nullptr && pName->is(JSONValue::TYPE_STRING) && pPhase != nullptr &&
+                  pPid != nullptr && pPid->is(JSONValue::TYPE_NUMBER) && pTid != nullptr && pTid->is(JSONValue::TYPE_NUMBER),
+                  name + ": name, ph, pid and tid");
+            const std::string& tid = pTid->m_text;
+            std::vector<std::pair<std::string, std::vector<std::pair<int64_t, int64_t> > > >::iterator track = tracks.begin();
+            while (track != tracks.end() && track->first != tid){
+                ++track;
+            }
+
+            if (pPhase->m_text == "M"){
+                // one thread_name event per thread, ahead of its spans
+                Check(pName->m_text == "thread_name", name + ": metadata names the thread");
+                Check(std::find(namedThreads.begin(), namedThreads.end(), tid) == namedThreads.end(), name + ": thread named once");
+                Check(track == tracks.end(), name + ": thread named before its spans");
+                namedThreads.push_back(tid);
+                continue;
+            }
+            Check(pPhase->m_text == "X", name + ": complete event");
+            Check(std::find(namedThreads.begin(), namedThreads.end(), tid) != namedThreads.end(), name + ": on a named thread");
+            Check(std::find(stageNames.begin(), stageNames.end(), pName->m_text) != stageNames.end(), name + ": a stage name");
+            if (std::find(stagesSeen.begin(), stagesSeen.end(), pName->m_text) == stagesSeen.end()){
+                stagesSeen.push_back(pName->m_text);
+            }
+            const JSONValue* const pTimestamp = event.find("ts");
+            const JSONValue* const pDuration = event.find("dur");
+            Check(pTimestamp != nullptr && pDuration != nullptr, name + ": ts and dur");
+            const int64_t start = TraceNanoseconds(*pTimestamp);
+            const int64_t duration = TraceNanoseconds(*pDuration);
+            Check(start >= 0 && duration >= 0, name + ": ts and dur in microseconds");
+            const JSONValue* const pArgs = event.find("args");
+            const JSONValue* const pRecord = (pArgs != nullptr) ? pArgs->find("record") : nullptr;
+            Check(pRecord != nullptr && pRecord->is(JSONValue::TYPE_NUMBER) && std::stoull(pRecord->m_text) <= lineCount, name + ": record is a manifest line");
+            if (track == tracks.end()){
+                tracks.push_back(std::make_pair(tid, std::vector<std::pair<int64_t, int64_t> >()));
+                track = tracks.end() - 1;
+            }
+            track->second.push_back(std::make_pair(start, start + duration));
+        }
+        Check(tracks.size() > 1, "spans of several threads");
+        const char* const EXPECTED_STAGES[] = { "read", "decode", "parse", "digest", "public_op" };
+        for (size_t i = 0; i < sizeof(EXPECTED_STAGES) / sizeof(EXPECTED_STAGES[0]); ++i){
+            Check(std::find(stagesSeen.begin(), stagesSeen.end(), EXPECTED_STAGES[i]) != stagesSeen.end(), std::string("spans of stage ") + EXPECTED_STAGES[i]);
+        }
+
+        // each span is a begin (B) and end (E) event on its thread: in time order, every E must close the innermost open
+        //   span, so spans of one thread nest or follow each other but never partly overlap
+        for (size_t t = 0; t < tracks.size(); ++t){
+            std::vector<std::pair<int64_t, int64_t> > spans(tracks[t].second);
+            // by start, and the longer of two spans starting together first (it encloses the other)
+            std::sort(spans.begin(), spans.end(), [](const std::pair<int64_t, int64_t>& a, const std::pair<int64_t, int64_t>& b){
+                return (a.first != b.first) ? a.first < b.first : a.second > b.second;
+            });
+            std::vector<int64_t> openEnds;
+            bool matched = true;
+            for (size_t i = 0; i < spans.size(); ++i){
+                while (openEnds.empty() == false && openEnds.back() <= spans[i].first){
+                    openEnds.pop_back();
+                }
+                if (openEnds.empty() == false && spans[i].second > openEnds.back()){
+                    matched = false;
+                }
+                openEnds.push_back(spans[i].second);
+            }
+            Check(matched, "thread " + tracks[t].first + ": B and E events match");
+        }
+    }
+
+    //------------------------------------------------------------------
+    // challenge-key
+
+    // challenge key test - ChallengeKeySearch finds the wrappedkey of a generated manifest line among random candidates,
+    // reports malformed and unreadable candidates as input errors, and matches nothing for a damaged proof
+    void TestChallengeKey(){
+        ScratchFiles scratch;
+        const std::string fieldPath = scratch.add("CKYEnrollmentTests_challenge_field.txt");
+
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+        const TestKey keyExponent3(1024, 3);
+        const TestKey* const keys[] = { &key1024, &key2048, &keyExponent3 };
+        for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k){
+            const std::string keyName = "key " + std::to_string(k);
+            const std::vector<TestRecord> records(BuildRecords(*keys[k]));
+
+            // the fields of the record's manifest line: the iobuf to search for, and the wrappedkey to find
+            const std::string manifestText(BuildManifest(std::vector<TestRecord>(1, records[0])));
+            std::istringstream lineStream(manifestText);
+            std::string iobufField;
+            std::string wrappedKeyField;
+            lineStream >> iobufField >> wrappedKeyField;
+            std::istringstream manifestStream(manifestText);
+            const BatchVerifier manifest(manifestStream);
+            Check(manifest.verifyAll(1)[0].m_outcome == RETCODE_SUCCESS, keyName + ": the manifest line verifies");
+
+            // random misses around a hit, the hit again through an '@' file, and malformed and unreadable lines
+            const std::string wrappedKeyHex(ToHex(records[0].m_wrappedKey));
+            WriteFileBytes(fieldPath, std::vector<byte>(wrappedKeyHex.begin(), wrappedKeyHex.end()));
+            std::vector<int> expected;
+            std::string candidateText("# candidates\n\n");
+            for (size_t i = 0; i < 40; ++i){
+                std::vector<byte> candidate(RandomBytes(WRAPPED_KEY_LENGTH));
+                if (candidate == records[0].m_wrappedKey){
+                    candidate[0] ^= 0x01;
+                }
+                if (i == 17){
+                    candidateText += wrappedKeyField + "\n";
+                    expected.push_back(RETCODE_SUCCESS);
+                }
+                candidateText += ToHex(candidate) + "   trailing fields are ignored\n";
+                expected.push_back(RETCODE_VERIFY_ERROR);
+            }
+            candidateText += wrappedKeyHex.substr(0, wrappedKeyHex.length() - 2) + "\n";
+            expected.push_back(RETCODE_VERIFY_ERROR);
+            candidateText += "0g" + wrappedKeyHex.substr(2) + "\n";
+            expected.push_back(RETCODE_INPUT_ERROR);
+            candidateText += wrappedKeyHex.substr(1) + "\n";
+            expected.push_back(RETCODE_INPUT_ERROR);
+            candidateText += "@" + fieldPath + "\n";
+            expected.push_back(RETCODE_SUCCESS);
+            candidateText += "@CKYEnrollmentTests_missing.txt\n";
+            expected.push_back(RETCODE_INPUT_ERROR);
+
+            std::istringstream candidateStream(candidateText);
+            const std::vector<ChallengeKeySearch::Candidate> candidates(ChallengeKeySearch::readCandidates(candidateStream));
+            Check(candidates.size() == expected.size(), keyName + ": comments and blank lines skipped");
+            Check(candidates.empty() == false && candidates[0].m_lineNumber == 3, keyName + ": candidate line numbers");
+
+            const std::vector<byte> iobuf(Convert_ASCIIHex_To_Byte(iobufField));
+            Check(iobuf == records[0].m_iobuf, keyName + ": iobuf field decodes");
+            const ChallengeKeySearch search(iobuf);
+            Check(search.getRecoveryStatus().isOk() == true, keyName + ": digest recovered");
+            std::vector<ChallengeKeySearch::Result> firstResults;
+            for (size_t threadCount = 1; threadCount <= 3; threadCount += 2){
+                const std::string name = keyName + ", " + std::to_string(threadCount) + " threads";
+                const std::vector<ChallengeKeySearch::Result> results(search.search(candidates, threadCount));
+                Check(Outcomes(results) == expected, name + ": hits, misses and malformed candidates");
+                for (size_t i = 0; i < results.size() && i < candidates.size(); ++i){
+                    Check(results[i].m_lineNumber == candidates[i].m_lineNumber, name + ": result line numbers");
+                }
+                if (threadCount == 1){
+                    firstResults = results;
+                }else{
+                    Check(LinesAndOutcomes(results) == LinesAndOutcomes(firstResults), name + ": results match one thread");
+                }
+            }
+
+            // run() lists the hits and the unloadable candidates only
+            std::ostringstream out;
+            Check(search.run(candidates, out, 2) == RETCODE_SUCCESS, keyName + ": a hit is success");
+            std::string expectedOut;
+            for (size_t i = 0; i < firstResults.size(); ++i){
+                if (firstResults[i].m_outcome != RETCODE_VERIFY_ERROR){
+                    expectedOut += std::to_string(firstResults[i].m_lineNumber) + "\t" + std::to_string(firstResults[i].m_outcome) + "\t" + firstResults[i].m_message + "\n";
+                }
+            }
+            Check(out.str() == expectedOut, keyName + ": run lists hits and input errors");
+
+            // without the hits, only the input errors are listed and the run fails
+            std::vector<ChallengeKeySearch::Candidate> misses;
+            for (size_t i = 0; i < candidates.size(); ++i){
+                if (expected[i] != RETCODE_SUCCESS){
+                    misses.push_back(candidates[i]);
+                }
+            }
+            std::ostringstream missOut;
+            Check(search.run(misses, missOut, 1) == RETCODE_VERIFY_ERROR, keyName + ": no hit is a verification error");
+            const std::string missText(missOut.str());
+            Check(std::count(missText.begin(), missText.end(), '\n') == 3, keyName + ": only the input errors listed");
+
+            // a damaged proof matches no candidate, the right one included; a truncated iobuf cannot be searched
+            const ChallengeKeySearch damaged(records[2].m_iobuf);
+            const std::vector<ChallengeKeySearch::Result> damagedResults(damaged.search(candidates, 2));
+            bool anyMatched = false;
+            for (size_t i = 0; i < damagedResults.size(); ++i){
+                anyMatched = anyMatched || damagedResults[i].m_outcome == RETCODE_SUCCESS;
+            }
+            Check(anyMatched == false, keyName + ": damaged proof matches nothing");
+            std::ostringstream damagedOut;
+            Check(damaged.run(candidates, damagedOut, 1) != RETCODE_SUCCESS, keyName + ": damaged proof run fails");
+            CheckThrows([&](){ ChallengeKeySearch truncated(records[3].m_iobuf); }, keyName + ": truncated iobuf refused");
+        }
+    }
+
+    //------------------------------------------------------------------
+    // arena
+
+    // returns true if arena.allocate(size) throws std::bad_alloc
+    bool AllocateThrowsBadAlloc(ByteArena& arena, const size_t size){
+        try{
+            arena.allocate(size);
+        }catch (std::bad_alloc&){
+            return true;
+        }
+        return false;
+    }
+
+    // arena test - ByteArena allocations are aligned and disjoint, reset() reuses every block without allocating,
+    // oversized requests get blocks of their own, and sizes that cannot be rounded up are refused
+    void TestArena(){
+        const size_t BLOCK_SIZE = 1024;
+        ByteArena arena(BLOCK_SIZE);
+        Check(arena.getBlockCount() == 0 && arena.getCapacity() == 0, "nothing allocated before the first allocation");
+
+        // a mix of sizes, including 0, unaligned sizes, exactly a block and more than a block
+        std::vector<size_t> sizes;
+        for (size_t i = 0; i < 200; ++i){
+            const size_t choice = g_random() % 10;
+            sizes.push_back((choice == 0) ? 0 : (choice == 1) ? BLOCK_SIZE : (choice == 2) ? BLOCK_SIZE + 1 + g_random() % (3 * BLOCK_SIZE) : 1 + g_random() % 300);
+        }
+
+        std::vector<byte*> first;
+        for (int pass = 0; pass < 3; ++pass){
+            const std::string name = "pass " + std::to_string(pass);
+            const size_t blockCount = arena.getBlockCount();
+            const size_t capacity = arena.getCapacity();
+            std::vector<byte*> pointers;
+            for (size_t i = 0; i < sizes.size(); ++i){
+                byte* const pData = arena.allocate(sizes[i]);
+                Check(pData != nullptr && reinterpret_cast<uintptr_t>(pData) % ByteArena::ALIGNMENT == 0, name + ": allocation aligned");
+                std::memset(pData, static_cast<int>(i & 0xFF), sizes[i]);
+                pointers.push_back(pData);
+            }
+
+            // every allocation kept its contents, so none overlaps another
+            bool intact = true;
+            for (size_t i = 0; i < sizes.size(); ++i){
+                for (size_t j = 0; j < sizes[i]; ++j){
+                    intact = intact && pointers[i][j] == static_cast<byte>(i & 0xFF);
+                }
+            }
+            Check(intact, name + ": allocations are disjoint");
+            std::vector<byte*> sorted(pointers);
+            std::sort(sorted.begin(), sorted.end());
+            Check(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end(), name + ": zero-size allocations are distinct");
+
+            if (pass == 0){
+                first = pointers;
+                Check(arena.getBlockCount() > 1, "several blocks used");
+                Check(arena.getCapacity() >= BLOCK_SIZE * arena.getBlockCount(), "blocks are at least the block size");
+            }else{
+                // the same sizes after reset() are served from the same blocks, at the same addresses
+                Check(arena.getBlockCount() == blockCount && arena.getCapacity() == capacity, name + ": no block added after reset");
+                Check(pointers == first, name + ": the same memory handed out after reset");
+            }
+            arena.reset();
+        }
+
+        // after a reset, a request larger than every block gets a block of its own, exactly its rounded size
+        const size_t blockCount = arena.getBlockCount();
+        const size_t capacity = arena.getCapacity();
+        const size_t largeSize = 64 * BLOCK_SIZE + 3;
+        const size_t roundedLargeSize = (largeSize + ByteArena::ALIGNMENT - 1) / ByteArena::ALIGNMENT * ByteArena::ALIGNMENT;
+        arena.allocate(largeSize);
+        Check(arena.getBlockCount() == blockCount + 1 && arena.getCapacity() == capacity + roundedLargeSize, "large request gets its own block");
+        arena.reset();
+        Check(arena.allocate(1) == first[0], "first block reused after a large request");
+
+        // sizes within ALIGNMENT of SIZE_MAX would round to a tiny allocation: refused, leaving the arena as it was
+        arena.reset();
+        const size_t maxSize = std::numeric_limits<size_t>::max();
+        const size_t refused[] = { maxSize, maxSize - 1, maxSize - ByteArena::ALIGNMENT + 2, maxSize - ByteArena::ALIGNMENT + 1 };
+        for (size_t i = 0; i < sizeof(refused) / sizeof(refused[0]); ++i){
+            Check(AllocateThrowsBadAlloc(arena, refused[i]) == true, "size SIZE_MAX - " + std::to_string(maxSize - refused[i]) + " refused");
+        }
+        Check(arena.getBlockCount() == blockCount + 1 && arena.getCapacity() == capacity + roundedLargeSize, "refused sizes add no block");
+        Check(arena.allocate(1) == first[0], "arena usable after refused sizes");
+        Check(AllocateThrowsBadAlloc(arena, maxSize - ByteArena::ALIGNMENT) == true, "size SIZE_MAX - ALIGNMENT fails to allocate");
+    }
+
+    //------------------------------------------------------------------
+    // shared-result
+
+    // shared result test - parsed key gen results verified from several threads at once, each thread switching
+    // between results, give the outcomes of verifying them one at a time
+    void TestSharedResult(){
+        const TestKey key1024(1024, 65537);
+        const TestKey key2048(2048, 65537);
+        const TestKey keyExponent3(1024, 3);
+        const TestKey* const keys[] = { &key1024, &key2048, &keyExponent3 };
+
+        // the signed record of each key, with its own and a wrong challenge key, and a record whose proof is damaged
+        std::vector<TestRecord> records;
+        for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); ++k){
+            const std::vector<TestRecord> keyRecords(BuildRecords(*keys[k]));
+            records.push_back(keyRecords[0]);
+            records.push_back(keyRecords[1]);
+            records.push_back(keyRecords[2]);
+        }
+        std::vector<std::unique_ptr<CoolkeyRSAKeyGenResult> > results;
+        for (size_t i = 0; i < records.size(); ++i){
+            results.push_back(std::unique_ptr<CoolkeyRSAKeyGenResult>(new CoolkeyRSAKeyGenResult(records[i].m_iobuf)));
+        }
+
+        // one at a time, on this thread - including results constructed before the latest one
+        for (size_t i = 0; i < records.size(); ++i){
+            const CoolkeyStatus status = CoolkeyRSAKeyGenResult::tryVerifySignature(results[i]->getBlob(), results[i]->getProofData().data(), results[i]->getProofSize(),
+                                                                                   records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size());
+            Check(status.isOk() == records[i].m_valid, "record " + std::to_string(i) + ": verified alone");
+        }
+
+        // every thread verifies every result many times, in its own order
+        const size_t THREAD_COUNT = 4;
+        const size_t ROUNDS = 200;
+        std::atomic<size_t> wrongOutcomes(0);
+        std::atomic<size_t> verifications(0);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREAD_COUNT; ++t){
+            threads.push_back(std::thread([&, t](){
+                for (size_t round = 0; round < ROUNDS; ++round){
+                    for (size_t j = 0; j < records.size(); ++j){
+                        // every thread walks the results at a different stride, so threads share results at different times
+                        const size_t i = (j * (2 * t + 1) + round) % records.size();
+                        const CoolkeyStatus status = CoolkeyRSAKeyGenResult::tryVerifySignature(results[i]->getBlob(), results[i]->getProofData().data(),
+                                                                                               results[i]->getProofSize(), records[i].m_wrappedKey.data(),
+                                                                                               records[i].m_wrappedKey.size());
+                        if (status.isOk() != records[i].m_valid){
+                            ++wrongOutcomes;
+                        }
+                        // the same result twice in a row reuses the thread's context
+                        if (round % 3 == 0){
+                            bool verified = true;
+                            try{
+                                results[i]->verifySignature(records[i].m_wrappedKey);
+                            }catch (std::runtime_error&){
+                                verified = false;
+                            }
+                            if (verified != records[i].m_valid){
+                                ++wrongOutcomes;
+                            }
+                        }
+                        ++verifications;
+                    }
+                }
+            }));
+        }
+        for (size_t t = 0; t < threads.size(); ++t){
+            threads[t].join();
+        }
+        Check(verifications == THREAD_COUNT * ROUNDS * records.size(), "every verification made");
+        Check(wrongOutcomes == 0, "concurrent verifications give the single-threaded outcomes");
+
+#if defined(CKY_OPENSSL3_BACKEND)
+        // the OpenSSL contexts themselves: one per thread, reused by a thread until it moves on to another blob
+        const CoolkeyRSAKeyBlob& blob = results[0]->getBlob();
+        EVP_PKEY_CTX* const pOwnContext = blob.getOpensslVerifyContext();
+        Check(pOwnContext != nullptr && blob.getOpensslVerifyContext() == pOwnContext, "a thread reuses its verify context");
+        EVP_PKEY_CTX* pOtherContext = nullptr;
+        std::thread other([&](){ pOtherContext = blob.getOpensslVerifyContext(); });
+        other.join();
+        Check(pOtherContext != nullptr && pOtherContext != pOwnContext, "another thread gets a verify context of its own");
+        Check(results[1]->getBlob().getOpensslVerifyContext() != nullptr && blob.getOpensslVerifyContext() != nullptr, "switching blobs prepares a new context");
+#endif
+
+        // results outlive the threads that verified them, and a new result verifies after the old ones are gone
+        results.clear();
+        const CoolkeyRSAKeyGenResult fresh(records[0].m_iobuf);
+        Check(CoolkeyRSAKeyGenResult::tryVerifySignature(fresh.getBlob(), fresh.getProofData().data(), fresh.getProofSize(),
+                                                         records[0].m_wrappedKey.data(), records[0].m_wrappedKey.size()).isOk(), "new result verifies");
+    }
+}
+
+//----------------------------------------------------------------------
+
+int main(int argc, const char** const argv){
+    if (argc != 2){
+        PrintUsage();
+        return RETCODE_USAGE;
+    }
+    const std::string test(argv[1]);
+
+    try{
+        if (test == "pool"){
+            TestPool();
+        }else if (test == "hex"){
+            TestHex();
+        }else if (test == "hex-stream"){
+            TestHexStream();
+        }else if (test == "status"){
+            TestStatus();
+        }else if (test == "verifier"){
+            TestVerifier();
+        }else if (test == "sha1"){
+            TestSHA1();
+        }else if (test == "rsa"){
+            TestRSA();
+        }else if (test == "fixed-records"){
+            TestFixedRecords();
+        }else if (test == "archive"){
+            TestArchive();
+        }else if (test == "cache"){
+            TestCache();
+        }else if (test == "index"){
+            TestIndex();
+        }else if (test == "shared-factors"){
+            TestSharedFactors();
+        }else if (test == "capi"){
+            TestCAPI();
+        }else if (test == "daemon"){
+            TestDaemon();
+        }else if (test == "daemon-cache"){
+            TestDaemonCache();
+        }else if (test == "pipeline"){
+            TestPipeline();
+        }else if (test == "metrics"){
+            TestMetrics();
+        }else if (test == "writer"){
+            TestWriter();
+        }else if (test == "trace"){
+            TestTrace();
+        }else if (test == "challenge-key"){
+            TestChallengeKey();
+        }else if (test == "arena"){
+            TestArena();
+        }else if (test == "shared-result"){
+            TestSharedResult();
+        }else{
+            PrintUsage();
+            return RETCODE_USAGE;
+        }
+    }catch (std::exception& e){
+        std::cerr << test << ": " << e.what() << " (after " << g_checkCount << " checks)" << std::endl;
+        return 1;
+    }
+
+    std::cout << test << ": " << g_checkCount << " checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,1339 @@
+/*
+ * CKYStartEnrollmentBenchmark - Measures the throughput of parsing and
+ *              verifying Coolkey SecureStartEnrollment() results.
+ *
+ * Written by Aaron Curley
+ */
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+
+#include <stdexcept>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <memory> // unique_ptr
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <algorithm> // min
+#include <ctime>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+
+#include "ArchiveBatchVerifier.h"
+#include "BatchPipeline.h"
+#include "BatchVerifier.h"
+#include "ByteArena.h"
+#include "CoolkeyRSAKeyBlob.h"
+#include "CoolkeyRSAKeyGenResult.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "CoolkeyRSAVerifier.h"
+#include "CoolkeyStatus.h"
+#include "EnrollmentArchiveReader.h"
+#include "EnrollmentArchiveWriter.h"
+#include "FixedSizeRSA.h"
+#include "HexDecoder.h"
+#include "Metrics.h"
+#include "MultiBufferSHA1.h"
+#include "OpenSSLAlgorithms.h"
+#include "ResultWriter.h"
+#include "VerificationDaemon.h"
+#include "VerificationWorkerPool.h"
+
+#include "benchmark/FixedKeyGenResult.h"
+#include "benchmark/KeyGenResultDispatcher.h"
+
+//----------------------------------------------------------------------
+// allocation counters for the verifier, records and memory benchmarks
+
+namespace{
+    std::atomic<size_t> g_openSSLAllocations(0);  // calls to OpenSSL's malloc/realloc hooks
+    std::atomic<size_t> g_newAllocations(0);      // calls to global operator new
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    void* CountingOpenSSLMalloc(size_t size){
+        ++g_openSSLAllocations;
+        return std::malloc(size);
+    }
+    void* CountingOpenSSLRealloc(void* p, size_t size){
+        ++g_openSSLAllocations;
+        return std::realloc(p, size);
+    }
+    void CountingOpenSSLFree(void* p){
+        std::free(p);
+    }
+#else
+    void* CountingOpenSSLMalloc(size_t size, const char*, int){
+        ++g_openSSLAllocations;
+        return std::malloc(size);
+    }
+    void* CountingOpenSSLRealloc(void* p, size_t size, const char*, int){
+        ++g_openSSLAllocations;
+        return std::realloc(p, size);
+    }
+    void CountingOpenSSLFree(void* p, const char*, int){
+        std::free(p);
+    }
+#endif
+}
+
+// counting replacements of the global allocation functions
+void* operator new(size_t size){
+    ++g_newAllocations;
+    void* p = std::malloc((size == 0) ? 1 : size);
+    if (p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+void operator delete(void* p) noexcept{
+    std::free(p);
+}
+
+//----------------------------------------------------------------------
+
+namespace{
+    // minimum wall time spent measuring each configuration
+    const double MIN_MEASUREMENT_SECONDS = 1.0;
+
+    // prints usage information
+    void PrintUsage(){
+        std::cout << PROGRAM_NAME << " benchmark  -  " << PROGRAM_VERSION << std::endl;
+        std::cout << std::endl;
+        std::cout << "Usage:  CKYStartEnrollmentBenchmark scaling <manifest file> [max threads]" << std::endl;
+        std::cout << "  Verifies every manifest record with 1, 2, 4, ... up to max threads" << std::endl;
+        std::cout << "  (default: one per CPU) and reports records per second for each." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark hex" << std::endl;
+        std::cout << "  Reports ASCII-hex decoding throughput (GB/s of input text) of the original" << std::endl;
+        std::cout << "  stringstream decoder and each HexDecoder implementation on this CPU." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark errors <manifest file>" << std::endl;
+        std::cout << "  Mixes the manifest records with truncated copies (0% to 100% invalid) and" << std::endl;
+        std::cout << "  reports records per second of the throwing and the status-returning API." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark verifier <manifest file>" << std::endl;
+        std::cout << "  Compares per-call OpenSSL key/context setup with a reused CoolkeyRSAVerifier:" << std::endl;
+        std::cout << "  records per second and heap allocations (OpenSSL and C++) per verification." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark sha1 <manifest file>" << std::endl;
+        std::cout << "  Compares per-record EVP SHA-1 with each MultiBufferSHA1 implementation on this" << std::endl;
+        std::cout << "  CPU, for the digests alone and within full verification (records per second)." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark rsa <manifest file>" << std::endl;
+        std::cout << "  Reports the per-verification latency (mean, median, 99th percentile) of the" << std::endl;
+        std::cout << "  per-call, reused OpenSSL and fixed-size (FixedSizeRSA) paths." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark records <manifest file>" << std::endl;
+        std::cout << "  Compares parsing into in-place views with parsing into contiguous arrays of" << std::endl;
+        std::cout << "  FixedKeyGenResult records: records per second and heap allocations per record." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark archive <manifest file> <archive file>" << std::endl;
+        std::cout << "  Converts the manifest into an enrollment archive (overwriting archive file) and" << std::endl;
+        std::cout << "  compares loading and verifying the records from each: records per second." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark output <manifest file>" << std::endl;
+        std::cout << "  Compares per-field iostream formatting of the key fields with ResultWriter's" << std::endl;
+        std::cout << "  text, JSONL and CSV output: records per second and MB/s of output." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark stages <manifest file> [text|jsonl|csv] [results file]" << std::endl;
+        std::cout << "  Measures hex decoding, parsing, OpenSSL key construction and verification separately" << std::endl;
+        std::cout << "  (per key size) and end to end: records per second and ns per record.  jsonl and csv" << std::endl;
+        std::cout << "  rows carry the OpenSSL version, backend and compiler; a results file is appended to." << std::endl;
+        std::cout << "        CKYStartEnrollmentBenchmark memory <manifest file> [seconds]" << std::endl;
+        std::cout << "  Runs field loading, batch verification, the pipeline and daemon requests for seconds" << std::endl;
+        std::cout << "  each (default: 5) and reports heap allocations per record (OpenSSL and C++) and RSS." << std::endl;
+        std::cout << "Timing only: the correctness checks are run by CKYEnrollmentTests (ctest)." << std::endl;
+        std::cout << std::endl;
+    }
+
+    // original stringstream-based decoder, kept as the baseline for the hex benchmark
+    std::vector<byte> LegacyConvertASCIIHexToByte(std::string str){
+        // strip out any separator characters from this string
+        StringReplaceAll(str, ":", "");
+        StringReplaceAll(str, " ", "");
+
+        std::vector<byte> result;
+
+        std::stringstream converter;
+        size_t pos = 1;
+        while (pos < str.length()){
+            std::string twoChars(str.substr(pos - 1, 2));
+            converter.clear();
+            converter << std::hex << twoChars;
+            int temp;
+            converter >> temp;
+            result.push_back(static_cast<byte>(temp));
+            pos += 2;
+        }
+
+        return result;
+    }
+
+    // calls decodeOnce repeatedly for at least MIN_MEASUREMENT_SECONDS; returns GB/s of textLength-sized input
+    template<typename DecodeFunction>
+    double MeasureGigabytesPerSecond(const size_t textLength, DecodeFunction decodeOnce){
+        size_t bytesProcessed = 0;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsedSeconds = 0.0;
+        do{
+            decodeOnce();
+            bytesProcessed += textLength;
+            elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }while (elapsedSeconds < MIN_MEASUREMENT_SECONDS);
+        return (bytesProcessed / elapsedSeconds) / 1.0e9;
+    }
+
+    // hex benchmark - decoding throughput of each implementation on plain and colon-separated text
+    void RunHexBenchmark(){
+        // 32 KiB of random data, as plain hex and as AA:BB:CC hex
+        const size_t DATA_LENGTH = 32 * 1024;
+        static const char HEX_DIGITS[] = "0123456789ABCDEF";
+        std::string plainText;
+        std::string separatedText;
+        uint32_t seed = 12345;
+        for (size_t i = 0; i < DATA_LENGTH; ++i){
+            seed = seed * 1103515245u + 12345u;
+            const byte value = static_cast<byte>(seed >> 16);
+            plainText += HEX_DIGITS[value >> 4];
+            plainText += HEX_DIGITS[value & 0x0F];
+            separatedText += HEX_DIGITS[value >> 4];
+            separatedText += HEX_DIGITS[value & 0x0F];
+            separatedText += ':';
+        }
+        separatedText.erase(separatedText.length() - 1);
+
+        const std::string* const inputs[] = { &plainText, &separatedText };
+        const char* const inputNames[] = { "plain", "separated" };
+
+        std::cout << std::setw(12) << "input" << std::setw(12) << "decoder" << std::setw(12) << "GB/s" << "\n";
+        for (size_t inputIndex = 0; inputIndex < 2; ++inputIndex){
+            const std::string& text = *inputs[inputIndex];
+
+            const double legacyRate = MeasureGigabytesPerSecond(text.length(), [&text](){
+                LegacyConvertASCIIHexToByte(text);
+            });
+            std::cout << std::setw(12) << inputNames[inputIndex] << std::setw(12) << "legacy"
+                      << std::setw(12) << std::fixed << std::setprecision(4) << legacyRate << std::endl;
+
+            for (int impl = 0; impl < HexDecoder::IMPLEMENTATION_COUNT; ++impl){
+                const HexDecoder::Implementation implementation = static_cast<HexDecoder::Implementation>(impl);
+                if (HexDecoder::isSupported(implementation) == false){
+                    continue;
+                }
+
+                std::vector<byte> decoded;
+                size_t errorOffset;
+                const double rate = MeasureGigabytesPerSecond(text.length(), [&text, &decoded, &errorOffset, implementation](){
+                    decoded.clear();
+                    HexDecoder::decode(implementation, text.data(), text.length(), decoded, errorOffset);
+                });
+                std::cout << std::setw(12) << inputNames[inputIndex] << std::setw(12) << HexDecoder::getImplementationName(implementation)
+                          << std::setw(12) << std::fixed << std::setprecision(4) << rate << std::endl;
+            }
+        }
+    }
+
+    // opens and reads a batch manifest
+    //   throws std::runtime_error on failure
+    std::unique_ptr<BatchVerifier> LoadManifest(const std::string& manifest_filepath){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(new BatchVerifier(manifest_filepath));
+        if (pBatchVerifier->getRecordCount() == 0){
+            throw std::runtime_error("Manifest file contains no records.");
+        }
+        return pBatchVerifier;
+    }
+
+    // verifies all records repeatedly with the given thread count; returns records per second
+    double MeasureRecordsPerSecond(const BatchVerifier& batchVerifier, const size_t threadCount){
+        size_t recordsProcessed = 0;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsedSeconds = 0.0;
+        do{
+            batchVerifier.verifyAll(threadCount);
+            recordsProcessed += batchVerifier.getRecordCount();
+            elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }while (elapsedSeconds < MIN_MEASUREMENT_SECONDS);
+        return recordsProcessed / elapsedSeconds;
+    }
+
+    // scaling benchmark - records per second from 1 to maxThreads threads
+    void RunScalingBenchmark(const std::string& manifest_filepath, const size_t maxThreads){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(LoadManifest(manifest_filepath));
+
+        // one warm-up pass so that file caches and OpenSSL tables are populated
+        pBatchVerifier->verifyAll(maxThreads);
+
+        std::cout << "records: " << pBatchVerifier->getRecordCount() << "\n";
+        std::cout << std::setw(8) << "threads" << std::setw(16) << "records/s" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << "\n";
+
+        double baseline = 0.0;
+        for (size_t threadCount = 1; ; threadCount *= 2){
+            if (threadCount > maxThreads){
+                threadCount = maxThreads;
+            }
+            const double recordsPerSecond = MeasureRecordsPerSecond(*pBatchVerifier, threadCount);
+            if (threadCount == 1){
+                baseline = recordsPerSecond;
+            }
+            const double speedup = recordsPerSecond / baseline;
+            std::cout << std::setw(8) << threadCount
+                      << std::setw(16) << std::fixed << std::setprecision(1) << recordsPerSecond
+                      << std::setw(10) << std::setprecision(2) << speedup
+                      << std::setw(11) << std::setprecision(1) << (100.0 * speedup / threadCount) << "%"
+                      << std::endl;
+            if (threadCount == maxThreads){
+                break;
+            }
+        }
+    }
+
+    // one decoded record of the error benchmark
+    class DecodedRecord{
+        public:
+            std::vector<byte> m_iobuf;
+            std::vector<byte> m_wrappedKey;
+    };
+
+    // parses and verifies one record with the throwing API; returns true if it verified
+    bool VerifyThrowing(const DecodedRecord& record){
+        try{
+            const CoolkeyRSAKeyGenResult keyGenResult(record.m_iobuf);
+            keyGenResult.verifySignature(record.m_wrappedKey);
+        }catch (std::runtime_error&){
+            return false;
+        }
+        return true;
+    }
+
+    // parses and verifies one record with the status-returning API; returns true if it verified
+    bool VerifyStatus(const DecodedRecord& record){
+        CoolkeyRSAKeyGenResultView view;
+        if (view.tryParse(record.m_iobuf.data(), record.m_iobuf.size()).isOk() == false){
+            return false;
+        }
+        return CoolkeyRSAKeyGenResult::tryVerifySignature(view, record.m_wrappedKey.data(), record.m_wrappedKey.size()).isOk();
+    }
+
+    // calls verifyOnce on every record repeatedly; returns records per second
+    template<typename VerifyFunction>
+    double MeasureMixRecordsPerSecond(const std::vector<DecodedRecord>& records, VerifyFunction verifyOnce){
+        size_t recordsProcessed = 0;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsedSeconds = 0.0;
+        do{
+            for (size_t i = 0; i < records.size(); ++i){
+                verifyOnce(records[i]);
+            }
+            recordsProcessed += records.size();
+            elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }while (elapsedSeconds < MIN_MEASUREMENT_SECONDS);
+        return recordsProcessed / elapsedSeconds;
+    }
+
+    // error benchmark - throughput of both APIs as the share of truncated records grows
+    void RunErrorBenchmark(const std::string& manifest_filepath){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(LoadManifest(manifest_filepath));
+
+        // decode every record that can be loaded
+        std::vector<DecodedRecord> sourceRecords;
+        for (size_t i = 0; i < pBatchVerifier->getRecordCount(); ++i){
+            const BatchVerifier::Record& record = pBatchVerifier->getRecords()[i];
+            if (record.m_fieldCount != 2){
+                continue;
+            }
+            try{
+                DecodedRecord decoded;
+                decoded.m_iobuf = BatchVerifier::loadField(record.m_fields[0]);
+                decoded.m_wrappedKey = BatchVerifier::loadField(record.m_fields[1]);
+                sourceRecords.push_back(decoded);
+            }catch (std::runtime_error&){
+                // unreadable field - not useful for this benchmark
+            }
+        }
+        if (sourceRecords.empty() == true){
+            throw std::runtime_error("Manifest file contains no loadable records.");
+        }
+
+        // mixes of at least 1000 records with a growing share truncated at a pseudo-random length
+        const size_t MIX_SIZE = (sourceRecords.size() < 1000) ? 1000 : sourceRecords.size();
+        const int INVALID_PERCENTAGES[] = { 0, 25, 50, 75, 100 };
+
+        std::cout << "source records: " << sourceRecords.size() << "  mix size: " << MIX_SIZE << "\n";
+        std::cout << std::setw(10) << "invalid" << std::setw(16) << "throwing/s" << std::setw(16) << "status/s" << std::setw(10) << "speedup" << "\n";
+        for (size_t p = 0; p < sizeof(INVALID_PERCENTAGES) / sizeof(INVALID_PERCENTAGES[0]); ++p){
+            std::vector<DecodedRecord> mix;
+            mix.reserve(MIX_SIZE);
+            uint32_t seed = 12345;
+            for (size_t i = 0; i < MIX_SIZE; ++i){
+                mix.push_back(sourceRecords[i % sourceRecords.size()]);
+                // spread the invalid records evenly through the mix
+                const size_t percentage = static_cast<size_t>(INVALID_PERCENTAGES[p]);
+                if (((i + 1) * percentage) / 100 != (i * percentage) / 100){
+                    seed = seed * 1103515245u + 12345u;
+                    std::vector<byte>& iobuf = mix.back().m_iobuf;
+                    iobuf.resize((iobuf.empty() == true) ? 0 : ((seed >> 8) % iobuf.size()));
+                }
+            }
+
+            // count the verified records of the mix
+            size_t verifiedCount = 0;
+            for (size_t i = 0; i < mix.size(); ++i){
+                verifiedCount += (VerifyStatus(mix[i]) == true) ? 1 : 0;
+            }
+
+            const double throwingRate = MeasureMixRecordsPerSecond(mix, VerifyThrowing);
+            const double statusRate = MeasureMixRecordsPerSecond(mix, VerifyStatus);
+            std::cout << std::setw(9) << INVALID_PERCENTAGES[p] << "%"
+                      << std::setw(16) << std::fixed << std::setprecision(1) << throwingRate
+                      << std::setw(16) << statusRate
+                      << std::setw(10) << std::setprecision(2) << (statusRate / throwingRate)
+                      << "    (" << verifiedCount << " verified)" << std::endl;
+        }
+    }
+
+    // decodes every manifest record that can be loaded and parsed
+    //   throws std::runtime_error if there is none
+    std::vector<DecodedRecord> LoadParsableRecords(const std::string& manifest_filepath){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(LoadManifest(manifest_filepath));
+
+        std::vector<DecodedRecord> records;
+        for (size_t i = 0; i < pBatchVerifier->getRecordCount(); ++i){
+            const BatchVerifier::Record& record = pBatchVerifier->getRecords()[i];
+            if (record.m_fieldCount != 2){
+                continue;
+            }
+            try{
+                DecodedRecord decoded;
+                decoded.m_iobuf = BatchVerifier::loadField(record.m_fields[0]);
+                decoded.m_wrappedKey = BatchVerifier::loadField(record.m_fields[1]);
+                CoolkeyRSAKeyGenResultView view;
+                if (view.tryParse(decoded.m_iobuf.data(), decoded.m_iobuf.size()).isOk() == true){
+                    records.push_back(decoded);
+                }
+            }catch (std::runtime_error&){
+                // unreadable field - not useful for this benchmark
+            }
+        }
+        if (records.empty() == true){
+            throw std::runtime_error("Manifest file contains no parsable records.");
+        }
+        return records;
+    }
+
+    // verifier benchmark - per-call OpenSSL setup versus a reused CoolkeyRSAVerifier
+    //   countingInstalled tells whether the OpenSSL allocation hooks are in place
+    void RunVerifierBenchmark(const std::string& manifest_filepath, const bool countingInstalled){
+        const std::vector<DecodedRecord> records(LoadParsableRecords(manifest_filepath));
+
+        CoolkeyRSAVerifier verifier;
+        auto verifyPerCall = [](const DecodedRecord& record){
+            CoolkeyRSAKeyGenResultView view;
+            view.tryParse(record.m_iobuf.data(), record.m_iobuf.size());
+            return CoolkeyRSAKeyGenResult::tryVerifySignature(view, record.m_wrappedKey.data(), record.m_wrappedKey.size()).isOk();
+        };
+        auto verifyReused = [&verifier](const DecodedRecord& record){
+            CoolkeyRSAKeyGenResultView view;
+            view.tryParse(record.m_iobuf.data(), record.m_iobuf.size());
+            return verifier.verify(view, record.m_wrappedKey.data(), record.m_wrappedKey.size()).isOk();
+        };
+
+        // warm up the reused state, counting the verified records
+        size_t verifiedCount = 0;
+        for (size_t i = 0; i < records.size(); ++i){
+            verifiedCount += (verifyReused(records[i]) == true) ? 1 : 0;
+        }
+
+        std::cout << "records: " << records.size() << "  verified: " << verifiedCount << "\n";
+        std::cout << std::setw(10) << "path" << std::setw(14) << "records/s" << std::setw(18) << "OpenSSL allocs" << std::setw(16) << "C++ allocs" << "\n";
+        const char* const pathNames[] = { "per-call", "reused" };
+        for (int path = 0; path < 2; ++path){
+            // one counted pass, then a timed run
+            const size_t openSSLBefore = g_openSSLAllocations.load();
+            const size_t newBefore = g_newAllocations.load();
+            for (size_t i = 0; i < records.size(); ++i){
+                (path == 0) ? verifyPerCall(records[i]) : verifyReused(records[i]);
+            }
+            const double openSSLPerRecord = static_cast<double>(g_openSSLAllocations.load() - openSSLBefore) / records.size();
+            const double newPerRecord = static_cast<double>(g_newAllocations.load() - newBefore) / records.size();
+
+            const double rate = (path == 0) ? MeasureMixRecordsPerSecond(records, verifyPerCall)
+                                            : MeasureMixRecordsPerSecond(records, verifyReused);
+
+            std::cout << std::setw(10) << pathNames[path]
+                      << std::setw(14) << std::fixed << std::setprecision(1) << rate;
+            if (countingInstalled == true){
+                std::cout << std::setw(18) << std::setprecision(2) << openSSLPerRecord;
+            }else{
+                std::cout << std::setw(18) << "n/a";
+            }
+            std::cout << std::setw(16) << std::setprecision(2) << newPerRecord << std::endl;
+        }
+    }
+
+    // calls passOnce (which processes recordCount records) repeatedly; returns records per second
+    template<typename PassFunction>
+    double MeasurePassRecordsPerSecond(const size_t recordCount, PassFunction passOnce){
+        size_t recordsProcessed = 0;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsedSeconds = 0.0;
+        do{
+            passOnce();
+            recordsProcessed += recordCount;
+            elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }while (elapsedSeconds < MIN_MEASUREMENT_SECONDS);
+        return recordsProcessed / elapsedSeconds;
+    }
+
+    // SHA-1 benchmark - per-record EVP digests versus MultiBufferSHA1, alone and within full verification
+    void RunSHA1Benchmark(const std::string& manifest_filepath){
+        const std::vector<DecodedRecord> records(LoadParsableRecords(manifest_filepath));
+
+        // parse every record once; the views point into records, which is not modified below
+        std::vector<CoolkeyRSAKeyGenResultView> views(records.size());
+        std::vector<MultiBufferSHA1::Message> messages(records.size());
+        for (size_t i = 0; i < records.size(); ++i){
+            views[i].tryParse(records[i].m_iobuf.data(), records[i].m_iobuf.size());
+            messages[i].m_pPart1 = views[i].getBlob().getBlobData();
+            messages[i].m_part1Length = views[i].getBlob().getBlobSize();
+            messages[i].m_pPart2 = records[i].m_wrappedKey.data();
+            messages[i].m_part2Length = records[i].m_wrappedKey.size();
+        }
+        const size_t recordCount = records.size();
+        std::vector<byte> digests(recordCount * MultiBufferSHA1::DIGEST_LENGTH);
+        byte (* const pDigests)[MultiBufferSHA1::DIGEST_LENGTH] = reinterpret_cast<byte (*)[MultiBufferSHA1::DIGEST_LENGTH]>(digests.data());
+
+        // baseline: one EVP digest per record, as tryVerifySignature computes it
+        EVP_MD_CTX* const pContext = EVP_MD_CTX_create();
+        if (pContext == nullptr){
+            throw std::runtime_error("Unable to create EVP_MD_CTX.");
+        }
+        const EVP_MD* const pSHA1 = OpenSSLAlgorithms::getSHA1();
+        auto digestEVP = [&messages, recordCount, pContext, pSHA1](byte* pOutput){
+            for (size_t i = 0; i < recordCount; ++i){
+                EVP_DigestInit_ex(pContext, pSHA1, nullptr);
+                EVP_DigestUpdate(pContext, messages[i].m_pPart1, messages[i].m_part1Length);
+                EVP_DigestUpdate(pContext, messages[i].m_pPart2, messages[i].m_part2Length);
+                EVP_DigestFinal_ex(pContext, pOutput + i * MultiBufferSHA1::DIGEST_LENGTH, nullptr);
+            }
+        };
+
+        std::cout << "records: " << recordCount << "\n";
+        std::cout << std::setw(12) << "digest" << std::setw(8) << "lanes" << std::setw(16) << "records/s" << std::setw(10) << "speedup" << "\n";
+        const double evpRate = MeasurePassRecordsPerSecond(recordCount, [&digestEVP, &digests](){
+            digestEVP(digests.data());
+        });
+        std::cout << std::setw(12) << "evp" << std::setw(8) << 1
+                  << std::setw(16) << std::fixed << std::setprecision(1) << evpRate
+                  << std::setw(10) << std::setprecision(2) << 1.0 << std::endl;
+
+        for (int impl = 0; impl < MultiBufferSHA1::IMPLEMENTATION_COUNT; ++impl){
+            const MultiBufferSHA1::Implementation implementation = static_cast<MultiBufferSHA1::Implementation>(impl);
+            if (MultiBufferSHA1::isSupported(implementation) == false){
+                continue;
+            }
+            const double rate = MeasurePassRecordsPerSecond(recordCount, [&messages, recordCount, pDigests, implementation](){
+                MultiBufferSHA1::hash(implementation, messages.data(), recordCount, pDigests);
+            });
+            std::cout << std::setw(12) << MultiBufferSHA1::getImplementationName(implementation)
+                      << std::setw(8) << MultiBufferSHA1::getLaneCount(implementation)
+                      << std::setw(16) << std::fixed << std::setprecision(1) << rate
+                      << std::setw(10) << std::setprecision(2) << (rate / evpRate) << std::endl;
+        }
+        EVP_MD_CTX_destroy(pContext);
+
+        // full verification: per-call setup, reused verifier, and reused verifier fed by grouped digests
+        CoolkeyRSAVerifier verifier;
+        std::vector<bool> outcomes(recordCount);
+        auto verifyPerCall = [&views, &records, &outcomes, recordCount](){
+            for (size_t i = 0; i < recordCount; ++i){
+                outcomes[i] = CoolkeyRSAKeyGenResult::tryVerifySignature(views[i], records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size()).isOk();
+            }
+        };
+        auto verifyReused = [&views, &records, &outcomes, &verifier, recordCount](){
+            for (size_t i = 0; i < recordCount; ++i){
+                outcomes[i] = verifier.verify(views[i], records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size()).isOk();
+            }
+        };
+        auto verifyGrouped = [&views, &messages, &outcomes, &verifier, recordCount](){
+            const size_t groupSize = MultiBufferSHA1::MAX_LANES;
+            byte groupDigests[groupSize][MultiBufferSHA1::DIGEST_LENGTH];
+            for (size_t first = 0; first < recordCount; first += groupSize){
+                const size_t count = std::min(groupSize, recordCount - first);
+                MultiBufferSHA1::hash(&messages[first], count, groupDigests);
+                for (size_t i = 0; i < count; ++i){
+                    const CoolkeyRSAKeyGenResultView& view = views[first + i];
+                    outcomes[first + i] = verifier.verifyDigest(view.getBlob(), view.getProofData(), view.getProofSize(), groupDigests[i]).isOk();
+                }
+            }
+        };
+
+        // warm up the reused state, counting the verified records
+        verifyReused();
+        size_t verifiedCount = 0;
+        for (size_t i = 0; i < recordCount; ++i){
+            verifiedCount += (outcomes[i] == true) ? 1 : 0;
+        }
+
+        std::cout << "\nverified: " << verifiedCount << "  (multi-buffer: " << MultiBufferSHA1::getImplementationName(MultiBufferSHA1::getBestImplementation()) << ")\n";
+        std::cout << std::setw(12) << "verify" << std::setw(16) << "records/s" << std::setw(10) << "speedup" << "\n";
+        const char* const pathNames[] = { "per-call", "reused", "grouped" };
+        double baseline = 0.0;
+        for (int path = 0; path < 3; ++path){
+            const double rate = (path == 0) ? MeasurePassRecordsPerSecond(recordCount, verifyPerCall)
+                              : (path == 1) ? MeasurePassRecordsPerSecond(recordCount, verifyReused)
+                                            : MeasurePassRecordsPerSecond(recordCount, verifyGrouped);
+            if (path == 0){
+                baseline = rate;
+            }
+            std::cout << std::setw(12) << pathNames[path]
+                      << std::setw(16) << std::fixed << std::setprecision(1) << rate
+                      << std::setw(10) << std::setprecision(2) << (rate / baseline) << std::endl;
+        }
+    }
+
+    // mean, median and 99th percentile of a set of latencies (microseconds)
+    class LatencySummary{
+        public:
+            double m_mean;
+            double m_median;
+            double m_p99;
+
+            explicit LatencySummary(std::vector<double> samples) : m_mean(0.0), m_median(0.0), m_p99(0.0){
+                if (samples.empty() == true){
+                    return;
+                }
+                std::sort(samples.begin(), samples.end());
+                for (size_t i = 0; i < samples.size(); ++i){
+                    this->m_mean += samples[i];
+                }
+                this->m_mean /= samples.size();
+                this->m_median = samples[samples.size() / 2];
+                this->m_p99 = samples[(samples.size() * 99) / 100];
+            }
+    };
+
+    // calls verifyOnce on every record, timing each call, for at least MIN_MEASUREMENT_SECONDS
+    //   returns the latency of every call in microseconds
+    template<typename VerifyFunction>
+    std::vector<double> MeasureLatencies(const size_t recordCount, VerifyFunction verifyOnce){
+        std::vector<double> samples;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        double elapsedSeconds = 0.0;
+        do{
+            for (size_t i = 0; i < recordCount; ++i){
+                const std::chrono::steady_clock::time_point callStart = std::chrono::steady_clock::now();
+                verifyOnce(i);
+                samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - callStart).count());
+            }
+            elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }while (elapsedSeconds < MIN_MEASUREMENT_SECONDS);
+        return samples;
+    }
+
+    // RSA benchmark - per-verification latency of the per-call, reused OpenSSL and fixed-size paths
+    void RunRSABenchmark(const std::string& manifest_filepath){
+        const std::vector<DecodedRecord> records(LoadParsableRecords(manifest_filepath));
+        const size_t recordCount = records.size();
+        std::vector<CoolkeyRSAKeyGenResultView> views(recordCount);
+        size_t fixedSizeCount = 0;
+        for (size_t i = 0; i < recordCount; ++i){
+            views[i].tryParse(records[i].m_iobuf.data(), records[i].m_iobuf.size());
+            const CoolkeyRSAKeyBlobView& blob = views[i].getBlob();
+            fixedSizeCount += (FixedSizeRSA::isSupportedKey(blob.getExponentData(), blob.getExponentLength(),
+                                                            blob.getModulusData(), blob.getModulusLength()) == true) ? 1 : 0;
+        }
+
+        // warm up both verifiers, counting the verified records
+        CoolkeyRSAVerifier fixedVerifier(true);
+        CoolkeyRSAVerifier openSSLVerifier(false);
+        size_t verifiedCount = 0;
+        for (size_t i = 0; i < recordCount; ++i){
+            openSSLVerifier.verify(views[i], records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size());
+            verifiedCount += (fixedVerifier.verify(views[i], records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size()).isOk() == true) ? 1 : 0;
+        }
+
+        std::cout << "records: " << recordCount << "  verified: " << verifiedCount << "  fixed-size keys: " << fixedSizeCount << "\n";
+        std::cout << "fixed-size implementation: " << FixedSizeRSA::getImplementationName(FixedSizeRSA::getBestImplementation()) << "\n";
+
+        // latency of one verification on each path
+        auto verifyPerCall = [&views, &records](const size_t i){
+            CoolkeyRSAKeyGenResult::tryVerifySignature(views[i], records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size());
+        };
+        auto verifyOpenSSL = [&views, &records, &openSSLVerifier](const size_t i){
+            openSSLVerifier.verify(views[i], records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size());
+        };
+        auto verifyFixed = [&views, &records, &fixedVerifier](const size_t i){
+            fixedVerifier.verify(views[i], records[i].m_wrappedKey.data(), records[i].m_wrappedKey.size());
+        };
+        std::cout << std::setw(12) << "verify" << std::setw(12) << "mean us" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(10) << "speedup" << "\n";
+        const char* const pathNames[] = { "per-call", "reused", "fixed-size" };
+        double baseline = 0.0;
+        for (int path = 0; path < 3; ++path){
+            const LatencySummary summary((path == 0) ? MeasureLatencies(recordCount, verifyPerCall)
+                                       : (path == 1) ? MeasureLatencies(recordCount, verifyOpenSSL)
+                                                     : MeasureLatencies(recordCount, verifyFixed));
+            if (path == 0){
+                baseline = summary.m_mean;
+            }
+            std::cout << std::setw(12) << pathNames[path]
+                      << std::setw(12) << std::fixed << std::setprecision(2) << summary.m_mean
+                      << std::setw(12) << summary.m_median
+                      << std::setw(12) << summary.m_p99
+                      << std::setw(10) << (baseline / summary.m_mean) << std::endl;
+        }
+    }
+
+    // collects dispatched key gen results: fixed-size records into contiguous arrays, the rest counted
+    class RecordCollector{
+        public:
+            std::vector<FixedKeyGenResult<1024> > m_records1024;
+            std::vector<FixedKeyGenResult<2048> > m_records2048;
+            size_t m_genericCount;
+
+            RecordCollector() : m_genericCount(0){
+
+            }
+
+            void operator()(const FixedKeyGenResult<1024>& record){ this->m_records1024.push_back(record); }
+            void operator()(const FixedKeyGenResult<2048>& record){ this->m_records2048.push_back(record); }
+            void operator()(const CoolkeyRSAKeyGenResultView&){ ++this->m_genericCount; }
+
+            void clear(){
+                this->m_records1024.clear();
+                this->m_records2048.clear();
+                this->m_genericCount = 0;
+            }
+    };
+
+    // records benchmark - parsing into in-place views versus contiguous FixedKeyGenResult arrays
+    void RunRecordsBenchmark(const std::string& manifest_filepath){
+        const std::vector<DecodedRecord> records(LoadParsableRecords(manifest_filepath));
+        const size_t recordCount = records.size();
+
+        // views borrow the decoded buffers; the collector copies into its own arrays (reserved up front)
+        std::vector<CoolkeyRSAKeyGenResultView> views(recordCount);
+        RecordCollector collector;
+        collector.m_records1024.reserve(recordCount);
+        collector.m_records2048.reserve(recordCount);
+        auto parseViews = [&records, &views, recordCount](){
+            for (size_t i = 0; i < recordCount; ++i){
+                views[i].tryParse(records[i].m_iobuf.data(), records[i].m_iobuf.size());
+            }
+        };
+        auto parseFixed = [&records, &collector, recordCount](){
+            collector.clear();
+            for (size_t i = 0; i < recordCount; ++i){
+                KeyGenResultDispatcher::tryParse(records[i].m_iobuf.data(), records[i].m_iobuf.size(), collector);
+            }
+        };
+
+        // one pass to count the records of each size
+        parseFixed();
+
+        std::cout << "records: " << recordCount << "  1024 bit: " << collector.m_records1024.size()
+                  << "  2048 bit: " << collector.m_records2048.size() << "  generic: " << collector.m_genericCount << "\n";
+        std::cout << "record size: " << sizeof(FixedKeyGenResult<1024>) << " / " << sizeof(FixedKeyGenResult<2048>) << " bytes\n";
+        std::cout << std::setw(12) << "parse" << std::setw(16) << "records/s" << std::setw(16) << "C++ allocs" << "\n";
+        const char* const pathNames[] = { "view", "fixed-size" };
+        for (int path = 0; path < 2; ++path){
+            // one counted pass, then a timed run
+            const size_t newBefore = g_newAllocations.load();
+            (path == 0) ? parseViews() : parseFixed();
+            const double newPerRecord = static_cast<double>(g_newAllocations.load() - newBefore) / recordCount;
+
+            const double rate = (path == 0) ? MeasurePassRecordsPerSecond(recordCount, parseViews)
+                                            : MeasurePassRecordsPerSecond(recordCount, parseFixed);
+            std::cout << std::setw(12) << pathNames[path]
+                      << std::setw(16) << std::fixed << std::setprecision(1) << rate
+                      << std::setw(16) << std::setprecision(2) << newPerRecord << std::endl;
+        }
+    }
+
+    // archive benchmark - ASCII-hex manifest versus binary enrollment archive, loading alone and with verification
+    void RunArchiveBenchmark(const std::string& manifest_filepath, const std::string& archive_filepath){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(LoadManifest(manifest_filepath));
+        {
+            std::ostringstream skipped;
+            EnrollmentArchiveWriter::convertManifest(*pBatchVerifier, archive_filepath, skipped);
+        }
+        const ArchiveBatchVerifier archiveBatchVerifier(archive_filepath);
+        const EnrollmentArchiveReader reader(archive_filepath);
+        const size_t recordCount = pBatchVerifier->getRecordCount();
+        const size_t archiveRecordCount = reader.getRecordCount();
+        if (archiveRecordCount == 0){
+            throw std::runtime_error("Manifest file contains no loadable records.");
+        }
+
+        std::ifstream manifest_file(manifest_filepath, std::ios::binary | std::ios::ate);
+        std::ifstream archive_file(archive_filepath, std::ios::binary | std::ios::ate);
+        std::cout << "records: " << recordCount << "  archived: " << archiveRecordCount << "\n";
+        std::cout << "size: " << manifest_file.tellg() << " bytes (manifest) / " << archive_file.tellg() << " bytes (archive)\n";
+
+        // load only: decode every manifest field, or fetch and checksum every archive record
+        const std::vector<BatchVerifier::Record>& records = pBatchVerifier->getRecords();
+        size_t sink = 0;
+        auto loadManifest = [&records, &sink](){
+            for (size_t i = 0; i < records.size(); ++i){
+                try{
+                    sink += BatchVerifier::loadField(records[i].m_fields[0]).size();
+                    sink += BatchVerifier::loadField(records[i].m_fields[1]).size();
+                }catch (std::exception&){
+                    ++sink;
+                }
+            }
+        };
+        auto loadArchive = [&reader, &sink, archiveRecordCount](){
+            EnrollmentArchiveReader::Record record;
+            const char* pError = nullptr;
+            for (size_t i = 0; i < archiveRecordCount; ++i){
+                if (reader.tryGetRecord(i, record, pError) == true){
+                    sink += record.m_iobufSize + record.m_wrappedKeySize;
+                }
+            }
+        };
+        auto verifyManifest = [&pBatchVerifier](){ pBatchVerifier->verifyAll(1); };
+        auto verifyArchive = [&archiveBatchVerifier](){ archiveBatchVerifier.verifyAll(1); };
+
+        std::cout << std::setw(10) << "source" << std::setw(16) << "load/s" << std::setw(16) << "verify/s" << "\n";
+        const double manifestLoadRate = MeasurePassRecordsPerSecond(recordCount, loadManifest);
+        const double manifestVerifyRate = MeasurePassRecordsPerSecond(recordCount, verifyManifest);
+        std::cout << std::setw(10) << "manifest"
+                  << std::setw(16) << std::fixed << std::setprecision(1) << manifestLoadRate
+                  << std::setw(16) << manifestVerifyRate << std::endl;
+        const double archiveLoadRate = MeasurePassRecordsPerSecond(archiveRecordCount, loadArchive);
+        const double archiveVerifyRate = MeasurePassRecordsPerSecond(archiveRecordCount, verifyArchive);
+        std::cout << std::setw(10) << "archive"
+                  << std::setw(16) << std::fixed << std::setprecision(1) << archiveLoadRate
+                  << std::setw(16) << archiveVerifyRate << std::endl;
+        if (sink == 0){
+            std::cout << "(no data loaded)" << std::endl;
+        }
+    }
+
+    // stream buffer that counts and discards everything written to it
+    class DiscardBuffer : public std::streambuf{
+        public:
+            size_t m_count;
+
+            DiscardBuffer() : m_count(0){
+
+            }
+
+        protected:
+            int_type overflow(int_type c) override{
+                ++this->m_count;
+                return traits_type::not_eof(c);
+            }
+            std::streamsize xsputn(const char*, std::streamsize count) override{
+                this->m_count += static_cast<size_t>(count);
+                return count;
+            }
+    };
+
+    // original stringstream-based byte formatting (setw/setfill per byte), kept as the baseline for the output benchmark
+    std::string LegacyBytesToString(const std::vector<byte>& v){
+        std::stringstream ss;
+        for (std::vector<byte>::const_iterator it = v.begin(); it != v.end(); it++){
+            int thisNum = *it;
+            ss << std::setfill('0') << std::setw(2) << std::hex << thisNum << ":";
+        }
+
+        std::string result = ss.str();
+        if (result.size() > 0){
+            result.erase(result.length() - 1);
+        }
+        return result;
+    }
+
+    // output benchmark - per-field iostream formatting versus ResultWriter formats
+    void RunOutputBenchmark(const std::string& manifest_filepath){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(LoadManifest(manifest_filepath));
+        const std::vector<BatchVerifier::Result> results(pBatchVerifier->verifyAll(1, true));
+        const size_t recordCount = results.size();
+
+        DiscardBuffer discardBuffer;
+        std::ostream discard(&discardBuffer);
+        auto writeLegacy = [&results, &discard](){
+            for (std::vector<BatchVerifier::Result>::const_iterator it = results.begin(); it != results.end(); it++){
+                discard << it->m_lineNumber << '\t' << it->m_outcome << '\t' << std::dec << it->m_keyLengthBits << '\t'
+                        << LegacyBytesToString(it->m_exponent) << '\t' << LegacyBytesToString(it->m_modulus) << '\t'
+                        << LegacyBytesToString(it->m_proof) << '\t' << it->m_message << std::endl;
+            }
+        };
+
+        std::cout << "records: " << recordCount << "\n";
+        std::cout << std::setw(10) << "format" << std::setw(16) << "records/s" << std::setw(10) << "MB/s" << std::setw(10) << "speedup" << "\n";
+        const char* const formatNames[] = { "iostream", "text", "jsonl", "csv" };
+        double baseline = 0.0;
+        for (int format = -1; format < ResultWriter::FORMAT_COUNT; ++format){
+            discardBuffer.m_count = 0;
+            size_t passes = 0;
+            const double rate = MeasurePassRecordsPerSecond(recordCount, [&](){
+                if (format < 0){
+                    writeLegacy();
+                }else{
+                    ResultWriter writer(discard, static_cast<ResultWriter::Format>(format));
+                    writer.writeAll(results);
+                }
+                ++passes;
+            });
+            const double bytesPerRecord = static_cast<double>(discardBuffer.m_count) / (passes * recordCount);
+            if (format < 0){
+                baseline = rate;
+            }
+            std::cout << std::setw(10) << formatNames[format + 1]
+                      << std::setw(16) << std::fixed << std::setprecision(1) << rate
+                      << std::setw(10) << (rate * bytesPerRecord / 1e6)
+                      << std::setw(10) << std::setprecision(2) << (rate / baseline) << std::endl;
+        }
+    }
+}
+
+namespace{
+    // one measured stage of the stages benchmark
+    class StageResult{
+        public:
+            std::string m_stage;
+            size_t m_keyBits;          // 0 for all key sizes
+            size_t m_recordCount;
+            double m_rate;             // records per second
+    };
+
+    // returns text as the contents of a JSON string (the texts here hold no control characters)
+    std::string EscapeJSON(const std::string& text){
+        std::string escaped;
+        for (size_t i = 0; i < text.size(); ++i){
+            if (text[i] == '"' || text[i] == '\\'){
+                escaped += '\\';
+            }
+            escaped += text[i];
+        }
+        return escaped;
+    }
+
+    // returns the version of the OpenSSL library in use (not of the headers built against)
+    std::string GetOpenSSLVersion(){
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+        return SSLeay_version(SSLEAY_VERSION);
+#else
+        return OpenSSL_version(OPENSSL_VERSION);
+#endif
+    }
+
+    // returns the compiler this benchmark was built with
+    std::string GetCompilerVersion(){
+#if defined(__clang__)
+        return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+        return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+        std::ostringstream version;
+        version << "msvc " << _MSC_VER;
+        return version.str();
+#else
+        return "unknown";
+#endif
+    }
+
+    // stages benchmark - hex decoding, parsing, key construction and verification on their own and end to end
+    //   rows are printed as a table or as JSONL/CSV; a results file, if given, is appended to instead
+    void RunStagesBenchmark(const std::string& manifest_filepath, const ResultWriter::Format format, const std::string& results_filepath){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(LoadManifest(manifest_filepath));
+        const std::vector<BatchVerifier::Record>& manifestRecords = pBatchVerifier->getRecords();
+        const std::vector<DecodedRecord> records(LoadParsableRecords(manifest_filepath));
+
+        // parsed views of every record, grouped by key size (group 0: all records)
+        std::vector<CoolkeyRSAKeyGenResultView> views(records.size());
+        std::vector<size_t> groupKeyBits(1, 0);
+        std::vector<std::vector<size_t>> groups(1);
+        for (size_t i = 0; i < records.size(); ++i){
+            views[i].tryParse(records[i].m_iobuf.data(), records[i].m_iobuf.size());
+            const size_t keyBits = views[i].getBlob().getKeyLengthBits();
+            const size_t group = std::find(groupKeyBits.begin(), groupKeyBits.end(), keyBits) - groupKeyBits.begin();
+            if (group == groupKeyBits.size()){
+                groupKeyBits.push_back(keyBits);
+                groups.push_back(std::vector<size_t>());
+            }
+            groups[0].push_back(i);
+            groups[group].push_back(i);
+        }
+        // a single key size needs no separate rows
+        const size_t groupCount = (groups.size() == 2) ? 1 : groups.size();
+
+        std::vector<StageResult> results;
+        auto addResult = [&results](const char* pStage, const size_t keyBits, const size_t recordCount, const double rate){
+            StageResult result;
+            result.m_stage = pStage;
+            result.m_keyBits = keyBits;
+            result.m_recordCount = recordCount;
+            result.m_rate = rate;
+            results.push_back(result);
+        };
+
+        // ASCII-hex decoding of both fields of every manifest record
+        addResult("decode", 0, manifestRecords.size(), MeasurePassRecordsPerSecond(manifestRecords.size(), [&manifestRecords](){
+            for (size_t i = 0; i < manifestRecords.size(); ++i){
+                try{
+                    if (manifestRecords[i].m_fieldCount == 2){
+                        BatchVerifier::loadField(manifestRecords[i].m_fields[0]);
+                        BatchVerifier::loadField(manifestRecords[i].m_fields[1]);
+                    }
+                }catch (std::runtime_error&){
+                    // unreadable field - counted like any other record
+                }
+            }
+        }));
+
+        CoolkeyRSAVerifier verifier;
+        for (size_t group = 0; group < groupCount; ++group){
+            const std::vector<size_t>& indexes = groups[group];
+
+            // key gen result parsing into in-place views
+            addResult("parse", groupKeyBits[group], indexes.size(), MeasurePassRecordsPerSecond(indexes.size(), [&records, &indexes](){
+                CoolkeyRSAKeyGenResultView view;
+                for (size_t i = 0; i < indexes.size(); ++i){
+                    const DecodedRecord& record = records[indexes[i]];
+                    view.tryParse(record.m_iobuf.data(), record.m_iobuf.size());
+                }
+            }));
+
+            // OpenSSL public key construction from the parsed modulus and exponent
+            addResult("key", groupKeyBits[group], indexes.size(), MeasurePassRecordsPerSecond(indexes.size(), [&views, &indexes](){
+                for (size_t i = 0; i < indexes.size(); ++i){
+                    EVP_PKEY* pKey = nullptr;
+                    if (CoolkeyRSAKeyBlob::createOpensslKey(views[indexes[i]].getBlob(), pKey).isOk() == true){
+                        EVP_PKEY_free(pKey);
+                    }
+                }
+            }));
+
+            // proof verification of parsed records with a reused verifier
+            addResult("verify", groupKeyBits[group], indexes.size(), MeasurePassRecordsPerSecond(indexes.size(), [&records, &views, &indexes, &verifier](){
+                for (size_t i = 0; i < indexes.size(); ++i){
+                    const DecodedRecord& record = records[indexes[i]];
+                    verifier.verify(views[indexes[i]], record.m_wrappedKey.data(), record.m_wrappedKey.size());
+                }
+            }));
+        }
+
+        // batch verification of the manifest from its mapped text, on one thread
+        addResult("end_to_end", 0, manifestRecords.size(), MeasureRecordsPerSecond(*pBatchVerifier, 1));
+
+        std::ofstream results_file;
+        if (results_filepath.empty() == false){
+            results_file.open(results_filepath.c_str(), std::ios::out | std::ios::app);
+            if (results_file.good() == false){
+                throw std::runtime_error("Unable to open results file '" + results_filepath + "'.");
+            }
+        }
+        std::ostream& out = (results_filepath.empty() == false) ? static_cast<std::ostream&>(results_file) : std::cout;
+
+        if (format == ResultWriter::FORMAT_TEXT){
+            out << "records: " << manifestRecords.size() << "  parsable: " << records.size() << "\n";
+            out << std::setw(12) << "stage" << std::setw(10) << "key bits" << std::setw(10) << "records"
+                << std::setw(16) << "records/s" << std::setw(14) << "ns/record" << "\n";
+            for (size_t i = 0; i < results.size(); ++i){
+                const StageResult& result = results[i];
+                out << std::setw(12) << result.m_stage;
+                if (result.m_keyBits == 0){
+                    out << std::setw(10) << "all";
+                }else{
+                    out << std::setw(10) << result.m_keyBits;
+                }
+                out << std::setw(10) << result.m_recordCount
+                    << std::setw(16) << std::fixed << std::setprecision(1) << result.m_rate
+                    << std::setw(14) << (1e9 / result.m_rate) << "\n";
+            }
+            out.flush();
+            return;
+        }
+
+        // machine-readable rows identify the run so that results of different builds can be compared
+        char timestamp[32] = "";
+        const std::time_t now = std::time(nullptr);
+        const std::tm* pTime = std::gmtime(&now);
+        if (pTime != nullptr){
+            std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", pTime);
+        }
+#if defined(CKY_OPENSSL3_BACKEND)
+        const char* const backend = "OPENSSL3";
+#else
+        const char* const backend = "LEGACY";
+#endif
+        const std::string openSSLVersion(GetOpenSSLVersion());
+        const std::string compilerVersion(GetCompilerVersion());
+        const bool metricsEnabled = Metrics::isEnabled();
+
+        if (format == ResultWriter::FORMAT_CSV && (results_filepath.empty() == true || results_file.tellp() == 0)){
+            out << "timestamp,stage,key_bits,records,records_per_second,ns_per_record,openssl,backend,compiler,metrics\n";
+        }
+        for (size_t i = 0; i < results.size(); ++i){
+            const StageResult& result = results[i];
+            std::ostringstream keyBits;
+            if (result.m_keyBits == 0){
+                keyBits << ((format == ResultWriter::FORMAT_JSONL) ? "null" : "");
+            }else{
+                keyBits << result.m_keyBits;
+            }
+            out << std::fixed << std::setprecision(1);
+            if (format == ResultWriter::FORMAT_JSONL){
+                out << "{\"benchmark\":\"stages\",\"timestamp\":\"" << timestamp << "\",\"stage\":\"" << result.m_stage
+                    << "\",\"key_bits\":" << keyBits.str() << ",\"records\":" << result.m_recordCount
+                    << ",\"records_per_second\":" << result.m_rate << ",\"ns_per_record\":" << (1e9 / result.m_rate)
+                    << ",\"openssl\":\"" << EscapeJSON(openSSLVersion) << "\",\"backend\":\"" << backend
+                    << "\",\"compiler\":\"" << EscapeJSON(compilerVersion) << "\",\"metrics\":" << (metricsEnabled == true ? "true" : "false") << "}\n";
+            }else{
+                out << timestamp << ',' << result.m_stage << ',' << keyBits.str() << ',' << result.m_recordCount << ','
+                    << result.m_rate << ',' << (1e9 / result.m_rate) << ",\"" << openSSLVersion << "\"," << backend
+                    << ",\"" << compilerVersion << "\"," << (metricsEnabled == true ? 1 : 0) << "\n";
+            }
+        }
+        out.flush();
+    }
+}
+
+namespace{
+    // reads the resident set size of this process and its peak so far, in KiB
+    //   returns false where the platform does not report them (only Linux is supported)
+    bool TryReadResidentKilobytes(size_t& currentKilobytes, size_t& peakKilobytes){
+#if defined(__linux__)
+        std::ifstream status("/proc/self/status");
+        bool haveCurrent = false;
+        bool havePeak = false;
+        std::string line;
+        while (std::getline(status, line)){
+            std::istringstream fields(line);
+            std::string name;
+            fields >> name;
+            if (name == "VmRSS:"){
+                haveCurrent = static_cast<bool>(fields >> currentKilobytes);
+            }else if (name == "VmHWM:"){
+                havePeak = static_cast<bool>(fields >> peakKilobytes);
+            }
+        }
+        return haveCurrent == true && havePeak == true;
+#else
+        (void)currentKilobytes;
+        (void)peakKilobytes;
+        return false;
+#endif
+    }
+
+    // memory benchmark - heap allocations per record and resident memory of the batch and daemon paths under sustained load
+    //   countingInstalled tells whether the OpenSSL allocation hooks are in place
+    void RunMemoryBenchmark(const std::string& manifest_filepath, const double seconds, const bool countingInstalled){
+        std::unique_ptr<BatchVerifier> pBatchVerifier(LoadManifest(manifest_filepath));
+        const std::vector<BatchVerifier::Record>& records = pBatchVerifier->getRecords();
+        const std::vector<DecodedRecord> decodedRecords(LoadParsableRecords(manifest_filepath));
+        const size_t groupSize = MultiBufferSHA1::MAX_LANES;
+
+        // load only: every field decoded into a vector of its own, or into a per-worker arena reset after each record
+        size_t sink = 0;
+        auto loadVectors = [&records, &sink](){
+            for (size_t i = 0; i < records.size(); ++i){
+                try{
+                    sink += BatchVerifier::loadField(records[i].m_fields[0]).size();
+                    sink += BatchVerifier::loadField(records[i].m_fields[1]).size();
+                }catch (std::exception&){
+                    ++sink;
+                }
+            }
+        };
+        ByteArena loadArena;
+        auto loadArenaFields = [&records, &sink, &loadArena](){
+            for (size_t i = 0; i < records.size(); ++i){
+                BatchVerifier::Result result;
+                BatchVerifier::Input input;
+                if (BatchVerifier::loadRecord(records[i], loadArena, input, result) == true){
+                    sink += input.m_iobufSize + input.m_wrappedKeySize;
+                }
+                loadArena.reset();
+            }
+        };
+
+        // full verification as a batch worker does it: one verifier, one arena and reused results per worker
+        CoolkeyRSAVerifier verifier;
+        ByteArena groupArena;
+        BatchVerifier::Result groupResults[MultiBufferSHA1::MAX_LANES];
+        auto verifyGroups = [&](){
+            for (size_t first = 0; first < records.size(); first += groupSize){
+                const size_t count = std::min(groupSize, records.size() - first);
+                for (size_t i = 0; i < count; ++i){
+                    groupResults[i].reset();
+                }
+                BatchVerifier::verifyRecords(&records[first], count, verifier, groupArena, groupResults);
+                groupArena.reset();
+            }
+        };
+
+        // the batch modes end to end (one verify thread), writing text results to a discarding stream
+        DiscardBuffer discardBuffer;
+        std::ostream discard(&discardBuffer);
+        auto verifyAll = [&](){
+            ResultWriter writer(discard, ResultWriter::FORMAT_TEXT);
+            writer.writeAll(pBatchVerifier->verifyAll(1));
+        };
+        auto verifyPipeline = [&](){
+            ResultWriter writer(discard, ResultWriter::FORMAT_TEXT);
+            BatchPipeline pipeline(*pBatchVerifier, 1, 1);
+            pipeline.run(writer);
+        };
+
+        // daemon requests: parsed in place from the (already decoded) request bytes into a reused response buffer
+        std::vector<byte> payload;
+        auto processRequests = [&](){
+            for (size_t i = 0; i < decodedRecords.size(); ++i){
+                const DecodedRecord& record = decodedRecords[i];
+                VerificationDaemon::processRequest(verifier, record.m_iobuf.data(), record.m_iobuf.size(),
+                                                   record.m_wrappedKey.data(), record.m_wrappedKey.size(), payload);
+            }
+        };
+
+        std::cout << "records: " << records.size() << "  parsable: " << decodedRecords.size()
+                  << "  seconds per path: " << std::fixed << std::setprecision(1) << seconds << "\n";
+        std::cout << std::setw(16) << "path" << std::setw(14) << "records/s" << std::setw(16) << "OpenSSL allocs"
+                  << std::setw(14) << "C++ allocs" << std::setw(16) << "RSS start MiB" << std::setw(14) << "RSS end MiB" << "\n";
+        const char* const pathNames[] = { "load (vectors)", "load (arena)", "verify groups", "batch", "pipeline", "daemon" };
+        const size_t PATH_COUNT = sizeof(pathNames) / sizeof(pathNames[0]);
+        for (size_t path = 0; path < PATH_COUNT; ++path){
+            // daemon requests are made of the parsable records only
+            const size_t passRecords = (path == PATH_COUNT - 1) ? decodedRecords.size() : records.size();
+            auto runPass = [&](){
+                switch (path){
+                    case 0: loadVectors(); break;
+                    case 1: loadArenaFields(); break;
+                    case 2: verifyGroups(); break;
+                    case 3: verifyAll(); break;
+                    case 4: verifyPipeline(); break;
+                    default: processRequests(); break;
+                }
+            };
+
+            // one warm-up pass lets the reused buffers grow, then every allocation of the sustained run is counted
+            runPass();
+            size_t rssStart = 0;
+            size_t rssPeak = 0;
+            const bool haveRSS = TryReadResidentKilobytes(rssStart, rssPeak);
+            const size_t openSSLBefore = g_openSSLAllocations.load();
+            const size_t newBefore = g_newAllocations.load();
+            size_t recordsProcessed = 0;
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            double elapsedSeconds = 0.0;
+            do{
+                runPass();
+                recordsProcessed += passRecords;
+                elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            }while (elapsedSeconds < seconds);
+            const double openSSLPerRecord = static_cast<double>(g_openSSLAllocations.load() - openSSLBefore) / recordsProcessed;
+            const double newPerRecord = static_cast<double>(g_newAllocations.load() - newBefore) / recordsProcessed;
+            size_t rssEnd = 0;
+            TryReadResidentKilobytes(rssEnd, rssPeak);
+
+            std::cout << std::setw(16) << pathNames[path]
+                      << std::setw(14) << std::fixed << std::setprecision(1) << (recordsProcessed / elapsedSeconds);
+            if (countingInstalled == true){
+                std::cout << std::setw(16) << std::setprecision(3) << openSSLPerRecord;
+            }else{
+                std::cout << std::setw(16) << "n/a";
+            }
+            std::cout << std::setw(14) << std::setprecision(3) << newPerRecord;
+            if (haveRSS == true){
+                std::cout << std::setw(16) << std::setprecision(1) << (rssStart / 1024.0) << std::setw(14) << (rssEnd / 1024.0);
+            }else{
+                std::cout << std::setw(16) << "n/a" << std::setw(14) << "n/a";
+            }
+            std::cout << std::endl;
+        }
+
+        size_t rssCurrent = 0;
+        size_t rssPeak = 0;
+        if (TryReadResidentKilobytes(rssCurrent, rssPeak) == true){
+            std::cout << "peak RSS: " << std::fixed << std::setprecision(1) << (rssPeak / 1024.0) << " MiB" << std::endl;
+        }
+        if (sink == 0){
+            std::cout << "(no field loaded)" << std::endl;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// entry point of the benchmark program
+int main(int argc, const char** const argv){
+    int retcode = RETCODE_SUCCESS;
+
+    // must precede the first OpenSSL allocation
+    const bool countingInstalled = (CRYPTO_set_mem_functions(CountingOpenSSLMalloc, CountingOpenSSLRealloc, CountingOpenSSLFree) == 1);
+
+    const std::string command((argc >= 2) ? argv[1] : "");
+    const bool scalingCommand = (command == "scaling" && (argc == 3 || argc == 4));
+    const bool hexCommand = (command == "hex" && argc == 2);
+    const bool errorsCommand = (command == "errors" && argc == 3);
+    const bool verifierCommand = (command == "verifier" && argc == 3);
+    const bool sha1Command = (command == "sha1" && argc == 3);
+    const bool rsaCommand = (command == "rsa" && argc == 3);
+    const bool recordsCommand = (command == "records" && argc == 3);
+    const bool archiveCommand = (command == "archive" && argc == 4);
+    const bool outputCommand = (command == "output" && argc == 3);
+    const bool memoryCommand = (command == "memory" && (argc == 3 || argc == 4));
+    ResultWriter::Format stagesFormat = ResultWriter::FORMAT_TEXT;
+    const bool stagesCommand = (command == "stages" && argc >= 3 && argc <= 5 &&
+                                (argc == 3 || ResultWriter::tryParseFormat(argv[3], stagesFormat) == true));
+    if (scalingCommand == false && hexCommand == false && errorsCommand == false && verifierCommand == false && sha1Command == false &&
+        rsaCommand == false && recordsCommand == false && archiveCommand == false && outputCommand == false && stagesCommand == false &&
+        memoryCommand == false){
+        PrintUsage();
+        return RETCODE_USAGE;
+    }
+
+    try{
+        if (scalingCommand == true){
+            size_t maxThreads = VerificationWorkerPool::getDefaultThreadCount();
+            if (argc == 4){
+                std::istringstream maxThreadsStream(argv[3]);
+                if (!(maxThreadsStream >> maxThreads) || maxThreads == 0){
+                    throw std::runtime_error("Invalid max thread count.");
+                }
+            }
+            RunScalingBenchmark(argv[2], maxThreads);
+        }else if (errorsCommand == true){
+            RunErrorBenchmark(argv[2]);
+        }else if (verifierCommand == true){
+            RunVerifierBenchmark(argv[2], countingInstalled);
+        }else if (sha1Command == true){
+            RunSHA1Benchmark(argv[2]);
+        }else if (rsaCommand == true){
+            RunRSABenchmark(argv[2]);
+        }else if (recordsCommand == true){
+            RunRecordsBenchmark(argv[2]);
+        }else if (archiveCommand == true){
+            RunArchiveBenchmark(argv[2], argv[3]);
+        }else if (outputCommand == true){
+            RunOutputBenchmark(argv[2]);
+        }else if (stagesCommand == true){
+            RunStagesBenchmark(argv[2], stagesFormat, (argc == 5) ? argv[4] : "");
+        }else if (memoryCommand == true){
+            double seconds = 5.0;
+            if (argc == 4){
+                std::istringstream secondsStream(argv[3]);
+                if (!(secondsStream >> seconds) || seconds <= 0.0){
+                    throw std::runtime_error("Invalid number of seconds.");
+                }
+            }
+            RunMemoryBenchmark(argv[2], seconds, countingInstalled);
+        }else{
+            RunHexBenchmark();
+        }
+
+    }catch(std::runtime_error& ex){
+        std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }catch(...){
+        std::cout << "Unknown exception thrown.";
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }
+
+    return retcode;
+}
+
+//----------------------------------------------------------------------
@@ -16,68 +16,260 @@
 #include <sstream>
 #include <iomanip>
 #include <fstream>
+#include <memory> // unique_ptr
 
 #include "CoolkeyRSAKeyBlob.h"
 #include "CoolkeyRSAKeyGenResult.h"
+#include "BatchVerifier.h"
+#include "BatchPipeline.h"
+#include "ArchiveBatchVerifier.h"
+#include "EnrollmentArchiveWriter.h"
+#include "ResultWriter.h"
+#include "ChallengeKeySearch.h"
+#include "KeyFingerprintIndex.h"
+#include "SharedFactorScan.h"
+#include "Metrics.h"
+#include "ResultCache.h"
+#include "TraceRecorder.h"
+#include "VerificationDaemon.h"
 
 //----------------------------------------------------------------------
-// converts a byte vector to a hexadecimal string in the form of AA:BB:CC:etc
-std::string Bytes_To_String(const std::vector<byte>& v){
-    std::stringstream ss;
-    for(std::vector<byte>::const_iterator it = v.begin(); it != v.end(); it++){
-        int thisNum = *it;
-        ss << std::setfill('0') << std::setw(2) << std::hex << thisNum << ":";
+// writes the metrics collected so far to a Prometheus text file
+//   failure is reported on stderr (stdout carries the results) and does not change the exit code
+void WriteMetricsFile(const std::string& metrics_filepath){
+    if (Metrics::tryWritePrometheusFile(metrics_filepath) == false){
+        std::cerr << "Unable to write metrics file '" << metrics_filepath << "'." << std::endl;
     }
+}
 
-    std::string result = ss.str();
-    if (result.size() > 0){
-        result.erase(result.length() - 1);
+//----------------------------------------------------------------------
+// writes the spans recorded since tracing was enabled to a Chrome trace-event JSON file
+//   failure is reported on stderr and does not change the exit code
+void WriteTraceFile(const std::string& trace_filepath){
+    if (TraceRecorder::tryWriteChromeTraceFile(trace_filepath) == false){
+        std::cerr << "Unable to write trace file '" << trace_filepath << "'." << std::endl;
     }
-    return result;
 }
 
 //----------------------------------------------------------------------
-// Converts a string of ASCII-encoded hex to a byte array.
-std::vector<byte> Convert_ASCIIHex_To_Byte(std::string str){
-    // strip out any separator characters from this string
-    StringReplaceAll(str, ":", "");
-    StringReplaceAll(str, " ", "");
-
-    std::vector<byte> result;
-
-    std::stringstream converter;
-    size_t pos = 1;
-    while (pos < str.length()){
-        // get two characters from string
-        std::string twoChars(str.substr(pos - 1, 2));
-
-        // convert two characters to int
-        converter.clear();
-        converter << std::hex << twoChars;
-        int temp;
-        converter >> temp;
-
-        // save result
-        result.push_back(static_cast<byte>(temp));
-        
-        // skip forward two characters
-        pos += 2; 
+// opens the key index named on the command line, if any (returns nullptr for an empty path)
+//   throws std::runtime_error if the index cannot be opened or created
+std::unique_ptr<KeyFingerprintIndex> OpenKeyIndex(const std::string& key_index_filepath, const bool key_index_read_only){
+    std::unique_ptr<KeyFingerprintIndex> pKeyIndex;
+    if (key_index_filepath.empty() == false){
+        pKeyIndex.reset(new KeyFingerprintIndex(key_index_filepath, (key_index_read_only == true) ? KeyFingerprintIndex::MODE_READ_ONLY
+                                                                                                   : KeyFingerprintIndex::MODE_READ_WRITE));
+    }
+    return pKeyIndex;
+}
+
+//----------------------------------------------------------------------
+// batch mode - verifies every record listed in a manifest file, printing one result line per record
+//   a pipeline_load_threads count other than 0 runs the load, verify and emit stages on separate threads
+//   (see BatchPipeline) and prints the stage statistics to stderr
+int RunBatch(const std::string& manifest_filepath, const size_t thread_count, const ResultWriter::Format output_format,
+             const std::string& key_index_filepath, const bool key_index_read_only,
+             const size_t pipeline_load_threads, const size_t pipeline_verify_threads){
+    int retcode;
+
+    try{
+        // map manifest file ('-' reads standard input) and process all records
+        std::unique_ptr<BatchVerifier> pBatchVerifier((manifest_filepath == "-") ? new BatchVerifier(std::cin)
+                                                                                 : new BatchVerifier(manifest_filepath));
+        std::unique_ptr<KeyFingerprintIndex> pKeyIndex(OpenKeyIndex(key_index_filepath, key_index_read_only));
+        ResultWriter writer(std::cout, output_format);
+        if (pipeline_load_threads > 0){
+            BatchPipeline pipeline(*pBatchVerifier, pipeline_load_threads, pipeline_verify_threads);
+            retcode = pipeline.run(writer, pKeyIndex.get());
+            pipeline.writeStatistics(std::cerr);
+        }else{
+            retcode = writer.writeAll(pBatchVerifier->verifyAll(thread_count, writer.needsKeyData(), pKeyIndex.get()));
+        }
+
+    }catch(std::runtime_error& ex){
+        std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }catch(...){
+        std::cout << "Unknown exception thrown.";
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }
+
+    return retcode;
+}
+
+//----------------------------------------------------------------------
+// archive conversion mode - converts a manifest into a binary enrollment archive
+//   records that cannot be loaded are left out of the archive and printed as batch result lines
+int RunConvertArchive(const std::string& manifest_filepath, const std::string& archive_filepath){
+    int retcode;
+
+    try{
+        // map manifest file ('-' reads standard input)
+        std::unique_ptr<BatchVerifier> pBatchVerifier((manifest_filepath == "-") ? new BatchVerifier(std::cin)
+                                                                                 : new BatchVerifier(manifest_filepath));
+        retcode = EnrollmentArchiveWriter::convertManifest(*pBatchVerifier, archive_filepath, std::cout);
+
+    }catch(std::runtime_error& ex){
+        std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }catch(...){
+        std::cout << "Unknown exception thrown.";
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }
+
+    return retcode;
+}
+
+//----------------------------------------------------------------------
+// archive batch mode - verifies every record of a binary enrollment archive, printing one result line per record
+int RunBatchArchive(const std::string& archive_filepath, const size_t thread_count, const ResultWriter::Format output_format,
+                    const std::string& key_index_filepath, const bool key_index_read_only){
+    int retcode;
+
+    try{
+        // map archive and process all records
+        ArchiveBatchVerifier archiveBatchVerifier(archive_filepath);
+        std::unique_ptr<KeyFingerprintIndex> pKeyIndex(OpenKeyIndex(key_index_filepath, key_index_read_only));
+        ResultWriter writer(std::cout, output_format);
+        retcode = writer.writeAll(archiveBatchVerifier.verifyAll(thread_count, writer.needsKeyData(), pKeyIndex.get()));
+
+    }catch(std::runtime_error& ex){
+        std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }catch(...){
+        std::cout << "Unknown exception thrown.";
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }
+
+    return retcode;
+}
+
+//----------------------------------------------------------------------
+// challenge key search mode - checks every candidate wrappedkey against one key gen result, printing the matches
+int RunFindChallengeKey(const std::string& iobuf_filepath, const std::string& candidates_filepath, const size_t thread_count){
+    int retcode;
+
+    try{
+        // open input files
+        std::ifstream iobuf_file(iobuf_filepath);
+        if (iobuf_file.good() == false){
+            throw std::runtime_error("Unable to open iobuf file.");
+        }
+        std::ifstream candidates_file(candidates_filepath);
+        if (candidates_file.good() == false){
+            throw std::runtime_error("Unable to open candidate list.");
+        }
+
+        const std::vector<byte> iobuf_data(Read_ASCIIHex_Line(iobuf_file));
+        const std::vector<ChallengeKeySearch::Candidate> candidates(ChallengeKeySearch::readCandidates(candidates_file));
+
+        try{
+            // parse the key gen result and recover the signed digest once for all candidates
+            ChallengeKeySearch search(iobuf_data);
+
+            const CoolkeyStatus& recoveryStatus = search.getRecoveryStatus();
+            if (recoveryStatus.isOk() == false){
+                std::cout << "Unable to recover the signed digest from the key proof: " << recoveryStatus.getMessage();
+                std::cout << std::endl;
+
+                retcode = (recoveryStatus.getCategory() == CoolkeyStatus::CATEGORY_KEY) ? RETCODE_PARSE_ERROR : RETCODE_VERIFY_ERROR;
+            }else{
+                retcode = search.run(candidates, std::cout, thread_count);
+            }
+
+        }catch (std::runtime_error& ex){
+            std::cout << "Exception thrown while parsing RSA key gen result: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+            std::cout << std::endl;
+
+            retcode = RETCODE_PARSE_ERROR;
+        }
+
+    }catch(std::runtime_error& ex){
+        std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }catch(...){
+        std::cout << "Unknown exception thrown.";
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
     }
 
-    return result;
+    return retcode;
 }
 
 //----------------------------------------------------------------------
-// replaces all instances of a string with a new string
-void StringReplaceAll(std::string& str, const std::string& from, const std::string& to){
-    if (from.empty() == true){
-        return;
+// shared factor scan mode - finds the keys of a manifest whose moduli share a prime factor, printing one line per key
+//   records without a parsable modulus are printed as batch result lines as well
+int RunScanSharedFactors(const std::string& manifest_filepath, const size_t thread_count, const std::string& spill_directory,
+                         const size_t memory_limit){
+    int retcode;
+
+    try{
+        // map manifest file ('-' reads standard input) and scan all moduli
+        std::unique_ptr<BatchVerifier> pBatchVerifier((manifest_filepath == "-") ? new BatchVerifier(std::cin)
+                                                                                 : new BatchVerifier(manifest_filepath));
+        SharedFactorScan scan(spill_directory, memory_limit);
+        retcode = scan.run(*pBatchVerifier, std::cout, thread_count);
+
+    }catch(std::runtime_error& ex){
+        std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }catch(...){
+        std::cout << "Unknown exception thrown.";
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
     }
-    size_t start_pos = 0;
-    while((start_pos = str.find(from, start_pos)) != std::string::npos){
-        str.replace(start_pos, from.length(), to);
-        start_pos += to.length();
+
+    return retcode;
+}
+
+//----------------------------------------------------------------------
+// daemon mode - serves verify requests on a Unix domain socket until SIGINT/SIGTERM
+int RunDaemon(const std::string& socket_filepath, const std::string& metrics_filepath,
+              const std::string& key_index_filepath, const bool key_index_read_only,
+              const size_t cache_capacity, const std::string& cache_filepath){
+    int retcode;
+
+    try{
+        std::unique_ptr<KeyFingerprintIndex> pKeyIndex(OpenKeyIndex(key_index_filepath, key_index_read_only));
+        std::unique_ptr<ResultCache> pResultCache;
+        if (cache_capacity > 0){
+            pResultCache.reset(new ResultCache(cache_capacity, cache_filepath));
+        }
+        VerificationDaemon daemon(socket_filepath, std::cout, metrics_filepath, pKeyIndex.get(), pResultCache.get());
+        daemon.run();
+        retcode = RETCODE_SUCCESS;
+
+    }catch(std::runtime_error& ex){
+        std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
+    }catch(...){
+        std::cout << "Unknown exception thrown.";
+        std::cout << std::endl;
+
+        retcode = RETCODE_INPUT_ERROR;
     }
+
+    return retcode;
 }
 
 //----------------------------------------------------------------------
@@ -85,14 +277,171 @@ void StringReplaceAll(std::string& str, const std::string& from, const std::stri
 int main(int argc, const char** const argv){
     int retcode;
 
-    if (argc != 3){
+    // single record mode: <iobuf file> <wrappedkey file> [--key-index <file>] [--key-index-readonly <file>]
+    // batch mode: --batch <manifest file> [--threads <count>] [--pipeline <load>,<verify>] [--format <format>] [--metrics <file>] [--trace <file>] [--key-index ...]
+    const bool batchMode = (argc >= 3) && (std::string(argv[1]) == "--batch");
+    // archive batch mode: --batch-archive <archive file> [--threads <count>] [--format <format>] [--metrics <file>] [--trace <file>] [--key-index ...]
+    const bool batchArchiveMode = (argc >= 3) && (std::string(argv[1]) == "--batch-archive");
+    // archive conversion mode: --convert-archive <manifest file> <archive file>
+    const bool convertMode = (argc >= 2) && (std::string(argv[1]) == "--convert-archive");
+    // daemon mode: --daemon <socket file> [--metrics <file>] [--trace <file>] [--key-index ...] [--cache <entries>] [--cache-file <file>]
+    const bool daemonMode = (argc >= 2) && (std::string(argv[1]) == "--daemon");
+    // challenge key search mode: --find-challenge-key <iobuf file> <candidates file> [--threads <count>]
+    const bool searchMode = (argc >= 2) && (std::string(argv[1]) == "--find-challenge-key");
+    // shared factor scan mode: --scan-shared-factors <manifest file> [--threads <count>] [--spill-dir <dir>] [--memory-limit <MiB>]
+    const bool scanMode = (argc >= 2) && (std::string(argv[1]) == "--scan-shared-factors");
+    const bool singleMode = (batchMode == false && batchArchiveMode == false && convertMode == false && daemonMode == false &&
+                             searchMode == false && scanMode == false);
+    size_t threadCount = 1;
+    ResultWriter::Format outputFormat = ResultWriter::FORMAT_TEXT;
+    std::string metricsFilepath;
+    std::string traceFilepath;
+    std::string spillDirectory;
+    size_t memoryLimit = SharedFactorScan::DEFAULT_MEMORY_LIMIT;
+    std::string keyIndexFilepath;
+    bool keyIndexReadOnly = false;
+    size_t cacheCapacity = 0;
+    size_t pipelineLoadThreads = 0;
+    size_t pipelineVerifyThreads = 0;
+    std::string cacheFilepath;
+    const int requiredArguments = (searchMode == true || convertMode == true) ? 4 : 3;
+    bool argumentsValid = (argc >= requiredArguments);
+    if (convertMode == false){
+        // options follow the required arguments as name/value pairs, in any order
+        const bool batchOptions = (batchMode == true || batchArchiveMode == true);
+        const bool keyIndexOptions = (batchOptions == true || daemonMode == true || singleMode == true);
+        for (int i = requiredArguments; i < argc && argumentsValid == true; i += 2){
+            const std::string option(argv[i]);
+            if (i + 1 >= argc){
+                argumentsValid = false;
+            }else if (option == "--threads" && daemonMode == false && singleMode == false){
+                std::istringstream threadCountStream(argv[i + 1]);
+                argumentsValid = ((threadCountStream >> threadCount) && threadCountStream.eof());
+            }else if (option == "--pipeline" && batchMode == true){
+                // <load threads>,<verify threads>
+                std::istringstream pipelineStream(argv[i + 1]);
+                char separator = 0;
+                argumentsValid = ((pipelineStream >> pipelineLoadThreads >> separator >> pipelineVerifyThreads) && pipelineStream.eof() &&
+                                  separator == ',' && pipelineLoadThreads > 0);
+            }else if (option == "--format" && batchOptions == true){
+                argumentsValid = ResultWriter::tryParseFormat(argv[i + 1], outputFormat);
+            }else if (option == "--metrics" && (batchOptions == true || daemonMode == true)){
+                metricsFilepath = argv[i + 1];
+                argumentsValid = (metricsFilepath.empty() == false);
+            }else if (option == "--trace" && (batchOptions == true || daemonMode == true)){
+                traceFilepath = argv[i + 1];
+                argumentsValid = (traceFilepath.empty() == false);
+            }else if (option == "--spill-dir" && scanMode == true){
+                spillDirectory = argv[i + 1];
+                argumentsValid = (spillDirectory.empty() == false);
+            }else if (option == "--memory-limit" && scanMode == true){
+                std::istringstream memoryLimitStream(argv[i + 1]);
+                size_t memoryLimitMiB = 0;
+                argumentsValid = ((memoryLimitStream >> memoryLimitMiB) && memoryLimitStream.eof() && memoryLimitMiB > 0);
+                memoryLimit = memoryLimitMiB * 1024 * 1024;
+            }else if (option == "--cache" && daemonMode == true){
+                std::istringstream cacheCapacityStream(argv[i + 1]);
+                argumentsValid = ((cacheCapacityStream >> cacheCapacity) && cacheCapacityStream.eof());
+            }else if (option == "--cache-file" && daemonMode == true){
+                cacheFilepath = argv[i + 1];
+                argumentsValid = (cacheFilepath.empty() == false);
+            }else if ((option == "--key-index" || option == "--key-index-readonly") && keyIndexOptions == true){
+                keyIndexFilepath = argv[i + 1];
+                keyIndexReadOnly = (option == "--key-index-readonly");
+                argumentsValid = (keyIndexFilepath.empty() == false);
+            }else{
+                argumentsValid = false;
+            }
+        }
+    }else{
+        argumentsValid = (argc == requiredArguments);
+    }
+
+    if (argumentsValid == false){
         std::cout << PROGRAM_NAME << "  -  " << PROGRAM_VERSION << std::endl;
         std::cout << PROGRAM_DESCRIPTION << std::endl;
         std::cout << std::endl;
-        std::cout << "Usage:  " << PROGRAM_EXECUTABLE << " <resulting iobuf file> <wrappedkey file>" << std::endl;
+        std::cout << "Usage:  " << PROGRAM_EXECUTABLE << " <resulting iobuf file> <wrappedkey file> [--key-index <file> | --key-index-readonly <file>]" << std::endl;
         std::cout << "  Files should both contain data in ASCII-hex format on a single line." << std::endl;
+        std::cout << "  --key-index rejects a verified key already recorded in the index (outcome 40) and records new ones;" << std::endl;
+        std::cout << "  the index file is created if missing.  --key-index-readonly only looks keys up." << std::endl;
+        std::cout << "        " << PROGRAM_EXECUTABLE << " --batch <manifest file> [--threads <count>] [--pipeline <load>,<verify>] [--format text|jsonl|csv] [--metrics <file>] [--trace <file>] [--key-index ...]" << std::endl;
+        std::cout << "  Each manifest line holds an iobuf and a wrappedkey field separated by whitespace." << std::endl;
+        std::cout << "  A field is either ASCII-hex data or '@' followed by the path of an input file." << std::endl;
+        std::cout << "  A manifest file of '-' reads the manifest from standard input." << std::endl;
+        std::cout << "  --threads selects the number of verification threads (0 = one per CPU; default 1)." << std::endl;
+        std::cout << "  --pipeline instead loads and verifies records on separate threads (verify 0 = one per CPU)," << std::endl;
+        std::cout << "  overlapping file reads and decoding with verification, and prints per-stage wait times to stderr." << std::endl;
+        std::cout << "  --format jsonl or csv adds the key length, exponent, modulus and proof of each record." << std::endl;
+        std::cout << "  --metrics writes per-stage latency histograms and outcome counts to a Prometheus text file." << std::endl;
+        std::cout << "  --trace writes the stage spans of every record to a Chrome trace-event JSON file (for Perfetto)." << std::endl;
+        std::cout << "  --key-index / --key-index-readonly check keys as in single record mode, in manifest order." << std::endl;
+        std::cout << "        " << PROGRAM_EXECUTABLE << " --convert-archive <manifest file> <archive file>" << std::endl;
+        std::cout << "  Stores the records of a manifest as raw bytes in a binary enrollment archive." << std::endl;
+        std::cout << "        " << PROGRAM_EXECUTABLE << " --batch-archive <archive file> [--threads <count>] [--format text|jsonl|csv] [--metrics <file>] [--trace <file>] [--key-index ...]" << std::endl;
+        std::cout << "  As --batch, reading the records from an archive made with --convert-archive." << std::endl;
+        std::cout << "        " << PROGRAM_EXECUTABLE << " --find-challenge-key <iobuf file> <candidates file> [--threads <count>]" << std::endl;
+        std::cout << "  Reports which wrappedkey fields of the candidate list (one per line) the iobuf was made for." << std::endl;
+        std::cout << "        " << PROGRAM_EXECUTABLE << " --daemon <socket file> [--metrics <file>] [--trace <file>] [--key-index ...] [--cache <entries>] [--cache-file <file>]" << std::endl;
+        std::cout << "  Serves framed verify requests on a Unix domain socket until SIGINT/SIGTERM (Linux only)." << std::endl;
+        std::cout << "  --metrics rewrites the metrics file with every latency report and on shutdown; --trace is written on shutdown." << std::endl;
+        std::cout << "  --cache answers repeated requests from a cache of that many responses (default with --cache-file: " << ResultCache::DEFAULT_CAPACITY << ")," << std::endl;
+        std::cout << "  each for " << ResultCache::DEFAULT_TTL_SECONDS << " seconds after it was stored; with --key-index, a response that recorded a new key is" << std::endl;
+        std::cout << "  not cached, so the same request sent again is answered with outcome 40 as without --cache." << std::endl;
+        std::cout << "  --cache-file keeps them in a memory-mapped file as well, across restarts." << std::endl;
+        std::cout << "        " << PROGRAM_EXECUTABLE << " --scan-shared-factors <manifest file> [--threads <count>] [--spill-dir <dir>] [--memory-limit <MiB>]" << std::endl;
+        std::cout << "  Reports every key whose modulus shares a prime factor with another key of the manifest (outcome 40)." << std::endl;
+        std::cout << "  Tree levels are spilled to files in --spill-dir (default: the temporary directory); --memory-limit" << std::endl;
+        std::cout << "  bounds the tree nodes held in memory per step (default 512).  Needs a build with GMP." << std::endl;
         std::cout << std::endl;
-        retcode = 1;
+        retcode = RETCODE_USAGE;
+    }else if (batchMode == true){
+        // batch mode - results are printed one line per record so no banner is printed
+        if (traceFilepath.empty() == false){
+            TraceRecorder::enable();
+        }
+        retcode = RunBatch(argv[2], threadCount, outputFormat, keyIndexFilepath, keyIndexReadOnly, pipelineLoadThreads, pipelineVerifyThreads);
+        if (metricsFilepath.empty() == false){
+            WriteMetricsFile(metricsFilepath);
+        }
+        if (traceFilepath.empty() == false){
+            WriteTraceFile(traceFilepath);
+        }
+    }else if (batchArchiveMode == true){
+        // archive batch mode - same output as batch mode
+        if (traceFilepath.empty() == false){
+            TraceRecorder::enable();
+        }
+        retcode = RunBatchArchive(argv[2], threadCount, outputFormat, keyIndexFilepath, keyIndexReadOnly);
+        if (metricsFilepath.empty() == false){
+            WriteMetricsFile(metricsFilepath);
+        }
+        if (traceFilepath.empty() == false){
+            WriteTraceFile(traceFilepath);
+        }
+    }else if (convertMode == true){
+        // archive conversion mode - only records that could not be converted are printed
+        retcode = RunConvertArchive(argv[2], argv[3]);
+    }else if (searchMode == true){
+        // challenge key search mode - one result line per matching candidate so no banner is printed
+        retcode = RunFindChallengeKey(argv[2], argv[3], threadCount);
+    }else if (scanMode == true){
+        // shared factor scan mode - one result line per reported key so no banner is printed
+        retcode = RunScanSharedFactors(argv[2], threadCount, spillDirectory, memoryLimit);
+    }else if (daemonMode == true){
+        // daemon mode - status and latency reports are written to stdout
+        std::cout << PROGRAM_NAME << "  -  " << PROGRAM_VERSION << "\n" << std::endl;
+        if (traceFilepath.empty() == false){
+            TraceRecorder::enable();
+        }
+        // a cache file without an entry count enables the cache at its default size
+        if (cacheFilepath.empty() == false && cacheCapacity == 0){
+            cacheCapacity = ResultCache::DEFAULT_CAPACITY;
+        }
+        retcode = RunDaemon(argv[2], metricsFilepath, keyIndexFilepath, keyIndexReadOnly, cacheCapacity, cacheFilepath);
+        if (traceFilepath.empty() == false){
+            WriteTraceFile(traceFilepath);
+        }
     }else{
         // print program name and version
         std::cout << PROGRAM_NAME << "  -  " << PROGRAM_VERSION << "\n" << std::endl;
@@ -114,15 +463,12 @@ int main(int argc, const char** const argv){
                 throw std::runtime_error("Unable to open wrappedKey file.");
             }
             
-            // read in one line of text from each file
-            std::string iobuf_data_str;
-            std::getline(iobuf_file, iobuf_data_str);
-            std::string wrappedkey_data_str;
-            std::getline(wrappedKey_file, wrappedkey_data_str);
+            // read in one line of ASCII-hex from each file, converting to byte arrays as the text streams in
+            std::vector<byte> iobuf_data(Read_ASCIIHex_Line(iobuf_file));
+            std::vector<byte> wrappedkey_data(Read_ASCIIHex_Line(wrappedKey_file));
 
-            // convert from ASCII-hex to byte array
-            std::vector<byte> iobuf_data(Convert_ASCIIHex_To_Byte(iobuf_data_str));
-            std::vector<byte> wrappedkey_data(Convert_ASCIIHex_To_Byte(wrappedkey_data_str));
+            // open (or create) the key index, if one was named
+            std::unique_ptr<KeyFingerprintIndex> pKeyIndex(OpenKeyIndex(keyIndexFilepath, keyIndexReadOnly));
 
             try{
                 // try to parse RSA key gen result blob
@@ -147,48 +493,78 @@ int main(int argc, const char** const argv){
                           << "0x" << Bytes_To_String(coolkeyRSAKeyGenResult.getProofData()) << "\n"
                           << "  Length (of proof):" << std::dec << coolkeyRSAKeyGenResult.getProofSize() << "\n\n";
 
+                bool verified = false;
                 try{
                     // try to verify RSA key gen result blob
                     coolkeyRSAKeyGenResult.verifySignature(wrappedkey_data);
                     
                     // if we made it here, validation was successful
                     std::cout << "Successfully validated RSA key gen result!" << std::endl;
-                    retcode = 0;
+                    retcode = RETCODE_SUCCESS;
+                    verified = true;
 
                 }catch (std::runtime_error& ex){
                     std::cout << "Exception thrown while validating RSA key gen result: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
                     std::cout << std::endl;
 
-                    retcode = 30;
+                    retcode = RETCODE_VERIFY_ERROR;
                 }catch (...){
                     std::cout << "Unknown exception thrown while validating RSA key gen result.";
                     std::cout << std::endl;
 
-                    retcode = 30;
+                    retcode = RETCODE_VERIFY_ERROR;
+                }
+
+                // reject a key seen before (only verified keys are recorded)
+                //   an index that cannot be read or grown is an input error, as it is in batch mode
+                if (verified == true && pKeyIndex.get() != nullptr){
+                    try{
+                        const std::vector<byte>& modulus = coolkeyRSAKeyBlob.getModulusData();
+                        const std::vector<byte>& exponent = coolkeyRSAKeyBlob.getExponentData();
+                        byte fingerprint[KeyFingerprintIndex::FINGERPRINT_LENGTH];
+                        if (KeyFingerprintIndex::tryComputeFingerprint(modulus.data(), modulus.size(), exponent.data(), exponent.size(), fingerprint) == false){
+                            throw std::runtime_error("Unable to compute key fingerprint.");
+                        }
+                        KeyFingerprintIndex::Entry entry;
+                        if (pKeyIndex->findOrInsert(fingerprint, entry) == true){
+                            std::cout << KeyFingerprintIndex::describeDuplicate(entry) << std::endl;
+                            retcode = RETCODE_WEAK_KEY;
+                        }
+                    }catch (std::runtime_error& ex){
+                        std::cout << "Exception thrown while checking the key index: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
+                        std::cout << std::endl;
+
+                        retcode = RETCODE_INPUT_ERROR;
+                    }catch (...){
+                        std::cout << "Unknown exception thrown while checking the key index.";
+                        std::cout << std::endl;
+
+                        retcode = RETCODE_INPUT_ERROR;
+                    }
                 }
 
             }catch (std::runtime_error& ex){
                 std::cout << "Exception thrown while parsing RSA key gen result: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
                 std::cout << std::endl;
 
-                retcode = 20;
+                retcode = RETCODE_PARSE_ERROR;
             }catch (...){
                 std::cout << "Unknown exception thrown while parsing RSA key gen result.";
                 std::cout << std::endl;
 
-                retcode = 20;
+                retcode = RETCODE_PARSE_ERROR;
             }
 
         }catch(std::runtime_error& ex){
             std::cout << "Exception thrown: " << ((ex.what() == nullptr) ? "<null>" : ex.what());
             std::cout << std::endl;
 
-            retcode = 10;
+            retcode = RETCODE_INPUT_ERROR;
         }catch(...){
             std::cout << "Unknown exception thrown.";
             std::cout << std::endl;
 
-            retcode = 10;
+            retcode = RETCODE_INPUT_ERROR;
         } 
         
     } // endif arguments are correct
@@ -17,8 +17,8 @@
 #include <vector>
 #include <string>
 
-typedef unsigned char BYTE;
-typedef unsigned char byte;
+#include "HexUtilities.h"
+#include "ResultWriter.h"
 
 //----------------------------------------------------------------------
 // PUBLIC STATIC
@@ -31,11 +31,28 @@ const std::string PROGRAM_DESCRIPTION(std::string("A simple utility tool that pe
                                                   "retrieves the public key; verifies that the proof-of-location field\n" + 
                                                   "(signature) is as expected.");
 
+// program return codes (also used as per-record outcome codes in batch mode)
+const int RETCODE_SUCCESS = 0;          // key gen result parsed and verified
+const int RETCODE_USAGE = 1;            // invalid command line
+const int RETCODE_INPUT_ERROR = 10;     // unable to read or decode input data
+const int RETCODE_PARSE_ERROR = 20;     // unable to parse key gen result
+const int RETCODE_VERIFY_ERROR = 30;    // unable to verify key gen result
+const int RETCODE_WEAK_KEY = 40;        // key shares a prime factor with (or is) another key's, or was recorded before
+
 //----------------------------------------------------------------------
 // PROTOTYPES
-std::string Bytes_To_String(const std::vector<byte>& v);
-std::vector<byte> Convert_ASCIIHex_To_Byte(std::string str);
-void StringReplaceAll(std::string& str, const std::string& from, const std::string& to);
+int RunBatch(const std::string& manifest_filepath, const size_t thread_count, const ResultWriter::Format output_format,
+             const std::string& key_index_filepath, const bool key_index_read_only,
+             const size_t pipeline_load_threads, const size_t pipeline_verify_threads);
+int RunConvertArchive(const std::string& manifest_filepath, const std::string& archive_filepath);
+int RunBatchArchive(const std::string& archive_filepath, const size_t thread_count, const ResultWriter::Format output_format,
+                    const std::string& key_index_filepath, const bool key_index_read_only);
+int RunFindChallengeKey(const std::string& iobuf_filepath, const std::string& candidates_filepath, const size_t thread_count);
+int RunScanSharedFactors(const std::string& manifest_filepath, const size_t thread_count, const std::string& spill_directory,
+                         const size_t memory_limit);
+int RunDaemon(const std::string& socket_filepath, const std::string& metrics_filepath,
+              const std::string& key_index_filepath, const bool key_index_read_only,
+              const size_t cache_capacity, const std::string& cache_filepath);
 int main(int argc, const char** const argv);
 
 //----------------------------------------------------------------------
@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------
+// See CRC32C.h
+//----------------------------------------------------------------------
+
+#include "CRC32C.h"
+
+//----------------------------------------------------------------------
+
+#include "CpuFeatures.h"
+
+// the hardware implementation needs 64-bit x86 and GCC/Clang target attributes
+#if defined(CPUFEATURES_X86) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define CRC32C_HARDWARE
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    // reflected Castagnoli polynomial
+    const uint32_t POLYNOMIAL = 0x82F63B78u;
+
+    // tables for processing 8 bytes per step: TABLES[k][b] is the CRC of byte b followed by k zero bytes
+    class SliceTables{
+        public:
+            uint32_t m_tables[8][256];
+
+            SliceTables(){
+                for (uint32_t b = 0; b < 256; ++b){
+                    uint32_t crc = b;
+                    for (int bit = 0; bit < 8; ++bit){
+                        crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1u)));
+                    }
+                    this->m_tables[0][b] = crc;
+                }
+                for (uint32_t b = 0; b < 256; ++b){
+                    for (int k = 1; k < 8; ++k){
+                        const uint32_t previous = this->m_tables[k - 1][b];
+                        this->m_tables[k][b] = (previous >> 8) ^ this->m_tables[0][previous & 0xFF];
+                    }
+                }
+            }
+    };
+
+    // table-driven CRC of the (inverted) running value crc
+    uint32_t computeTable(const byte* pData, size_t length, uint32_t crc){
+        static const SliceTables tables;
+        const uint32_t (&t)[8][256] = tables.m_tables;
+        while (length >= 8){
+            const uint32_t low = crc ^ (static_cast<uint32_t>(pData[0]) | (static_cast<uint32_t>(pData[1]) << 8) |
+                                        (static_cast<uint32_t>(pData[2]) << 16) | (static_cast<uint32_t>(pData[3]) << 24));
+            crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^ t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+                  t[3][pData[4]] ^ t[2][pData[5]] ^ t[1][pData[6]] ^ t[0][pData[7]];
+            pData += 8;
+            length -= 8;
+        }
+        while (length > 0){
+            crc = (crc >> 8) ^ t[0][(crc ^ *pData) & 0xFF];
+            ++pData;
+            --length;
+        }
+        return crc;
+    }
+
+#if defined(CRC32C_HARDWARE)
+    // CRC of the (inverted) running value crc with the SSE4.2 CRC32 instruction
+    __attribute__((target("sse4.2")))
+    uint32_t computeHardware(const byte* pData, size_t length, uint32_t crc){
+        uint64_t crc64 = crc;
+        while (length >= 8){
+            uint64_t word;
+            __builtin_memcpy(&word, pData, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+            pData += 8;
+            length -= 8;
+        }
+        uint32_t crc32 = static_cast<uint32_t>(crc64);
+        while (length > 0){
+            crc32 = _mm_crc32_u8(crc32, *pData);
+            ++pData;
+            --length;
+        }
+        return crc32;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the CRC-32C of length bytes at pData, continuing crc
+uint32_t CRC32C::compute(const byte* pData, const size_t length, const uint32_t crc){
+#if defined(CRC32C_HARDWARE)
+    if (CpuFeatures::hasSSE42() == true){
+        return ~computeHardware(pData, length, ~crc);
+    }
+#endif
+    return ~computeTable(pData, length, ~crc);
+}
+
+//----------------------------------------------------------------------
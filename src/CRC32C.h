@@ -0,0 +1,41 @@
+//----------------------------------------------------------------------
+// CRC32C - CRC-32C (Castagnoli) checksums, with the SSE4.2 CRC32
+//          instruction when the CPU has it and a table-driven
+//          implementation (8 bytes per step) otherwise.
+//----------------------------------------------------------------------
+
+#ifndef CRC32CH_Included
+#define CRC32CH_Included
+
+//----------------------------------------------------------------------
+
+class CRC32C;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class CRC32C{
+    public:
+        // returns the CRC-32C of length bytes at pData
+        //   crc continues an earlier checksum (the result of a previous call) - 0 to start a new one
+        static uint32_t compute(const byte* pData, const size_t length, const uint32_t crc = 0);
+
+    private:
+        // prevent copying and assignment
+        CRC32C(const CRC32C& src);
+        CRC32C operator=(const CRC32C& rhs);
+
+        // prevent construction
+        CRC32C();
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,185 @@
+//----------------------------------------------------------------------
+// See ChallengeKeySearch.h
+//----------------------------------------------------------------------
+
+#include "ChallengeKeySearch.h"
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+#include "OpenSSLAlgorithms.h"
+#include "VerificationWorkerPool.h"
+
+#include <cstring>
+#include <sstream>
+#include <memory>     // unique_ptr
+
+//----------------------------------------------------------------------
+
+namespace{
+    // frees a worker's digest context
+    struct DigestContextDeleter{
+        void operator()(EVP_MD_CTX* pContext) const { EVP_MD_CTX_destroy(pContext); }
+    };
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor parses the key gen result and recovers the signed digest from its proof
+//   throws std::runtime_error if unable to parse or to create the OpenSSL state
+ChallengeKeySearch::ChallengeKeySearch(const std::vector<byte>& iobufData) : m_iobufData(iobufData),
+                                                                            m_pPrefixContext(nullptr){
+    // parse in place - may throw std::runtime_error but this is okay
+    this->m_view.parse(this->m_iobufData.data(), this->m_iobufData.size());
+
+    // RSA public operation on the proof, once for all candidates
+    CoolkeyRSAVerifier verifier;
+    const CoolkeyRSAKeyBlobView& blob = this->m_view.getBlob();
+    std::memset(this->m_digest, 0, sizeof(this->m_digest));
+    this->m_recoveryStatus = verifier.recoverDigest(blob, this->m_view.getProofData(), this->m_view.getProofSize(), this->m_digest);
+
+    // hash the blob prefix, once for all candidates
+    this->m_pPrefixContext = EVP_MD_CTX_create();
+    if (this->m_pPrefixContext == nullptr ||
+        EVP_DigestInit_ex(this->m_pPrefixContext, OpenSSLAlgorithms::getSHA1(), nullptr) != 1 ||
+        EVP_DigestUpdate(this->m_pPrefixContext, blob.getBlobData(), blob.getBlobSize()) != 1){
+        // the destructor does not run when the constructor throws
+        EVP_MD_CTX_destroy(this->m_pPrefixContext);
+        this->m_pPrefixContext = nullptr;
+        throw std::runtime_error(CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_BLOB_FAILED).getMessage());
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - frees the OpenSSL state
+ChallengeKeySearch::~ChallengeKeySearch(){
+    if (this->m_pPrefixContext != nullptr){
+        EVP_MD_CTX_destroy(this->m_pPrefixContext);
+        this->m_pPrefixContext = nullptr;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// reads a candidate list: the first whitespace-separated field of every line
+//   blank lines and lines starting with '#' are skipped
+//   throws std::runtime_error if the list cannot be read
+std::vector<ChallengeKeySearch::Candidate> ChallengeKeySearch::readCandidates(std::istream& candidateList){
+    std::vector<Candidate> candidates;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(candidateList, line)){
+        ++lineNumber;
+
+        Candidate candidate;
+        candidate.m_lineNumber = lineNumber;
+        std::istringstream fieldStream(line);
+        if (!(fieldStream >> candidate.m_field) || candidate.m_field.at(0) == '#'){
+            // skip blank lines and comments
+            continue;
+        }
+
+        candidates.push_back(candidate);
+    }
+
+    if (candidateList.bad() == true){
+        throw std::runtime_error("Unable to read candidate list.");
+    }
+    return candidates;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// checks every candidate, spreading the work across threadCount threads
+//   results are returned in list order regardless of thread count
+std::vector<ChallengeKeySearch::Result> ChallengeKeySearch::search(const std::vector<Candidate>& candidates, const size_t threadCount) const {
+    std::vector<Result> results(candidates.size());
+
+    // each item writes only its own result slot and only reads the shared prefix state, so no locking is required
+    const EVP_MD_CTX* const pPrefixContext = this->m_pPrefixContext;
+    const byte* const pDigest = this->m_digest;
+    const CoolkeyStatus& recoveryStatus = this->m_recoveryStatus;
+    VerificationWorkerPool workerPool(threadCount);
+    // every worker reuses one digest context (created on first use, on the worker's own thread)
+    std::vector<std::unique_ptr<EVP_MD_CTX, DigestContextDeleter>> contexts(workerPool.getThreadCount());
+    workerPool.run(candidates.size(), [&](const size_t itemIndex, const size_t workerIndex){
+        const Candidate& candidate = candidates[itemIndex];
+        Result& result = results[itemIndex];
+        result.m_lineNumber = candidate.m_lineNumber;
+
+        // stage 1: load the candidate
+        std::vector<byte> wrappedkey_data;
+        try{
+            wrappedkey_data = BatchVerifier::loadField(candidate.m_field);
+        }catch (std::runtime_error& ex){
+            result.m_outcome = RETCODE_INPUT_ERROR;
+            result.m_message = (ex.what() == nullptr) ? "<null>" : ex.what();
+            return;
+        }catch (...){
+            result.m_outcome = RETCODE_INPUT_ERROR;
+            result.m_message = "Unknown exception thrown.";
+            return;
+        }
+
+        // no candidate can match a proof whose digest could not be recovered
+        if (recoveryStatus.isOk() == false){
+            result.m_outcome = (recoveryStatus.getCategory() == CoolkeyStatus::CATEGORY_KEY) ? RETCODE_PARSE_ERROR : RETCODE_VERIFY_ERROR;
+            result.m_message = recoveryStatus.getMessage();
+            return;
+        }
+
+        // stage 2: finish SHA-1(blob || candidate) from a clone of the prefix state
+        std::unique_ptr<EVP_MD_CTX, DigestContextDeleter>& pContext = contexts[workerIndex];
+        if (pContext.get() == nullptr){
+            pContext.reset(EVP_MD_CTX_create());
+        }
+        byte digest[EVP_MAX_MD_SIZE];
+        unsigned int digestLength = 0;
+        CoolkeyStatus status;
+        if (pContext.get() == nullptr || EVP_MD_CTX_copy_ex(pContext.get(), pPrefixContext) != 1){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_INIT_FAILED);
+        }else if (EVP_DigestUpdate(pContext.get(), wrappedkey_data.data(), wrappedkey_data.size()) != 1){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_CHALLENGE_FAILED);
+        }else if (EVP_DigestFinal_ex(pContext.get(), digest, &digestLength) != 1 || digestLength != CoolkeyRSAVerifier::DIGEST_LENGTH){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+        }else if (std::memcmp(digest, pDigest, digestLength) != 0){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+        }
+
+        if (status.isOk() == false){
+            result.m_outcome = RETCODE_VERIFY_ERROR;
+            result.m_message = status.getMessage();
+            return;
+        }
+        result.m_outcome = RETCODE_SUCCESS;
+        result.m_message = "Challenge key matches RSA key gen result.";
+    });
+
+    return results;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// checks every candidate, writing one result line per matching or unloadable candidate to out
+//   returns RETCODE_SUCCESS if any candidate matched, otherwise RETCODE_VERIFY_ERROR
+int ChallengeKeySearch::run(const std::vector<Candidate>& candidates, std::ostream& out, const size_t threadCount) const {
+    const std::vector<Result> results(this->search(candidates, threadCount));
+
+    bool matched = false;
+    for (std::vector<Result>::const_iterator it = results.begin(); it != results.end(); it++){
+        const Result& result = *it;
+        if (result.m_outcome == RETCODE_SUCCESS){
+            matched = true;
+        }
+
+        // mismatches are the expected case and are not listed
+        if (result.m_outcome != RETCODE_VERIFY_ERROR){
+            out << result.m_lineNumber << '\t' << result.m_outcome << '\t' << result.m_message << '\n';
+        }
+    }
+    out.flush();
+    return (matched == true) ? RETCODE_SUCCESS : RETCODE_VERIFY_ERROR;
+}
+
+//----------------------------------------------------------------------
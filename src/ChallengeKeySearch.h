@@ -0,0 +1,100 @@
+//----------------------------------------------------------------------
+// ChallengeKeySearch - Finds which of many candidate challenge (wrapped)
+//                      keys a Coolkey RSA key gen result was made for.
+//
+// The key gen result is parsed once and the RSA public operation on its
+// proof is done once to recover the signed SHA-1 digest.  The digest is
+// SHA-1(blob || challenge key), so the hash state after the blob is
+// computed once as well and cloned for every candidate; each candidate
+// then costs one short SHA-1 update and a digest comparison.
+//----------------------------------------------------------------------
+
+#ifndef ChallengeKeySearchH_Included
+#define ChallengeKeySearchH_Included
+
+//----------------------------------------------------------------------
+
+class ChallengeKeySearch;
+
+//----------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include <openssl/evp.h>
+
+#include "BatchVerifier.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "CoolkeyRSAVerifier.h"
+#include "CoolkeyStatus.h"
+
+//----------------------------------------------------------------------
+
+class ChallengeKeySearch{
+    public:
+        // one candidate line: a wrappedkey field (ASCII-hex data or '@' followed by a file path)
+        class Candidate{
+            public:
+                size_t m_lineNumber;             // line number within the candidate list (1-based)
+                std::string m_field;             // wrappedkey field of the line
+        };
+
+        // outcome of checking one candidate (same form as a batch result)
+        typedef BatchVerifier::Result Result;
+
+    private:
+        // prevent copying and assignment
+        ChallengeKeySearch(const ChallengeKeySearch& src);
+        ChallengeKeySearch operator=(const ChallengeKeySearch& rhs);
+
+    protected:
+        std::vector<byte> m_iobufData;           // raw key gen result data - m_view points into it
+        CoolkeyRSAKeyGenResultView m_view;       // parsed key gen result   - parsed in constructor
+        CoolkeyStatus m_recoveryStatus;          // outcome of recovering the signed digest
+        byte m_digest[CoolkeyRSAVerifier::DIGEST_LENGTH]; // signed digest (valid if m_recoveryStatus is OK)
+        EVP_MD_CTX* m_pPrefixContext;            // SHA-1 state after hashing the key blob - cloned per candidate
+
+    public:
+        // constructor parses the key gen result and recovers the signed digest from its proof
+        //   throws std::runtime_error if unable to parse or to create the OpenSSL state
+        //   a proof that no challenge key can verify is reported by getRecoveryStatus(), not thrown
+        explicit ChallengeKeySearch(const std::vector<byte>& iobufData);
+
+        // destructor - frees the OpenSSL state
+        virtual ~ChallengeKeySearch();
+
+
+        // getter for the parsed key gen result
+        const CoolkeyRSAKeyGenResultView& getKeyGenResult() const { return this->m_view; }
+
+        // outcome of recovering the signed digest from the proof
+        //   CATEGORY_KEY: the key could not be loaded; CATEGORY_VERIFY: no challenge key can match
+        const CoolkeyStatus& getRecoveryStatus() const { return this->m_recoveryStatus; }
+
+
+        // reads a candidate list: the first whitespace-separated field of every line
+        //   blank lines and lines starting with '#' are skipped
+        //   throws std::runtime_error if the list cannot be read
+        static std::vector<Candidate> readCandidates(std::istream& candidateList);
+
+        // checks every candidate, spreading the work across threadCount threads
+        //   (0 selects one thread per hardware thread)
+        //   results are returned in list order; outcome is RETCODE_SUCCESS for a matching
+        //   candidate, RETCODE_INPUT_ERROR if it cannot be loaded and RETCODE_VERIFY_ERROR otherwise
+        std::vector<Result> search(const std::vector<Candidate>& candidates, const size_t threadCount = 1) const;
+
+        // checks every candidate, writing one result line per matching or unloadable candidate to out
+        //   line format: <candidate line number> TAB <outcome code> TAB <message>
+        //   returns RETCODE_SUCCESS if any candidate matched, otherwise RETCODE_VERIFY_ERROR
+        int run(const std::vector<Candidate>& candidates, std::ostream& out, const size_t threadCount = 1) const;
+};
+
+//----------------------------------------------------------------------
+
+#endif
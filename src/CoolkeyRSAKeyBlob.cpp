@@ -6,173 +6,297 @@
 
 //----------------------------------------------------------------------
 
-#include "Endianness.h"
-
+#include <algorithm> // copy, reverse_copy
+#include <atomic>
 #include <cstdint>
 #include <string>
-#include <sstream>
-#include <iomanip>
-#include <iterator>  // std::back_inserter
 
 #include <openssl/bn.h>
 #include <openssl/engine.h>
+#if defined(CKY_OPENSSL3_BACKEND)
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#endif
+
+#include "Endianness.h"
+#include "OpenSSLAlgorithms.h"
+
+#if defined(CKY_OPENSSL3_BACKEND)
+//----------------------------------------------------------------------
+
+namespace{
+    // copies length big endian bytes to pOut in native byte order
+    void copyToNativeEndian(const byte* pBigEndian, const size_t length, byte* pOut){
+        if (Endianness::is_big_endian() == true){
+            std::copy(pBigEndian, pBigEndian + length, pOut);
+        }else{
+            std::reverse_copy(pBigEndian, pBigEndian + length, pOut);
+        }
+    }
+
+    // the verify context of one thread and the blob it was prepared for
+    //   an EVP_PKEY_CTX may not be shared between threads, so each thread keeps its own; the context holds a
+    //   reference to the key, and blob ids are never reused, so a context outliving its blob is never used again
+    class ThreadVerifyContext{
+        private:
+            // prevent copying and assignment
+            ThreadVerifyContext(const ThreadVerifyContext& src);
+            ThreadVerifyContext operator=(const ThreadVerifyContext& rhs);
+
+        public:
+            uint64_t m_blobId;            // id of the blob m_pContext was prepared for (0: none)
+            EVP_PKEY_CTX* m_pContext;
+
+            ThreadVerifyContext() : m_blobId(0), m_pContext(nullptr) {}
+            ~ThreadVerifyContext(){ this->assign(0, nullptr); }
+
+            // replaces the context
+            void assign(const uint64_t blobId, EVP_PKEY_CTX* pContext){
+                if (this->m_pContext != nullptr){
+                    EVP_PKEY_CTX_free(this->m_pContext);
+                }
+                this->m_blobId = blobId;
+                this->m_pContext = pContext;
+            }
+    };
+
+    thread_local ThreadVerifyContext t_verifyContext;
+
+    // id of the next blob constructed
+    std::atomic<uint64_t> g_nextBlobId(1);
+}
+#endif
 
 //----------------------------------------------------------------------
 // PUBLIC
 // constructor does parsing work
 //   throws std::runtime_error if unable to parse
-CoolkeyRSAKeyBlob::CoolkeyRSAKeyBlob(const std::vector<byte>& blobData, const bool extraDataOkay) : m_rsaKey(nullptr){
-    // check that sufficient data is present for encoding, key type, key length, and modulus length
-    if (blobData.size() < (1 + 1 + 2 + 2)){
-        throw std::runtime_error("Invalid RSA Key Blob data - Insufficient data for blob header.");
-    }
-
-    size_t bytesConsumed = 0;  // how many bytes we've parsed out of the blobData vector
-
-    // parse out encoding byte
-    this->m_encoding = blobData.at(0);
-    ++bytesConsumed;
-
-    // parse out key type byte
-    this->m_keyType = blobData.at(1);
-    ++bytesConsumed;
-
-    // parse out key length in bits
-    uint16_t keyLengthBitsShort = *(reinterpret_cast<const uint16_t*>(&blobData.at(2)));  // get at(2 to 3) as short
-    keyLengthBitsShort = Endianness::ntohs(keyLengthBitsShort);                           // fix endianness
-    this->m_keyLengthBits = keyLengthBitsShort;                                           // widen to word size of machine
-    bytesConsumed += 2;
-
-    // parse out modulus length
-    uint16_t modulusLengthShort = *(reinterpret_cast<const uint16_t*>(&blobData.at(4)));  // get at(4 to 5) as short
-    modulusLengthShort = Endianness::ntohs(modulusLengthShort);                           // fix endianness
-    this->m_modulusLength = modulusLengthShort;                                           // widen to word size of machine
-    bytesConsumed += 2;
-
-    // sanity check parsed out values thus far
-    if (this->m_encoding != KEYENCODING_PLAINTEXT){
-        std::ostringstream errsstr;
-        int m_encoding_int = this->m_encoding;
-        errsstr << "Invalid RSA Key Blob data - Unsupported key encoding 0x"
-                << std::setw(2) << std::setfill('0') << std::hex << m_encoding_int;
-        throw std::runtime_error(errsstr.str());
-    }
-    if (this->m_keyType != KEYTYPE_RSA_PUBLIC){
-        std::ostringstream errsstr;
-        int m_keyType_int = this->m_keyType;
-        errsstr << "Invalid RSA Key Blob data - Unsupported key type 0x"
-                << std::setw(2) << std::setfill('0') << std::hex << m_keyType_int;
-        throw std::runtime_error(errsstr.str());
-    }
-
-    // sanity check modulus length
-    size_t remainingData = blobData.size() - bytesConsumed;
-    // subtract 2 for exponent length
-    if ((remainingData - 2) < this->m_modulusLength){
-        std::ostringstream errsstr;
-        errsstr << "Invalid RSA Key Blob data - Insufficient data for key modulus."
-                << "  Modulus length was: " << this->m_modulusLength
-                << "  Remaining data was: " << (remainingData - 2);
-        throw std::runtime_error(errsstr.str());
-    }
-
-    // parse out modulus data (copy subset of blobData to this->m_modulusData)
-    std::copy(blobData.begin() + bytesConsumed, 
-              blobData.begin() + bytesConsumed + this->m_modulusLength,
-              std::back_inserter(this->m_modulusData));
-    bytesConsumed += this->m_modulusLength;
-
-    // parse out exponent length
-    uint16_t exponentLengthShort = *(reinterpret_cast<const uint16_t*>(&blobData.at(bytesConsumed)));  // get at(bytesConsumed to bytesConsumed+1) as short
-    exponentLengthShort = Endianness::ntohs(exponentLengthShort);                                      // fix endianness
-    this->m_exponentLength = exponentLengthShort;                                                      // widen to word size of machine
-    bytesConsumed += 2;
-
-    // sanity check exponent length
-    remainingData = blobData.size() - bytesConsumed;
-    if ((remainingData) < this->m_exponentLength){
-        std::ostringstream errsstr;
-        errsstr << "Invalid RSA Key Blob data - Insufficient data for key exponent."
-                << "  Exponent length was: " << this->m_exponentLength
-                << "  Remaining data was: " << (remainingData);
-        throw std::runtime_error(errsstr.str());
-    }
-
-    // parse out exponent data (copy subset of blobData to this->m_exponentData)
-    std::copy(blobData.begin() + bytesConsumed,
-              blobData.begin() + bytesConsumed + this->m_exponentLength,
-              std::back_inserter(this->m_exponentData));
-    bytesConsumed += this->m_exponentLength;
-
-    // check if extra data was present.  If so --> if configuration parameter was that extra data isn't okay, throw exception.
-    if (extraDataOkay == false){
-        if (bytesConsumed != blobData.size()){
-            std::ostringstream errsstr;
-            errsstr << "Invalid RSA Key Blob data - Extra data was present after parsing completed."
-                    << "  Parsed blob length was: " << bytesConsumed
-                    << "  Total blob length was: " << blobData.size();
-            throw std::runtime_error(errsstr.str());
-        }
+CoolkeyRSAKeyBlob::CoolkeyRSAKeyBlob(const std::vector<byte>& blobData, const bool extraDataOkay) : m_pKey(nullptr),
+#if defined(CKY_OPENSSL3_BACKEND)
+                                                                                                   m_id(g_nextBlobId++){
+#else
+                                                                                                   m_rsaKey(nullptr){
+#endif
+    // parse in place, then copy out the parsed fields
+    CoolkeyRSAKeyBlobView view;
+    view.parse(blobData.data(), blobData.size(), extraDataOkay);
+    this->initialize(view);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor copies the fields of an already parsed key blob view
+//   throws std::runtime_error if unable to create the OpenSSL key
+CoolkeyRSAKeyBlob::CoolkeyRSAKeyBlob(const CoolkeyRSAKeyBlobView& view) : m_pKey(nullptr),
+#if defined(CKY_OPENSSL3_BACKEND)
+                                                                          m_id(g_nextBlobId++){
+#else
+                                                                          m_rsaKey(nullptr){
+#endif
+    this->initialize(view);
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// copies the parsed fields of view into this object and creates the OpenSSL key
+//   throws std::runtime_error if unable to create the OpenSSL key
+void CoolkeyRSAKeyBlob::initialize(const CoolkeyRSAKeyBlobView& view){
+    // copy parsed fields (one allocation per vector)
+    this->m_encoding = view.getKeyEncoding();
+    this->m_keyType = view.getKeyType();
+    this->m_keyLengthBits = view.getKeyLengthBits();
+    this->m_modulusLength = view.getModulusLength();
+    this->m_modulusData.assign(view.getModulusData(), view.getModulusData() + view.getModulusLength());
+    this->m_exponentLength = view.getExponentLength();
+    this->m_exponentData.assign(view.getExponentData(), view.getExponentData() + view.getExponentLength());
+    this->m_blobData.assign(view.getBlobData(), view.getBlobData() + view.getBlobSize());
+
+
+
+    // create the OpenSSL key
+    createOpensslKey(view, this->m_pKey).throwIfError();
+
+#if defined(CKY_OPENSSL3_BACKEND)
+    // prepare the constructing thread's verify context for every later verification on this thread
+    EVP_PKEY_CTX* pVerifyContext = nullptr;
+    const CoolkeyStatus contextStatus = createVerifyContext(this->m_pKey, pVerifyContext);
+    if (contextStatus.isOk() == false){
+        // the destructor does not run when the constructor throws
+        EVP_PKEY_free(this->m_pKey);
+        this->m_pKey = nullptr;
+        contextStatus.throwIfError();
+    }
+    t_verifyContext.assign(this->m_id, pVerifyContext);
+#else
+    // EVP key owns the RSA key; keep a pointer to it for getOpensslRSAKey()
+    this->m_rsaKey = EVP_PKEY_get1_RSA(this->m_pKey);
+    RSA_free(this->m_rsaKey);
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// creates an OpenSSL public key from the modulus and exponent of a parsed key blob view
+//   on success pKey receives a new key owned by the caller (free with EVP_PKEY_free); never throws
+CoolkeyStatus CoolkeyRSAKeyBlob::createOpensslKey(const CoolkeyRSAKeyBlobView& view, EVP_PKEY*& pKey){
+    pKey = nullptr;
+
+#if defined(CKY_OPENSSL3_BACKEND)
+    // import from the thread's RSA key import context (key management fetched once per thread)
+    EVP_PKEY_CTX* pFromDataContext = OpenSSLAlgorithms::getRSAFromDataContext();
+    if (pFromDataContext == nullptr){
+        return CoolkeyStatus(CoolkeyStatus::KEY_PKEY_FAILED);
     }
 
-    // copy blob data bytes to this->m_blobData
-    std::copy(blobData.begin(),
-              blobData.begin() + bytesConsumed,
-              std::back_inserter(this->m_blobData));
+    // OSSL_PARAM integers are native endian; the blob holds big endian data
+    //   converted in stack buffers, or in heap buffers for fields longer than OpenSSL accepts anyway
+    byte modulusBuffer[MAX_MODULUS_BITS / 8];
+    byte exponentBuffer[MAX_MODULUS_BITS / 8];
+    std::vector<byte> oversizeModulus;
+    std::vector<byte> oversizeExponent;
+    const size_t modulusLength = view.getModulusLength();
+    const size_t exponentLength = view.getExponentLength();
+    byte* pModulus = modulusBuffer;
+    if (modulusLength > sizeof(modulusBuffer)){
+        oversizeModulus.resize(modulusLength);
+        pModulus = oversizeModulus.data();
+    }
+    byte* pExponent = exponentBuffer;
+    if (exponentLength > sizeof(exponentBuffer)){
+        oversizeExponent.resize(exponentLength);
+        pExponent = oversizeExponent.data();
+    }
+    copyToNativeEndian(view.getModulusData(), modulusLength, pModulus);
+    copyToNativeEndian(view.getExponentData(), exponentLength, pExponent);
 
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_BN(OSSL_PKEY_PARAM_RSA_N, pModulus, modulusLength),
+        OSSL_PARAM_construct_BN(OSSL_PKEY_PARAM_RSA_E, pExponent, exponentLength),
+        OSSL_PARAM_construct_end()
+    };
+    if (EVP_PKEY_fromdata(pFromDataContext, &pKey, EVP_PKEY_PUBLIC_KEY, params) != 1){
+        pKey = nullptr;
+        return CoolkeyStatus(CoolkeyStatus::KEY_PKEY_FAILED);
+    }
+    return CoolkeyStatus();
+#else
+    RSA* rsaKey = nullptr;
+    const CoolkeyStatus status = createOpensslRSAKey(view, rsaKey);
+    if (status.isOk() == false){
+        return status;
+    }
 
+    // wrap RSA key inside EVP key object; "assign" hands ownership of the RSA key to the EVP key
+    EVP_PKEY* newKey = EVP_PKEY_new();
+    if (newKey == nullptr || EVP_PKEY_assign_RSA(newKey, rsaKey) != 1){
+        EVP_PKEY_free(newKey);
+        RSA_free(rsaKey);
+        return CoolkeyStatus(CoolkeyStatus::KEY_PKEY_FAILED);
+    }
 
-    // pointers to openssl BIGNUM versions of m_modulusData and m_exponentData
-    BIGNUM* bnModulus = nullptr;
-    BIGNUM* bnExponent = nullptr;
-    try{
-        // create openssl BIGNUM structures based on modulus and exponent data
-        bnExponent = BN_bin2bn(&this->m_exponentData.at(0), this->m_exponentData.size(), nullptr);
-        if (bnExponent == nullptr){
-            throw std::runtime_error("Unable to finalize RSA Key Blob data parsing - Could not create openssl BIGNUM structure for exponent data.");
-        }
-        bnModulus = BN_bin2bn(&this->m_modulusData.at(0), this->m_modulusData.size(), nullptr);
-        if (bnModulus == nullptr){
-            throw std::runtime_error("Unable to finalize RSA Key Blob data parsing - Could not create openssl BIGNUM structure for modulus data.");
-        }
+    pKey = newKey;
+    return CoolkeyStatus();
+#endif
+}
 
-        // create openssl RSA structure
-        this->m_rsaKey = RSA_new();
-        if (this->m_rsaKey == nullptr){
-            throw std::runtime_error("Unable to finalize RSA Key Blob data parsing - Could not create openssl RSA key structure.");
-        }
+#if defined(CKY_OPENSSL3_BACKEND)
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// creates a context that verifies PKCS#1 v1.5 SHA-1 signatures over a digest with pKey
+//   on success pContext receives a new context owned by the caller (free with EVP_PKEY_CTX_free); never throws
+CoolkeyStatus CoolkeyRSAKeyBlob::createVerifyContext(EVP_PKEY* pKey, EVP_PKEY_CTX*& pContext){
+    pContext = nullptr;
 
-    }catch (...){
-        // free openssl BIGNUM structures we may have allocated
-        if (bnExponent != nullptr){
-            BN_free(bnExponent);
-            bnExponent = nullptr;
-        }
-        if (bnModulus != nullptr){
-            BN_free(bnModulus);
-            bnModulus = nullptr;
-        }
-        // free RSA structure we may have allocated
-        if (this->m_rsaKey != nullptr){
-            RSA_free(this->m_rsaKey);
-            this->m_rsaKey = nullptr;
+    const EVP_MD* pDigest = OpenSSLAlgorithms::getSHA1();
+    EVP_PKEY_CTX* newContext = EVP_PKEY_CTX_new_from_pkey(nullptr, pKey, nullptr);
+    if (pDigest == nullptr || newContext == nullptr ||
+        EVP_PKEY_verify_init(newContext) != 1 ||
+        EVP_PKEY_CTX_set_rsa_padding(newContext, RSA_PKCS1_PADDING) <= 0 ||
+        EVP_PKEY_CTX_set_signature_md(newContext, pDigest) <= 0){
+        EVP_PKEY_CTX_free(newContext);
+        return CoolkeyStatus(CoolkeyStatus::KEY_CONTEXT_FAILED);
+    }
+
+    pContext = newContext;
+    return CoolkeyStatus();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// returns the calling thread's verify context for the key, prepared on the thread's first use, or nullptr on failure
+EVP_PKEY_CTX* CoolkeyRSAKeyBlob::getOpensslVerifyContext() const{
+    if (t_verifyContext.m_blobId != this->m_id){
+        EVP_PKEY_CTX* pContext = nullptr;
+        if (createVerifyContext(this->m_pKey, pContext).isOk() == false){
+            return nullptr;
         }
+        t_verifyContext.assign(this->m_id, pContext);
     }
+    return t_verifyContext.m_pContext;
+}
+#else
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// creates an OpenSSL RSA public key from the modulus and exponent of a parsed key blob view
+//   on success rsaKey receives a new key owned by the caller (free with RSA_free); never throws
+CoolkeyStatus CoolkeyRSAKeyBlob::createOpensslRSAKey(const CoolkeyRSAKeyBlobView& view, RSA*& rsaKey){
+    rsaKey = nullptr;
 
-    // assign ownership of bnExponent and bnModulus to this->m_rsaKey
-    //   this means that when we free this->m_rsaKey, we will free the BIGNUMs as well
-    this->m_rsaKey->e = bnExponent;
-    this->m_rsaKey->n = bnModulus;
+    // create openssl BIGNUM structures based on modulus and exponent data
+    BIGNUM* bnExponent = BN_bin2bn(view.getExponentData(), static_cast<int>(view.getExponentLength()), nullptr);
+    if (bnExponent == nullptr){
+        return CoolkeyStatus(CoolkeyStatus::KEY_EXPONENT_FAILED);
+    }
+    BIGNUM* bnModulus = BN_bin2bn(view.getModulusData(), static_cast<int>(view.getModulusLength()), nullptr);
+    if (bnModulus == nullptr){
+        BN_free(bnExponent);
+        return CoolkeyStatus(CoolkeyStatus::KEY_MODULUS_FAILED);
+    }
+
+    // create openssl RSA structure
+    RSA* newKey = RSA_new();
+    if (newKey == nullptr){
+        BN_free(bnExponent);
+        BN_free(bnModulus);
+        return CoolkeyStatus(CoolkeyStatus::KEY_RSA_FAILED);
+    }
+
+    // assign ownership of bnExponent and bnModulus to newKey
+    //   this means that when we free newKey, we will free the BIGNUMs as well
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    newKey->e = bnExponent;
+    newKey->n = bnModulus;
+#else
+    if (RSA_set0_key(newKey, bnModulus, bnExponent, nullptr) != 1){
+        RSA_free(newKey);
+        BN_free(bnExponent);
+        BN_free(bnModulus);
+        return CoolkeyStatus(CoolkeyStatus::KEY_RSA_FAILED);
+    }
+#endif
+
+    rsaKey = newKey;
+    return CoolkeyStatus();
 }
+#endif
 
 //----------------------------------------------------------------------
 // PUBLIC
 // destructor - cleans up OpenSSL objects
 CoolkeyRSAKeyBlob::~CoolkeyRSAKeyBlob(){
-    // free RSA structure we may have allocated
-    if (this->m_rsaKey != nullptr){
-        RSA_free(this->m_rsaKey);
-        this->m_rsaKey = nullptr;
+    // free EVP structures we may have allocated (the EVP key owns the RSA structure)
+#if defined(CKY_OPENSSL3_BACKEND)
+    // other threads free their contexts of this blob when they move on to another blob, or exit
+    if (t_verifyContext.m_blobId == this->m_id){
+        t_verifyContext.assign(0, nullptr);
+    }
+#else
+    this->m_rsaKey = nullptr;
+#endif
+    if (this->m_pKey != nullptr){
+        EVP_PKEY_free(this->m_pKey);
+        this->m_pKey = nullptr;
     }
 }
 
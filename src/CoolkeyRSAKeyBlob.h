@@ -1,6 +1,13 @@
 //----------------------------------------------------------------------
 // CoolkeyRSAKeyBlob - Handles parsing of Coolkey RSA Key Blob objects 
 //                     into machine-retrievable fields.
+//
+// The public key is held as an EVP_PKEY.  With the OpenSSL 3 backend
+// (CKY_OPENSSL3_BACKEND) it is imported with EVP_PKEY_fromdata() and
+// verified with a context prepared for PKCS#1 v1.5 SHA-1.  Contexts are
+// per thread: each thread keeps the context of the blob it last verified,
+// so repeated verifications of one blob reuse it and a blob may be
+// verified from several threads at once.
 //----------------------------------------------------------------------
 
 #ifndef CoolkeyRSAKeyBlobH_Included
@@ -14,21 +21,29 @@ class CoolkeyRSAKeyBlob;
 
 #include <vector>
 #include <stdexcept>
+#include <cstdint>
 
 typedef unsigned char byte;
 typedef unsigned char BYTE;
 
+#include <openssl/evp.h>
 #include <openssl/rsa.h>
 
+#include "CoolkeyRSAKeyBlobView.h"
+#include "CoolkeyStatus.h"
+
 //----------------------------------------------------------------------
 
 class CoolkeyRSAKeyBlob{
     public:
         // supported key blob types
-        const static byte KEYTYPE_RSA_PUBLIC = 0x01;
+        const static byte KEYTYPE_RSA_PUBLIC = CoolkeyRSAKeyBlobView::KEYTYPE_RSA_PUBLIC;
         
         // supported key encoding types
-        const static byte KEYENCODING_PLAINTEXT = 0x00;
+        const static byte KEYENCODING_PLAINTEXT = CoolkeyRSAKeyBlobView::KEYENCODING_PLAINTEXT;
+
+        // largest modulus (and exponent) createOpensslKey() imports without heap memory - OpenSSL's own RSA limit
+        const static size_t MAX_MODULUS_BITS = 16384;
 
     private:
         // prevent copying and assignment
@@ -48,18 +63,49 @@ class CoolkeyRSAKeyBlob{
         std::vector<byte> m_exponentData;     // exponent data                  - parsed out in constructor
 
 
-        // pointer to openssl RSA (public key) structure
-        RSA* m_rsaKey;                        // initialized in constructor with parsed out key data
+        // pointer to openssl EVP (public key) structure
+        EVP_PKEY* m_pKey;                     // initialized in constructor with parsed out key data
+#if defined(CKY_OPENSSL3_BACKEND)
+        uint64_t m_id;                        // unique among all blobs - names the blob's per-thread verify contexts
+#else
+        RSA* m_rsaKey;                        // RSA key wrapped (and owned) by m_pKey
+#endif
+
+        // copies the parsed fields of view into this object and creates the OpenSSL key
+        //   throws std::runtime_error if unable to create the OpenSSL key
+        void initialize(const CoolkeyRSAKeyBlobView& view);
 
     public:
         // constructor does parsing work
         //   throws std::runtime_error if unable to parse
         CoolkeyRSAKeyBlob(const std::vector<byte>& blobData, const bool extraDataOkay = false);
 
+        // constructor copies the fields of an already parsed key blob view
+        //   throws std::runtime_error if unable to create the OpenSSL key
+        explicit CoolkeyRSAKeyBlob(const CoolkeyRSAKeyBlobView& view);
+
         // destructor
         virtual ~CoolkeyRSAKeyBlob();
 
 
+        // creates an OpenSSL public key from the modulus and exponent of a parsed key blob view
+        //   on success pKey receives a new key owned by the caller (free with EVP_PKEY_free)
+        //   never throws; failures are reported through the returned status
+        static CoolkeyStatus createOpensslKey(const CoolkeyRSAKeyBlobView& view, EVP_PKEY*& pKey);
+
+#if defined(CKY_OPENSSL3_BACKEND)
+        // creates a context that verifies PKCS#1 v1.5 SHA-1 signatures over a digest with pKey
+        //   on success pContext receives a new context owned by the caller (free with EVP_PKEY_CTX_free)
+        //   never throws; failures are reported through the returned status
+        static CoolkeyStatus createVerifyContext(EVP_PKEY* pKey, EVP_PKEY_CTX*& pContext);
+#else
+        // creates an OpenSSL RSA public key from the modulus and exponent of a parsed key blob view
+        //   on success rsaKey receives a new key owned by the caller (free with RSA_free)
+        //   never throws; failures are reported through the returned status
+        static CoolkeyStatus createOpensslRSAKey(const CoolkeyRSAKeyBlobView& view, RSA*& rsaKey);
+#endif
+
+
         // getters for raw blob data
         size_t getBlobSize() const { return this->m_blobData.size(); }
         const std::vector<byte>& getBlobData() const { return this->m_blobData; }
@@ -72,12 +118,24 @@ class CoolkeyRSAKeyBlob{
         const std::vector<byte>& getExponentData() const { return this->m_exponentData; }
 
 
-        // getter for openssl RSA key object
+        // getter for openssl EVP key object
         //   rules: 
         //   1. valid for the lifetime of this
         //   2. don't free (will be automatically freed by this)
         //   3. guaranteed to not be NULL (provided complete construction of the object occurs)
+        EVP_PKEY* getOpensslKey() const{ return this->m_pKey; }
+
+#if defined(CKY_OPENSSL3_BACKEND)
+        // returns the calling thread's verify context for the key, prepared on the thread's first use
+        //   (the constructing thread's is prepared by the constructor), or nullptr if it cannot be created
+        //   rules:
+        //   1. valid until the calling thread asks for another blob's context, or this is destroyed
+        //   2. don't free, and don't pass to another thread
+        EVP_PKEY_CTX* getOpensslVerifyContext() const;
+#else
+        // getter for openssl RSA key object - same rules as getOpensslKey()
         const RSA* getOpensslRSAKey() const{ return this->m_rsaKey; }
+#endif
 };
 
 //----------------------------------------------------------------------
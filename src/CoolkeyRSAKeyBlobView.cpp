@@ -0,0 +1,93 @@
+//----------------------------------------------------------------------
+// See CoolkeyRSAKeyBlobView.h
+//----------------------------------------------------------------------
+
+#include "CoolkeyRSAKeyBlobView.h"
+
+//----------------------------------------------------------------------
+
+#include "ByteCursor.h"
+
+#include <cstdint>
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor - creates an empty view
+CoolkeyRSAKeyBlobView::CoolkeyRSAKeyBlobView() : m_pBlobData(nullptr),
+                                                 m_blobSize(0),
+                                                 m_encoding(0),
+                                                 m_keyType(0),
+                                                 m_keyLengthBits(0),
+                                                 m_pModulusData(nullptr),
+                                                 m_modulusLength(0),
+                                                 m_pExponentData(nullptr),
+                                                 m_exponentLength(0){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// parses the key blob at pData
+//   throws std::runtime_error if unable to parse
+void CoolkeyRSAKeyBlobView::parse(const byte* pData, const size_t size, const bool extraDataOkay){
+    this->tryParse(pData, size, extraDataOkay).throwIfError();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// parses the key blob at pData without throwing
+//   returns the reason and offset of the first problem found
+CoolkeyStatus CoolkeyRSAKeyBlobView::tryParse(const byte* pData, const size_t size, const bool extraDataOkay){
+    ByteCursor cursor(pData, size);
+
+    // parse out encoding byte, key type byte, key length in bits and modulus length
+    uint16_t keyLengthBitsShort = 0;
+    uint16_t modulusLengthShort = 0;
+    if (cursor.readByte(this->m_encoding) == false ||
+        cursor.readByte(this->m_keyType) == false ||
+        cursor.readUint16(keyLengthBitsShort) == false ||
+        cursor.readUint16(modulusLengthShort) == false){
+        return CoolkeyStatus(CoolkeyStatus::BLOB_TRUNCATED_HEADER, cursor.getOffset());
+    }
+    this->m_keyLengthBits = keyLengthBitsShort;
+    this->m_modulusLength = modulusLengthShort;
+
+    // sanity check parsed out values thus far
+    if (this->m_encoding != KEYENCODING_PLAINTEXT){
+        return CoolkeyStatus(CoolkeyStatus::BLOB_UNSUPPORTED_ENCODING, 0, this->m_encoding);
+    }
+    if (this->m_keyType != KEYTYPE_RSA_PUBLIC){
+        return CoolkeyStatus(CoolkeyStatus::BLOB_UNSUPPORTED_KEY_TYPE, 1, this->m_keyType);
+    }
+
+    // sanity check modulus length
+    //   subtract 2 for exponent length
+    const size_t remainingForModulus = (cursor.getRemaining() < 2) ? 0 : (cursor.getRemaining() - 2);
+    if (remainingForModulus < this->m_modulusLength){
+        return CoolkeyStatus(CoolkeyStatus::BLOB_TRUNCATED_MODULUS, cursor.getOffset(), this->m_modulusLength, remainingForModulus);
+    }
+
+    // parse out modulus data and exponent length (cannot fail after the check above)
+    uint16_t exponentLengthShort = 0;
+    cursor.readBytes(this->m_modulusLength, this->m_pModulusData);
+    cursor.readUint16(exponentLengthShort);
+    this->m_exponentLength = exponentLengthShort;
+
+    // sanity check exponent length and parse out exponent data
+    if (cursor.readBytes(this->m_exponentLength, this->m_pExponentData) == false){
+        return CoolkeyStatus(CoolkeyStatus::BLOB_TRUNCATED_EXPONENT, cursor.getOffset(), this->m_exponentLength, cursor.getRemaining());
+    }
+
+    // check if extra data was present.  If so --> if configuration parameter was that extra data isn't okay, fail.
+    if (extraDataOkay == false){
+        if (cursor.getRemaining() != 0){
+            return CoolkeyStatus(CoolkeyStatus::BLOB_EXTRA_DATA, cursor.getOffset(), cursor.getOffset(), size);
+        }
+    }
+
+    this->m_pBlobData = pData;
+    this->m_blobSize = cursor.getOffset();
+    return CoolkeyStatus();
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,78 @@
+//----------------------------------------------------------------------
+// CoolkeyRSAKeyBlobView - Parses Coolkey RSA Key Blob objects in place.
+//                         Fields are recorded as pointers into a
+//                         caller-owned buffer; nothing is copied or
+//                         allocated.
+//----------------------------------------------------------------------
+
+#ifndef CoolkeyRSAKeyBlobViewH_Included
+#define CoolkeyRSAKeyBlobViewH_Included
+
+//----------------------------------------------------------------------
+
+class CoolkeyRSAKeyBlobView;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "CoolkeyStatus.h"
+
+//----------------------------------------------------------------------
+
+class CoolkeyRSAKeyBlobView{
+    public:
+        // supported key blob types
+        const static byte KEYTYPE_RSA_PUBLIC = 0x01;
+
+        // supported key encoding types
+        const static byte KEYENCODING_PLAINTEXT = 0x00;
+
+    protected:
+        const byte* m_pBlobData;              // start of key blob              - set by parse()
+        size_t m_blobSize;                    // byte length of parsed key blob - set by parse()
+
+        byte m_encoding;                      // key encoding field of blob     - set by parse()
+        byte m_keyType;                       // key type field of blob         - set by parse()
+        size_t m_keyLengthBits;               // length of RSA key in bits      - set by parse()
+
+        const byte* m_pModulusData;           // modulus data                   - set by parse()
+        size_t m_modulusLength;               // byte length of modulus field   - set by parse()
+        const byte* m_pExponentData;          // exponent data                  - set by parse()
+        size_t m_exponentLength;              // byte length of exponent field  - set by parse()
+
+    public:
+        // constructor - creates an empty view; call parse() to fill it in
+        CoolkeyRSAKeyBlobView();
+
+        // parses the key blob at pData
+        //   the buffer is borrowed, not copied: it must outlive every use of this view
+        //   throws std::runtime_error if unable to parse (contents of this view are then undefined)
+        void parse(const byte* pData, const size_t size, const bool extraDataOkay = false);
+
+        // as parse(), but reports failure through the returned status instead of throwing
+        //   the status carries the reason and the offset within pData of the first problem found
+        CoolkeyStatus tryParse(const byte* pData, const size_t size, const bool extraDataOkay = false);
+
+
+        // getters for raw blob data
+        size_t getBlobSize() const { return this->m_blobSize; }
+        const byte* getBlobData() const { return this->m_pBlobData; }
+
+        // getters for key blob fields
+        byte getKeyEncoding() const { return this->m_encoding; }
+        byte getKeyType() const { return this->m_keyType; }
+        size_t getKeyLengthBits() const { return this->m_keyLengthBits; }
+        const byte* getModulusData() const { return this->m_pModulusData; }
+        size_t getModulusLength() const { return this->m_modulusLength; }
+        const byte* getExponentData() const { return this->m_pExponentData; }
+        size_t getExponentLength() const { return this->m_exponentLength; }
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -6,89 +6,44 @@
 
 //----------------------------------------------------------------------
 
-#include "Endianness.h"
-
 #include <cstdint>
 #include <string>
-#include <sstream>
-#include <iomanip>
-#include <iterator>  // std::back_inserter
 
 #include <openssl/evp.h>
 #include <openssl/rsa.h>
 
+#include "OpenSSLAlgorithms.h"
+
 //----------------------------------------------------------------------
 // PUBLIC
 // constructor does parsing work
 //   throws std::runtime_error if unable to parse
 //   does NOT verify the signature on the key - call CoolkeyRSAKeyChallenge::verifySignature() to do that
 CoolkeyRSAKeyGenResult::CoolkeyRSAKeyGenResult(const std::vector<byte>& data, const bool extraDataOkay){
-    // check that sufficient data is present for keyblob length and proof length
-    if (data.size() < (2 + 2)){
-        throw std::runtime_error("Invalid RSA Key Gen Result - Insufficient data for key blob length and proof length.");
-    }
-
-    size_t bytesConsumed = 0;  // how many bytes we've parsed out of the data vector
-
-    // parse out key length
-    uint16_t keyLength_short = *(reinterpret_cast<const uint16_t*>(&data.at(0)));  // get at(0 to 1) as short
-    keyLength_short = Endianness::ntohs(keyLength_short);                          // fix endianness
-    size_t keyLength_sizet = keyLength_short;                                      // widen to word size of machine
-    bytesConsumed += 2;
-
-    // sanity check key length
-    size_t remainingData = data.size() - bytesConsumed;
-    // subtract 2 for proof length
-    if ((remainingData - 2) < keyLength_sizet){
-        std::ostringstream errsstr;
-        errsstr << "Invalid RSA Key Gen Result - Insufficient data for key blob."
-                << "  Blob length was: " << keyLength_sizet
-                << "  Remaining data was: " << (remainingData - 2);
-        throw std::runtime_error(errsstr.str());
-    }
+    // parse in place - may throw std::runtime_error but this is okay
+    CoolkeyRSAKeyGenResultView view;
+    view.parse(data.data(), data.size(), extraDataOkay);
+    this->initialize(view);
+}
 
-    // copy key blob data
-    std::vector<byte> keyBlobData(data.begin() + bytesConsumed, data.begin() + bytesConsumed + keyLength_sizet);
-    bytesConsumed += keyLength_sizet;
-
-    // parse key blob data into object - may throw std::runtime_error but this is okay
-    std::unique_ptr<CoolkeyRSAKeyBlob> keyBlobPtr(new CoolkeyRSAKeyBlob(keyBlobData));
-    this->m_pKeyBlob = std::move(keyBlobPtr);
-
-
-    // parse out proof length
-    uint16_t proofLength_short = *(reinterpret_cast<const uint16_t*>(&data.at(bytesConsumed)));  // get at(bytesConsumed to bytesConsumed+1) as short
-    proofLength_short = Endianness::ntohs(proofLength_short);                                    // fix endianness
-    size_t proofLength_sizet = proofLength_short;                                                // widen to word size of machine
-    bytesConsumed += 2;
-
-    // sanity check proof length
-    remainingData = data.size() - bytesConsumed;
-    if ((remainingData) < proofLength_sizet){
-        std::ostringstream errsstr;
-        errsstr << "Invalid RSA Key Gen Result - Insufficient data for proof."
-                << "  Proof length was: " << proofLength_sizet
-                << "  Remaining data was: " << (remainingData);
-        throw std::runtime_error(errsstr.str());
-    }
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor copies the fields of an already parsed key gen result view
+//   throws std::runtime_error if unable to create the OpenSSL key
+CoolkeyRSAKeyGenResult::CoolkeyRSAKeyGenResult(const CoolkeyRSAKeyGenResultView& view){
+    this->initialize(view);
+}
 
-    // parse out proof data (copy subset of blobData to this->m_keyProofData)
-    std::copy(data.begin() + bytesConsumed,
-              data.begin() + bytesConsumed + proofLength_sizet,
-              std::back_inserter(this->m_keyProofData));
-    bytesConsumed += proofLength_sizet;
-
-
-    // check if extra data was present.  If so --> if configuration parameter was that extra data isn't okay, throw exception.
-    if (extraDataOkay == false){
-        if (bytesConsumed != data.size()){
-            std::ostringstream errsstr;
-            errsstr << "Invalid RSA Key Gen Result - Extra data was present after parsing completed."
-                    << "  Parsed result length was: " << bytesConsumed
-                    << "  Total result length was: " << data.size();
-            throw std::runtime_error(errsstr.str());
-        }
-    }
+//----------------------------------------------------------------------
+// PROTECTED
+// copies the parsed fields of view into this object
+//   throws std::runtime_error if unable to create the OpenSSL key
+void CoolkeyRSAKeyGenResult::initialize(const CoolkeyRSAKeyGenResultView& view){
+    // key blob object copies straight out of the parsed view - no temporary copy of the blob
+    this->m_pKeyBlob.reset(new CoolkeyRSAKeyBlob(view.getBlob()));
+
+    // copy proof data
+    this->m_keyProofData.assign(view.getProofData(), view.getProofData() + view.getProofSize());
 }
 
 //----------------------------------------------------------------------
@@ -102,132 +57,194 @@ CoolkeyRSAKeyGenResult::~CoolkeyRSAKeyGenResult(){
 // verify method verifies the RSA signature on the blob with the specified challenge key
 //   throws std::runtime_error if signature has a problem
 void CoolkeyRSAKeyGenResult::verifySignature(const std::vector<byte>& challengeKeyData) const {
-    const RSA* rsaKey = this->m_pKeyBlob.get()->getOpensslRSAKey();
+    verifySignature(*(this->m_pKeyBlob.get()), this->m_keyProofData.data(), this->m_keyProofData.size(),
+                    challengeKeyData.data(), challengeKeyData.size());
+}
 
-    // create new EVP Key object
-    EVP_PKEY* evpRsaKey = EVP_PKEY_new();
-    if (evpRsaKey == nullptr){
-        throw std::runtime_error("Unable to create EVP_PKEY object.");
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// verifies proof data (signature) over a key blob with the specified challenge key
+//   throws std::runtime_error if signature has a problem
+void CoolkeyRSAKeyGenResult::verifySignature(const CoolkeyRSAKeyBlob& keyBlob,
+                                             const byte* pProofData, const size_t proofSize,
+                                             const byte* pChallengeKeyData, const size_t challengeKeySize){
+    tryVerifySignature(keyBlob, pProofData, proofSize, pChallengeKeyData, challengeKeySize).throwIfError();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// creates the OpenSSL key of a parsed key gen result view and verifies its proof with the specified challenge key
+//   never throws; failures are reported through the returned status
+CoolkeyStatus CoolkeyRSAKeyGenResult::tryVerifySignature(const CoolkeyRSAKeyGenResultView& view,
+                                                         const byte* pChallengeKeyData, const size_t challengeKeySize){
+    EVP_PKEY* pKey = nullptr;
+    const CoolkeyStatus keyStatus = CoolkeyRSAKeyBlob::createOpensslKey(view.getBlob(), pKey);
+    if (keyStatus.isOk() == false){
+        return keyStatus;
     }
-    try{
-        // wrap RSAkey inside EVP key object.  
-        // Using the "set1" function adds a reference count to the RSA key so freeing the EVP key will not free the RSA key (what we want).
-        int result = EVP_PKEY_set1_RSA(evpRsaKey, const_cast<RSA*>(rsaKey));
-        if (result != 1){
-            throw std::runtime_error("Unable to assign RSA public key to EVP_PKEY object.");
-        }
 
-        // create cipher context
-        EVP_MD_CTX ctx;
-        EVP_MD_CTX_init(&ctx);
-
-        try{
-            // initialize cipher context for verification with sha1
-            if (EVP_VerifyInit_ex(&ctx, EVP_sha1(), nullptr) != 1){
-                throw std::runtime_error("Unable to initialize EVP_MD_CTX for verify operation.");
-            }
-
-
-            // calculate sha1 digest of (key blob + challenge key)
-            if (EVP_VerifyUpdate(&ctx, &this->m_pKeyBlob.get()->getBlobData().at(0), this->m_pKeyBlob.get()->getBlobSize()) != 1){
-                throw std::runtime_error("Unable to compute digest of original message (part 1 of 2).");
-            }
-            if (EVP_VerifyUpdate(&ctx, &challengeKeyData.at(0), challengeKeyData.size()) != 1){
-                throw std::runtime_error("Unable to compute digest of original message (part 2 of 2).");
-            }
-
-
-            // decrypt proof data and compare digests
-            int verifyResult = EVP_VerifyFinal(&ctx, &this->m_keyProofData.at(0), this->m_keyProofData.size(), evpRsaKey);
-            // result == 1 indicates success, 0 verify failure and < 0 for some other error.
-                
-            if (verifyResult == 1){
-                // do nothing
-            }else if (verifyResult == 0){
-                throw std::runtime_error("OpenSSL computation successful; however, verification of proof/signature data failed.");
-            }else{
-                throw std::runtime_error("Unable to perform data validation; internal error decrypting encrypted digest.");
-            }
-
-
-            // clean up
-            EVP_MD_CTX_cleanup(&ctx);
-        }catch (...){
-            // clean up
-            EVP_MD_CTX_cleanup(&ctx);
-
-            throw;
-        }
+    EVP_PKEY_CTX* pVerifyContext = nullptr;
+#if defined(CKY_OPENSSL3_BACKEND)
+    const CoolkeyStatus contextStatus = CoolkeyRSAKeyBlob::createVerifyContext(pKey, pVerifyContext);
+    if (contextStatus.isOk() == false){
+        EVP_PKEY_free(pKey);
+        return contextStatus;
+    }
+#endif
+
+    const CoolkeyStatus status = verifyWithOpensslKey(pKey, pVerifyContext, view.getBlob().getBlobData(), view.getBlob().getBlobSize(),
+                                                      view.getProofData(), view.getProofSize(),
+                                                      pChallengeKeyData, challengeKeySize);
+    EVP_PKEY_CTX_free(pVerifyContext);
+    EVP_PKEY_free(pKey);
+    return status;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// verifies proof data (signature) over a key blob with the specified challenge key
+//   never throws; failures are reported through the returned status
+CoolkeyStatus CoolkeyRSAKeyGenResult::tryVerifySignature(const CoolkeyRSAKeyBlob& keyBlob,
+                                                         const byte* pProofData, const size_t proofSize,
+                                                         const byte* pChallengeKeyData, const size_t challengeKeySize){
+#if defined(CKY_OPENSSL3_BACKEND)
+    // the calling thread's own context, so one blob may be verified from several threads at once
+    EVP_PKEY_CTX* pVerifyContext = keyBlob.getOpensslVerifyContext();
+    if (pVerifyContext == nullptr){
+        return CoolkeyStatus(CoolkeyStatus::KEY_CONTEXT_FAILED);
+    }
+#else
+    EVP_PKEY_CTX* pVerifyContext = nullptr;
+#endif
+    return verifyWithOpensslKey(keyBlob.getOpensslKey(), pVerifyContext, keyBlob.getBlobData().data(), keyBlob.getBlobSize(),
+                                pProofData, proofSize, pChallengeKeyData, challengeKeySize);
+}
+
+//----------------------------------------------------------------------
+// PROTECTED STATIC
+// verifies proof data (signature) over blob data with an OpenSSL public key and the specified challenge key
+//   never throws; failures are reported through the returned status
+CoolkeyStatus CoolkeyRSAKeyGenResult::verifyWithOpensslKey(EVP_PKEY* pKey, EVP_PKEY_CTX* pVerifyContext,
+                                                           const byte* pBlobData, const size_t blobSize,
+                                                           const byte* pProofData, const size_t proofSize,
+                                                           const byte* pChallengeKeyData, const size_t challengeKeySize){
+    // create digest context
+    EVP_MD_CTX* ctx = EVP_MD_CTX_create();
+    if (ctx == nullptr){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_INIT_FAILED);
+    }
 
-        
-        // AC: Old code that doesn't work right.  It doesn't appear to have OpenSSL 
-        //     calculate the digest of the data prior to comparison:
-        
-        
-        //// create cipher context with public RSA (EVP) key
-        //EVP_PKEY_CTX* ctx = nullptr;
-        //ctx = EVP_PKEY_CTX_new(evpRsaKey, nullptr);
-        //if (ctx == nullptr){
-        //    throw std::runtime_error("Unable to create EVP_PKEY_CTX.");
-        //}
-        //
-        //try{
-        //    // try to initialize cipher context for a verify operation
-        //    if (EVP_PKEY_verify_init(ctx) != 1){
-        //        throw std::runtime_error("Unable to initialize EVP_PKEY_CTX for verify operation.");
-        //    }
-
-        //    // configure to use SHA1 digest algorithm
-        //    int digestResult = EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha1());
-        //    if (digestResult <= 0){
-        //        throw std::runtime_error("Unable to set message digest algorithm of EVP_PKEY_CTX to sha1.");
-        //    }
-
-        //    // try to set padding
-        //    int paddingResult = EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING);
-        //    if (paddingResult <= 0){
-        //        throw std::runtime_error("Unable to set RSA padding mode for EVP_PKEY_CTX.");
-        //    }
-
-        //    // build "original data" for hashing
-        //    std::vector<byte> dataToVerify(this->m_pKeyBlob.get()->getBlobData()); // copy key blob data
-        //    dataToVerify.reserve(dataToVerify.size() + challengeKeyData.size());    
-        //    std::copy(challengeKeyData.begin(), challengeKeyData.end(), std::back_inserter(dataToVerify)); // append challenge key data
-
-        //    // Performs three things:
-        //    // 1. Calculates hash of original message.
-        //    // 2. Decrypts encrypted RSA blob, which yields original hash.
-        //    // 3. Compares the two hashes.
-        //    int    result = EVP_PKEY_verify(ctx,
-        //                                    &this->m_keyProofData.at(0),
-        //                                    this->m_keyProofData.size(),
-        //                                    &dataToVerify.at(0),
-        //                                    dataToVerify.size());
-        //    // result == 1 indicates success, 0 verify failure and < 0 for some other error.
-        //    
-        //    if (result == 1){
-        //        // do nothing
-        //    }else if (result == 0){
-        //        throw std::runtime_error("OpenSSL computation successful; however, verification of proof/signature data failed.");
-        //    }else{
-        //        throw std::runtime_error("Unable to perform data validation; internal error.");
-        //    }
-
-        //    // clean up
-        //    EVP_PKEY_CTX_free(ctx);
-        //}catch (...){
-        //    // clean up
-        //    EVP_PKEY_CTX_free(ctx);
-        //    throw;
-        //}
-
-        // clean up
-        EVP_PKEY_free(evpRsaKey);
-    }catch (...){
-        // clean up
-        EVP_PKEY_free(evpRsaKey);
-        throw;
+    CoolkeyStatus status;
+#if defined(CKY_OPENSSL3_BACKEND)
+    (void)pKey;
+    // digest with the fetched SHA-1, then check the proof against the digest with the prepared verify context
+    byte digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    if (EVP_DigestInit_ex(ctx, OpenSSLAlgorithms::getSHA1(), nullptr) != 1){
+        status = CoolkeyStatus(CoolkeyStatus::VERIFY_INIT_FAILED);
+    }else if (EVP_DigestUpdate(ctx, pBlobData, blobSize) != 1){
+        // calculate sha1 digest of (key blob + challenge key)
+        status = CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_BLOB_FAILED);
+    }else if (EVP_DigestUpdate(ctx, pChallengeKeyData, challengeKeySize) != 1){
+        status = CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_CHALLENGE_FAILED);
+    }else if (EVP_DigestFinal_ex(ctx, digest, &digestLength) != 1){
+        status = CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+    }else{
+        // decrypt proof data and compare digests
+        const int verifyResult = EVP_PKEY_verify(pVerifyContext, pProofData, proofSize, digest, digestLength);
+        // result == 1 indicates success, 0 verify failure and < 0 for some other error.
+        if (verifyResult == 0){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+        }else if (verifyResult != 1){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+        }
+    }
+#else
+    (void)pVerifyContext;
+    if (EVP_VerifyInit_ex(ctx, OpenSSLAlgorithms::getSHA1(), nullptr) != 1){
+        // initialize cipher context for verification with sha1
+        status = CoolkeyStatus(CoolkeyStatus::VERIFY_INIT_FAILED);
+    }else if (EVP_VerifyUpdate(ctx, pBlobData, blobSize) != 1){
+        // calculate sha1 digest of (key blob + challenge key)
+        status = CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_BLOB_FAILED);
+    }else if (EVP_VerifyUpdate(ctx, pChallengeKeyData, challengeKeySize) != 1){
+        status = CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_CHALLENGE_FAILED);
+    }else{
+        // decrypt proof data and compare digests
+        const int verifyResult = EVP_VerifyFinal(ctx, pProofData, static_cast<unsigned int>(proofSize), pKey);
+        // result == 1 indicates success, 0 verify failure and < 0 for some other error.
+        if (verifyResult == 0){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+        }else if (verifyResult != 1){
+            status = CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+        }
     }
+#endif
+
+    // AC: Old code that doesn't work right.  It doesn't appear to have OpenSSL 
+    //     calculate the digest of the data prior to comparison:
+    
+    
+    //// create cipher context with public RSA (EVP) key
+    //EVP_PKEY_CTX* ctx = nullptr;
+    //ctx = EVP_PKEY_CTX_new(evpRsaKey, nullptr);
+    //if (ctx == nullptr){
+    //    throw std::runtime_error("Unable to create EVP_PKEY_CTX.");
+    //}
+    //
+    //try{
+    //    // try to initialize cipher context for a verify operation
+    //    if (EVP_PKEY_verify_init(ctx) != 1){
+    //        throw std::runtime_error("Unable to initialize EVP_PKEY_CTX for verify operation.");
+    //    }
+
+    //    // configure to use SHA1 digest algorithm
+    //    int digestResult = EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha1());
+    //    if (digestResult <= 0){
+    //        throw std::runtime_error("Unable to set message digest algorithm of EVP_PKEY_CTX to sha1.");
+    //    }
+
+    //    // try to set padding
+    //    int paddingResult = EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING);
+    //    if (paddingResult <= 0){
+    //        throw std::runtime_error("Unable to set RSA padding mode for EVP_PKEY_CTX.");
+    //    }
+
+    //    // build "original data" for hashing
+    //    std::vector<byte> dataToVerify(this->m_pKeyBlob.get()->getBlobData()); // copy key blob data
+    //    dataToVerify.reserve(dataToVerify.size() + challengeKeyData.size());    
+    //    std::copy(challengeKeyData.begin(), challengeKeyData.end(), std::back_inserter(dataToVerify)); // append challenge key data
+
+    //    // Performs three things:
+    //    // 1. Calculates hash of original message.
+    //    // 2. Decrypts encrypted RSA blob, which yields original hash.
+    //    // 3. Compares the two hashes.
+    //    int    result = EVP_PKEY_verify(ctx,
+    //                                    &this->m_keyProofData.at(0),
+    //                                    this->m_keyProofData.size(),
+    //                                    &dataToVerify.at(0),
+    //                                    dataToVerify.size());
+    //    // result == 1 indicates success, 0 verify failure and < 0 for some other error.
+    //    
+    //    if (result == 1){
+    //        // do nothing
+    //    }else if (result == 0){
+    //        throw std::runtime_error("OpenSSL computation successful; however, verification of proof/signature data failed.");
+    //    }else{
+    //        throw std::runtime_error("Unable to perform data validation; internal error.");
+    //    }
+
+    //    // clean up
+    //    EVP_PKEY_CTX_free(ctx);
+    //}catch (...){
+    //    // clean up
+    //    EVP_PKEY_CTX_free(ctx);
+    //    throw;
+    //}
+
+    // clean up
+    EVP_MD_CTX_destroy(ctx);
+    return status;
 }
 
 //----------------------------------------------------------------------
@@ -21,6 +21,8 @@ typedef unsigned char byte;
 typedef unsigned char BYTE;
 
 #include "CoolkeyRSAKeyBlob.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "CoolkeyStatus.h"
 
 //----------------------------------------------------------------------
 
@@ -36,12 +38,28 @@ class CoolkeyRSAKeyGenResult{
         std::unique_ptr<CoolkeyRSAKeyBlob> m_pKeyBlob;   // key blob object (RSA key)      - parsed out in constructor
         std::vector<byte> m_keyProofData;                // raw key proof data (signature) - parsed out in constructor
 
+        // copies the parsed fields of view into this object
+        //   throws std::runtime_error if unable to create the OpenSSL key
+        void initialize(const CoolkeyRSAKeyGenResultView& view);
+
+        // verifies proof data (signature) over blob data with an OpenSSL public key and the specified challenge key
+        //   pVerifyContext is the key's prepared verify context (OpenSSL 3 backend; ignored by the legacy backend)
+        //   never throws; failures are reported through the returned status
+        static CoolkeyStatus verifyWithOpensslKey(EVP_PKEY* pKey, EVP_PKEY_CTX* pVerifyContext,
+                                                  const byte* pBlobData, const size_t blobSize,
+                                                  const byte* pProofData, const size_t proofSize,
+                                                  const byte* pChallengeKeyData, const size_t challengeKeySize);
+
     public:
         // constructor does parsing work
         //   throws std::runtime_error if unable to parse
         //   does NOT verify the signature on the key - call CoolkeyRSAKeyGenResult::verifySignature() to do that
         CoolkeyRSAKeyGenResult(const std::vector<byte>& data, const bool extraDataOkay = false);
 
+        // constructor copies the fields of an already parsed key gen result view
+        //   throws std::runtime_error if unable to create the OpenSSL key
+        explicit CoolkeyRSAKeyGenResult(const CoolkeyRSAKeyGenResultView& view);
+
         // destructor
         virtual ~CoolkeyRSAKeyGenResult();
 
@@ -58,6 +76,24 @@ class CoolkeyRSAKeyGenResult{
         // verify method verifies the RSA signature on the blob with the specified challenge key
         //   throws std::runtime_error if signature has a problem
         void verifySignature(const std::vector<byte>& challengeKeyData) const;
+
+        // verifies proof data (signature) over a key blob with the specified challenge key
+        //   throws std::runtime_error if signature has a problem
+        static void verifySignature(const CoolkeyRSAKeyBlob& keyBlob,
+                                    const byte* pProofData, const size_t proofSize,
+                                    const byte* pChallengeKeyData, const size_t challengeKeySize);
+
+
+        // creates the OpenSSL key of a parsed key gen result view and verifies its proof with the specified challenge key
+        //   never throws; key creation and verification failures are reported through the returned status
+        static CoolkeyStatus tryVerifySignature(const CoolkeyRSAKeyGenResultView& view,
+                                                const byte* pChallengeKeyData, const size_t challengeKeySize);
+
+        // verifies proof data (signature) over a key blob with the specified challenge key
+        //   never throws; failures are reported through the returned status
+        static CoolkeyStatus tryVerifySignature(const CoolkeyRSAKeyBlob& keyBlob,
+                                                const byte* pProofData, const size_t proofSize,
+                                                const byte* pChallengeKeyData, const size_t challengeKeySize);
 };
 
 //----------------------------------------------------------------------
@@ -0,0 +1,82 @@
+//----------------------------------------------------------------------
+// See CoolkeyRSAKeyGenResultView.h
+//----------------------------------------------------------------------
+
+#include "CoolkeyRSAKeyGenResultView.h"
+
+//----------------------------------------------------------------------
+
+#include "ByteCursor.h"
+
+#include <cstdint>
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor - creates an empty view
+CoolkeyRSAKeyGenResultView::CoolkeyRSAKeyGenResultView() : m_pKeyProofData(nullptr), m_keyProofSize(0){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// parses the key gen result at pData
+//   throws std::runtime_error if unable to parse
+//   does NOT verify the signature on the key
+void CoolkeyRSAKeyGenResultView::parse(const byte* pData, const size_t size, const bool extraDataOkay){
+    this->tryParse(pData, size, extraDataOkay).throwIfError();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// parses the key gen result at pData without throwing
+//   returns the reason and offset of the first problem found
+//   does NOT verify the signature on the key
+CoolkeyStatus CoolkeyRSAKeyGenResultView::tryParse(const byte* pData, const size_t size, const bool extraDataOkay){
+    ByteCursor cursor(pData, size);
+
+    // check that sufficient data is present for keyblob length and proof length
+    if (cursor.getRemaining() < (2 + 2)){
+        return CoolkeyStatus(CoolkeyStatus::RESULT_TRUNCATED_HEADER, 0, size);
+    }
+
+    // parse out key blob length
+    uint16_t keyLengthShort = 0;
+    cursor.readUint16(keyLengthShort);
+    const size_t keyLength = keyLengthShort;
+
+    // sanity check key blob length
+    //   subtract 2 for proof length
+    const size_t remainingForKeyBlob = cursor.getRemaining() - 2;
+    if (remainingForKeyBlob < keyLength){
+        return CoolkeyStatus(CoolkeyStatus::RESULT_TRUNCATED_BLOB, cursor.getOffset(), keyLength, remainingForKeyBlob);
+    }
+
+    // parse key blob data in place; its offsets are reported relative to this result
+    const byte* pKeyBlobData = nullptr;
+    const size_t keyBlobOffset = cursor.getOffset();
+    cursor.readBytes(keyLength, pKeyBlobData);
+    const CoolkeyStatus blobStatus = this->m_keyBlob.tryParse(pKeyBlobData, keyLength);
+    if (blobStatus.isOk() == false){
+        return blobStatus.rebase(keyBlobOffset);
+    }
+
+    // parse out proof length (cannot fail after the key blob length check above)
+    uint16_t proofLengthShort = 0;
+    cursor.readUint16(proofLengthShort);
+    this->m_keyProofSize = proofLengthShort;
+
+    // sanity check proof length and parse out proof data
+    if (cursor.readBytes(this->m_keyProofSize, this->m_pKeyProofData) == false){
+        return CoolkeyStatus(CoolkeyStatus::RESULT_TRUNCATED_PROOF, cursor.getOffset(), this->m_keyProofSize, cursor.getRemaining());
+    }
+
+    // check if extra data was present.  If so --> if configuration parameter was that extra data isn't okay, fail.
+    if (extraDataOkay == false){
+        if (cursor.getRemaining() != 0){
+            return CoolkeyStatus(CoolkeyStatus::RESULT_EXTRA_DATA, cursor.getOffset(), cursor.getOffset(), size);
+        }
+    }
+    return CoolkeyStatus();
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,60 @@
+//----------------------------------------------------------------------
+// CoolkeyRSAKeyGenResultView - Parses Coolkey RSA Key generation result
+//                              blobs in place.  Fields are recorded as
+//                              pointers into a caller-owned buffer;
+//                              nothing is copied or allocated.
+//----------------------------------------------------------------------
+
+#ifndef CoolkeyRSAKeyGenResultViewH_Included
+#define CoolkeyRSAKeyGenResultViewH_Included
+
+//----------------------------------------------------------------------
+
+class CoolkeyRSAKeyGenResultView;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "CoolkeyRSAKeyBlobView.h"
+#include "CoolkeyStatus.h"
+
+//----------------------------------------------------------------------
+
+class CoolkeyRSAKeyGenResultView{
+    protected:
+        CoolkeyRSAKeyBlobView m_keyBlob;      // key blob view (RSA key)        - set by parse()
+        const byte* m_pKeyProofData;          // key proof data (signature)     - set by parse()
+        size_t m_keyProofSize;                // byte length of key proof data  - set by parse()
+
+    public:
+        // constructor - creates an empty view; call parse() to fill it in
+        CoolkeyRSAKeyGenResultView();
+
+        // parses the key gen result at pData
+        //   the buffer is borrowed, not copied: it must outlive every use of this view
+        //   throws std::runtime_error if unable to parse (contents of this view are then undefined)
+        //   does NOT verify the signature on the key
+        void parse(const byte* pData, const size_t size, const bool extraDataOkay = false);
+
+        // as parse(), but reports failure through the returned status instead of throwing
+        //   the status carries the reason and the offset within pData of the first problem found
+        //   does NOT verify the signature on the key
+        CoolkeyStatus tryParse(const byte* pData, const size_t size, const bool extraDataOkay = false);
+
+
+        // getter for parsed out blob view
+        const CoolkeyRSAKeyBlobView& getBlob() const { return this->m_keyBlob; }
+
+        // getters for raw proof data
+        size_t getProofSize() const { return this->m_keyProofSize; }
+        const byte* getProofData() const { return this->m_pKeyProofData; }
+};
+
+//----------------------------------------------------------------------
+
+#endif
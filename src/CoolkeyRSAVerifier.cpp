@@ -0,0 +1,263 @@
+//----------------------------------------------------------------------
+// See CoolkeyRSAVerifier.h
+//----------------------------------------------------------------------
+
+#include "CoolkeyRSAVerifier.h"
+
+//----------------------------------------------------------------------
+
+#include <cstring>
+
+#include "FixedSizeRSA.h"
+#include "Metrics.h"
+#include "OpenSSLAlgorithms.h"
+
+//----------------------------------------------------------------------
+
+namespace{
+    // DER encoding of the SHA-1 DigestInfo header (AlgorithmIdentifier with NULL parameters)
+    const byte SHA1_DIGEST_INFO_PREFIX[] = { 0x30, 0x21, 0x30, 0x09, 0x06, 0x05, 0x2B, 0x0E, 0x03, 0x02, 0x1A, 0x05, 0x00, 0x04, 0x14 };
+    const size_t SHA1_DIGEST_LENGTH = CoolkeyRSAVerifier::DIGEST_LENGTH;
+
+    // PKCS#1 v1.5 type 1 padding: 00 01 FF..FF 00 with at least 8 FF bytes
+    const size_t PKCS1_PADDING_OVERHEAD = 11;
+
+    // public key limits enforced by OpenSSL's RSA public operation
+    const int MAX_MODULUS_BITS = 16384;
+    const int SMALL_MODULUS_BITS = 3072;
+    const int MAX_PUBLIC_EXPONENT_BITS = 64;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor allocates the reusable OpenSSL state
+//   useFixedSizePath - false to send every key through OpenSSL (for comparisons)
+//   throws std::runtime_error if an OpenSSL object cannot be created
+CoolkeyRSAVerifier::CoolkeyRSAVerifier(const bool useFixedSizePath) : m_pDigest(OpenSSLAlgorithms::getSHA1()),
+                                                                      m_pDigestContext(EVP_MD_CTX_create()),
+                                                                      m_pBnContext(BN_CTX_new()),
+                                                                      m_pMontContext(BN_MONT_CTX_new()),
+                                                                      m_pModulus(BN_new()),
+                                                                      m_pExponent(BN_new()),
+                                                                      m_pSignature(BN_new()),
+                                                                      m_pMessage(BN_new()),
+                                                                      m_useFixedSizePath(useFixedSizePath){
+    if (this->m_pDigest == nullptr || this->m_pDigestContext == nullptr || this->m_pBnContext == nullptr || this->m_pMontContext == nullptr ||
+        this->m_pModulus == nullptr || this->m_pExponent == nullptr || this->m_pSignature == nullptr || this->m_pMessage == nullptr){
+        this->release();
+        throw std::runtime_error("Unable to create OpenSSL objects for RSA verifier.");
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - frees the OpenSSL state
+CoolkeyRSAVerifier::~CoolkeyRSAVerifier(){
+    this->release();
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// frees every OpenSSL object owned by this verifier
+void CoolkeyRSAVerifier::release(){
+    if (this->m_pDigestContext != nullptr){
+        EVP_MD_CTX_destroy(this->m_pDigestContext);
+        this->m_pDigestContext = nullptr;
+    }
+    if (this->m_pMontContext != nullptr){
+        BN_MONT_CTX_free(this->m_pMontContext);
+        this->m_pMontContext = nullptr;
+    }
+    if (this->m_pBnContext != nullptr){
+        BN_CTX_free(this->m_pBnContext);
+        this->m_pBnContext = nullptr;
+    }
+    BIGNUM** const numbers[] = { &this->m_pModulus, &this->m_pExponent, &this->m_pSignature, &this->m_pMessage };
+    for (size_t i = 0; i < sizeof(numbers) / sizeof(numbers[0]); ++i){
+        if (*numbers[i] != nullptr){
+            BN_free(*numbers[i]);
+            *numbers[i] = nullptr;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// verifies the proof of a parsed key gen result with the specified challenge key
+CoolkeyStatus CoolkeyRSAVerifier::verify(const CoolkeyRSAKeyGenResultView& view, const byte* pChallengeKeyData, const size_t challengeKeySize){
+    return this->verify(view.getBlob(), view.getProofData(), view.getProofSize(), pChallengeKeyData, challengeKeySize);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// verifies proof data (signature) over a parsed key blob with the specified challenge key
+//   applies the key and proof checks of OpenSSL's RSA_verify() and requires the canonical
+//   DigestInfo encoding (NULL parameters); every rejected proof is reported as
+//   VERIFY_SIGNATURE_MISMATCH, as EVP_VerifyFinal() would
+CoolkeyStatus CoolkeyRSAVerifier::verify(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize,
+                                         const byte* pChallengeKeyData, const size_t challengeKeySize){
+    // message = signature ^ exponent mod modulus
+    const CoolkeyStatus status = this->recoverEncodedMessage(blob, pProofData, proofSize);
+    if (status.isOk() == false){
+        return status;
+    }
+
+    // calculate sha1 digest of (key blob + challenge key)
+    StageTimer digestTimer(Metrics::STAGE_DIGEST);
+    byte digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    if (EVP_DigestInit_ex(this->m_pDigestContext, this->m_pDigest, nullptr) != 1){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_INIT_FAILED);
+    }
+    if (EVP_DigestUpdate(this->m_pDigestContext, blob.getBlobData(), blob.getBlobSize()) != 1){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_BLOB_FAILED);
+    }
+    if (EVP_DigestUpdate(this->m_pDigestContext, pChallengeKeyData, challengeKeySize) != 1){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_DIGEST_CHALLENGE_FAILED);
+    }
+    if (EVP_DigestFinal_ex(this->m_pDigestContext, digest, &digestLength) != 1 || digestLength != SHA1_DIGEST_LENGTH){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+    }
+    digestTimer.stop();
+
+    if (this->isEncodingOf(digest) == false){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+    }
+    return CoolkeyStatus();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// verifies proof data (signature) over a parsed key blob against a precomputed SHA-1 digest
+CoolkeyStatus CoolkeyRSAVerifier::verifyDigest(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize,
+                                               const byte (&digest)[DIGEST_LENGTH]){
+    // message = signature ^ exponent mod modulus
+    const CoolkeyStatus status = this->recoverEncodedMessage(blob, pProofData, proofSize);
+    if (status.isOk() == false){
+        return status;
+    }
+
+    if (this->isEncodingOf(digest) == false){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+    }
+    return CoolkeyStatus();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// recovers the SHA-1 digest that proof data (signature) over a parsed key blob was made for
+//   a challenge key verifies exactly when SHA-1(blob || challenge key) equals the recovered digest
+CoolkeyStatus CoolkeyRSAVerifier::recoverDigest(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize,
+                                                byte (&digest)[DIGEST_LENGTH]){
+    const CoolkeyStatus status = this->recoverEncodedMessage(blob, pProofData, proofSize);
+    if (status.isOk() == false){
+        return status;
+    }
+
+    // everything but the trailing digest must match the expected encoding
+    if (this->hasDigestInfoEncoding() == false){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+    }
+    const size_t digestOffset = this->m_encodedMessage.size() - SHA1_DIGEST_LENGTH;
+    std::memcpy(digest, this->m_encodedMessage.data() + digestOffset, SHA1_DIGEST_LENGTH);
+    return CoolkeyStatus();
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// loads the key of blob and stores proof ^ exponent mod modulus in m_encodedMessage (modulus length)
+//   keys and proofs that OpenSSL's RSA public operation refuses are reported as VERIFY_SIGNATURE_MISMATCH
+CoolkeyStatus CoolkeyRSAVerifier::recoverEncodedMessage(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize){
+    // e = 65537 with a 1024 or 2048 bit modulus passes every key check below; only the
+    //   proof length and range remain, and the range is checked by the public operation
+    if (this->m_useFixedSizePath == true &&
+        FixedSizeRSA::isSupportedKey(blob.getExponentData(), blob.getExponentLength(), blob.getModulusData(), blob.getModulusLength()) == true){
+        const size_t modulusBytes = FixedSizeRSA::getSignificantLength(blob.getModulusData(), blob.getModulusLength());
+        if (FixedSizeRSA::isPreferred(FixedSizeRSA::getBestImplementation(), modulusBytes) == true){
+            if (proofSize != modulusBytes){
+                return CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+            }
+            this->m_encodedMessage.resize(modulusBytes);
+            StageTimer publicOpTimer(Metrics::STAGE_PUBLIC_OP);
+            if (FixedSizeRSA::publicOperation(blob.getModulusData(), blob.getModulusLength(), pProofData, this->m_encodedMessage.data()) == false){
+                return CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+            }
+            return CoolkeyStatus();
+        }
+    }
+
+    // load key into the reused BIGNUMs
+    StageTimer keySetupTimer(Metrics::STAGE_KEY_SETUP);
+    if (BN_bin2bn(blob.getExponentData(), static_cast<int>(blob.getExponentLength()), this->m_pExponent) == nullptr){
+        return CoolkeyStatus(CoolkeyStatus::KEY_EXPONENT_FAILED);
+    }
+    if (BN_bin2bn(blob.getModulusData(), static_cast<int>(blob.getModulusLength()), this->m_pModulus) == nullptr){
+        return CoolkeyStatus(CoolkeyStatus::KEY_MODULUS_FAILED);
+    }
+
+    // reject keys and proofs that the RSA public operation refuses
+    const size_t modulusBytes = static_cast<size_t>(BN_num_bytes(this->m_pModulus));
+    const int modulusBits = BN_num_bits(this->m_pModulus);
+    if (proofSize != modulusBytes ||
+        modulusBytes < PKCS1_PADDING_OVERHEAD + sizeof(SHA1_DIGEST_INFO_PREFIX) + SHA1_DIGEST_LENGTH ||
+        modulusBits > MAX_MODULUS_BITS ||
+        BN_ucmp(this->m_pModulus, this->m_pExponent) <= 0 ||
+        (modulusBits > SMALL_MODULUS_BITS && BN_num_bits(this->m_pExponent) > MAX_PUBLIC_EXPONENT_BITS) ||
+        BN_is_odd(this->m_pModulus) == 0){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+    }
+    if (BN_bin2bn(pProofData, static_cast<int>(proofSize), this->m_pSignature) == nullptr){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+    }
+    if (BN_ucmp(this->m_pSignature, this->m_pModulus) >= 0){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_SIGNATURE_MISMATCH);
+    }
+
+    // message = signature ^ exponent mod modulus
+    if (BN_MONT_CTX_set(this->m_pMontContext, this->m_pModulus, this->m_pBnContext) != 1){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+    }
+    keySetupTimer.stop();
+    StageTimer publicOpTimer(Metrics::STAGE_PUBLIC_OP);
+    if (BN_mod_exp_mont(this->m_pMessage, this->m_pSignature, this->m_pExponent, this->m_pModulus, this->m_pBnContext, this->m_pMontContext) != 1){
+        return CoolkeyStatus(CoolkeyStatus::VERIFY_INTERNAL_ERROR);
+    }
+    publicOpTimer.stop();
+
+    // left-pad the message to the modulus length
+    this->m_encodedMessage.assign(modulusBytes, 0);
+    const size_t messageBytes = static_cast<size_t>(BN_num_bytes(this->m_pMessage));
+    BN_bn2bin(this->m_pMessage, this->m_encodedMessage.data() + (modulusBytes - messageBytes));
+    return CoolkeyStatus();
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// returns true if m_encodedMessage is 00 01 FF..FF 00 DigestInfo followed by a SHA-1 digest
+//   (at least 8 FF bytes, which the minimum modulus length guarantees)
+bool CoolkeyRSAVerifier::hasDigestInfoEncoding() const {
+    const byte* pMessage = this->m_encodedMessage.data();
+    const size_t modulusBytes = this->m_encodedMessage.size();
+    const size_t digestInfoLength = sizeof(SHA1_DIGEST_INFO_PREFIX) + SHA1_DIGEST_LENGTH;
+    const size_t separatorOffset = modulusBytes - digestInfoLength - 1;
+    if (pMessage[0] != 0x00 || pMessage[1] != 0x01 || pMessage[separatorOffset] != 0x00){
+        return false;
+    }
+    for (size_t i = 2; i < separatorOffset; ++i){
+        if (pMessage[i] != 0xFF){
+            return false;
+        }
+    }
+    return std::memcmp(pMessage + separatorOffset + 1, SHA1_DIGEST_INFO_PREFIX, sizeof(SHA1_DIGEST_INFO_PREFIX)) == 0;
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// returns true if m_encodedMessage is the PKCS#1 v1.5 encoding of the given SHA-1 digest
+bool CoolkeyRSAVerifier::isEncodingOf(const byte* pDigest) const {
+    const size_t digestOffset = this->m_encodedMessage.size() - SHA1_DIGEST_LENGTH;
+    return std::memcmp(this->m_encodedMessage.data() + digestOffset, pDigest, SHA1_DIGEST_LENGTH) == 0 &&
+           this->hasDigestInfoEncoding() == true;
+}
+
+//----------------------------------------------------------------------
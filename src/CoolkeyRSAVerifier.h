@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------
+// CoolkeyRSAVerifier - Verifies the proof (PKCS#1 v1.5 SHA-1 signature)
+//                      of parsed Coolkey RSA key gen results while
+//                      reusing its OpenSSL state between records.
+//
+// The digest context, BN_CTX, Montgomery context and BIGNUMs are
+// allocated once and reset for every record, and the SHA-1 digest is
+// resolved once; no EVP_PKEY or RSA object is created per record.  Keys
+// with the public exponent 65537 and a 1024 or 2048 bit modulus skip
+// OpenSSL altogether where FixedSizeRSA is faster.  The PKCS#1 v1.5 encoding is
+// checked in place.  A verifier is not thread safe - give each thread its
+// own.
+//----------------------------------------------------------------------
+
+#ifndef CoolkeyRSAVerifierH_Included
+#define CoolkeyRSAVerifierH_Included
+
+//----------------------------------------------------------------------
+
+class CoolkeyRSAVerifier;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include <openssl/bn.h>
+#include <openssl/evp.h>
+
+#include "CoolkeyRSAKeyBlobView.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "CoolkeyStatus.h"
+
+//----------------------------------------------------------------------
+
+class CoolkeyRSAVerifier{
+    public:
+        // length of the SHA-1 digest the proof is made over
+        const static size_t DIGEST_LENGTH = 20;
+
+    private:
+        // prevent copying and assignment
+        CoolkeyRSAVerifier(const CoolkeyRSAVerifier& src);
+        CoolkeyRSAVerifier operator=(const CoolkeyRSAVerifier& rhs);
+
+    protected:
+        const EVP_MD* m_pDigest;              // SHA-1, resolved once
+        EVP_MD_CTX* m_pDigestContext;         // reused for every record
+        BN_CTX* m_pBnContext;                 // scratch BIGNUMs for the modular exponentiation
+        BN_MONT_CTX* m_pMontContext;          // Montgomery form of the current modulus
+        BIGNUM* m_pModulus;                   // current key modulus
+        BIGNUM* m_pExponent;                  // current key public exponent
+        BIGNUM* m_pSignature;                 // proof data as a number
+        BIGNUM* m_pMessage;                   // signature ^ exponent mod modulus
+        std::vector<byte> m_encodedMessage;   // signature ^ exponent mod modulus as big endian bytes, modulus length
+        bool m_useFixedSizePath;              // true to use FixedSizeRSA for the keys it prefers
+
+        // frees every OpenSSL object owned by this verifier
+        void release();
+
+        // loads the key of blob and stores proof ^ exponent mod modulus in m_encodedMessage (modulus length)
+        //   keys and proofs that OpenSSL's RSA public operation refuses are reported as VERIFY_SIGNATURE_MISMATCH
+        CoolkeyStatus recoverEncodedMessage(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize);
+
+        // returns true if m_encodedMessage is the PKCS#1 v1.5 encoding of some SHA-1 digest
+        bool hasDigestInfoEncoding() const;
+
+        // returns true if m_encodedMessage is the PKCS#1 v1.5 encoding of the given SHA-1 digest
+        bool isEncodingOf(const byte* pDigest) const;
+
+    public:
+        // constructor allocates the reusable OpenSSL state
+        //   useFixedSizePath - false to send every key through OpenSSL (for comparisons)
+        //   throws std::runtime_error if an OpenSSL object cannot be created
+        explicit CoolkeyRSAVerifier(const bool useFixedSizePath = true);
+
+        // destructor - frees the OpenSSL state
+        virtual ~CoolkeyRSAVerifier();
+
+
+        // verifies the proof of a parsed key gen result with the specified challenge key
+        //   never throws; key and verification failures are reported through the returned status
+        CoolkeyStatus verify(const CoolkeyRSAKeyGenResultView& view, const byte* pChallengeKeyData, const size_t challengeKeySize);
+
+        // verifies proof data (signature) over a parsed key blob with the specified challenge key
+        //   never throws; key and verification failures are reported through the returned status
+        CoolkeyStatus verify(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize,
+                             const byte* pChallengeKeyData, const size_t challengeKeySize);
+
+        // verifies proof data (signature) over a parsed key blob against a precomputed SHA-1 digest
+        //   of (key blob + challenge key), e.g. from MultiBufferSHA1; same checks and results as verify()
+        //   never throws; key and verification failures are reported through the returned status
+        CoolkeyStatus verifyDigest(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize,
+                                   const byte (&digest)[DIGEST_LENGTH]);
+
+        // recovers the SHA-1 digest that proof data (signature) over a parsed key blob was made for
+        //   a challenge key verifies exactly when SHA-1(blob || challenge key) equals the recovered digest
+        //   never throws; a proof that no challenge key can verify is reported as VERIFY_SIGNATURE_MISMATCH
+        CoolkeyStatus recoverDigest(const CoolkeyRSAKeyBlobView& blob, const byte* pProofData, const size_t proofSize,
+                                    byte (&digest)[DIGEST_LENGTH]);
+};
+
+//----------------------------------------------------------------------
+
+#endif
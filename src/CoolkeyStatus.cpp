@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------
+// See CoolkeyStatus.h
+//----------------------------------------------------------------------
+
+#include "CoolkeyStatus.h"
+
+//----------------------------------------------------------------------
+
+#include <sstream>
+#include <iomanip>
+
+//----------------------------------------------------------------------
+// PUBLIC
+// returns the stage of processing this status belongs to
+CoolkeyStatus::Category CoolkeyStatus::getCategory() const {
+    if (this->m_code == OK){
+        return CATEGORY_NONE;
+    }else if (this->m_code < KEY_EXPONENT_FAILED){
+        return CATEGORY_PARSE;
+    }else if (this->m_code < VERIFY_INIT_FAILED){
+        return CATEGORY_KEY;
+    }else{
+        return CATEGORY_VERIFY;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// formats the human-readable description of this status
+std::string CoolkeyStatus::getMessage() const {
+    std::ostringstream errsstr;
+    switch (this->m_code){
+        case OK:
+            return "Success.";
+
+        case RESULT_TRUNCATED_HEADER:
+            return "Invalid RSA Key Gen Result - Insufficient data for key blob length and proof length.";
+        case RESULT_TRUNCATED_BLOB:
+            errsstr << "Invalid RSA Key Gen Result - Insufficient data for key blob."
+                    << "  Blob length was: " << this->m_detail1
+                    << "  Remaining data was: " << this->m_detail2;
+            break;
+        case RESULT_TRUNCATED_PROOF:
+            errsstr << "Invalid RSA Key Gen Result - Insufficient data for proof."
+                    << "  Proof length was: " << this->m_detail1
+                    << "  Remaining data was: " << this->m_detail2;
+            break;
+        case RESULT_EXTRA_DATA:
+            errsstr << "Invalid RSA Key Gen Result - Extra data was present after parsing completed."
+                    << "  Parsed result length was: " << this->m_detail1
+                    << "  Total result length was: " << this->m_detail2;
+            break;
+
+        case BLOB_TRUNCATED_HEADER:
+            return "Invalid RSA Key Blob data - Insufficient data for blob header.";
+        case BLOB_UNSUPPORTED_ENCODING:
+            errsstr << "Invalid RSA Key Blob data - Unsupported key encoding 0x"
+                    << std::setw(2) << std::setfill('0') << std::hex << this->m_detail1;
+            break;
+        case BLOB_UNSUPPORTED_KEY_TYPE:
+            errsstr << "Invalid RSA Key Blob data - Unsupported key type 0x"
+                    << std::setw(2) << std::setfill('0') << std::hex << this->m_detail1;
+            break;
+        case BLOB_TRUNCATED_MODULUS:
+            errsstr << "Invalid RSA Key Blob data - Insufficient data for key modulus."
+                    << "  Modulus length was: " << this->m_detail1
+                    << "  Remaining data was: " << this->m_detail2;
+            break;
+        case BLOB_TRUNCATED_EXPONENT:
+            errsstr << "Invalid RSA Key Blob data - Insufficient data for key exponent."
+                    << "  Exponent length was: " << this->m_detail1
+                    << "  Remaining data was: " << this->m_detail2;
+            break;
+        case BLOB_EXTRA_DATA:
+            errsstr << "Invalid RSA Key Blob data - Extra data was present after parsing completed."
+                    << "  Parsed blob length was: " << this->m_detail1
+                    << "  Total blob length was: " << this->m_detail2;
+            break;
+
+        case KEY_EXPONENT_FAILED:
+            return "Unable to finalize RSA Key Blob data parsing - Could not create openssl BIGNUM structure for exponent data.";
+        case KEY_MODULUS_FAILED:
+            return "Unable to finalize RSA Key Blob data parsing - Could not create openssl BIGNUM structure for modulus data.";
+        case KEY_RSA_FAILED:
+            return "Unable to finalize RSA Key Blob data parsing - Could not create openssl RSA key structure.";
+        case KEY_PKEY_FAILED:
+            return "Unable to create EVP_PKEY object.";
+        case KEY_CONTEXT_FAILED:
+            return "Unable to create EVP_PKEY_CTX for verify operation.";
+
+        case VERIFY_INIT_FAILED:
+            return "Unable to initialize EVP_MD_CTX for verify operation.";
+        case VERIFY_DIGEST_BLOB_FAILED:
+            return "Unable to compute digest of original message (part 1 of 2).";
+        case VERIFY_DIGEST_CHALLENGE_FAILED:
+            return "Unable to compute digest of original message (part 2 of 2).";
+        case VERIFY_SIGNATURE_MISMATCH:
+            return "OpenSSL computation successful; however, verification of proof/signature data failed.";
+        case VERIFY_INTERNAL_ERROR:
+            return "Unable to perform data validation; internal error decrypting encrypted digest.";
+
+        default:
+            errsstr << "Unknown error code " << static_cast<int>(this->m_code) << ".";
+            break;
+    }
+    return errsstr.str();
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,109 @@
+//----------------------------------------------------------------------
+// CoolkeyStatus - Compact result of a non-throwing parse, key creation
+//                 or verify operation.  Holds an error code, the byte
+//                 offset at which the problem was detected and up to two
+//                 numeric details; the human-readable message is only
+//                 formatted when getMessage() is called.
+//----------------------------------------------------------------------
+
+#ifndef CoolkeyStatusH_Included
+#define CoolkeyStatusH_Included
+
+//----------------------------------------------------------------------
+
+class CoolkeyStatus;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+//----------------------------------------------------------------------
+
+class CoolkeyStatus{
+    public:
+        // error codes (OK means success)
+        enum Code{
+            OK = 0,
+
+            // key gen result parsing
+            RESULT_TRUNCATED_HEADER,           // detail1: total length
+            RESULT_TRUNCATED_BLOB,             // detail1: blob length,     detail2: remaining data
+            RESULT_TRUNCATED_PROOF,            // detail1: proof length,    detail2: remaining data
+            RESULT_EXTRA_DATA,                 // detail1: parsed length,   detail2: total length
+
+            // key blob parsing
+            BLOB_TRUNCATED_HEADER,
+            BLOB_UNSUPPORTED_ENCODING,         // detail1: encoding byte
+            BLOB_UNSUPPORTED_KEY_TYPE,         // detail1: key type byte
+            BLOB_TRUNCATED_MODULUS,            // detail1: modulus length,  detail2: remaining data
+            BLOB_TRUNCATED_EXPONENT,           // detail1: exponent length, detail2: remaining data
+            BLOB_EXTRA_DATA,                   // detail1: parsed length,   detail2: total length
+
+            // OpenSSL key creation
+            KEY_EXPONENT_FAILED,
+            KEY_MODULUS_FAILED,
+            KEY_RSA_FAILED,
+            KEY_PKEY_FAILED,
+            KEY_CONTEXT_FAILED,
+
+            // signature verification
+            VERIFY_INIT_FAILED,
+            VERIFY_DIGEST_BLOB_FAILED,
+            VERIFY_DIGEST_CHALLENGE_FAILED,
+            VERIFY_SIGNATURE_MISMATCH,
+            VERIFY_INTERNAL_ERROR
+        };
+
+        // stage of processing an error code belongs to
+        enum Category{
+            CATEGORY_NONE = 0,                 // OK
+            CATEGORY_PARSE,                    // malformed key gen result or key blob
+            CATEGORY_KEY,                      // OpenSSL key could not be created
+            CATEGORY_VERIFY                    // signature did not verify
+        };
+
+    protected:
+        Code m_code;                           // error code
+        size_t m_offset;                       // byte offset (within the parsed buffer) where the error was detected
+        size_t m_detail1;                      // code-specific numeric detail (see Code)
+        size_t m_detail2;                      // code-specific numeric detail (see Code)
+
+    public:
+        // constructor - success
+        CoolkeyStatus() : m_code(OK), m_offset(0), m_detail1(0), m_detail2(0) {}
+
+        // constructor - error with optional details
+        explicit CoolkeyStatus(const Code code, const size_t offset = 0, const size_t detail1 = 0, const size_t detail2 = 0)
+            : m_code(code), m_offset(offset), m_detail1(detail1), m_detail2(detail2) {}
+
+
+        // getters
+        bool isOk() const { return this->m_code == OK; }
+        Code getCode() const { return this->m_code; }
+        size_t getOffset() const { return this->m_offset; }
+        size_t getDetail1() const { return this->m_detail1; }
+        size_t getDetail2() const { return this->m_detail2; }
+        Category getCategory() const;
+
+        // returns a copy with baseOffset added to the offset (for nested structures)
+        CoolkeyStatus rebase(const size_t baseOffset) const {
+            return CoolkeyStatus(this->m_code, this->m_offset + baseOffset, this->m_detail1, this->m_detail2);
+        }
+
+
+        // formats the human-readable description of this status
+        std::string getMessage() const;
+
+        // throws std::runtime_error carrying getMessage() if this status is an error
+        void throwIfError() const {
+            if (this->m_code != OK){
+                throw std::runtime_error(this->getMessage());
+            }
+        }
+};
+
+//----------------------------------------------------------------------
+
+#endif
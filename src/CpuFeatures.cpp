@@ -0,0 +1,182 @@
+//----------------------------------------------------------------------
+// See CpuFeatures.h
+//----------------------------------------------------------------------
+
+#include "CpuFeatures.h"
+
+//----------------------------------------------------------------------
+
+#include <cstdint>
+
+#if defined(CPUFEATURES_X86)
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+#if defined(CPUFEATURES_X86)
+    // executes cpuid for the given leaf/subleaf; returns false if the leaf is not supported
+    bool cpuid(const uint32_t leaf, const uint32_t subleaf, uint32_t regs[4]){
+    #if defined(_MSC_VER)
+        int maxInfo[4];
+        __cpuid(maxInfo, static_cast<int>(leaf & 0x80000000u));
+        if (static_cast<uint32_t>(maxInfo[0]) < leaf){
+            return false;
+        }
+        int info[4];
+        __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i){
+            regs[i] = static_cast<uint32_t>(info[i]);
+        }
+        return true;
+    #else
+        unsigned int a, b, c, d;
+        if (__get_cpuid_count(leaf, subleaf, &a, &b, &c, &d) == 0){
+            return false;
+        }
+        regs[0] = a;
+        regs[1] = b;
+        regs[2] = c;
+        regs[3] = d;
+        return true;
+    #endif
+    }
+
+    // returns true if the operating system saves the YMM registers on context switches
+    bool osSupportsAVX(){
+        uint32_t regs[4];
+        if (cpuid(1, 0, regs) == false){
+            return false;
+        }
+        const bool osxsave = (regs[2] & (1u << 27)) != 0;
+        const bool avx = (regs[2] & (1u << 28)) != 0;
+        if (osxsave == false || avx == false){
+            return false;
+        }
+    #if defined(_MSC_VER)
+        const uint64_t xcr0 = _xgetbv(0);
+    #else
+        uint32_t xcr0Low, xcr0High;
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+        const uint64_t xcr0 = (static_cast<uint64_t>(xcr0High) << 32) | xcr0Low;
+    #endif
+        return (xcr0 & 0x6) == 0x6;  // XMM and YMM state
+    }
+
+    // returns true if the operating system also saves the opmask and ZMM registers on context switches
+    bool osSupportsAVX512(){
+        if (osSupportsAVX() == false){
+            return false;
+        }
+    #if defined(_MSC_VER)
+        const uint64_t xcr0 = _xgetbv(0);
+    #else
+        uint32_t xcr0Low, xcr0High;
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+        const uint64_t xcr0 = (static_cast<uint64_t>(xcr0High) << 32) | xcr0Low;
+    #endif
+        return (xcr0 & 0xE6) == 0xE6;  // XMM, YMM, opmask, ZMM0-15 high halves and ZMM16-31 state
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the CPU supports SSE2
+bool CpuFeatures::hasSSE2(){
+#if defined(CPUFEATURES_X86)
+    static const bool result = [](){
+        uint32_t regs[4];
+        return cpuid(1, 0, regs) == true && (regs[3] & (1u << 26)) != 0;
+    }();
+    return result;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the CPU supports SSE4.2
+bool CpuFeatures::hasSSE42(){
+#if defined(CPUFEATURES_X86)
+    static const bool result = [](){
+        uint32_t regs[4];
+        return cpuid(1, 0, regs) == true && (regs[2] & (1u << 20)) != 0;
+    }();
+    return result;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the CPU and operating system support AVX2
+bool CpuFeatures::hasAVX2(){
+#if defined(CPUFEATURES_X86)
+    static const bool result = [](){
+        uint32_t regs[4];
+        return osSupportsAVX() == true && cpuid(7, 0, regs) == true && (regs[1] & (1u << 5)) != 0;
+    }();
+    return result;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the CPU and operating system support AVX-512 Foundation
+bool CpuFeatures::hasAVX512F(){
+#if defined(CPUFEATURES_X86)
+    static const bool result = [](){
+        uint32_t regs[4];
+        return osSupportsAVX512() == true && cpuid(7, 0, regs) == true && (regs[1] & (1u << 16)) != 0;
+    }();
+    return result;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the CPU and operating system support AVX-512 Foundation and IFMA
+bool CpuFeatures::hasAVX512IFMA(){
+#if defined(CPUFEATURES_X86)
+    static const bool result = [](){
+        uint32_t regs[4];
+        return osSupportsAVX512() == true && cpuid(7, 0, regs) == true &&
+               (regs[1] & (1u << 16)) != 0 && (regs[1] & (1u << 21)) != 0;
+    }();
+    return result;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the CPU supports the SHA extensions (with SSSE3 and SSE4.1)
+bool CpuFeatures::hasSHA(){
+#if defined(CPUFEATURES_X86)
+    static const bool result = [](){
+        uint32_t regs[4];
+        if (cpuid(1, 0, regs) == false || (regs[2] & (1u << 9)) == 0 || (regs[2] & (1u << 19)) == 0){
+            return false;
+        }
+        return cpuid(7, 0, regs) == true && (regs[1] & (1u << 29)) != 0;
+    }();
+    return result;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,49 @@
+//----------------------------------------------------------------------
+// Defines helper functions for detecting instruction set extensions
+// of the machine at run time.
+//----------------------------------------------------------------------
+
+#ifndef CpuFeaturesH_Included
+#define CpuFeaturesH_Included
+
+//----------------------------------------------------------------------
+
+class CpuFeatures;
+
+//----------------------------------------------------------------------
+
+// defined when compiling for an x86 or x86-64 target (SIMD code paths are available)
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define CPUFEATURES_X86
+#endif
+
+//----------------------------------------------------------------------
+
+class CpuFeatures{
+    public:
+        // returns true if the CPU supports SSE2
+        static bool hasSSE2();
+        // returns true if the CPU supports SSE4.2 (CRC32 instruction)
+        static bool hasSSE42();
+        // returns true if the CPU and operating system support AVX2
+        static bool hasAVX2();
+        // returns true if the CPU and operating system support AVX-512 Foundation
+        static bool hasAVX512F();
+        // returns true if the CPU and operating system support AVX-512 Foundation and
+        //   Integer Fused Multiply-Add (52-bit multiplies)
+        static bool hasAVX512IFMA();
+        // returns true if the CPU supports the SHA extensions (with SSSE3 and SSE4.1)
+        static bool hasSHA();
+
+    private:
+        // prevent copying and assignment
+        CpuFeatures(const CpuFeatures& src);
+        CpuFeatures operator=(const CpuFeatures& rhs);
+
+        // prevent construction
+        CpuFeatures();
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,92 @@
+//----------------------------------------------------------------------
+// EnrollmentArchive - Layout of the binary enrollment archive, which
+//                     stores SecureStartEnrollment() results (iobuf and
+//                     wrappedkey pairs) as raw bytes instead of
+//                     ASCII-hex text.
+//
+// All integers are big endian.
+//   header (HEADER_LENGTH bytes):
+//     magic "CKYARCH1" | u32 format version | u32 header length |
+//     u64 record count | u64 index offset | u32 CRC-32C of the index |
+//     u32 CRC-32C of the preceding header bytes
+//   records, back to back from HEADER_LENGTH:
+//     u32 iobuf length | u32 wrappedkey length | iobuf | wrappedkey
+//   index (record count entries of INDEX_ENTRY_LENGTH bytes):
+//     u64 record offset | u32 source line number | u32 CRC-32C of the record
+//
+// Written by EnrollmentArchiveWriter, read by EnrollmentArchiveReader.
+//----------------------------------------------------------------------
+
+#ifndef EnrollmentArchiveH_Included
+#define EnrollmentArchiveH_Included
+
+//----------------------------------------------------------------------
+
+class EnrollmentArchive;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class EnrollmentArchive{
+    public:
+        // file identification
+        const static size_t MAGIC_LENGTH = 8;
+        const static uint32_t FORMAT_VERSION = 1;
+
+        // header field offsets and length
+        const static size_t VERSION_OFFSET = 8;
+        const static size_t HEADER_LENGTH_OFFSET = 12;
+        const static size_t RECORD_COUNT_OFFSET = 16;
+        const static size_t INDEX_OFFSET_OFFSET = 24;
+        const static size_t INDEX_CRC_OFFSET = 32;
+        const static size_t HEADER_CRC_OFFSET = 36;
+        const static size_t HEADER_LENGTH = 40;
+
+        // record and index entry layout
+        const static size_t RECORD_HEADER_LENGTH = 4 + 4;
+        const static size_t INDEX_ENTRY_LENGTH = 8 + 4 + 4;
+
+        // returns the magic bytes at the start of every archive
+        static const byte* getMagic(){
+            static const byte MAGIC[MAGIC_LENGTH] = { 'C', 'K', 'Y', 'A', 'R', 'C', 'H', '1' };
+            return MAGIC;
+        }
+
+        // big endian integer access
+        static uint32_t readUint32(const byte* pData){
+            return (static_cast<uint32_t>(pData[0]) << 24) | (static_cast<uint32_t>(pData[1]) << 16) |
+                   (static_cast<uint32_t>(pData[2]) << 8) | static_cast<uint32_t>(pData[3]);
+        }
+        static uint64_t readUint64(const byte* pData){
+            return (static_cast<uint64_t>(readUint32(pData)) << 32) | readUint32(pData + 4);
+        }
+        static void writeUint32(byte* pData, const uint32_t value){
+            pData[0] = static_cast<byte>(value >> 24);
+            pData[1] = static_cast<byte>(value >> 16);
+            pData[2] = static_cast<byte>(value >> 8);
+            pData[3] = static_cast<byte>(value);
+        }
+        static void writeUint64(byte* pData, const uint64_t value){
+            writeUint32(pData, static_cast<uint32_t>(value >> 32));
+            writeUint32(pData + 4, static_cast<uint32_t>(value));
+        }
+
+    private:
+        // prevent copying and assignment
+        EnrollmentArchive(const EnrollmentArchive& src);
+        EnrollmentArchive operator=(const EnrollmentArchive& rhs);
+
+        // prevent construction
+        EnrollmentArchive();
+};
+
+//----------------------------------------------------------------------
+
+#endif
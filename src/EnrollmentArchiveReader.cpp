@@ -0,0 +1,104 @@
+//----------------------------------------------------------------------
+// See EnrollmentArchiveReader.h
+//----------------------------------------------------------------------
+
+#include "EnrollmentArchiveReader.h"
+
+//----------------------------------------------------------------------
+
+#include <cstring>
+
+#include "CRC32C.h"
+#include "EnrollmentArchive.h"
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor maps the archive and checks its header and index
+//   throws std::runtime_error if the file cannot be mapped or is not a valid archive
+EnrollmentArchiveReader::EnrollmentArchiveReader(const std::string& filepath) : m_file(filepath),
+                                                                                m_recordCount(0),
+                                                                                m_pIndex(nullptr){
+    const byte* pData = this->m_file.getData();
+    const uint64_t fileSize = this->m_file.getSize();
+
+    // header
+    if (fileSize < EnrollmentArchive::HEADER_LENGTH ||
+        std::memcmp(pData, EnrollmentArchive::getMagic(), EnrollmentArchive::MAGIC_LENGTH) != 0){
+        throw std::runtime_error("Not an enrollment archive: '" + filepath + "'.");
+    }
+    if (EnrollmentArchive::readUint32(pData + EnrollmentArchive::HEADER_CRC_OFFSET) != CRC32C::compute(pData, EnrollmentArchive::HEADER_CRC_OFFSET)){
+        throw std::runtime_error("Enrollment archive header is damaged (checksum mismatch).");
+    }
+    if (EnrollmentArchive::readUint32(pData + EnrollmentArchive::VERSION_OFFSET) != EnrollmentArchive::FORMAT_VERSION ||
+        EnrollmentArchive::readUint32(pData + EnrollmentArchive::HEADER_LENGTH_OFFSET) != EnrollmentArchive::HEADER_LENGTH){
+        throw std::runtime_error("Unsupported enrollment archive version.");
+    }
+
+    // index: must lie within the file after the header
+    const uint64_t recordCount = EnrollmentArchive::readUint64(pData + EnrollmentArchive::RECORD_COUNT_OFFSET);
+    const uint64_t indexOffset = EnrollmentArchive::readUint64(pData + EnrollmentArchive::INDEX_OFFSET_OFFSET);
+    if (indexOffset < EnrollmentArchive::HEADER_LENGTH || indexOffset > fileSize ||
+        recordCount > (fileSize - indexOffset) / EnrollmentArchive::INDEX_ENTRY_LENGTH){
+        throw std::runtime_error("Enrollment archive index lies outside the file.");
+    }
+    const size_t indexLength = static_cast<size_t>(recordCount * EnrollmentArchive::INDEX_ENTRY_LENGTH);
+    if (EnrollmentArchive::readUint32(pData + EnrollmentArchive::INDEX_CRC_OFFSET) != CRC32C::compute(pData + indexOffset, indexLength)){
+        throw std::runtime_error("Enrollment archive index is damaged (checksum mismatch).");
+    }
+
+    this->m_recordCount = static_cast<size_t>(recordCount);
+    this->m_pIndex = pData + indexOffset;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - the mapping is released by m_file
+EnrollmentArchiveReader::~EnrollmentArchiveReader(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// returns the manifest line number of a record without checking the record itself
+size_t EnrollmentArchiveReader::getLineNumber(const size_t index) const {
+    return EnrollmentArchive::readUint32(this->m_pIndex + index * EnrollmentArchive::INDEX_ENTRY_LENGTH + 8);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// fetches record index (0-based) and checks it against its checksum
+//   returns false and points pError at a description if the record is damaged; never throws
+bool EnrollmentArchiveReader::tryGetRecord(const size_t index, Record& record, const char*& pError) const {
+    const byte* pEntry = this->m_pIndex + index * EnrollmentArchive::INDEX_ENTRY_LENGTH;
+    const uint64_t offset = EnrollmentArchive::readUint64(pEntry);
+    record.m_lineNumber = EnrollmentArchive::readUint32(pEntry + 8);
+    const uint32_t expectedCrc = EnrollmentArchive::readUint32(pEntry + 12);
+
+    // records lie between the header and the index
+    const uint64_t recordsEnd = static_cast<uint64_t>(this->m_pIndex - this->m_file.getData());
+    if (offset < EnrollmentArchive::HEADER_LENGTH || offset > recordsEnd ||
+        recordsEnd - offset < EnrollmentArchive::RECORD_HEADER_LENGTH){
+        pError = "Archive record lies outside the record area.";
+        return false;
+    }
+    const byte* pRecord = this->m_file.getData() + offset;
+    const uint64_t iobufSize = EnrollmentArchive::readUint32(pRecord);
+    const uint64_t wrappedKeySize = EnrollmentArchive::readUint32(pRecord + 4);
+    if (recordsEnd - offset - EnrollmentArchive::RECORD_HEADER_LENGTH < iobufSize + wrappedKeySize){
+        pError = "Archive record extends past the record area.";
+        return false;
+    }
+    const size_t recordLength = static_cast<size_t>(EnrollmentArchive::RECORD_HEADER_LENGTH + iobufSize + wrappedKeySize);
+    if (CRC32C::compute(pRecord, recordLength) != expectedCrc){
+        pError = "Archive record is damaged (checksum mismatch).";
+        return false;
+    }
+
+    record.m_pIobufData = pRecord + EnrollmentArchive::RECORD_HEADER_LENGTH;
+    record.m_iobufSize = static_cast<size_t>(iobufSize);
+    record.m_pWrappedKeyData = record.m_pIobufData + record.m_iobufSize;
+    record.m_wrappedKeySize = static_cast<size_t>(wrappedKeySize);
+    return true;
+}
+
+//----------------------------------------------------------------------
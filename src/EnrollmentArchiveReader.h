@@ -0,0 +1,77 @@
+//----------------------------------------------------------------------
+// EnrollmentArchiveReader - Reads a binary enrollment archive (see
+//                           EnrollmentArchive.h) through a memory
+//                           mapping.
+//
+// The header and index are checked when the archive is opened.  Each
+// record is checked against its index checksum when it is fetched and is
+// then returned as pointers into the mapping - nothing is copied or
+// decoded.  Fetching records is thread safe.
+//----------------------------------------------------------------------
+
+#ifndef EnrollmentArchiveReaderH_Included
+#define EnrollmentArchiveReaderH_Included
+
+//----------------------------------------------------------------------
+
+class EnrollmentArchiveReader;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "MappedFile.h"
+
+//----------------------------------------------------------------------
+
+class EnrollmentArchiveReader{
+    public:
+        // one archived record; the data points into the archive mapping
+        class Record{
+            public:
+                size_t m_lineNumber;             // manifest line the record was converted from
+                const byte* m_pIobufData;        // iobuf bytes
+                size_t m_iobufSize;              // byte length of iobuf
+                const byte* m_pWrappedKeyData;   // wrappedkey bytes
+                size_t m_wrappedKeySize;         // byte length of wrappedkey
+        };
+
+    private:
+        // prevent copying and assignment
+        EnrollmentArchiveReader(const EnrollmentArchiveReader& src);
+        EnrollmentArchiveReader operator=(const EnrollmentArchiveReader& rhs);
+
+    protected:
+        MappedFile m_file;                    // the whole archive
+        size_t m_recordCount;                 // number of records               - read in constructor
+        const byte* m_pIndex;                 // first index entry (in m_file)   - read in constructor
+
+    public:
+        // constructor maps the archive and checks its header and index
+        //   throws std::runtime_error if the file cannot be mapped or is not a valid archive
+        explicit EnrollmentArchiveReader(const std::string& filepath);
+
+        // destructor - unmaps the archive
+        virtual ~EnrollmentArchiveReader();
+
+
+        // getter for the number of records
+        size_t getRecordCount() const { return this->m_recordCount; }
+
+        // returns the manifest line number of a record without checking the record itself
+        size_t getLineNumber(const size_t index) const;
+
+        // fetches record index (0-based) and checks it against its checksum
+        //   returns false and points pError at a description if the record is damaged; never throws
+        bool tryGetRecord(const size_t index, Record& record, const char*& pError) const;
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,146 @@
+//----------------------------------------------------------------------
+// See EnrollmentArchiveWriter.h
+//----------------------------------------------------------------------
+
+#include "EnrollmentArchiveWriter.h"
+
+//----------------------------------------------------------------------
+
+#include <cstring>
+#include <limits>
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+#include "CRC32C.h"
+#include "EnrollmentArchive.h"
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor creates (or truncates) the archive and reserves room for the header
+//   throws std::runtime_error if the file cannot be created
+EnrollmentArchiveWriter::EnrollmentArchiveWriter(const std::string& filepath) : m_file(filepath, std::ios::out | std::ios::binary | std::ios::trunc),
+                                                                                m_recordCount(0),
+                                                                                m_offset(0),
+                                                                                m_finished(false){
+    if (this->m_file.good() == false){
+        throw std::runtime_error("Unable to create archive file '" + filepath + "'.");
+    }
+
+    // the header is rewritten by finish(); until then the file does not start with the magic bytes
+    const byte placeholder[EnrollmentArchive::HEADER_LENGTH] = { 0 };
+    this->write(placeholder, sizeof(placeholder));
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - closes the file
+EnrollmentArchiveWriter::~EnrollmentArchiveWriter(){
+
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// writes bytes to the archive, advancing m_offset
+//   throws std::runtime_error on write failure
+void EnrollmentArchiveWriter::write(const byte* pData, const size_t length){
+    this->m_file.write(reinterpret_cast<const char*>(pData), static_cast<std::streamsize>(length));
+    if (this->m_file.good() == false){
+        throw std::runtime_error("Unable to write archive file.");
+    }
+    this->m_offset += length;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// appends one record
+//   throws std::runtime_error on write failure or if a field exceeds 4 GiB
+void EnrollmentArchiveWriter::addRecord(const size_t lineNumber, const byte* pIobufData, const size_t iobufSize,
+                                        const byte* pWrappedKeyData, const size_t wrappedKeySize){
+    if (this->m_finished == true){
+        throw std::runtime_error("Archive is already finished.");
+    }
+    const uint64_t maxField = std::numeric_limits<uint32_t>::max();
+    if (iobufSize > maxField || wrappedKeySize > maxField || lineNumber > maxField){
+        throw std::runtime_error("Record is too large for the archive format.");
+    }
+
+    byte recordHeader[EnrollmentArchive::RECORD_HEADER_LENGTH];
+    EnrollmentArchive::writeUint32(recordHeader, static_cast<uint32_t>(iobufSize));
+    EnrollmentArchive::writeUint32(recordHeader + 4, static_cast<uint32_t>(wrappedKeySize));
+    uint32_t crc = CRC32C::compute(recordHeader, sizeof(recordHeader));
+    crc = CRC32C::compute(pIobufData, iobufSize, crc);
+    crc = CRC32C::compute(pWrappedKeyData, wrappedKeySize, crc);
+
+    byte indexEntry[EnrollmentArchive::INDEX_ENTRY_LENGTH];
+    EnrollmentArchive::writeUint64(indexEntry, this->m_offset);
+    EnrollmentArchive::writeUint32(indexEntry + 8, static_cast<uint32_t>(lineNumber));
+    EnrollmentArchive::writeUint32(indexEntry + 12, crc);
+
+    this->write(recordHeader, sizeof(recordHeader));
+    this->write(pIobufData, iobufSize);
+    this->write(pWrappedKeyData, wrappedKeySize);
+    this->m_index.insert(this->m_index.end(), indexEntry, indexEntry + sizeof(indexEntry));
+    ++this->m_recordCount;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// writes the index and the header; no records can be added afterwards
+//   throws std::runtime_error on write failure
+void EnrollmentArchiveWriter::finish(){
+    if (this->m_finished == true){
+        return;
+    }
+    const uint64_t indexOffset = this->m_offset;
+    this->write(this->m_index.data(), this->m_index.size());
+
+    byte header[EnrollmentArchive::HEADER_LENGTH];
+    std::memcpy(header, EnrollmentArchive::getMagic(), EnrollmentArchive::MAGIC_LENGTH);
+    EnrollmentArchive::writeUint32(header + EnrollmentArchive::VERSION_OFFSET, EnrollmentArchive::FORMAT_VERSION);
+    EnrollmentArchive::writeUint32(header + EnrollmentArchive::HEADER_LENGTH_OFFSET, static_cast<uint32_t>(EnrollmentArchive::HEADER_LENGTH));
+    EnrollmentArchive::writeUint64(header + EnrollmentArchive::RECORD_COUNT_OFFSET, this->m_recordCount);
+    EnrollmentArchive::writeUint64(header + EnrollmentArchive::INDEX_OFFSET_OFFSET, indexOffset);
+    EnrollmentArchive::writeUint32(header + EnrollmentArchive::INDEX_CRC_OFFSET, CRC32C::compute(this->m_index.data(), this->m_index.size()));
+    EnrollmentArchive::writeUint32(header + EnrollmentArchive::HEADER_CRC_OFFSET, CRC32C::compute(header, EnrollmentArchive::HEADER_CRC_OFFSET));
+
+    this->m_file.seekp(0);
+    this->m_file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    this->m_file.flush();
+    if (this->m_file.good() == false){
+        throw std::runtime_error("Unable to write archive file.");
+    }
+    this->m_finished = true;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// converts a batch manifest into an archive
+//   records whose fields cannot be loaded are skipped and reported to out as batch result lines
+//   returns the highest outcome code reported (0 if every record was converted)
+int EnrollmentArchiveWriter::convertManifest(const BatchVerifier& manifest, const std::string& archive_filepath, std::ostream& out){
+    EnrollmentArchiveWriter writer(archive_filepath);
+
+    int worstOutcome = RETCODE_SUCCESS;
+    const std::vector<BatchVerifier::Record>& records = manifest.getRecords();
+    for (size_t i = 0; i < records.size(); ++i){
+        const BatchVerifier::Record& record = records[i];
+        std::vector<byte> iobuf_data;
+        std::vector<byte> wrappedkey_data;
+        try{
+            if (record.m_fieldCount != 2){
+                throw std::runtime_error("Malformed manifest line; expected <iobuf> <wrappedkey>.");
+            }
+            iobuf_data = BatchVerifier::loadField(record.m_fields[0]);
+            wrappedkey_data = BatchVerifier::loadField(record.m_fields[1]);
+        }catch (std::runtime_error& ex){
+            out << record.m_lineNumber << '\t' << RETCODE_INPUT_ERROR << '\t' << ((ex.what() == nullptr) ? "<null>" : ex.what()) << '\n';
+            worstOutcome = RETCODE_INPUT_ERROR;
+            continue;
+        }
+        writer.addRecord(record.m_lineNumber, iobuf_data.data(), iobuf_data.size(), wrappedkey_data.data(), wrappedkey_data.size());
+    }
+    writer.finish();
+    out.flush();
+    return worstOutcome;
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,83 @@
+//----------------------------------------------------------------------
+// EnrollmentArchiveWriter - Writes iobuf and wrappedkey pairs to a
+//                           binary enrollment archive (see
+//                           EnrollmentArchive.h).
+//
+// Records are streamed to the file as they are added; the index is kept
+// in memory and written, with the final header, by finish().
+//----------------------------------------------------------------------
+
+#ifndef EnrollmentArchiveWriterH_Included
+#define EnrollmentArchiveWriterH_Included
+
+//----------------------------------------------------------------------
+
+class EnrollmentArchiveWriter;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "BatchVerifier.h"
+
+//----------------------------------------------------------------------
+
+class EnrollmentArchiveWriter{
+    private:
+        // prevent copying and assignment
+        EnrollmentArchiveWriter(const EnrollmentArchiveWriter& src);
+        EnrollmentArchiveWriter operator=(const EnrollmentArchiveWriter& rhs);
+
+    protected:
+        std::ofstream m_file;                 // archive being written
+        std::vector<byte> m_index;            // index entries of the records written so far
+        uint64_t m_recordCount;               // number of records written so far
+        uint64_t m_offset;                    // file offset of the next record
+        bool m_finished;                      // true once finish() has completed
+
+        // writes bytes to the archive, advancing m_offset
+        //   throws std::runtime_error on write failure
+        void write(const byte* pData, const size_t length);
+
+    public:
+        // constructor creates (or truncates) the archive and reserves room for the header
+        //   throws std::runtime_error if the file cannot be created
+        explicit EnrollmentArchiveWriter(const std::string& filepath);
+
+        // destructor - closes the file; an archive that was not finished has no valid header
+        virtual ~EnrollmentArchiveWriter();
+
+
+        // appends one record
+        //   lineNumber is the manifest line the record came from (reported by the batch reader)
+        //   throws std::runtime_error on write failure or if a field exceeds 4 GiB
+        void addRecord(const size_t lineNumber, const byte* pIobufData, const size_t iobufSize,
+                       const byte* pWrappedKeyData, const size_t wrappedKeySize);
+
+        // writes the index and the header; no records can be added afterwards
+        //   throws std::runtime_error on write failure
+        void finish();
+
+        // getter for the number of records written so far
+        uint64_t getRecordCount() const { return this->m_recordCount; }
+
+
+        // converts the records of a batch manifest (ASCII-hex or '@' file fields) into an archive at archive_filepath
+        //   records whose fields cannot be loaded are skipped and reported to out as batch result lines
+        //   returns the highest outcome code reported (0 if every record was converted)
+        //   throws std::runtime_error if the archive cannot be written
+        static int convertManifest(const BatchVerifier& manifest, const std::string& archive_filepath, std::ostream& out);
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,651 @@
+//----------------------------------------------------------------------
+// See FixedSizeRSA.h
+//----------------------------------------------------------------------
+
+#include "FixedSizeRSA.h"
+
+//----------------------------------------------------------------------
+
+#include <cstdint>
+
+#include "CpuFeatures.h"
+
+// the AVX-512 IFMA implementation needs 64-bit x86, 64-bit limbs and GCC/Clang target attributes
+#if defined(CPUFEATURES_X86) && defined(__x86_64__) && defined(__SIZEOF_INT128__) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define FIXEDSIZERSA_IFMA
+    #define FIXEDSIZERSA_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+// fully unrolls the following loop over vectors (keeps the accumulators in registers)
+#if defined(__clang__)
+    #define FIXEDSIZERSA_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+    #define FIXEDSIZERSA_UNROLL _Pragma("GCC unroll 8")
+#else
+    #define FIXEDSIZERSA_UNROLL
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    // limbs are as wide as the compiler can multiply into a double-width product
+#if defined(__SIZEOF_INT128__)
+    typedef uint64_t Limb;
+    typedef unsigned __int128 DoubleLimb;
+#else
+    typedef uint32_t Limb;
+    typedef uint64_t DoubleLimb;
+#endif
+    const size_t LIMB_BITS = sizeof(Limb) * 8;
+
+    // three-limb column sum of double-limb products
+    class Accumulator{
+        public:
+            DoubleLimb m_low;           // low two limbs
+            Limb m_high;                // carries out of m_low
+
+            Accumulator() : m_low(0), m_high(0){
+
+            }
+
+            // adds x * y
+            inline void add(const Limb x, const Limb y){
+                const DoubleLimb product = static_cast<DoubleLimb>(x) * y;
+                this->m_low += product;
+                this->m_high = static_cast<Limb>(this->m_high + (this->m_low < product));
+            }
+
+            // adds another accumulator
+            inline void add(const Accumulator& other){
+                this->m_low += other.m_low;
+                this->m_high = static_cast<Limb>(this->m_high + other.m_high + (this->m_low < other.m_low));
+            }
+
+            // doubles the sum
+            inline void doubleValue(){
+                this->m_high = static_cast<Limb>((this->m_high << 1) | static_cast<Limb>(this->m_low >> (2 * LIMB_BITS - 1)));
+                this->m_low <<= 1;
+            }
+
+            // returns the lowest limb
+            inline Limb getLow() const { return static_cast<Limb>(this->m_low); }
+
+            // drops the lowest limb
+            inline void shift(){
+                this->m_low = (this->m_low >> LIMB_BITS) | (static_cast<DoubleLimb>(this->m_high) << LIMB_BITS);
+                this->m_high = 0;
+            }
+    };
+
+    // an odd modulus of exactly BITS bits (top bit set) and the non-Montgomery arithmetic
+    //   shared by both implementations; numbers are stored least significant limb first
+    template<size_t BITS>
+    class FixedModulus{
+        public:
+            static const size_t LIMBS = BITS / LIMB_BITS;
+
+            Limb m_modulus[LIMBS];
+
+            // loads a big endian modulus of BITS / 8 bytes
+            explicit FixedModulus(const byte* pModulusData){
+                static_assert(BITS % 64 == 0, "key size must be a multiple of 64 bits");
+                load(pModulusData, this->m_modulus);
+            }
+
+            // loads a big endian number of BITS / 8 bytes
+            static void load(const byte* pData, Limb (&value)[LIMBS]){
+                for (size_t i = 0; i < LIMBS; ++i){
+                    const byte* pLimbData = pData + (LIMBS - 1 - i) * sizeof(Limb);
+                    Limb limb = 0;
+                    for (size_t j = 0; j < sizeof(Limb); ++j){
+                        limb = static_cast<Limb>((limb << 8) | pLimbData[j]);
+                    }
+                    value[i] = limb;
+                }
+            }
+
+            // stores a number as BITS / 8 big endian bytes
+            static void store(const Limb (&value)[LIMBS], byte* pData){
+                for (size_t i = 0; i < LIMBS; ++i){
+                    byte* pLimbData = pData + (LIMBS - 1 - i) * sizeof(Limb);
+                    Limb limb = value[i];
+                    for (size_t j = sizeof(Limb); j > 0; --j){
+                        pLimbData[j - 1] = static_cast<byte>(limb);
+                        limb = static_cast<Limb>(limb >> 8);
+                    }
+                }
+            }
+
+            // returns -modulus^-1 mod 2^LIMB_BITS by Newton iteration (an odd number is its own inverse modulo 8)
+            Limb getNegatedInverse() const {
+                Limb inverse = this->m_modulus[0];
+                for (size_t correctBits = 3; correctBits < LIMB_BITS; correctBits *= 2){
+                    inverse *= static_cast<Limb>(2 - this->m_modulus[0] * inverse);
+                }
+                return static_cast<Limb>(~inverse + 1);
+            }
+
+            // returns true if value < modulus
+            bool isReduced(const Limb (&value)[LIMBS]) const {
+                for (size_t i = LIMBS; i > 0; --i){
+                    if (value[i - 1] != this->m_modulus[i - 1]){
+                        return value[i - 1] < this->m_modulus[i - 1];
+                    }
+                }
+                return false;
+            }
+
+            // value = value - modulus if (topLimb:value) >= modulus; requires (topLimb:value) < 2 * modulus
+            void reduceOnce(Limb (&value)[LIMBS], const Limb topLimb) const {
+                Limb difference[LIMBS];
+                Limb borrow = 0;
+                for (size_t i = 0; i < LIMBS; ++i){
+                    const Limb subtrahend = this->m_modulus[i];
+                    const Limb partial = static_cast<Limb>(value[i] - subtrahend);
+                    difference[i] = static_cast<Limb>(partial - borrow);
+                    borrow = static_cast<Limb>((value[i] < subtrahend) | (partial < borrow));
+                }
+                if (topLimb != 0 || borrow == 0){
+                    for (size_t i = 0; i < LIMBS; ++i){
+                        value[i] = difference[i];
+                    }
+                }
+            }
+
+            // value = 2^exponent mod modulus (exponent >= BITS)
+            //   starts from 2^BITS mod modulus = 2^BITS - modulus and appends one zero limb at a
+            //   time with a schoolbook division step, which costs far less than the Montgomery
+            //   multiplications it replaces
+            void powerOfTwo(const size_t exponent, Limb (&value)[LIMBS]) const {
+                Limb carry = 1;
+                for (size_t i = 0; i < LIMBS; ++i){
+                    const DoubleLimb sum = static_cast<DoubleLimb>(static_cast<Limb>(~this->m_modulus[i])) + carry;
+                    value[i] = static_cast<Limb>(sum);
+                    carry = static_cast<Limb>(sum >> LIMB_BITS);
+                }
+
+                size_t remainingBits = exponent - BITS;
+                for (; remainingBits >= LIMB_BITS; remainingBits -= LIMB_BITS){
+                    this->shiftLimb(value);
+                }
+                for (; remainingBits > 0; --remainingBits){
+                    Limb topBit = 0;
+                    for (size_t i = 0; i < LIMBS; ++i){
+                        const Limb nextTopBit = static_cast<Limb>(value[i] >> (LIMB_BITS - 1));
+                        value[i] = static_cast<Limb>((value[i] << 1) | topBit);
+                        topBit = nextTopBit;
+                    }
+                    this->reduceOnce(value, topBit);
+                }
+            }
+
+            // value = value * 2^LIMB_BITS mod modulus (value < modulus)
+            //   the quotient limb is estimated from the top limbs (the modulus is normalized) and is
+            //   at most two too large (Knuth, algorithm D); the modulus is added back while negative
+            void shiftLimb(Limb (&value)[LIMBS]) const {
+                const Limb top = value[LIMBS - 1];
+                for (size_t i = LIMBS - 1; i > 0; --i){
+                    value[i] = value[i - 1];
+                }
+                value[0] = 0;
+
+                const DoubleLimb numerator = (static_cast<DoubleLimb>(top) << LIMB_BITS) | value[LIMBS - 1];
+                const DoubleLimb estimate = numerator / this->m_modulus[LIMBS - 1];
+                const Limb quotient = (estimate >> LIMB_BITS) != 0 ? static_cast<Limb>(~static_cast<Limb>(0)) : static_cast<Limb>(estimate);
+
+                // (top:value) -= quotient * modulus
+                Limb productCarry = 0;
+                Limb borrow = 0;
+                for (size_t i = 0; i < LIMBS; ++i){
+                    const DoubleLimb product = static_cast<DoubleLimb>(quotient) * this->m_modulus[i] + productCarry;
+                    productCarry = static_cast<Limb>(product >> LIMB_BITS);
+                    const Limb subtrahend = static_cast<Limb>(product);
+                    const Limb partial = static_cast<Limb>(value[i] - subtrahend);
+                    const Limb nextBorrow = static_cast<Limb>((value[i] < subtrahend) | (partial < borrow));
+                    value[i] = static_cast<Limb>(partial - borrow);
+                    borrow = nextBorrow;
+                }
+                Limb remainderTop = static_cast<Limb>(top - productCarry - borrow);
+
+                // a negative remainder has an all-ones top limb; add the modulus back until it is zero
+                while (remainderTop != 0){
+                    Limb addCarry = 0;
+                    for (size_t i = 0; i < LIMBS; ++i){
+                        const DoubleLimb sum = static_cast<DoubleLimb>(value[i]) + this->m_modulus[i] + addCarry;
+                        value[i] = static_cast<Limb>(sum);
+                        addCarry = static_cast<Limb>(sum >> LIMB_BITS);
+                    }
+                    remainderTop = static_cast<Limb>(remainderTop + addCarry);
+                }
+            }
+    };
+
+    // portable Montgomery arithmetic modulo a FixedModulus (R = 2^BITS)
+    template<size_t BITS>
+    class ScalarMontgomery{
+        public:
+            typedef FixedModulus<BITS> Modulus;
+            static const size_t LIMBS = Modulus::LIMBS;
+
+            const Modulus& m_modulus;
+            Limb m_inverse;             // -modulus^-1 mod 2^LIMB_BITS
+            Limb m_rr[LIMBS];           // R^2 mod modulus
+
+            explicit ScalarMontgomery(const Modulus& modulus) : m_modulus(modulus), m_inverse(modulus.getNegatedInverse()){
+                modulus.powerOfTwo(2 * BITS, this->m_rr);
+            }
+
+            // result = a * b / R mod modulus (a, b < modulus; result may alias a or b)
+            void multiply(Limb (&result)[LIMBS], const Limb (&a)[LIMBS], const Limb (&b)[LIMBS]) const {
+                this->montgomeryProduct<false>(result, a, b);
+            }
+
+            // result = a * a / R mod modulus (a < modulus; result may alias a)
+            void square(Limb (&result)[LIMBS], const Limb (&a)[LIMBS]) const {
+                this->montgomeryProduct<true>(result, a, a);
+            }
+
+            // result = a * b / R mod modulus with finely integrated product scanning: the columns of
+            //   a * b and of the reduction multiples m * modulus are summed in separate three-limb
+            //   accumulators, so the multiplications do not wait for each other's carries
+            //   when SQUARING, b must be a and every cross product a[j] * a[k] is computed once and doubled
+            template<bool SQUARING>
+            void montgomeryProduct(Limb (&result)[LIMBS], const Limb (&a)[LIMBS], const Limb (&b)[LIMBS]) const {
+                const Limb (&modulus)[LIMBS] = this->m_modulus.m_modulus;
+                Limb m[LIMBS];
+                Limb t[LIMBS];
+                Accumulator accumulator;
+
+                // low columns: choose m[i] so that column i becomes zero
+                for (size_t i = 0; i < LIMBS; ++i){
+                    accumulator.add(productColumn<SQUARING>(a, b, 0, i));
+                    for (size_t j = 0; j < i; ++j){
+                        accumulator.add(m[j], modulus[i - j]);
+                    }
+                    m[i] = static_cast<Limb>(accumulator.getLow() * this->m_inverse);
+                    accumulator.add(m[i], modulus[0]);
+                    accumulator.shift();
+                }
+
+                // high columns: the result, (a * b + m * modulus) / R
+                for (size_t i = LIMBS; i < 2 * LIMBS - 1; ++i){
+                    accumulator.add(productColumn<SQUARING>(a, b, i - LIMBS + 1, i));
+                    for (size_t j = i - LIMBS + 1; j < LIMBS; ++j){
+                        accumulator.add(m[j], modulus[i - j]);
+                    }
+                    t[i - LIMBS] = accumulator.getLow();
+                    accumulator.shift();
+                }
+                t[LIMBS - 1] = accumulator.getLow();
+                accumulator.shift();
+
+                for (size_t i = 0; i < LIMBS; ++i){
+                    result[i] = t[i];
+                }
+                this->m_modulus.reduceOnce(result, accumulator.getLow());
+            }
+
+            // returns the sum of a[j] * b[column - j] for j = first .. min(column, LIMBS - 1)
+            template<bool SQUARING>
+            static Accumulator productColumn(const Limb (&a)[LIMBS], const Limb (&b)[LIMBS], const size_t first, const size_t column){
+                Accumulator sum;
+                const size_t last = (column < LIMBS) ? column : (LIMBS - 1);
+                if (SQUARING == true){
+                    size_t j = first;
+                    size_t k = last;
+                    for (; j < k; ++j, --k){
+                        sum.add(a[j], a[k]);
+                    }
+                    sum.doubleValue();
+                    if (j == k){
+                        sum.add(a[j], a[j]);
+                    }
+                }else{
+                    for (size_t j = first; j <= last; ++j){
+                        sum.add(a[j], b[column - j]);
+                    }
+                }
+                return sum;
+            }
+    };
+
+    // message = signature ^ 65537 mod modulus with portable limb arithmetic
+    //   returns false if the signature is not less than the modulus
+    template<size_t BITS>
+    bool publicOperationScalar(const byte* pModulusData, const byte* pSignatureData, byte* pMessage){
+        typedef FixedModulus<BITS> Modulus;
+        const Modulus modulus(pModulusData);
+
+        Limb signature[Modulus::LIMBS];
+        Modulus::load(pSignatureData, signature);
+        if (modulus.isReduced(signature) == false){
+            return false;
+        }
+        const ScalarMontgomery<BITS> montgomery(modulus);
+
+        // x = signature * R, squared 16 times: signature^65536 * R
+        Limb x[Modulus::LIMBS];
+        montgomery.multiply(x, signature, montgomery.m_rr);
+        for (int i = 0; i < 16; ++i){
+            montgomery.square(x, x);
+        }
+        // multiplying by the plain signature also leaves Montgomery form: signature^65537
+        montgomery.multiply(x, x, signature);
+
+        Modulus::store(x, pMessage);
+        return true;
+    }
+
+#if defined(FIXEDSIZERSA_IFMA)
+    const size_t IFMA_LIMB_BITS = 52;
+    const uint64_t IFMA_LIMB_MASK = (static_cast<uint64_t>(1) << IFMA_LIMB_BITS) - 1;
+
+    // AVX-512 IFMA Montgomery arithmetic modulo a FixedModulus
+    //   numbers are held in 52-bit limbs, eight to a 512-bit vector, and multiplied with
+    //   vpmadd52luq/vpmadd52huq one limb of b at a time (almost Montgomery multiplication:
+    //   inputs and results are below 2 * modulus, which works because R > 4 * modulus)
+    template<size_t BITS>
+    class IFMAMontgomery{
+        public:
+            typedef FixedModulus<BITS> Modulus;
+            static const size_t VECTORS = (BITS + 8 * IFMA_LIMB_BITS - 1) / (8 * IFMA_LIMB_BITS);
+            static const size_t LIMBS = 8 * VECTORS;
+            static const size_t R_BITS = LIMBS * IFMA_LIMB_BITS;
+
+            const Modulus& m_modulus;
+            uint64_t m_limbs[LIMBS];    // modulus in 52-bit limbs, zero padded
+            uint64_t m_inverse;         // -modulus^-1 mod 2^52
+            uint64_t m_rr[LIMBS];       // R^2 mod modulus in 52-bit limbs
+
+            explicit IFMAMontgomery(const Modulus& modulus) : m_modulus(modulus),
+                                                              m_inverse(static_cast<uint64_t>(modulus.getNegatedInverse()) & IFMA_LIMB_MASK){
+                static_assert(R_BITS >= BITS + 2, "R must exceed 4 * modulus");
+                toLimbs(modulus.m_modulus, this->m_limbs);
+                Limb rr[Modulus::LIMBS];
+                modulus.powerOfTwo(2 * R_BITS, rr);
+                toLimbs(rr, this->m_rr);
+            }
+
+            // converts a number to 52-bit limbs
+            static void toLimbs(const Limb (&value)[Modulus::LIMBS], uint64_t (&limbs)[LIMBS]){
+                for (size_t i = 0; i < LIMBS; ++i){
+                    const size_t bit = i * IFMA_LIMB_BITS;
+                    const size_t word = bit / LIMB_BITS;
+                    const size_t offset = bit % LIMB_BITS;
+                    uint64_t limb = 0;
+                    if (word < Modulus::LIMBS){
+                        limb = value[word] >> offset;
+                        if (offset > LIMB_BITS - IFMA_LIMB_BITS && word + 1 < Modulus::LIMBS){
+                            limb |= value[word + 1] << (LIMB_BITS - offset);
+                        }
+                    }
+                    limbs[i] = limb & IFMA_LIMB_MASK;
+                }
+            }
+
+            // converts normalized 52-bit limbs back; returns the bits above BITS
+            static Limb fromLimbs(const uint64_t (&limbs)[LIMBS], Limb (&value)[Modulus::LIMBS]){
+                for (size_t i = 0; i < Modulus::LIMBS; ++i){
+                    value[i] = 0;
+                }
+                Limb top = 0;
+                for (size_t i = 0; i < LIMBS; ++i){
+                    const size_t bit = i * IFMA_LIMB_BITS;
+                    const size_t word = bit / LIMB_BITS;
+                    const size_t offset = bit % LIMB_BITS;
+                    if (word < Modulus::LIMBS){
+                        value[word] |= limbs[i] << offset;
+                        if (offset > LIMB_BITS - IFMA_LIMB_BITS){
+                            if (word + 1 < Modulus::LIMBS){
+                                value[word + 1] |= limbs[i] >> (LIMB_BITS - offset);
+                            }else{
+                                top |= limbs[i] >> (LIMB_BITS - offset);
+                            }
+                        }
+                    }else{
+                        top |= limbs[i] << (bit - BITS);
+                    }
+                }
+                return top;
+            }
+
+            // result = a * b / R mod modulus, below 2 * modulus (a, b below 2 * modulus; result may alias a or b)
+            FIXEDSIZERSA_TARGET("avx512f,avx512ifma")
+            void multiply(uint64_t (&result)[LIMBS], const uint64_t (&a)[LIMBS], const uint64_t (&b)[LIMBS]) const {
+                // also the source of the full-mask extract and alignr below (GCC's unmasked forms take an
+                //   uninitialized source vector, which -Wmaybe-uninitialized reports)
+                const __m512i zero = _mm512_setzero_si512();
+                __m512i aVectors[VECTORS];
+                __m512i modulusVectors[VECTORS];
+                __m512i sum[VECTORS];
+                FIXEDSIZERSA_UNROLL
+                for (size_t k = 0; k < VECTORS; ++k){
+                    aVectors[k] = _mm512_loadu_si512(a + 8 * k);
+                    modulusVectors[k] = _mm512_loadu_si512(this->m_limbs + 8 * k);
+                    sum[k] = zero;
+                }
+                const uint64_t modulusLow = this->m_limbs[0];
+
+                for (size_t i = 0; i < LIMBS; ++i){
+                    // sum += a * b[i] (low halves)
+                    const __m512i bLimb = _mm512_set1_epi64(static_cast<long long>(b[i]));
+                    FIXEDSIZERSA_UNROLL
+                    for (size_t k = 0; k < VECTORS; ++k){
+                        sum[k] = _mm512_madd52lo_epu64(sum[k], aVectors[k], bLimb);
+                    }
+
+                    // sum += m * modulus (low halves), with m chosen so that limb 0 becomes a multiple of 2^52
+                    const uint64_t sumLow = static_cast<uint64_t>(_mm_cvtsi128_si64(_mm512_maskz_extracti32x4_epi32(0x0F, sum[0], 0)));
+                    const uint64_t m = (sumLow * this->m_inverse) & IFMA_LIMB_MASK;
+                    const __m512i mLimb = _mm512_set1_epi64(static_cast<long long>(m));
+                    FIXEDSIZERSA_UNROLL
+                    for (size_t k = 0; k < VECTORS; ++k){
+                        sum[k] = _mm512_madd52lo_epu64(sum[k], modulusVectors[k], mLimb);
+                    }
+                    const uint64_t carry = (sumLow + ((m * modulusLow) & IFMA_LIMB_MASK)) >> IFMA_LIMB_BITS;
+
+                    // drop limb 0 (divide by 2^52), carrying its high bits into the new limb 0
+                    FIXEDSIZERSA_UNROLL
+                    for (size_t k = 0; k + 1 < VECTORS; ++k){
+                        sum[k] = _mm512_mask_alignr_epi64(zero, 0xFF, sum[k + 1], sum[k], 1);
+                    }
+                    sum[VECTORS - 1] = _mm512_mask_alignr_epi64(zero, 0xFF, zero, sum[VECTORS - 1], 1);
+                    sum[0] = _mm512_add_epi64(sum[0], _mm512_maskz_set1_epi64(0x01, static_cast<long long>(carry)));
+
+                    // high halves belong one limb up, which after the shift is the same position
+                    FIXEDSIZERSA_UNROLL
+                    for (size_t k = 0; k < VECTORS; ++k){
+                        sum[k] = _mm512_madd52hi_epu64(sum[k], aVectors[k], bLimb);
+                        sum[k] = _mm512_madd52hi_epu64(sum[k], modulusVectors[k], mLimb);
+                    }
+                }
+
+                // normalize to 52-bit limbs
+                uint64_t limbs[LIMBS];
+                for (size_t k = 0; k < VECTORS; ++k){
+                    _mm512_storeu_si512(limbs + 8 * k, sum[k]);
+                }
+                uint64_t carry = 0;
+                for (size_t i = 0; i < LIMBS; ++i){
+                    const uint64_t limb = limbs[i] + carry;
+                    result[i] = limb & IFMA_LIMB_MASK;
+                    carry = limb >> IFMA_LIMB_BITS;
+                }
+            }
+    };
+
+    // message = signature ^ 65537 mod modulus with AVX-512 IFMA
+    //   returns false if the signature is not less than the modulus
+    template<size_t BITS>
+    FIXEDSIZERSA_TARGET("avx512f,avx512ifma")
+    bool publicOperationIFMA(const byte* pModulusData, const byte* pSignatureData, byte* pMessage){
+        typedef FixedModulus<BITS> Modulus;
+        typedef IFMAMontgomery<BITS> Montgomery;
+        const Modulus modulus(pModulusData);
+
+        Limb signature[Modulus::LIMBS];
+        Modulus::load(pSignatureData, signature);
+        if (modulus.isReduced(signature) == false){
+            return false;
+        }
+        const Montgomery montgomery(modulus);
+
+        uint64_t signatureLimbs[Montgomery::LIMBS];
+        Montgomery::toLimbs(signature, signatureLimbs);
+
+        // same ladder as the scalar implementation
+        uint64_t x[Montgomery::LIMBS];
+        montgomery.multiply(x, signatureLimbs, montgomery.m_rr);
+        for (int i = 0; i < 16; ++i){
+            montgomery.multiply(x, x, x);
+        }
+        montgomery.multiply(x, x, signatureLimbs);
+
+        // the result is below 2 * modulus
+        Limb message[Modulus::LIMBS];
+        const Limb top = Montgomery::fromLimbs(x, message);
+        modulus.reduceOnce(message, top);
+        Modulus::store(message, pMessage);
+        return true;
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns true if the key can take the fixed-size path
+bool FixedSizeRSA::isSupportedKey(const byte* pExponentData, const size_t exponentLength,
+                                  const byte* pModulusData, const size_t modulusLength){
+    // exponent must be 65537
+    const size_t exponentBytes = getSignificantLength(pExponentData, exponentLength);
+    if (exponentBytes == 0 || exponentBytes > 4){
+        return false;
+    }
+    unsigned long exponent = 0;
+    for (size_t i = exponentLength - exponentBytes; i < exponentLength; ++i){
+        exponent = (exponent << 8) | pExponentData[i];
+    }
+    if (exponent != PUBLIC_EXPONENT){
+        return false;
+    }
+
+    // modulus must be odd and exactly 1024 or 2048 bits long
+    const size_t modulusBytes = getSignificantLength(pModulusData, modulusLength);
+    if (modulusBytes != 1024 / 8 && modulusBytes != 2048 / 8){
+        return false;
+    }
+    const byte* pSignificant = pModulusData + (modulusLength - modulusBytes);
+    return (pSignificant[0] & 0x80) != 0 && (pSignificant[modulusBytes - 1] & 0x01) != 0;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the length in bytes of a big endian number without leading zero bytes
+size_t FixedSizeRSA::getSignificantLength(const byte* pData, const size_t length){
+    size_t leadingZeros = 0;
+    while (leadingZeros < length && pData[leadingZeros] == 0){
+        ++leadingZeros;
+    }
+    return length - leadingZeros;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// computes message = signature ^ 65537 mod modulus with the fastest implementation supported by this CPU
+bool FixedSizeRSA::publicOperation(const byte* pModulusData, const size_t modulusLength,
+                                   const byte* pSignatureData, byte* pMessage){
+    return publicOperation(getBestImplementation(), pModulusData, modulusLength, pSignatureData, pMessage);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// computes message = signature ^ 65537 mod modulus with the given implementation
+bool FixedSizeRSA::publicOperation(const Implementation implementation, const byte* pModulusData, const size_t modulusLength,
+                                   const byte* pSignatureData, byte* pMessage){
+    const size_t modulusBytes = getSignificantLength(pModulusData, modulusLength);
+    const byte* pSignificant = pModulusData + (modulusLength - modulusBytes);
+#if defined(FIXEDSIZERSA_IFMA)
+    if (implementation == IMPLEMENTATION_AVX512IFMA){
+        switch (modulusBytes){
+            case 1024 / 8:
+                return publicOperationIFMA<1024>(pSignificant, pSignatureData, pMessage);
+            case 2048 / 8:
+                return publicOperationIFMA<2048>(pSignificant, pSignatureData, pMessage);
+            default:
+                return false;
+        }
+    }
+#else
+    (void)implementation;
+#endif
+    switch (modulusBytes){
+        case 1024 / 8:
+            return publicOperationScalar<1024>(pSignificant, pSignatureData, pMessage);
+        case 2048 / 8:
+            return publicOperationScalar<2048>(pSignificant, pSignatureData, pMessage);
+        default:
+            return false;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the given implementation can run on this CPU (and was compiled in)
+bool FixedSizeRSA::isSupported(const Implementation implementation){
+    switch (implementation){
+        case IMPLEMENTATION_SCALAR:
+            return true;
+#if defined(FIXEDSIZERSA_IFMA)
+        case IMPLEMENTATION_AVX512IFMA:
+            return CpuFeatures::hasAVX512IFMA();
+#endif
+        default:
+            return false;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns the fastest implementation supported by this CPU
+FixedSizeRSA::Implementation FixedSizeRSA::getBestImplementation(){
+    static const Implementation bestImplementation = detectBestImplementation();
+    return bestImplementation;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the given implementation beats OpenSSL's generic exponentiation for a
+//   modulus of the given significant length
+bool FixedSizeRSA::isPreferred(const Implementation implementation, const size_t modulusBytes){
+    if (implementation == IMPLEMENTATION_AVX512IFMA){
+        return true;
+    }
+    return modulusBytes == 1024 / 8;
+}
+
+//----------------------------------------------------------------------
+// PRIVATE STATIC
+//   probes the CPU for the fastest supported implementation
+FixedSizeRSA::Implementation FixedSizeRSA::detectBestImplementation(){
+    if (isSupported(IMPLEMENTATION_AVX512IFMA) == true){
+        return IMPLEMENTATION_AVX512IFMA;
+    }
+    return IMPLEMENTATION_SCALAR;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns a printable name for the given implementation
+const char* FixedSizeRSA::getImplementationName(const Implementation implementation){
+    switch (implementation){
+        case IMPLEMENTATION_SCALAR:
+            return "scalar";
+        case IMPLEMENTATION_AVX512IFMA:
+            return "avx512ifma";
+        default:
+            return "unknown";
+    }
+}
+
+//----------------------------------------------------------------------
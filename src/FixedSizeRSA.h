@@ -0,0 +1,92 @@
+//----------------------------------------------------------------------
+// FixedSizeRSA - RSA public operation (signature ^ 65537 mod modulus)
+//                specialized at compile time for the common Coolkey key
+//                sizes.
+//
+// Nearly every card generates 1024 or 2048 bit keys with the public
+// exponent 0x010001.  For those keys the modular exponentiation is done
+// in fixed-size limb arrays on the stack: R^2 mod modulus by a short
+// schoolbook division, then 16 Montgomery squarings and one
+// multiplication.  Nothing is allocated.  The AVX-512 IFMA
+// implementation works on 52-bit limbs, eight to a vector; the portable
+// one on 64-bit (or 32-bit) limbs.  Other keys are left to OpenSSL (see
+// isSupportedKey()).
+//----------------------------------------------------------------------
+
+#ifndef FixedSizeRSAH_Included
+#define FixedSizeRSAH_Included
+
+//----------------------------------------------------------------------
+
+class FixedSizeRSA;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class FixedSizeRSA{
+    public:
+        // the only public exponent handled here (F4)
+        const static unsigned long PUBLIC_EXPONENT = 65537;
+
+        // implementations of the modular exponentiation
+        enum Implementation{
+            IMPLEMENTATION_SCALAR = 0,    // portable limb arithmetic
+            IMPLEMENTATION_AVX512IFMA,    // 52-bit multiply-add on 512-bit vectors
+            IMPLEMENTATION_COUNT
+        };
+
+        // returns true if the key can take the fixed-size path: public exponent 65537 and an odd
+        //   modulus of exactly 1024 or 2048 bits (leading zero bytes of either number are ignored)
+        static bool isSupportedKey(const byte* pExponentData, const size_t exponentLength,
+                                   const byte* pModulusData, const size_t modulusLength);
+
+        // returns the length in bytes of a big endian number without leading zero bytes
+        static size_t getSignificantLength(const byte* pData, const size_t length);
+
+        // computes message = signature ^ 65537 mod modulus for a key accepted by isSupportedKey()
+        //   signature and message are big endian, exactly getSignificantLength(modulus) bytes long
+        //   returns false (leaving message untouched) if the signature is not less than the modulus
+        //   uses the fastest implementation supported by this CPU
+        static bool publicOperation(const byte* pModulusData, const size_t modulusLength,
+                                    const byte* pSignatureData, byte* pMessage);
+
+        // as above, using the given implementation (must be supported by this CPU)
+        static bool publicOperation(const Implementation implementation, const byte* pModulusData, const size_t modulusLength,
+                                    const byte* pSignatureData, byte* pMessage);
+
+
+        // returns true if the given implementation can run on this CPU (and was compiled in)
+        static bool isSupported(const Implementation implementation);
+
+        // returns the fastest implementation supported by this CPU
+        static Implementation getBestImplementation();
+
+        // returns true if the given implementation beats OpenSSL's generic exponentiation for a
+        //   modulus of the given significant length (the portable code loses to OpenSSL's
+        //   assembly for 2048 bit keys)
+        static bool isPreferred(const Implementation implementation, const size_t modulusBytes);
+
+        // returns a printable name for the given implementation
+        static const char* getImplementationName(const Implementation implementation);
+
+    private:
+        // prevent copying and assignment
+        FixedSizeRSA(const FixedSizeRSA& src);
+        FixedSizeRSA operator=(const FixedSizeRSA& rhs);
+
+        // prevent construction
+        FixedSizeRSA();
+
+        // probes the CPU for the fastest supported implementation
+        static Implementation detectBestImplementation();
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,365 @@
+//----------------------------------------------------------------------
+// See HexDecoder.h
+//----------------------------------------------------------------------
+
+#include "HexDecoder.h"
+
+//----------------------------------------------------------------------
+
+#include "CpuFeatures.h"
+
+#include <cstdint>
+
+#if defined(CPUFEATURES_X86)
+    #include <emmintrin.h>  // SSE2
+    #include <immintrin.h>  // AVX2
+#endif
+
+// marks a function as compiled for the given instruction set regardless of compiler flags
+#if defined(CPUFEATURES_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define HEXDECODER_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define HEXDECODER_TARGET(isa)
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    // lookup table values other than 0x0-0xF
+    const byte HEX_SEPARATOR = 0xFE;
+    const byte HEX_INVALID = 0xFF;
+
+    // maps every character to its hex digit value, HEX_SEPARATOR or HEX_INVALID
+    class HexTable{
+        public:
+            byte m_values[256];
+
+            HexTable(){
+                for (int i = 0; i < 256; ++i){
+                    this->m_values[i] = HEX_INVALID;
+                }
+                for (int i = 0; i < 10; ++i){
+                    this->m_values['0' + i] = static_cast<byte>(i);
+                }
+                for (int i = 0; i < 6; ++i){
+                    this->m_values['a' + i] = static_cast<byte>(10 + i);
+                    this->m_values['A' + i] = static_cast<byte>(10 + i);
+                }
+                this->m_values[static_cast<byte>(':')] = HEX_SEPARATOR;
+                this->m_values[static_cast<byte>(' ')] = HEX_SEPARATOR;
+                this->m_values[static_cast<byte>('\t')] = HEX_SEPARATOR;
+                this->m_values[static_cast<byte>('\r')] = HEX_SEPARATOR;
+                this->m_values[static_cast<byte>('\n')] = HEX_SEPARATOR;
+            }
+    };
+    const HexTable g_hexTable;
+
+    // scalar implementation - no block fast path
+    class ScalarTraits{
+        public:
+            static const size_t BLOCK_CHARS = 64;
+            static bool decodeBlock(const char* pText, byte* pOut){ (void)pText; (void)pOut; return false; }
+    };
+
+#if defined(CPUFEATURES_X86)
+    // decodes 16 hex digits into 8 bytes (low 64 bits of result); returns false if any character is not a hex digit
+    HEXDECODER_TARGET("sse2") inline bool decodeSSE2Half(const __m128i text, __m128i& words){
+        const __m128i digits = _mm_sub_epi8(text, _mm_set1_epi8('0'));
+        const __m128i isDigit = _mm_cmpeq_epi8(_mm_subs_epu8(digits, _mm_set1_epi8(9)), _mm_setzero_si128());
+        const __m128i letters = _mm_sub_epi8(_mm_or_si128(text, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        const __m128i isLetter = _mm_cmpeq_epi8(_mm_subs_epu8(letters, _mm_set1_epi8(5)), _mm_setzero_si128());
+        if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xFFFF){
+            return false;
+        }
+        const __m128i nibbles = _mm_or_si128(_mm_and_si128(isDigit, digits),
+                                             _mm_and_si128(isLetter, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+        // each 16-bit lane holds (high nibble, low nibble) in memory order
+        words = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(nibbles, _mm_set1_epi16(0x00FF)), 4),
+                             _mm_srli_epi16(nibbles, 8));
+        return true;
+    }
+
+    // SSE2 implementation - 32 characters into 16 bytes per block
+    class SSE2Traits{
+        public:
+            static const size_t BLOCK_CHARS = 32;
+            HEXDECODER_TARGET("sse2") static inline bool decodeBlock(const char* pText, byte* pOut){
+                __m128i wordsLow, wordsHigh;
+                if (decodeSSE2Half(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pText)), wordsLow) == false ||
+                    decodeSSE2Half(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pText + 16)), wordsHigh) == false){
+                    return false;
+                }
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(pOut), _mm_packus_epi16(wordsLow, wordsHigh));
+                return true;
+            }
+    };
+
+    // decodes 32 hex digits into 16 bytes (as 16-bit lanes); returns false if any character is not a hex digit
+    HEXDECODER_TARGET("avx2") inline bool decodeAVX2Half(const __m256i text, __m256i& words){
+        const __m256i digits = _mm256_sub_epi8(text, _mm256_set1_epi8('0'));
+        const __m256i isDigit = _mm256_cmpeq_epi8(_mm256_subs_epu8(digits, _mm256_set1_epi8(9)), _mm256_setzero_si256());
+        const __m256i letters = _mm256_sub_epi8(_mm256_or_si256(text, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        const __m256i isLetter = _mm256_cmpeq_epi8(_mm256_subs_epu8(letters, _mm256_set1_epi8(5)), _mm256_setzero_si256());
+        if (_mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter)) != -1){
+            return false;
+        }
+        const __m256i nibbles = _mm256_or_si256(_mm256_and_si256(isDigit, digits),
+                                                _mm256_and_si256(isLetter, _mm256_add_epi8(letters, _mm256_set1_epi8(10))));
+        words = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(nibbles, _mm256_set1_epi16(0x00FF)), 4),
+                                _mm256_srli_epi16(nibbles, 8));
+        return true;
+    }
+
+    // AVX2 implementation - 64 characters into 32 bytes per block
+    class AVX2Traits{
+        public:
+            static const size_t BLOCK_CHARS = 64;
+            HEXDECODER_TARGET("avx2") static inline bool decodeBlock(const char* pText, byte* pOut){
+                __m256i wordsLow, wordsHigh;
+                if (decodeAVX2Half(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pText)), wordsLow) == false ||
+                    decodeAVX2Half(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pText + 32)), wordsHigh) == false){
+                    return false;
+                }
+                // packus works per 128-bit lane; restore memory order afterwards
+                const __m256i packed = _mm256_packus_epi16(wordsLow, wordsHigh);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(pOut), _mm256_permute4x64_epi64(packed, 0xD8));
+                return true;
+            }
+    };
+#endif
+
+    // decode loop shared by all implementations
+    //   blocks of plain hex digits go through Traits::decodeBlock; a block containing separators
+    //   or invalid characters (or following an unpaired digit) is handled by the lookup table
+    //   pendingNibble/pendingOffset carry an unpaired high nibble (-1 if none) across calls;
+    //   offsets are reported relative to baseOffset
+    //   pOut must have room for (length + 1) / 2 bytes; returns the number of bytes written via outLength
+    template<class Traits>
+    inline bool decodeLoop(const char* pText, const size_t length, const size_t baseOffset, byte* pOut, size_t& outLength,
+                           int& pendingNibble, size_t& pendingOffset, size_t& errorOffset){
+        size_t pos = 0;
+        size_t outPos = 0;
+
+        while (pos < length){
+            // fast path: a whole block of hex digits, aligned on a digit pair
+            if (pendingNibble < 0 && (length - pos) >= Traits::BLOCK_CHARS && Traits::decodeBlock(pText + pos, pOut + outPos) == true){
+                pos += Traits::BLOCK_CHARS;
+                outPos += Traits::BLOCK_CHARS / 2;
+                continue;
+            }
+
+            // slow path: one block through the lookup table
+            const size_t blockEnd = ((length - pos) > Traits::BLOCK_CHARS) ? (pos + Traits::BLOCK_CHARS) : length;
+            for (; pos < blockEnd; ++pos){
+                const byte value = g_hexTable.m_values[static_cast<byte>(pText[pos])];
+                if (value < 16){
+                    if (pendingNibble < 0){
+                        pendingNibble = value;
+                        pendingOffset = baseOffset + pos;
+                    }else{
+                        pOut[outPos++] = static_cast<byte>((pendingNibble << 4) | value);
+                        pendingNibble = -1;
+                    }
+                }else if (value != HEX_SEPARATOR){
+                    errorOffset = baseOffset + pos;
+                    outLength = outPos;
+                    return false;
+                }
+            }
+        }
+
+        outLength = outPos;
+        return true;
+    }
+
+    // per-implementation entry points
+    typedef bool (*DecodeFunction)(const char*, const size_t, const size_t, byte*, size_t&, int&, size_t&, size_t&);
+
+    bool decodeScalar(const char* pText, const size_t length, const size_t baseOffset, byte* pOut, size_t& outLength,
+                      int& pendingNibble, size_t& pendingOffset, size_t& errorOffset){
+        return decodeLoop<ScalarTraits>(pText, length, baseOffset, pOut, outLength, pendingNibble, pendingOffset, errorOffset);
+    }
+#if defined(CPUFEATURES_X86)
+    HEXDECODER_TARGET("sse2") bool decodeSSE2(const char* pText, const size_t length, const size_t baseOffset, byte* pOut, size_t& outLength,
+                                              int& pendingNibble, size_t& pendingOffset, size_t& errorOffset){
+        return decodeLoop<SSE2Traits>(pText, length, baseOffset, pOut, outLength, pendingNibble, pendingOffset, errorOffset);
+    }
+    HEXDECODER_TARGET("avx2") bool decodeAVX2(const char* pText, const size_t length, const size_t baseOffset, byte* pOut, size_t& outLength,
+                                              int& pendingNibble, size_t& pendingOffset, size_t& errorOffset){
+        return decodeLoop<AVX2Traits>(pText, length, baseOffset, pOut, outLength, pendingNibble, pendingOffset, errorOffset);
+    }
+#endif
+
+    // returns the entry point of the given implementation
+    DecodeFunction getDecodeFunction(const HexDecoder::Implementation implementation){
+        switch (implementation){
+#if defined(CPUFEATURES_X86)
+            case HexDecoder::IMPLEMENTATION_SSE2:
+                return decodeSSE2;
+            case HexDecoder::IMPLEMENTATION_AVX2:
+                return decodeAVX2;
+#endif
+            default:
+                return decodeScalar;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   decodes ASCII-hex text with the fastest implementation supported by this CPU
+bool HexDecoder::decode(const char* pText, const size_t length, std::vector<byte>& out, size_t& errorOffset){
+    return decode(getBestImplementation(), pText, length, out, errorOffset);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   decodes ASCII-hex text with the given implementation
+bool HexDecoder::decode(const Implementation implementation, const char* pText, const size_t length, std::vector<byte>& out, size_t& errorOffset){
+    const size_t originalSize = out.size();
+    HexStreamDecoder decoder(implementation);
+    if (decoder.feed(pText, length, out) == false || decoder.finish() == false){
+        out.resize(originalSize);
+        errorOffset = decoder.getErrorOffset();
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the given implementation can run on this CPU
+bool HexDecoder::isSupported(const Implementation implementation){
+    switch (implementation){
+        case IMPLEMENTATION_SCALAR:
+            return true;
+        case IMPLEMENTATION_SSE2:
+            return CpuFeatures::hasSSE2();
+        case IMPLEMENTATION_AVX2:
+            return CpuFeatures::hasAVX2();
+        default:
+            return false;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns the fastest implementation supported by this CPU
+HexDecoder::Implementation HexDecoder::getBestImplementation(){
+    static const Implementation bestImplementation = detectBestImplementation();
+    return bestImplementation;
+}
+
+//----------------------------------------------------------------------
+// PRIVATE STATIC
+//   probes the CPU for the fastest supported implementation
+HexDecoder::Implementation HexDecoder::detectBestImplementation(){
+    if (isSupported(IMPLEMENTATION_AVX2) == true){
+        return IMPLEMENTATION_AVX2;
+    }
+    if (isSupported(IMPLEMENTATION_SSE2) == true){
+        return IMPLEMENTATION_SSE2;
+    }
+    return IMPLEMENTATION_SCALAR;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns a printable name for the given implementation
+const char* HexDecoder::getImplementationName(const Implementation implementation){
+    switch (implementation){
+        case IMPLEMENTATION_SCALAR:
+            return "scalar";
+        case IMPLEMENTATION_SSE2:
+            return "sse2";
+        case IMPLEMENTATION_AVX2:
+            return "avx2";
+        default:
+            return "unknown";
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor - uses the fastest implementation supported by this CPU
+HexStreamDecoder::HexStreamDecoder() : m_implementation(HexDecoder::getBestImplementation()){
+    this->reset();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor - uses the given implementation (must be supported by this CPU)
+HexStreamDecoder::HexStreamDecoder(const HexDecoder::Implementation implementation) : m_implementation(implementation){
+    this->reset();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - nothing to do at present
+HexStreamDecoder::~HexStreamDecoder(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// forgets all state so that a new stream can be decoded
+void HexStreamDecoder::reset(){
+    this->m_streamOffset = 0;
+    this->m_pendingNibble = -1;
+    this->m_pendingOffset = 0;
+    this->m_failed = false;
+    this->m_errorOffset = 0;
+    this->m_errorUnpairedDigit = false;
+    this->m_errorCharacter = 0;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// decodes the next length characters of the stream, appending complete bytes to out
+//   returns false (now and on every later call) once an invalid character has been seen
+bool HexStreamDecoder::feed(const char* pText, const size_t length, std::vector<byte>& out){
+    // reserve room for the largest possible result; trimmed to the actual size afterwards
+    const size_t originalSize = out.size();
+    out.resize(originalSize + ((length + 1) / 2));
+
+    size_t outLength = 0;
+    const bool result = this->feed(pText, length, out.data() + originalSize, outLength);
+    out.resize(originalSize + outLength);
+    return result;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// decodes the next length characters of the stream into pOut, which must have room for (length + 1) / 2 bytes
+//   returns false (now and on every later call) once an invalid character has been seen
+bool HexStreamDecoder::feed(const char* pText, const size_t length, byte* pOut, size_t& outLength){
+    outLength = 0;
+    if (this->m_failed == true){
+        return false;
+    }
+
+    size_t errorOffset = 0;
+    const bool result = getDecodeFunction(this->m_implementation)(pText, length, this->m_streamOffset, pOut, outLength,
+                                                                  this->m_pendingNibble, this->m_pendingOffset, errorOffset);
+    if (result == false){
+        this->m_failed = true;
+        this->m_errorOffset = errorOffset;
+        this->m_errorCharacter = pText[errorOffset - this->m_streamOffset];
+    }
+    this->m_streamOffset += length;
+    return result;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// ends the stream; returns false if an invalid character was seen or a digit is left unpaired
+bool HexStreamDecoder::finish(){
+    if (this->m_failed == false && this->m_pendingNibble >= 0){
+        this->m_failed = true;
+        this->m_errorOffset = this->m_pendingOffset;
+        this->m_errorUnpairedDigit = true;
+    }
+    return (this->m_failed == false);
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,125 @@
+//----------------------------------------------------------------------
+// HexDecoder - Table-driven ASCII-hex decoder with SSE2/AVX2 fast paths
+//              selected at run time.
+//
+// Separator characters (':' ' ' TAB CR LF) are skipped; any other
+// character that is not a hex digit is reported as an error together
+// with its offset, as is an odd number of hex digits.
+//----------------------------------------------------------------------
+
+#ifndef HexDecoderH_Included
+#define HexDecoderH_Included
+
+//----------------------------------------------------------------------
+
+class HexDecoder;
+class HexStreamDecoder;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class HexDecoder{
+    public:
+        // decoder implementations
+        enum Implementation{
+            IMPLEMENTATION_SCALAR = 0,    // lookup table, one character at a time
+            IMPLEMENTATION_SSE2,          // 32 characters per step
+            IMPLEMENTATION_AVX2,          // 64 characters per step
+            IMPLEMENTATION_COUNT
+        };
+
+        // decodes length characters of ASCII-hex text, appending the bytes to out
+        //   uses the fastest implementation supported by this CPU
+        //   returns false if the text is invalid; errorOffset is then set to the offset of the
+        //   first invalid character (or of the unpaired last digit) and out is left unchanged
+        static bool decode(const char* pText, const size_t length, std::vector<byte>& out, size_t& errorOffset);
+
+        // as above, using the given implementation (must be supported by this CPU)
+        static bool decode(const Implementation implementation, const char* pText, const size_t length, std::vector<byte>& out, size_t& errorOffset);
+
+
+        // returns true if the given implementation can run on this CPU
+        static bool isSupported(const Implementation implementation);
+
+        // returns the fastest implementation supported by this CPU
+        static Implementation getBestImplementation();
+
+        // returns a printable name for the given implementation
+        static const char* getImplementationName(const Implementation implementation);
+
+    private:
+        // prevent copying and assignment
+        HexDecoder(const HexDecoder& src);
+        HexDecoder operator=(const HexDecoder& rhs);
+
+        // prevent construction
+        HexDecoder();
+
+        // probes the CPU for the fastest supported implementation
+        static Implementation detectBestImplementation();
+};
+
+//----------------------------------------------------------------------
+// Incremental decoder for ASCII-hex text that arrives in chunks.  Digit
+// pairs may be split across chunks; memory use is independent of the
+// length of the stream.
+
+class HexStreamDecoder{
+    private:
+        // prevent copying and assignment
+        HexStreamDecoder(const HexStreamDecoder& src);
+        HexStreamDecoder operator=(const HexStreamDecoder& rhs);
+
+    protected:
+        HexDecoder::Implementation m_implementation;  // decoder implementation used for every chunk
+        size_t m_streamOffset;                        // characters consumed so far
+        int m_pendingNibble;                          // unpaired high nibble from the previous chunk, or -1
+        size_t m_pendingOffset;                       // stream offset of the unpaired high nibble
+        bool m_failed;                                // true once an error has been detected
+        size_t m_errorOffset;                         // stream offset of the first error
+        bool m_errorUnpairedDigit;                    // true if the error is an unpaired digit at the end of the stream
+        char m_errorCharacter;                        // invalid character (if not an unpaired digit)
+
+    public:
+        // constructor - uses the fastest implementation supported by this CPU
+        HexStreamDecoder();
+
+        // constructor - uses the given implementation (must be supported by this CPU)
+        explicit HexStreamDecoder(const HexDecoder::Implementation implementation);
+
+        // destructor
+        virtual ~HexStreamDecoder();
+
+
+        // forgets all state so that a new stream can be decoded
+        void reset();
+
+        // decodes the next length characters of the stream, appending complete bytes to out
+        //   returns false (now and on every later call) once an invalid character has been seen;
+        //   bytes decoded before the invalid character are still appended
+        bool feed(const char* pText, const size_t length, std::vector<byte>& out);
+
+        // as above, writing into pOut which must have room for (length + 1) / 2 bytes
+        //   outLength receives the number of bytes written
+        bool feed(const char* pText, const size_t length, byte* pOut, size_t& outLength);
+
+        // ends the stream; returns false if an invalid character was seen or a digit is left unpaired
+        bool finish();
+
+
+        // getters for error details (valid once feed() or finish() returned false)
+        size_t getErrorOffset() const { return this->m_errorOffset; }
+        bool isErrorUnpairedDigit() const { return this->m_errorUnpairedDigit; }
+        char getErrorCharacter() const { return this->m_errorCharacter; }
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,167 @@
+//----------------------------------------------------------------------
+// See HexUtilities.h
+//----------------------------------------------------------------------
+
+#include "HexUtilities.h"
+
+//----------------------------------------------------------------------
+
+#include "HexDecoder.h"
+
+#include <stdexcept>
+#include <sstream>
+#include <iomanip>
+#include <istream>
+#include <cstring>    // memcpy
+
+//----------------------------------------------------------------------
+// returns the two lowercase hex digits of every byte value, indexed by 2 * value
+static const char* Get_ASCIIHex_Pair_Table(){
+    struct PairTable{
+        char m_pairs[2 * 256];
+        PairTable(){
+            const char DIGITS[] = "0123456789abcdef";
+            for (size_t value = 0; value < 256; ++value){
+                this->m_pairs[2 * value] = DIGITS[value >> 4];
+                this->m_pairs[2 * value + 1] = DIGITS[value & 0x0F];
+            }
+        }
+    };
+    static const PairTable table;
+    return table.m_pairs;
+}
+
+//----------------------------------------------------------------------
+// encodes length bytes as ASCII-hex, writing 2 * length lowercase hex digits to pText (no terminator)
+//   each byte is one lookup of its digit pair in a 512-character table
+void Encode_ASCIIHex(const byte* pData, const size_t length, char* pText){
+    const char* const pPairs = Get_ASCIIHex_Pair_Table();
+    for (size_t i = 0; i < length; ++i){
+        std::memcpy(pText + 2 * i, pPairs + 2 * pData[i], 2);
+    }
+}
+
+//----------------------------------------------------------------------
+// converts a byte vector to a hexadecimal string in the form of aa:bb:cc:etc
+std::string Bytes_To_String(const std::vector<byte>& v){
+    if (v.empty() == true){
+        return std::string();
+    }
+
+    // three characters per byte (two digits and a separator), less the trailing separator
+    std::string result(3 * v.size() - 1, ':');
+    const char* const pPairs = Get_ASCIIHex_Pair_Table();
+    for (size_t i = 0; i < v.size(); ++i){
+        std::memcpy(&result[3 * i], pPairs + 2 * v[i], 2);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------
+// throws std::runtime_error describing the error detected by decoder
+static void Throw_ASCIIHex_Error(const HexStreamDecoder& decoder){
+    std::ostringstream errsstr;
+    if (decoder.isErrorUnpairedDigit() == true){
+        errsstr << "Invalid ASCII-hex data - Odd number of hex digits.  Unpaired digit at offset: " << decoder.getErrorOffset();
+    }else{
+        errsstr << "Invalid ASCII-hex data - Unexpected character 0x"
+                << std::setw(2) << std::setfill('0') << std::hex << static_cast<int>(static_cast<unsigned char>(decoder.getErrorCharacter()))
+                << std::dec << " at offset: " << decoder.getErrorOffset();
+    }
+    throw std::runtime_error(errsstr.str());
+}
+
+//----------------------------------------------------------------------
+// Converts a string of ASCII-encoded hex to a byte array.
+//   separator characters (':' ' ' TAB CR LF) are ignored
+//   throws std::runtime_error if the string contains any other non-hex character or an odd number of hex digits
+std::vector<byte> Convert_ASCIIHex_To_Byte(const std::string& str){
+    return Convert_ASCIIHex_To_Byte(str.data(), str.length());
+}
+
+//----------------------------------------------------------------------
+// Converts length characters of ASCII-encoded hex (for instance a slice of a mapped file) to a byte array.
+//   throws std::runtime_error if the text contains invalid data (see above)
+std::vector<byte> Convert_ASCIIHex_To_Byte(const char* pText, const size_t length){
+    std::vector<byte> result;
+    result.reserve(length / 2);
+    HexStreamDecoder decoder;
+    if (decoder.feed(pText, length, result) == false || decoder.finish() == false){
+        Throw_ASCIIHex_Error(decoder);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------
+// Converts length characters of ASCII-encoded hex into caller-owned memory (for instance a ByteArena block).
+//   pOut must have room for (length + 1) / 2 bytes; returns the number of bytes written
+//   throws std::runtime_error if the text contains invalid data (see above)
+size_t Convert_ASCIIHex_To_Byte(const char* pText, const size_t length, byte* pOut){
+    size_t outLength = 0;
+    HexStreamDecoder decoder;
+    if (decoder.feed(pText, length, pOut, outLength) == false || decoder.finish() == false){
+        Throw_ASCIIHex_Error(decoder);
+    }
+    return outLength;
+}
+
+//----------------------------------------------------------------------
+// Reads one line of ASCII-encoded hex from a stream and converts it to a byte array.
+//   the line is read and decoded in fixed-size chunks, so memory use does not depend on line length
+//   throws std::runtime_error if the line contains invalid data (see Convert_ASCIIHex_To_Byte)
+std::vector<byte> Read_ASCIIHex_Line(std::istream& in){
+    const std::streamsize CHUNK_SIZE = 64 * 1024;
+    char chunk[CHUNK_SIZE];
+
+    std::vector<byte> result;
+    HexStreamDecoder decoder;
+    for (;;){
+        // read up to (not including) the next newline
+        in.get(chunk, CHUNK_SIZE, '\n');
+        const std::streamsize count = in.gcount();
+        if (count > 0 && decoder.feed(chunk, static_cast<size_t>(count), result) == false){
+            Throw_ASCIIHex_Error(decoder);
+        }
+        if (in.eof() == true || in.bad() == true){
+            break;
+        }
+        if (in.fail() == true){
+            // nothing extracted because the newline is next
+            in.clear();
+        }
+        if (in.peek() == '\n'){
+            in.ignore(1);
+            break;
+        }
+    }
+    if (decoder.finish() == false){
+        Throw_ASCIIHex_Error(decoder);
+    }
+    return result;
+}
+
+//----------------------------------------------------------------------
+// replaces all instances of a string with a new string
+//   builds the result in a single pass, so time is linear in the length of str
+void StringReplaceAll(std::string& str, const std::string& from, const std::string& to){
+    if (from.empty() == true){
+        return;
+    }
+    size_t start_pos = str.find(from);
+    if (start_pos == std::string::npos){
+        return;
+    }
+    std::string result;
+    result.reserve(str.length());
+    size_t copied_pos = 0;
+    while (start_pos != std::string::npos){
+        result.append(str, copied_pos, start_pos - copied_pos);
+        result.append(to);
+        copied_pos = start_pos + from.length();
+        start_pos = str.find(from, copied_pos);
+    }
+    result.append(str, copied_pos, std::string::npos);
+    str.swap(result);
+}
+
+//----------------------------------------------------------------------
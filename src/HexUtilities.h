@@ -0,0 +1,30 @@
+//----------------------------------------------------------------------
+// Defines helper functions for converting between binary data and
+// ASCII-hex text.
+//----------------------------------------------------------------------
+
+#ifndef HexUtilitiesH_Included
+#define HexUtilitiesH_Included
+
+//----------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <istream>
+
+typedef unsigned char BYTE;
+typedef unsigned char byte;
+
+//----------------------------------------------------------------------
+// PROTOTYPES
+std::string Bytes_To_String(const std::vector<byte>& v);
+void Encode_ASCIIHex(const byte* pData, const size_t length, char* pText);  // writes 2 * length lowercase hex digits to pText
+std::vector<byte> Convert_ASCIIHex_To_Byte(const std::string& str);  // throws std::runtime_error on invalid data
+std::vector<byte> Convert_ASCIIHex_To_Byte(const char* pText, const size_t length);  // throws std::runtime_error on invalid data
+size_t Convert_ASCIIHex_To_Byte(const char* pText, const size_t length, byte* pOut);  // pOut needs (length + 1) / 2 bytes; returns bytes written; throws as above
+std::vector<byte> Read_ASCIIHex_Line(std::istream& in);               // throws std::runtime_error on invalid data
+void StringReplaceAll(std::string& str, const std::string& from, const std::string& to);
+
+//----------------------------------------------------------------------
+
+#endif
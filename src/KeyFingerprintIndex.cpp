@@ -0,0 +1,624 @@
+//----------------------------------------------------------------------
+// See KeyFingerprintIndex.h
+//----------------------------------------------------------------------
+
+#include "KeyFingerprintIndex.h"
+
+//----------------------------------------------------------------------
+
+#include "OpenSSLAlgorithms.h"
+
+#include <cstring>    // memcmp, memcpy
+#include <ctime>
+#include <sstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define KEYINDEX_MMAP
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    const char INDEX_MAGIC[8] = { 'C', 'K', 'Y', 'K', 'I', 'D', 'X', '1' };
+    const uint32_t INDEX_VERSION = 1;
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // file header; every field is naturally aligned
+    struct IndexHeader{
+        char m_magic[8];                      // INDEX_MAGIC
+        uint32_t m_version;                   // INDEX_VERSION
+        uint32_t m_headerLength;              // sizeof(IndexHeader)
+        uint32_t m_byteOrderMark;             // BYTE_ORDER_MARK in the writer's byte order
+        uint32_t m_slotLength;                // sizeof(IndexSlot)
+        uint64_t m_capacity;                  // slot count (a power of two)
+        uint64_t m_count;                     // keys recorded; only paces growth, so a crash may leave it short
+        uint64_t m_nextSequence;              // sequence number of the next key recorded
+        uint32_t m_superseded;                // set once the file has been replaced by a grown copy
+        uint32_t m_reserved;
+        uint64_t m_reserved2;
+    };
+
+    // one hash table slot; empty while m_sequence is 0
+    struct IndexSlot{
+        byte m_fingerprint[KeyFingerprintIndex::FINGERPRINT_LENGTH];
+        uint64_t m_sequence;                  // published last (release), read first (acquire)
+        uint64_t m_firstSeen;                 // seconds since the Unix epoch
+    };
+
+    static_assert(sizeof(IndexHeader) == 64, "index header layout");
+    static_assert(sizeof(IndexSlot) == 32, "index slot layout");
+
+    // fields shared with other processes are accessed atomically (GCC/Clang builtins on plain mapped memory)
+    inline uint64_t loadAcquire(const uint64_t* pValue){ return __atomic_load_n(pValue, __ATOMIC_ACQUIRE); }
+    inline void storeRelease(uint64_t* pValue, const uint64_t value){ __atomic_store_n(pValue, value, __ATOMIC_RELEASE); }
+    inline uint64_t loadRelaxed(const uint64_t* pValue){ return __atomic_load_n(pValue, __ATOMIC_RELAXED); }
+    inline void storeRelaxed(uint64_t* pValue, const uint64_t value){ __atomic_store_n(pValue, value, __ATOMIC_RELAXED); }
+
+    // returns the home slot of a fingerprint (its first bytes are already uniformly distributed)
+    inline uint64_t getHomeSlot(const byte* pFingerprint, const uint64_t capacity){
+        uint64_t hash;
+        std::memcpy(&hash, pFingerprint, sizeof(hash));
+        return hash & (capacity - 1);
+    }
+
+    // skips the leading zero bytes of a big endian integer
+    void stripLeadingZeros(const byte*& pData, size_t& length){
+        while (length > 0 && *pData == 0){
+            ++pData;
+            --length;
+        }
+    }
+
+    // appends a 32-bit big endian length to a digest
+    bool digestLengthPrefix(EVP_MD_CTX* pContext, const size_t length){
+        const byte lengthBytes[4] = { static_cast<byte>((length >> 24) & 0xFF), static_cast<byte>((length >> 16) & 0xFF),
+                                      static_cast<byte>((length >> 8) & 0xFF), static_cast<byte>(length & 0xFF) };
+        return EVP_DigestUpdate(pContext, lengthBytes, sizeof(lengthBytes)) == 1;
+    }
+
+    // the digest context of one thread, reused for every fingerprint the thread computes
+    //   (EVP_MD_CTX_create/destroy exist under every supported OpenSSL version)
+    class ThreadDigestContext{
+        private:
+            // prevent copying and assignment
+            ThreadDigestContext(const ThreadDigestContext& src);
+            ThreadDigestContext operator=(const ThreadDigestContext& rhs);
+
+        public:
+            EVP_MD_CTX* m_pContext;
+
+            ThreadDigestContext() : m_pContext(EVP_MD_CTX_create()) {}
+            ~ThreadDigestContext(){
+                if (this->m_pContext != nullptr){
+                    EVP_MD_CTX_destroy(this->m_pContext);
+                }
+            }
+    };
+
+#if defined(KEYINDEX_MMAP)
+    // holds the exclusive writer lock of an index for the lifetime of the object
+    class WriterLock{
+        private:
+            // prevent copying and assignment
+            WriterLock(const WriterLock& src);
+            WriterLock operator=(const WriterLock& rhs);
+
+        protected:
+            int m_fd;                         // lock file
+
+        public:
+            // throws std::runtime_error if the lock cannot be taken
+            explicit WriterLock(const int fd) : m_fd(fd){
+                while (flock(fd, LOCK_EX) != 0){
+                    if (errno != EINTR){
+                        throw std::runtime_error("Unable to lock key index.");
+                    }
+                }
+            }
+
+            ~WriterLock(){ flock(this->m_fd, LOCK_UN); }
+    };
+
+    // syncs the directory holding filepath, making a rename within it durable
+    void syncParentDirectory(const std::string& filepath){
+        const std::string::size_type slash = filepath.find_last_of('/');
+        const std::string directory = (slash == std::string::npos) ? std::string(".") : (slash == 0) ? std::string("/") : filepath.substr(0, slash);
+        const int fd = open(directory.c_str(), O_RDONLY);
+        if (fd >= 0){
+            fsync(fd);
+            close(fd);
+        }
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// one mapped index file
+
+#if defined(KEYINDEX_MMAP)
+
+class KeyFingerprintIndex::Mapping{
+    private:
+        // prevent copying and assignment
+        Mapping(const Mapping& src);
+        Mapping operator=(const Mapping& rhs);
+
+    public:
+        void* m_pData;                        // whole file
+        size_t m_size;                        // byte length of the file
+        IndexHeader* m_pHeader;               // header at the start of the file
+        IndexSlot* m_pSlots;                  // slot table following the header
+        uint64_t m_capacity;                  // slot count
+        dev_t m_device;                       // identity of the mapped file, to notice a replaced index
+        ino_t m_inode;
+
+        // maps an index file and checks its header
+        //   throws std::runtime_error if the file cannot be opened or mapped or is not a valid index
+        Mapping(const std::string& filepath, const bool writable) : m_pData(MAP_FAILED), m_size(0), m_pHeader(nullptr), m_pSlots(nullptr), m_capacity(0){
+            const int fd = open(filepath.c_str(), (writable == true) ? O_RDWR : O_RDONLY);
+            if (fd < 0){
+                throw std::runtime_error("Unable to open key index '" + filepath + "'.");
+            }
+            struct stat fileStatus;
+            if (fstat(fd, &fileStatus) != 0 || S_ISREG(fileStatus.st_mode) == 0){
+                close(fd);
+                throw std::runtime_error("Unable to read key index '" + filepath + "'.");
+            }
+            this->m_size = static_cast<size_t>(fileStatus.st_size);
+            this->m_device = fileStatus.st_dev;
+            this->m_inode = fileStatus.st_ino;
+            if (this->m_size < sizeof(IndexHeader)){
+                close(fd);
+                throw std::runtime_error("Key index '" + filepath + "' is truncated.");
+            }
+            this->m_pData = mmap(nullptr, this->m_size, (writable == true) ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+            // the mapping stays valid after the descriptor is closed
+            close(fd);
+            if (this->m_pData == MAP_FAILED){
+                throw std::runtime_error("Unable to map key index '" + filepath + "'.");
+            }
+            // lookups hit random slots - do not read ahead
+            madvise(this->m_pData, this->m_size, MADV_RANDOM);
+
+            this->m_pHeader = static_cast<IndexHeader*>(this->m_pData);
+            this->m_pSlots = reinterpret_cast<IndexSlot*>(static_cast<byte*>(this->m_pData) + sizeof(IndexHeader));
+            const IndexHeader& header = *this->m_pHeader;
+            this->m_capacity = header.m_capacity;
+            if (std::memcmp(header.m_magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header.m_version != INDEX_VERSION ||
+                header.m_headerLength != sizeof(IndexHeader) || header.m_slotLength != sizeof(IndexSlot)){
+                munmap(this->m_pData, this->m_size);
+                throw std::runtime_error("File '" + filepath + "' is not a key index.");
+            }
+            if (header.m_byteOrderMark != BYTE_ORDER_MARK){
+                munmap(this->m_pData, this->m_size);
+                throw std::runtime_error("Key index '" + filepath + "' was written with a different byte order.");
+            }
+            if (this->m_capacity < 2 || (this->m_capacity & (this->m_capacity - 1)) != 0 ||
+                this->m_capacity > (this->m_size - sizeof(IndexHeader)) / sizeof(IndexSlot) ||
+                this->m_size != sizeof(IndexHeader) + this->m_capacity * sizeof(IndexSlot)){
+                munmap(this->m_pData, this->m_size);
+                throw std::runtime_error("Key index '" + filepath + "' is damaged.");
+            }
+        }
+
+        // destructor - unmaps the file
+        ~Mapping(){
+            munmap(this->m_pData, this->m_size);
+        }
+
+        // returns true once a writer has replaced the file with a grown copy
+        bool isSuperseded() const {
+            return __atomic_load_n(&this->m_pHeader->m_superseded, __ATOMIC_ACQUIRE) != 0;
+        }
+
+        // returns the slot holding a fingerprint, or the empty slot that ends its probe sequence
+        //   (the table is never more than half full, so the probe always ends)
+        IndexSlot& probe(const byte* pFingerprint) const {
+            const uint64_t mask = this->m_capacity - 1;
+            for (uint64_t slotIndex = getHomeSlot(pFingerprint, this->m_capacity); ; slotIndex = (slotIndex + 1) & mask){
+                IndexSlot& slot = this->m_pSlots[slotIndex];
+                if (loadAcquire(&slot.m_sequence) == 0 ||
+                    std::memcmp(slot.m_fingerprint, pFingerprint, FINGERPRINT_LENGTH) == 0){
+                    return slot;
+                }
+            }
+        }
+};
+
+#else
+
+class KeyFingerprintIndex::Mapping{
+
+};
+
+#endif
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor opens (and in read-write mode creates, if missing) the index file
+//   throws std::runtime_error if the index cannot be opened, created, locked or mapped
+KeyFingerprintIndex::KeyFingerprintIndex(const std::string& filepath, const Mode mode) : m_filepath(filepath),
+                                                                                           m_mode(mode),
+                                                                                           m_lockFd(-1),
+                                                                                           m_pMapping(nullptr){
+#if defined(KEYINDEX_MMAP)
+    if (mode == MODE_READ_ONLY){
+        this->remap();
+        return;
+    }
+
+    // writers of every process serialize on a lock file that, unlike the index, is never replaced
+    const std::string lockFilepath = filepath + ".lock";
+    this->m_lockFd = open(lockFilepath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (this->m_lockFd < 0){
+        throw std::runtime_error("Unable to open key index lock file '" + lockFilepath + "'.");
+    }
+    try{
+        std::lock_guard<std::mutex> guard(this->m_mutex);
+        WriterLock writerLock(this->m_lockFd);
+        struct stat fileStatus;
+        if (stat(filepath.c_str(), &fileStatus) != 0){
+            if (errno != ENOENT){
+                throw std::runtime_error("Unable to read key index '" + filepath + "'.");
+            }
+            this->writeIndexFile(INITIAL_CAPACITY, nullptr);
+        }
+        this->remap();
+    }catch (...){
+        close(this->m_lockFd);
+        throw;
+    }
+#else
+    throw std::runtime_error("The key index is only supported on POSIX systems.");
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - flushes (read-write mode) and unmaps the index file
+KeyFingerprintIndex::~KeyFingerprintIndex(){
+    this->flush();
+#if defined(KEYINDEX_MMAP)
+    if (this->m_lockFd >= 0){
+        close(this->m_lockFd);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// computes the fingerprint of a public key
+//   the first FINGERPRINT_LENGTH bytes of SHA-256(u32 modulus length | modulus | u32 exponent length | exponent)
+bool KeyFingerprintIndex::tryComputeFingerprint(const byte* pModulus, size_t modulusLength,
+                                                const byte* pExponent, size_t exponentLength, byte* pFingerprint){
+    stripLeadingZeros(pModulus, modulusLength);
+    stripLeadingZeros(pExponent, exponentLength);
+
+    static thread_local ThreadDigestContext threadContext;
+    EVP_MD_CTX* const pContext = threadContext.m_pContext;
+    if (pContext == nullptr){
+        return false;
+    }
+    byte digest[EVP_MAX_MD_SIZE];
+    unsigned int digestLength = 0;
+    const bool ok = EVP_DigestInit_ex(pContext, OpenSSLAlgorithms::getSHA256(), nullptr) == 1 &&
+                    digestLengthPrefix(pContext, modulusLength) == true &&
+                    EVP_DigestUpdate(pContext, pModulus, modulusLength) == 1 &&
+                    digestLengthPrefix(pContext, exponentLength) == true &&
+                    EVP_DigestUpdate(pContext, pExponent, exponentLength) == 1 &&
+                    EVP_DigestFinal_ex(pContext, digest, &digestLength) == 1 &&
+                    digestLength >= FINGERPRINT_LENGTH;
+    if (ok == true){
+        std::memcpy(pFingerprint, digest, FINGERPRINT_LENGTH);
+    }
+    return ok;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// computes the fingerprint of the key of a parsed key blob
+bool KeyFingerprintIndex::tryComputeFingerprint(const CoolkeyRSAKeyBlobView& blob, byte* pFingerprint){
+    return tryComputeFingerprint(blob.getModulusData(), blob.getModulusLength(), blob.getExponentData(), blob.getExponentLength(), pFingerprint);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the result message of a key found in the index
+std::string KeyFingerprintIndex::describeDuplicate(const Entry& entry){
+    std::ostringstream message;
+    message << "Public key was recorded before (key index entry " << entry.m_sequence;
+    const std::time_t firstSeen = static_cast<std::time_t>(entry.m_firstSeen);
+    std::tm firstSeenTime;
+#if defined(KEYINDEX_MMAP)
+    if (gmtime_r(&firstSeen, &firstSeenTime) != nullptr){
+#else
+    if (gmtime_s(&firstSeenTime, &firstSeen) == 0){
+#endif
+        char timeText[32];
+        if (std::strftime(timeText, sizeof(timeText), "%Y-%m-%dT%H:%M:%SZ", &firstSeenTime) > 0){
+            message << ", first seen " << timeText;
+        }
+    }
+    message << ").";
+    return message.str();
+}
+
+#if defined(KEYINDEX_MMAP)
+
+//----------------------------------------------------------------------
+// PROTECTED
+// returns the current mapping, remapping first if the file has been superseded
+KeyFingerprintIndex::Mapping& KeyFingerprintIndex::getMapping(){
+    Mapping* pMapping = this->m_pMapping.load(std::memory_order_acquire);
+    if (pMapping->isSuperseded() == true){
+        std::lock_guard<std::mutex> guard(this->m_mutex);
+        pMapping = this->m_pMapping.load(std::memory_order_acquire);
+        if (pMapping->isSuperseded() == true){
+            this->remap();
+            pMapping = this->m_pMapping.load(std::memory_order_acquire);
+        }
+    }
+    return *pMapping;
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// maps the index file, replacing the current mapping; the caller holds m_mutex
+//   the previous mapping stays valid (lookups may still be using it) until destruction
+void KeyFingerprintIndex::remap(){
+    std::unique_ptr<Mapping> pMapping(new Mapping(this->m_filepath, this->m_mode == MODE_READ_WRITE));
+    this->m_mappings.push_back(std::move(pMapping));
+    this->m_pMapping.store(this->m_mappings.back().get(), std::memory_order_release);
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// creates the index file (or a grown copy of source) under a temporary name and renames it into place
+//   the copy is synced before the rename, so a crash leaves either the old or the new file in place
+void KeyFingerprintIndex::writeIndexFile(const uint64_t capacity, const Mapping* pSource){
+    const std::string tempFilepath = this->m_filepath + ".grow";
+    const int fd = open(tempFilepath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0){
+        throw std::runtime_error("Unable to create key index '" + tempFilepath + "'.");
+    }
+    const size_t size = sizeof(IndexHeader) + capacity * sizeof(IndexSlot);
+    void* pData = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0){
+        pData = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (pData == MAP_FAILED){
+        close(fd);
+        unlink(tempFilepath.c_str());
+        throw std::runtime_error("Unable to write key index '" + tempFilepath + "'.");
+    }
+
+    // the file is still private to this writer, so no atomic stores are needed
+    IndexHeader& header = *static_cast<IndexHeader*>(pData);
+    IndexSlot* const pSlots = reinterpret_cast<IndexSlot*>(static_cast<byte*>(pData) + sizeof(IndexHeader));
+    std::memcpy(header.m_magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.m_version = INDEX_VERSION;
+    header.m_headerLength = sizeof(IndexHeader);
+    header.m_byteOrderMark = BYTE_ORDER_MARK;
+    header.m_slotLength = sizeof(IndexSlot);
+    header.m_capacity = capacity;
+    header.m_count = 0;
+    header.m_nextSequence = 1;
+    if (pSource != nullptr){
+        // rehash the published slots; the count is recomputed, repairing any shortfall left by a crash
+        header.m_nextSequence = loadRelaxed(&pSource->m_pHeader->m_nextSequence);
+        for (uint64_t sourceIndex = 0; sourceIndex < pSource->m_capacity; ++sourceIndex){
+            const IndexSlot& sourceSlot = pSource->m_pSlots[sourceIndex];
+            const uint64_t sequence = loadAcquire(&sourceSlot.m_sequence);
+            if (sequence == 0){
+                continue;
+            }
+            uint64_t slotIndex = getHomeSlot(sourceSlot.m_fingerprint, capacity);
+            while (pSlots[slotIndex].m_sequence != 0){
+                slotIndex = (slotIndex + 1) & (capacity - 1);
+            }
+            pSlots[slotIndex] = sourceSlot;
+            pSlots[slotIndex].m_sequence = sequence;
+            ++header.m_count;
+            if (sequence >= header.m_nextSequence){
+                header.m_nextSequence = sequence + 1;
+            }
+        }
+    }
+
+    const bool written = (msync(pData, size, MS_SYNC) == 0);
+    munmap(pData, size);
+    if (written == false || fsync(fd) != 0){
+        close(fd);
+        unlink(tempFilepath.c_str());
+        throw std::runtime_error("Unable to write key index '" + tempFilepath + "'.");
+    }
+    close(fd);
+    if (rename(tempFilepath.c_str(), this->m_filepath.c_str()) != 0){
+        unlink(tempFilepath.c_str());
+        throw std::runtime_error("Unable to replace key index '" + this->m_filepath + "'.");
+    }
+    syncParentDirectory(this->m_filepath);
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// looks up (and, if missing, records) fingerprints; the caller holds m_mutex and the writer lock
+void KeyFingerprintIndex::insertLocked(const byte* const* ppFingerprints, const size_t count, Entry* pEntries, bool* pFound){
+    // another process may have replaced the file; a crashed writer may even have done so without flagging it,
+    //   so the file identity is checked rather than the superseded flag alone
+    Mapping* pMapping = this->m_pMapping.load(std::memory_order_acquire);
+    struct stat fileStatus;
+    if (stat(this->m_filepath.c_str(), &fileStatus) != 0){
+        throw std::runtime_error("Key index '" + this->m_filepath + "' has been removed.");
+    }
+    if (fileStatus.st_dev != pMapping->m_device || fileStatus.st_ino != pMapping->m_inode){
+        this->remap();
+        pMapping = this->m_pMapping.load(std::memory_order_acquire);
+    }
+
+    const uint64_t now = static_cast<uint64_t>(std::time(nullptr));
+    for (size_t i = 0; i < count; ++i){
+        const byte* const pFingerprint = ppFingerprints[i];
+        IndexSlot* pSlot = &pMapping->probe(pFingerprint);
+        const uint64_t sequence = loadAcquire(&pSlot->m_sequence);
+        if (sequence != 0){
+            pEntries[i].m_sequence = sequence;
+            pEntries[i].m_firstSeen = pSlot->m_firstSeen;
+            pFound[i] = true;
+            continue;
+        }
+
+        // keep the table at most half full: grow into a copy of twice the capacity
+        IndexHeader& header = *pMapping->m_pHeader;
+        if ((loadRelaxed(&header.m_count) + 1) * 2 > pMapping->m_capacity){
+            this->writeIndexFile(pMapping->m_capacity * 2, pMapping);
+            __atomic_store_n(&header.m_superseded, 1u, __ATOMIC_RELEASE);
+            this->remap();
+            pMapping = this->m_pMapping.load(std::memory_order_acquire);
+            pSlot = &pMapping->probe(pFingerprint);
+        }
+
+        // fill the slot, then publish it with its sequence number
+        IndexHeader& currentHeader = *pMapping->m_pHeader;
+        const uint64_t newSequence = loadRelaxed(&currentHeader.m_nextSequence);
+        storeRelaxed(&currentHeader.m_nextSequence, newSequence + 1);
+        std::memcpy(pSlot->m_fingerprint, pFingerprint, FINGERPRINT_LENGTH);
+        pSlot->m_firstSeen = now;
+        storeRelease(&pSlot->m_sequence, newSequence);
+        storeRelaxed(&currentHeader.m_count, loadRelaxed(&currentHeader.m_count) + 1);
+
+        pEntries[i].m_sequence = newSequence;
+        pEntries[i].m_firstSeen = now;
+        pFound[i] = false;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// returns the number of keys recorded
+uint64_t KeyFingerprintIndex::getCount(){
+    return loadRelaxed(&this->getMapping().m_pHeader->m_count);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// looks up a fingerprint without locking; returns true (and sets entry) if it is recorded
+bool KeyFingerprintIndex::find(const byte* pFingerprint, Entry& entry){
+    const IndexSlot& slot = this->getMapping().probe(pFingerprint);
+    const uint64_t sequence = loadAcquire(&slot.m_sequence);
+    if (sequence == 0){
+        return false;
+    }
+    entry.m_sequence = sequence;
+    entry.m_firstSeen = slot.m_firstSeen;
+    return true;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// looks up a fingerprint and records it if missing; returns true if it was recorded before the call
+bool KeyFingerprintIndex::findOrInsert(const byte* pFingerprint, Entry& entry){
+    // keys seen before are answered without taking any lock
+    if (this->find(pFingerprint, entry) == true){
+        return true;
+    }
+    if (this->m_mode == MODE_READ_ONLY){
+        return false;
+    }
+    bool found = false;
+    this->findOrInsertAll(&pFingerprint, 1, &entry, &found);
+    return found;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// as findOrInsert() for count fingerprints in order, taking the writer lock once
+void KeyFingerprintIndex::findOrInsertAll(const byte* const* ppFingerprints, const size_t count, Entry* pEntries, bool* pFound){
+    if (this->m_mode == MODE_READ_ONLY){
+        for (size_t i = 0; i < count; ++i){
+            pEntries[i] = Entry();
+            pFound[i] = this->find(ppFingerprints[i], pEntries[i]);
+        }
+        return;
+    }
+    if (count == 0){
+        return;
+    }
+    std::lock_guard<std::mutex> guard(this->m_mutex);
+    WriterLock writerLock(this->m_lockFd);
+    this->insertLocked(ppFingerprints, count, pEntries, pFound);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// writes the recorded entries through to disk; a no-op in read-only mode
+bool KeyFingerprintIndex::flush(){
+    if (this->m_mode == MODE_READ_ONLY){
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(this->m_mutex);
+    const Mapping* const pMapping = this->m_pMapping.load(std::memory_order_acquire);
+    return (pMapping == nullptr) || (msync(pMapping->m_pData, pMapping->m_size, MS_SYNC) == 0);
+}
+
+#else
+
+//----------------------------------------------------------------------
+// platforms without shared mappings: the constructor throws, so these are never reached
+
+KeyFingerprintIndex::Mapping& KeyFingerprintIndex::getMapping(){
+    throw std::runtime_error("The key index is only supported on POSIX systems.");
+}
+
+void KeyFingerprintIndex::remap(){
+
+}
+
+void KeyFingerprintIndex::writeIndexFile(const uint64_t capacity, const Mapping* pSource){
+    (void)capacity;
+    (void)pSource;
+}
+
+void KeyFingerprintIndex::insertLocked(const byte* const* ppFingerprints, const size_t count, Entry* pEntries, bool* pFound){
+    (void)ppFingerprints;
+    (void)count;
+    (void)pEntries;
+    (void)pFound;
+}
+
+uint64_t KeyFingerprintIndex::getCount(){
+    return 0;
+}
+
+bool KeyFingerprintIndex::find(const byte* pFingerprint, Entry& entry){
+    (void)pFingerprint;
+    (void)entry;
+    return false;
+}
+
+bool KeyFingerprintIndex::findOrInsert(const byte* pFingerprint, Entry& entry){
+    (void)pFingerprint;
+    (void)entry;
+    return false;
+}
+
+void KeyFingerprintIndex::findOrInsertAll(const byte* const* ppFingerprints, const size_t count, Entry* pEntries, bool* pFound){
+    (void)ppFingerprints;
+    (void)count;
+    (void)pEntries;
+    (void)pFound;
+}
+
+bool KeyFingerprintIndex::flush(){
+    return true;
+}
+
+#endif
+
+//----------------------------------------------------------------------
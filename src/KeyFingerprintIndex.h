@@ -0,0 +1,161 @@
+//----------------------------------------------------------------------
+// KeyFingerprintIndex - Persistent, memory-mapped index of the public
+//                       keys seen at enrollment, for rejecting a key that
+//                       was enrolled before (a cloned card or a replayed
+//                       iobuf).
+//
+// Keys are identified by a 128-bit fingerprint (a truncated SHA-256 of the
+// modulus and public exponent).  The index file is an open-addressing hash
+// table of fixed-size slots kept at most half full, so a lookup or insert
+// touches one or two cache lines of the mapping:
+//
+//   header (64 bytes): magic "CKYKIDX1" | u32 version | u32 header length |
+//                      u32 byte order mark | u32 slot length | u64 capacity |
+//                      u64 count | u64 next sequence | u32 superseded flag
+//   slots (32 bytes):  fingerprint[16] | u64 sequence | u64 first seen
+//
+// A slot is published by storing its (non-zero) sequence number last, so
+// readers - in this or other processes - need no lock and never see a
+// partly written entry.  Writers are serialized by a lock on a separate
+// '<index file>.lock' file.  When the table fills up it is copied into a
+// file of twice the capacity, which is synced and renamed over the old one;
+// the old file is then flagged as superseded so that other processes
+// remap.  A crashed writer leaves at most an unpublished slot behind; after
+// a power loss the entries not yet flushed (see flush()) may be missing,
+// but the file stays consistent.  Integers are stored in host byte order.
+//
+// Needs POSIX file locking and shared mappings; elsewhere the constructor
+// throws.
+//----------------------------------------------------------------------
+
+#ifndef KeyFingerprintIndexH_Included
+#define KeyFingerprintIndexH_Included
+
+//----------------------------------------------------------------------
+
+class KeyFingerprintIndex;
+
+//----------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>     // unique_ptr
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "CoolkeyRSAKeyBlobView.h"
+
+//----------------------------------------------------------------------
+
+class KeyFingerprintIndex{
+    public:
+        // byte length of a key fingerprint
+        const static size_t FINGERPRINT_LENGTH = 16;
+
+        // slot count of a newly created index (grows by doubling)
+        const static uint64_t INITIAL_CAPACITY = 64 * 1024;
+
+        // how the index file is opened
+        enum Mode{
+            MODE_READ_ONLY = 0,               // lookups only; the file must exist
+            MODE_READ_WRITE                   // lookups and inserts; the file is created if missing
+        };
+
+        // a recorded key
+        class Entry{
+            public:
+                uint64_t m_sequence;          // 1-based number of the key in recording order
+                uint64_t m_firstSeen;         // time the key was recorded (seconds since the Unix epoch)
+
+                Entry() : m_sequence(0), m_firstSeen(0) {}
+        };
+
+        // one mapped index file (defined in the implementation)
+        class Mapping;
+
+    private:
+        // prevent copying and assignment
+        KeyFingerprintIndex(const KeyFingerprintIndex& src);
+        KeyFingerprintIndex operator=(const KeyFingerprintIndex& rhs);
+
+    protected:
+        std::string m_filepath;                             // path of the index file
+        Mode m_mode;                                        // read-only or read-write
+        int m_lockFd;                                       // writer lock file (read-write mode only)
+        std::atomic<Mapping*> m_pMapping;                   // current mapping of the index file
+        std::vector<std::unique_ptr<Mapping>> m_mappings;   // every mapping made; superseded ones stay valid
+                                                            //   for concurrent lookups until destruction
+        std::mutex m_mutex;                                 // serializes writers and remapping in this process
+
+        // returns the current mapping, remapping first if the file has been superseded
+        Mapping& getMapping();
+
+        // maps the index file, replacing the current mapping; the caller holds m_mutex
+        //   throws std::runtime_error if the file cannot be opened, mapped or is not a valid index
+        void remap();
+
+        // creates the index file (or a grown copy of source) under a temporary name and renames it into place;
+        //   the caller holds m_mutex and the writer lock
+        //   throws std::runtime_error if the file cannot be written
+        void writeIndexFile(const uint64_t capacity, const Mapping* pSource);
+
+        // looks up (and, if missing, records) fingerprints; the caller holds m_mutex and the writer lock
+        //   pFound[i] is set if fingerprint i was present before the call; pEntries[i] receives its entry
+        void insertLocked(const byte* const* ppFingerprints, const size_t count, Entry* pEntries, bool* pFound);
+
+    public:
+        // constructor opens (and in read-write mode creates, if missing) the index file
+        //   throws std::runtime_error if the file cannot be opened, created, locked or mapped, is not a
+        //   valid index, or the platform lacks file locking and shared mappings
+        explicit KeyFingerprintIndex(const std::string& filepath, const Mode mode = MODE_READ_WRITE);
+
+        // destructor - flushes (read-write mode) and unmaps the index file
+        virtual ~KeyFingerprintIndex();
+
+
+        // computes the fingerprint of a public key (leading zero bytes of either field are ignored)
+        //   writes FINGERPRINT_LENGTH bytes to pFingerprint; returns false if the digest fails
+        //   thread safe; each thread reuses one digest context
+        static bool tryComputeFingerprint(const byte* pModulus, const size_t modulusLength,
+                                          const byte* pExponent, const size_t exponentLength, byte* pFingerprint);
+
+        // as above, for the key of a parsed key blob
+        static bool tryComputeFingerprint(const CoolkeyRSAKeyBlobView& blob, byte* pFingerprint);
+
+        // returns the result message of a key found in the index
+        static std::string describeDuplicate(const Entry& entry);
+
+
+        // getters
+        const std::string& getFilepath() const { return this->m_filepath; }
+        bool isReadOnly() const { return this->m_mode == MODE_READ_ONLY; }
+
+        // returns the number of keys recorded (may fall short after a crash)
+        uint64_t getCount();
+
+        // looks up a fingerprint without locking; returns true (and sets entry) if it is recorded
+        bool find(const byte* pFingerprint, Entry& entry);
+
+        // looks up a fingerprint and records it if missing (in read-only mode only looks it up)
+        //   returns true (and sets entry) if it was recorded before the call
+        //   throws std::runtime_error if the index has to grow and the grown file cannot be written
+        bool findOrInsert(const byte* pFingerprint, Entry& entry);
+
+        // as findOrInsert() for count fingerprints in order, taking the writer lock once
+        //   a fingerprint repeated within the call is found at its second occurrence
+        void findOrInsertAll(const byte* const* ppFingerprints, const size_t count, Entry* pEntries, bool* pFound);
+
+        // writes the recorded entries through to disk (msync); a no-op in read-only mode
+        //   returns false if the sync fails
+        bool flush();
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,59 @@
+//----------------------------------------------------------------------
+// LineScanner - Splits a borrowed text buffer into lines in place.
+//
+// Each line is returned as a TextView into the buffer, without its
+// terminating '\n'; nothing is copied.  The newline search uses memchr(),
+// which the C library vectorizes.  A final line without a terminating
+// newline is still returned; an empty buffer has no lines.
+//----------------------------------------------------------------------
+
+#ifndef LineScannerH_Included
+#define LineScannerH_Included
+
+//----------------------------------------------------------------------
+
+class LineScanner;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstring>
+
+#include "TextView.h"
+
+//----------------------------------------------------------------------
+
+class LineScanner{
+    protected:
+        const char* m_pData;                  // borrowed buffer - must outlive this
+        size_t m_size;                        // byte length of buffer
+        size_t m_offset;                      // offset of the start of the next line
+        size_t m_lineNumber;                  // number of lines returned so far
+
+    public:
+        // constructor - scanning starts at the beginning of the buffer
+        LineScanner(const char* pData, const size_t size) : m_pData(pData), m_size(size), m_offset(0), m_lineNumber(0) {}
+
+
+        // getter for the line number (1-based) of the line last returned by nextLine()
+        size_t getLineNumber() const { return this->m_lineNumber; }
+
+        // returns the next line; returns false once the buffer is exhausted
+        bool nextLine(TextView& line){
+            if (this->m_offset >= this->m_size){
+                return false;
+            }
+            const char* const pStart = this->m_pData + this->m_offset;
+            const size_t remaining = this->m_size - this->m_offset;
+            const void* const pNewline = std::memchr(pStart, '\n', remaining);
+            const size_t length = (pNewline == nullptr) ? remaining : static_cast<size_t>(static_cast<const char*>(pNewline) - pStart);
+            line = TextView(pStart, length);
+            this->m_offset += (pNewline == nullptr) ? length : length + 1;
+            ++this->m_lineNumber;
+            return true;
+        }
+};
+
+//----------------------------------------------------------------------
+
+#endif
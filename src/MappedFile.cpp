@@ -0,0 +1,111 @@
+//----------------------------------------------------------------------
+// See MappedFile.h
+//----------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+//----------------------------------------------------------------------
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define MAPPEDFILE_MMAP
+#endif
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor opens and maps (or reads) the file
+//   throws std::runtime_error if the file cannot be opened, mapped or read
+MappedFile::MappedFile(const std::string& filepath, const AccessPattern accessPattern) : m_pData(nullptr), m_size(0), m_mapped(false){
+#if defined(MAPPEDFILE_MMAP)
+    const int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0){
+        throw std::runtime_error("Unable to open file '" + filepath + "'.");
+    }
+    struct stat fileStatus;
+    if (fstat(fd, &fileStatus) != 0){
+        close(fd);
+        throw std::runtime_error("Unable to read file '" + filepath + "'.");
+    }
+
+    // only regular files can be mapped; pipes and devices take the stream path below
+    if (S_ISREG(fileStatus.st_mode) != 0){
+        this->m_size = static_cast<size_t>(fileStatus.st_size);
+
+        // an empty file cannot be mapped; it has no contents to point at either
+        if (this->m_size > 0){
+            void* const pMapping = mmap(nullptr, this->m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pMapping == MAP_FAILED){
+                close(fd);
+                throw std::runtime_error("Unable to map file '" + filepath + "'.");
+            }
+            this->m_pData = static_cast<const byte*>(pMapping);
+            this->m_mapped = true;
+
+            // the hint only tunes read-ahead, so failure is harmless
+            if (accessPattern == ACCESS_SEQUENTIAL){
+                madvise(pMapping, this->m_size, MADV_SEQUENTIAL);
+            }else if (accessPattern == ACCESS_RANDOM){
+                madvise(pMapping, this->m_size, MADV_RANDOM);
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+        return;
+    }
+    close(fd);
+#else
+    (void)accessPattern;
+#endif
+
+    std::ifstream file(filepath, std::ios::in | std::ios::binary);
+    if (file.good() == false){
+        throw std::runtime_error("Unable to open file '" + filepath + "'.");
+    }
+    this->readStream(file, filepath);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor reads the rest of a stream (such as std::cin) into a buffer
+//   throws std::runtime_error if the stream cannot be read
+MappedFile::MappedFile(std::istream& in) : m_pData(nullptr), m_size(0), m_mapped(false){
+    this->readStream(in, "<stream>");
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - unmaps the file
+MappedFile::~MappedFile(){
+#if defined(MAPPEDFILE_MMAP)
+    if (this->m_mapped == true){
+        munmap(const_cast<byte*>(this->m_pData), this->m_size);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// reads the whole of in into m_buffer
+//   throws std::runtime_error (naming filepath) on read failure
+void MappedFile::readStream(std::istream& in, const std::string& filepath){
+    const size_t CHUNK_SIZE = 64 * 1024;
+    size_t size = 0;
+    while (in.good() == true){
+        this->m_buffer.resize(size + CHUNK_SIZE);
+        in.read(reinterpret_cast<char*>(this->m_buffer.data() + size), static_cast<std::streamsize>(CHUNK_SIZE));
+        size += static_cast<size_t>(in.gcount());
+    }
+    this->m_buffer.resize(size);
+    if (in.bad() == true){
+        throw std::runtime_error("Unable to read file '" + filepath + "'.");
+    }
+    this->m_pData = this->m_buffer.data();
+    this->m_size = this->m_buffer.size();
+}
+
+//----------------------------------------------------------------------
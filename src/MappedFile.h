@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------
+// MappedFile - Read-only view of a whole file.
+//
+// On POSIX systems regular files are mapped into memory with mmap(), so
+// their bytes are paged in from the page cache on first access and never
+// copied; the expected access pattern is passed on to the kernel with
+// madvise().  Pipes, terminals and other files that cannot be mapped
+// (and every file on other systems) are read into a buffer through
+// std::ifstream instead.  Either way getData() points at the complete
+// file contents for the lifetime of the object.
+//----------------------------------------------------------------------
+
+#ifndef MappedFileH_Included
+#define MappedFileH_Included
+
+//----------------------------------------------------------------------
+
+class MappedFile;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <istream>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class MappedFile{
+    public:
+        // expected access pattern of a mapping (a hint; ignored for buffered files)
+        enum AccessPattern{
+            ACCESS_NORMAL = 0,                // no particular pattern
+            ACCESS_SEQUENTIAL,                // read once from start to end - read ahead aggressively
+            ACCESS_RANDOM                     // scattered reads - do not read ahead
+        };
+
+    private:
+        // prevent copying and assignment
+        MappedFile(const MappedFile& src);
+        MappedFile operator=(const MappedFile& rhs);
+
+    protected:
+        const byte* m_pData;                  // file contents (mapping or m_buffer)
+        size_t m_size;                        // byte length of the file
+        bool m_mapped;                        // true if m_pData is a memory mapping
+        std::vector<byte> m_buffer;           // file contents when the file is not mapped
+
+        // reads the whole of in into m_buffer
+        //   throws std::runtime_error (naming filepath) on read failure
+        void readStream(std::istream& in, const std::string& filepath);
+
+    public:
+        // constructor opens and maps (or reads) the file
+        //   throws std::runtime_error if the file cannot be opened, mapped or read
+        explicit MappedFile(const std::string& filepath, const AccessPattern accessPattern = ACCESS_NORMAL);
+
+        // constructor reads the rest of a stream (such as std::cin) into a buffer
+        //   throws std::runtime_error if the stream cannot be read
+        explicit MappedFile(std::istream& in);
+
+        // destructor - unmaps the file
+        virtual ~MappedFile();
+
+
+        // getters for the file contents
+        const byte* getData() const { return this->m_pData; }
+        const char* getText() const { return reinterpret_cast<const char*>(this->m_pData); }
+        size_t getSize() const { return this->m_size; }
+        bool isMapped() const { return this->m_mapped; }
+};
+
+//----------------------------------------------------------------------
+
+#endif
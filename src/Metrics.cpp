@@ -0,0 +1,402 @@
+//----------------------------------------------------------------------
+// See Metrics.h
+//----------------------------------------------------------------------
+
+#include "Metrics.h"
+
+//----------------------------------------------------------------------
+
+#include <cstdio>     // rename, remove
+#include <fstream>
+#include <iomanip>
+#include <memory>     // unique_ptr
+
+#if defined(CKY_ENABLE_METRICS)
+    #include <atomic>
+    #include <mutex>
+    #include <vector>
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    // outcome codes with their own counter, in slot order (the last slot counts every other code)
+    const int COUNTED_OUTCOMES[Metrics::OUTCOME_SLOT_COUNT - 1] = { 0, 10, 20, 30, 40 };
+
+    // labels of the result cache lookup counters, in ResultCache::Lookup order
+    const char* const CACHE_LOOKUP_NAMES[Metrics::CACHE_LOOKUP_SLOT_COUNT] = { "hit", "persistent_hit", "miss" };
+
+    // labels of the batch pipeline counters, in BatchPipeline::Stage, ::Wait and ::Queue order
+    const char* const PIPELINE_STAGE_NAMES[Metrics::PIPELINE_STAGE_SLOT_COUNT] = { "load", "verify", "emit" };
+    const char* const PIPELINE_WAIT_NAMES[Metrics::PIPELINE_WAIT_SLOT_COUNT] = { "input", "output" };
+    const char* const PIPELINE_QUEUE_NAMES[Metrics::PIPELINE_QUEUE_SLOT_COUNT] = { "loaded", "verified" };
+
+    // exported histogram bounds are the powers of two 2^FIRST_EXPORTED_EXPONENT .. 2^LAST_EXPORTED_EXPONENT ns
+    //   (128 ns to about 69 s); they fall on bucket boundaries, so the exported counts are exact
+    const unsigned FIRST_EXPORTED_EXPONENT = 7;
+    const unsigned LAST_EXPORTED_EXPONENT = 36;
+
+    // totals over every thread's counters
+    struct Snapshot{
+        uint64_t m_buckets[Metrics::STAGE_COUNT][Metrics::BUCKET_COUNT];
+        uint64_t m_sums[Metrics::STAGE_COUNT];                // nanoseconds
+        uint64_t m_outcomes[Metrics::OUTCOME_SLOT_COUNT];
+        uint64_t m_cacheLookups[Metrics::CACHE_LOOKUP_SLOT_COUNT];
+        uint64_t m_pipelineStalls[Metrics::PIPELINE_STAGE_SLOT_COUNT][Metrics::PIPELINE_WAIT_SLOT_COUNT];  // nanoseconds
+        uint64_t m_queueDepthSums[Metrics::PIPELINE_QUEUE_SLOT_COUNT];
+        uint64_t m_queueDepthSamples[Metrics::PIPELINE_QUEUE_SLOT_COUNT];
+        uint64_t m_queueDepthMaxima[Metrics::PIPELINE_QUEUE_SLOT_COUNT];
+    };
+
+#if defined(CKY_ENABLE_METRICS)
+    // the counters of one thread
+    //   only the owning thread writes them, so an increment is a relaxed load and store rather than
+    //   a read-modify-write; exports read them concurrently, which the atomics make well defined
+    struct ThreadCounters{
+        std::atomic<uint64_t> m_buckets[Metrics::STAGE_COUNT][Metrics::BUCKET_COUNT];
+        std::atomic<uint64_t> m_sums[Metrics::STAGE_COUNT];
+        std::atomic<uint64_t> m_outcomes[Metrics::OUTCOME_SLOT_COUNT];
+        std::atomic<uint64_t> m_cacheLookups[Metrics::CACHE_LOOKUP_SLOT_COUNT];
+        std::atomic<uint64_t> m_pipelineStalls[Metrics::PIPELINE_STAGE_SLOT_COUNT][Metrics::PIPELINE_WAIT_SLOT_COUNT];
+        std::atomic<uint64_t> m_queueDepthSums[Metrics::PIPELINE_QUEUE_SLOT_COUNT];
+        std::atomic<uint64_t> m_queueDepthSamples[Metrics::PIPELINE_QUEUE_SLOT_COUNT];
+        std::atomic<uint64_t> m_queueDepthMaxima[Metrics::PIPELINE_QUEUE_SLOT_COUNT];
+    };
+
+    inline void addRelaxed(std::atomic<uint64_t>& counter, const uint64_t value){
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    // every thread's counters; blocks outlive their threads so that their counts stay in the totals
+    //   (never destroyed - worker threads may still be recording while main's statics are destroyed)
+    std::mutex& getRegistryMutex(){
+        static std::mutex* const pMutex = new std::mutex();
+        return *pMutex;
+    }
+    std::vector<std::unique_ptr<ThreadCounters>>& getRegistry(){
+        static std::vector<std::unique_ptr<ThreadCounters>>* const pRegistry = new std::vector<std::unique_ptr<ThreadCounters>>();
+        return *pRegistry;
+    }
+
+    // blocks of exited threads, handed to the next new thread; counts are cumulative, so the new
+    //   owner simply adds to them and the registry grows only with the number of concurrent threads
+    std::vector<ThreadCounters*>& getRetiredCounters(){
+        static std::vector<ThreadCounters*>* const pRetired = new std::vector<ThreadCounters*>();
+        return *pRetired;
+    }
+
+    // retires the calling thread's block when the thread exits
+    class ThreadCountersOwner{
+        public:
+            ThreadCounters* m_pCounters;
+
+            ThreadCountersOwner() : m_pCounters(nullptr) {}
+            ~ThreadCountersOwner(){
+                if (this->m_pCounters != nullptr){
+                    std::lock_guard<std::mutex> lock(getRegistryMutex());
+                    getRetiredCounters().push_back(this->m_pCounters);
+                }
+            }
+    };
+
+    // returns the calling thread's counters, registering them (or taking a retired block) on first use
+    ThreadCounters& getThreadCounters(){
+        static thread_local ThreadCounters* pCounters = nullptr;
+        if (pCounters == nullptr){
+            static thread_local ThreadCountersOwner owner;
+            std::lock_guard<std::mutex> lock(getRegistryMutex());
+            std::vector<ThreadCounters*>& retired = getRetiredCounters();
+            if (retired.empty() == false){
+                pCounters = retired.back();
+                retired.pop_back();
+            }else{
+                std::unique_ptr<ThreadCounters> pNew(new ThreadCounters());  // value-initialized: all zero
+                getRegistry().push_back(std::move(pNew));
+                pCounters = getRegistry().back().get();
+            }
+            owner.m_pCounters = pCounters;
+        }
+        return *pCounters;
+    }
+#endif
+
+    // sums every thread's counters into snapshot
+    void takeSnapshot(Snapshot& snapshot){
+        for (size_t stage = 0; stage < Metrics::STAGE_COUNT; ++stage){
+            for (size_t bucket = 0; bucket < Metrics::BUCKET_COUNT; ++bucket){
+                snapshot.m_buckets[stage][bucket] = 0;
+            }
+            snapshot.m_sums[stage] = 0;
+        }
+        for (size_t slot = 0; slot < Metrics::OUTCOME_SLOT_COUNT; ++slot){
+            snapshot.m_outcomes[slot] = 0;
+        }
+        for (size_t slot = 0; slot < Metrics::CACHE_LOOKUP_SLOT_COUNT; ++slot){
+            snapshot.m_cacheLookups[slot] = 0;
+        }
+        for (size_t stage = 0; stage < Metrics::PIPELINE_STAGE_SLOT_COUNT; ++stage){
+            for (size_t wait = 0; wait < Metrics::PIPELINE_WAIT_SLOT_COUNT; ++wait){
+                snapshot.m_pipelineStalls[stage][wait] = 0;
+            }
+        }
+        for (size_t queue = 0; queue < Metrics::PIPELINE_QUEUE_SLOT_COUNT; ++queue){
+            snapshot.m_queueDepthSums[queue] = 0;
+            snapshot.m_queueDepthSamples[queue] = 0;
+            snapshot.m_queueDepthMaxima[queue] = 0;
+        }
+
+#if defined(CKY_ENABLE_METRICS)
+        std::lock_guard<std::mutex> lock(getRegistryMutex());
+        const std::vector<std::unique_ptr<ThreadCounters>>& registry = getRegistry();
+        for (size_t i = 0; i < registry.size(); ++i){
+            const ThreadCounters& counters = *registry[i];
+            for (size_t stage = 0; stage < Metrics::STAGE_COUNT; ++stage){
+                for (size_t bucket = 0; bucket < Metrics::BUCKET_COUNT; ++bucket){
+                    snapshot.m_buckets[stage][bucket] += counters.m_buckets[stage][bucket].load(std::memory_order_relaxed);
+                }
+                snapshot.m_sums[stage] += counters.m_sums[stage].load(std::memory_order_relaxed);
+            }
+            for (size_t slot = 0; slot < Metrics::OUTCOME_SLOT_COUNT; ++slot){
+                snapshot.m_outcomes[slot] += counters.m_outcomes[slot].load(std::memory_order_relaxed);
+            }
+            for (size_t slot = 0; slot < Metrics::CACHE_LOOKUP_SLOT_COUNT; ++slot){
+                snapshot.m_cacheLookups[slot] += counters.m_cacheLookups[slot].load(std::memory_order_relaxed);
+            }
+            for (size_t stage = 0; stage < Metrics::PIPELINE_STAGE_SLOT_COUNT; ++stage){
+                for (size_t wait = 0; wait < Metrics::PIPELINE_WAIT_SLOT_COUNT; ++wait){
+                    snapshot.m_pipelineStalls[stage][wait] += counters.m_pipelineStalls[stage][wait].load(std::memory_order_relaxed);
+                }
+            }
+            for (size_t queue = 0; queue < Metrics::PIPELINE_QUEUE_SLOT_COUNT; ++queue){
+                snapshot.m_queueDepthSums[queue] += counters.m_queueDepthSums[queue].load(std::memory_order_relaxed);
+                snapshot.m_queueDepthSamples[queue] += counters.m_queueDepthSamples[queue].load(std::memory_order_relaxed);
+                const uint64_t maximum = counters.m_queueDepthMaxima[queue].load(std::memory_order_relaxed);
+                if (maximum > snapshot.m_queueDepthMaxima[queue]){
+                    snapshot.m_queueDepthMaxima[queue] = maximum;
+                }
+            }
+        }
+#endif
+    }
+}
+
+#if defined(CKY_ENABLE_METRICS)
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// adds count samples of the given latency (nanoseconds each) to a stage
+void Metrics::recordLatency(const Stage stage, const uint64_t nanoseconds, const uint64_t count){
+    ThreadCounters& counters = getThreadCounters();
+    addRelaxed(counters.m_buckets[stage][getBucketIndex(nanoseconds)], count);
+    addRelaxed(counters.m_sums[stage], nanoseconds * count);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// counts one finished record with the given outcome code
+void Metrics::countOutcome(const int outcome){
+    size_t slot = 0;
+    while (slot < OUTCOME_SLOT_COUNT - 1 && COUNTED_OUTCOMES[slot] != outcome){
+        ++slot;
+    }
+    addRelaxed(getThreadCounters().m_outcomes[slot], 1);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// counts one result cache lookup by where it was answered from
+void Metrics::countCacheLookup(const size_t lookup){
+    if (lookup < CACHE_LOOKUP_SLOT_COUNT){
+        addRelaxed(getThreadCounters().m_cacheLookups[lookup], 1);
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// adds the time a batch pipeline stage thread spent waiting
+void Metrics::countPipelineStall(const size_t stage, const size_t wait, const uint64_t nanoseconds){
+    if (stage < PIPELINE_STAGE_SLOT_COUNT && wait < PIPELINE_WAIT_SLOT_COUNT){
+        addRelaxed(getThreadCounters().m_pipelineStalls[stage][wait], nanoseconds);
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// samples the depth of a batch pipeline queue
+void Metrics::recordQueueDepth(const size_t queue, const uint64_t depth){
+    if (queue < PIPELINE_QUEUE_SLOT_COUNT){
+        ThreadCounters& counters = getThreadCounters();
+        addRelaxed(counters.m_queueDepthSums[queue], depth);
+        addRelaxed(counters.m_queueDepthSamples[queue], 1);
+        if (depth > counters.m_queueDepthMaxima[queue].load(std::memory_order_relaxed)){
+            counters.m_queueDepthMaxima[queue].store(depth, std::memory_order_relaxed);
+        }
+    }
+}
+#endif
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the metric label of a stage
+const char* Metrics::getStageName(const Stage stage){
+    switch (stage){
+        case STAGE_READ:        return "read";
+        case STAGE_DECODE:      return "decode";
+        case STAGE_PARSE:       return "parse";
+        case STAGE_DIGEST:      return "digest";
+        case STAGE_KEY_SETUP:   return "key_setup";
+        case STAGE_PUBLIC_OP:   return "public_op";
+        case STAGE_REQUEST:     return "request";
+        default:                return "unknown";
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the histogram bucket holding a latency
+//   below 2 * SUB_BUCKET_COUNT ns every value has its own bucket; above, a value with highest set bit e
+//   falls in group (e - SUB_BUCKET_BITS + 1), selected within the group by the SUB_BUCKET_BITS bits after e
+size_t Metrics::getBucketIndex(const uint64_t nanoseconds){
+    const uint64_t maxValue = (static_cast<uint64_t>(1) << MAX_EXPONENT) - 1;
+    const uint64_t value = (nanoseconds > maxValue) ? maxValue : nanoseconds;
+    if (value < 2 * SUB_BUCKET_COUNT){
+        return static_cast<size_t>(value);
+    }
+#if defined(__GNUC__)
+    const unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned exponent = SUB_BUCKET_BITS + 1;
+    while ((value >> (exponent + 1)) != 0){
+        ++exponent;
+    }
+#endif
+    const unsigned group = exponent - SUB_BUCKET_BITS + 1;
+    const size_t subBucket = static_cast<size_t>(value >> (group - 1)) - SUB_BUCKET_COUNT;
+    return group * SUB_BUCKET_COUNT + subBucket;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the exclusive upper bound (nanoseconds) of a bucket
+uint64_t Metrics::getBucketLimit(const size_t bucketIndex){
+    if (bucketIndex < SUB_BUCKET_COUNT){
+        return bucketIndex + 1;
+    }
+    const size_t group = bucketIndex / SUB_BUCKET_COUNT;
+    const uint64_t lowerBound = static_cast<uint64_t>(SUB_BUCKET_COUNT + bucketIndex % SUB_BUCKET_COUNT) << (group - 1);
+    return lowerBound + (static_cast<uint64_t>(1) << (group - 1));
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// writes every metric to out in the Prometheus text format
+void Metrics::writePrometheus(std::ostream& out){
+    std::unique_ptr<Snapshot> pSnapshot(new Snapshot());
+    takeSnapshot(*pSnapshot);
+    const Snapshot& snapshot = *pSnapshot;
+
+    const std::ios::fmtflags savedFlags = out.flags();
+    const std::streamsize savedPrecision = out.precision();
+    out << std::setprecision(12);
+
+    out << "# HELP cky_stage_duration_seconds Time spent per record in each processing stage.\n"
+        << "# TYPE cky_stage_duration_seconds histogram\n";
+    for (size_t stage = 0; stage < STAGE_COUNT; ++stage){
+        const char* const stageName = getStageName(static_cast<Stage>(stage));
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (unsigned exponent = FIRST_EXPORTED_EXPONENT; exponent <= LAST_EXPORTED_EXPONENT; ++exponent){
+            // buckets of group (exponent - SUB_BUCKET_BITS + 1) start at 2^exponent ns
+            const size_t boundary = (exponent - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+            for (; bucket < boundary; ++bucket){
+                cumulative += snapshot.m_buckets[stage][bucket];
+            }
+            out << "cky_stage_duration_seconds_bucket{stage=\"" << stageName << "\",le=\""
+                << static_cast<double>(static_cast<uint64_t>(1) << exponent) / 1e9 << "\"} " << cumulative << '\n';
+        }
+        for (; bucket < BUCKET_COUNT; ++bucket){
+            cumulative += snapshot.m_buckets[stage][bucket];
+        }
+        out << "cky_stage_duration_seconds_bucket{stage=\"" << stageName << "\",le=\"+Inf\"} " << cumulative << '\n'
+            << "cky_stage_duration_seconds_sum{stage=\"" << stageName << "\"} " << static_cast<double>(snapshot.m_sums[stage]) / 1e9 << '\n'
+            << "cky_stage_duration_seconds_count{stage=\"" << stageName << "\"} " << cumulative << '\n';
+    }
+
+    out << "# HELP cky_records_total Records (or daemon requests) finished, by outcome code.\n"
+        << "# TYPE cky_records_total counter\n";
+    for (size_t slot = 0; slot < OUTCOME_SLOT_COUNT; ++slot){
+        out << "cky_records_total{outcome=\"";
+        if (slot < OUTCOME_SLOT_COUNT - 1){
+            out << COUNTED_OUTCOMES[slot];
+        }else{
+            out << "other";
+        }
+        out << "\"} " << snapshot.m_outcomes[slot] << '\n';
+    }
+
+    out << "# HELP cky_result_cache_lookups_total Daemon result cache lookups, by where they were answered from.\n"
+        << "# TYPE cky_result_cache_lookups_total counter\n";
+    for (size_t slot = 0; slot < CACHE_LOOKUP_SLOT_COUNT; ++slot){
+        out << "cky_result_cache_lookups_total{result=\"" << CACHE_LOOKUP_NAMES[slot] << "\"} " << snapshot.m_cacheLookups[slot] << '\n';
+    }
+
+    out << "# HELP cky_pipeline_stall_seconds_total Time batch pipeline stage threads waited for input (queue empty) or output (queue full).\n"
+        << "# TYPE cky_pipeline_stall_seconds_total counter\n";
+    for (size_t stage = 0; stage < PIPELINE_STAGE_SLOT_COUNT; ++stage){
+        for (size_t wait = 0; wait < PIPELINE_WAIT_SLOT_COUNT; ++wait){
+            out << "cky_pipeline_stall_seconds_total{stage=\"" << PIPELINE_STAGE_NAMES[stage] << "\",wait=\"" << PIPELINE_WAIT_NAMES[wait] << "\"} "
+                << static_cast<double>(snapshot.m_pipelineStalls[stage][wait]) / 1e9 << '\n';
+        }
+    }
+
+    out << "# HELP cky_pipeline_queue_depth Depth of the batch pipeline queues, sampled at every push.\n"
+        << "# TYPE cky_pipeline_queue_depth summary\n";
+    for (size_t queue = 0; queue < PIPELINE_QUEUE_SLOT_COUNT; ++queue){
+        out << "cky_pipeline_queue_depth_sum{queue=\"" << PIPELINE_QUEUE_NAMES[queue] << "\"} " << snapshot.m_queueDepthSums[queue] << '\n'
+            << "cky_pipeline_queue_depth_count{queue=\"" << PIPELINE_QUEUE_NAMES[queue] << "\"} " << snapshot.m_queueDepthSamples[queue] << '\n';
+    }
+    out << "# HELP cky_pipeline_queue_depth_max Deepest sample of each batch pipeline queue.\n"
+        << "# TYPE cky_pipeline_queue_depth_max gauge\n";
+    for (size_t queue = 0; queue < PIPELINE_QUEUE_SLOT_COUNT; ++queue){
+        out << "cky_pipeline_queue_depth_max{queue=\"" << PIPELINE_QUEUE_NAMES[queue] << "\"} " << snapshot.m_queueDepthMaxima[queue] << '\n';
+    }
+
+    out << "# HELP cky_metrics_enabled 1 if stage timing was compiled in (CKY_METRICS).\n"
+        << "# TYPE cky_metrics_enabled gauge\n"
+        << "cky_metrics_enabled " << (isEnabled() == true ? 1 : 0) << '\n';
+
+    out.flags(savedFlags);
+    out.precision(savedPrecision);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// writes every metric to filepath, replacing it atomically
+//   returns false if the file cannot be written
+bool Metrics::tryWritePrometheusFile(const std::string& filepath){
+    // a scraper (e.g. node_exporter's textfile collector) never sees a partly written file
+    const std::string temporaryFilepath = filepath + ".tmp";
+    {
+        std::ofstream file(temporaryFilepath.c_str(), std::ios::out | std::ios::trunc);
+        if (file.good() == false){
+            return false;
+        }
+        writePrometheus(file);
+        file.flush();
+        if (file.good() == false){
+            file.close();
+            std::remove(temporaryFilepath.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporaryFilepath.c_str(), filepath.c_str()) != 0){
+        // rename does not replace an existing file on every platform
+        std::remove(filepath.c_str());
+        if (std::rename(temporaryFilepath.c_str(), filepath.c_str()) != 0){
+            std::remove(temporaryFilepath.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
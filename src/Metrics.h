@@ -0,0 +1,179 @@
+//----------------------------------------------------------------------
+// Metrics - Per-stage latency histograms and outcome counters, exported
+//           in the Prometheus text exposition format.
+//
+// Every thread records into its own block of counters, so recording
+// takes no lock and shares no cache line with other threads; the blocks
+// are only summed when the metrics are exported.  Latencies are kept in
+// log-linear (HDR-style) buckets: exact below 32 ns, then 16 buckets per
+// power of two (about 6% resolution) up to 2^40 ns.
+//
+// Recording compiles to nothing unless CKY_ENABLE_METRICS is defined
+// (CMake option CKY_METRICS); exports then contain no samples.  Stage
+// timers also feed TraceRecorder once tracing has been enabled, in
+// either build.
+//----------------------------------------------------------------------
+
+#ifndef MetricsH_Included
+#define MetricsH_Included
+
+//----------------------------------------------------------------------
+
+class Metrics;
+class StageTimer;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ostream>
+#include <chrono>
+
+#include "TraceRecorder.h"
+
+//----------------------------------------------------------------------
+
+class Metrics{
+    public:
+        // timed stages of record processing
+        enum Stage{
+            STAGE_READ = 0,          // manifest splitting, '@' field files and archive record fetch
+            STAGE_DECODE,            // ASCII-hex to bytes
+            STAGE_PARSE,             // key gen result parsing
+            STAGE_DIGEST,            // SHA-1 of (key blob + wrapped key)
+            STAGE_KEY_SETUP,         // BIGNUM key load, key checks and Montgomery setup
+            STAGE_PUBLIC_OP,         // RSA public operation
+            STAGE_REQUEST,           // whole daemon request
+            STAGE_COUNT
+        };
+
+        // histogram layout: SUB_BUCKET_COUNT buckets per power of two; longer latencies than
+        //   2^MAX_EXPONENT ns (about 18 minutes) are counted in the last bucket
+        const static unsigned SUB_BUCKET_BITS = 4;
+        const static size_t SUB_BUCKET_COUNT = static_cast<size_t>(1) << SUB_BUCKET_BITS;
+        const static unsigned MAX_EXPONENT = 40;
+        const static size_t BUCKET_COUNT = (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+        // outcome codes counted separately; any other code is counted as "other"
+        const static size_t OUTCOME_SLOT_COUNT = 6;
+
+        // result cache lookup results counted (ResultCache::Lookup values)
+        const static size_t CACHE_LOOKUP_SLOT_COUNT = 3;
+
+        // batch pipeline stages, waits and queues counted (BatchPipeline::Stage, ::Wait and ::Queue values)
+        const static size_t PIPELINE_STAGE_SLOT_COUNT = 3;
+        const static size_t PIPELINE_WAIT_SLOT_COUNT = 2;
+        const static size_t PIPELINE_QUEUE_SLOT_COUNT = 2;
+
+    private:
+        // prevent copying and assignment
+        Metrics(const Metrics& src);
+        Metrics operator=(const Metrics& rhs);
+
+        // prevent construction
+        Metrics();
+
+    public:
+        // returns true if recording was compiled in
+        static bool isEnabled(){
+#if defined(CKY_ENABLE_METRICS)
+            return true;
+#else
+            return false;
+#endif
+        }
+
+#if defined(CKY_ENABLE_METRICS)
+        // adds count samples of the given latency (nanoseconds each) to a stage
+        static void recordLatency(const Stage stage, const uint64_t nanoseconds, const uint64_t count = 1);
+
+        // counts one finished record with the given outcome code (RETCODE_*)
+        static void countOutcome(const int outcome);
+
+        // counts one result cache lookup by where it was answered from (a ResultCache::Lookup value)
+        static void countCacheLookup(const size_t lookup);
+
+        // adds the time a batch pipeline stage thread spent waiting (BatchPipeline::Stage and ::Wait values)
+        static void countPipelineStall(const size_t stage, const size_t wait, const uint64_t nanoseconds);
+
+        // samples the depth of a batch pipeline queue (a BatchPipeline::Queue value)
+        static void recordQueueDepth(const size_t queue, const uint64_t depth);
+#else
+        static void recordLatency(const Stage, const uint64_t, const uint64_t = 1) {}
+        static void countOutcome(const int) {}
+        static void countCacheLookup(const size_t) {}
+        static void countPipelineStall(const size_t, const size_t, const uint64_t) {}
+        static void recordQueueDepth(const size_t, const uint64_t) {}
+#endif
+
+        // returns the metric label of a stage
+        static const char* getStageName(const Stage stage);
+
+        // returns the histogram bucket holding a latency, and the exclusive upper bound of a bucket
+        static size_t getBucketIndex(const uint64_t nanoseconds);
+        static uint64_t getBucketLimit(const size_t bucketIndex);
+
+        // writes every metric to out in the Prometheus text format
+        static void writePrometheus(std::ostream& out);
+
+        // writes every metric to filepath, replacing it atomically (written to a temporary file, then renamed)
+        //   returns false if the file cannot be written; never throws except for std::bad_alloc
+        static bool tryWritePrometheusFile(const std::string& filepath);
+};
+
+//----------------------------------------------------------------------
+// Times a stage from construction until stop() or destruction, recording
+// it in the stage histogram and, while tracing, as a trace span.  When
+// metrics are disabled the clock is only read while tracing.
+
+class StageTimer{
+    private:
+        // prevent copying and assignment
+        StageTimer(const StageTimer& src);
+        StageTimer operator=(const StageTimer& rhs);
+
+    protected:
+        Metrics::Stage m_stage;                              // stage being timed
+        uint64_t m_count;                                    // samples the elapsed time is spread over
+        bool m_running;                                      // false once recorded (or if nothing is being timed)
+        std::chrono::steady_clock::time_point m_start;       // construction time
+
+    public:
+        // constructor starts timing; the elapsed time is recorded as count samples of an equal share
+        explicit StageTimer(const Metrics::Stage stage, const uint64_t count = 1) : m_stage(stage),
+                                                                                   m_count(count),
+                                                                                   m_running(Metrics::isEnabled() == true || TraceRecorder::isEnabled() == true),
+                                                                                   m_start(){
+            if (this->m_running == true){
+                this->m_start = std::chrono::steady_clock::now();
+            }
+        }
+
+        // destructor - records the stage unless stop() already has
+        ~StageTimer(){ this->stop(); }
+
+        // sets the number of samples (e.g. once the number of records in a group is known)
+        void setCount(const uint64_t count){ this->m_count = count; }
+
+        // records the elapsed time (once)
+        void stop(){
+            if (this->m_running == false){
+                return;
+            }
+            this->m_running = false;
+            if (this->m_count == 0){
+                return;
+            }
+            const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            const uint64_t elapsed = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - this->m_start).count());
+            Metrics::recordLatency(this->m_stage, elapsed / this->m_count, this->m_count);
+            if (TraceRecorder::isEnabled() == true){
+                TraceRecorder::recordSpan(Metrics::getStageName(this->m_stage), this->m_start, end, this->m_count);
+            }
+        }
+};
+
+//----------------------------------------------------------------------
+
+#endif
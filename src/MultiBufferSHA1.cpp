@@ -0,0 +1,431 @@
+//----------------------------------------------------------------------
+// See MultiBufferSHA1.h
+//----------------------------------------------------------------------
+
+#include "MultiBufferSHA1.h"
+
+//----------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstring>
+
+#include "CpuFeatures.h"
+
+#if defined(CPUFEATURES_X86)
+    #include <immintrin.h>  // SHA extensions, SSSE3, SSE4.1
+#endif
+
+// marks a function as compiled for the given instruction set regardless of compiler flags
+#if defined(CPUFEATURES_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define MULTIBUFFERSHA1_TARGET(isa) __attribute__((target(isa)))
+    #define MULTIBUFFERSHA1_INLINE inline __attribute__((always_inline))
+    // the lane implementations use compiler vector extensions
+    #define MULTIBUFFERSHA1_VECTOR_LANES
+#else
+    #define MULTIBUFFERSHA1_TARGET(isa)
+    #if defined(_MSC_VER)
+        #define MULTIBUFFERSHA1_INLINE __forceinline
+    #else
+        #define MULTIBUFFERSHA1_INLINE inline
+    #endif
+#endif
+
+// fully unrolls the following loop (keeps the message schedule in registers)
+#if defined(__clang__)
+    #define MULTIBUFFERSHA1_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__) && (__GNUC__ >= 8)
+    #define MULTIBUFFERSHA1_UNROLL _Pragma("GCC unroll 20")
+#else
+    #define MULTIBUFFERSHA1_UNROLL
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    const size_t BLOCK_LENGTH = 64;
+
+    // initial hash value (FIPS 180-4 5.3.1)
+    const uint32_t INITIAL_STATE[5] = { 0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u };
+
+    // round constants
+    const uint32_t K0 = 0x5A827999u;
+    const uint32_t K1 = 0x6ED9EBA1u;
+    const uint32_t K2 = 0x8F1BBCDCu;
+    const uint32_t K3 = 0xCA62C1D6u;
+
+    // returns the number of 64-byte blocks of the padded message (0x80, zeros, 64-bit bit length)
+    inline size_t getBlockCount(const MultiBufferSHA1::Message& message){
+        return (message.m_part1Length + message.m_part2Length + 8) / BLOCK_LENGTH + 1;
+    }
+
+    // copies the part of [pData, pData + length) that falls into [offset, offset + BLOCK_LENGTH) of a
+    // stream starting at dataOffset into pBlock
+    inline void copyIntoBlock(const byte* pData, const size_t length, const uint64_t dataOffset, const uint64_t offset, byte* pBlock){
+        const uint64_t begin = (offset > dataOffset) ? offset : dataOffset;
+        const uint64_t end = ((dataOffset + length) < (offset + BLOCK_LENGTH)) ? (dataOffset + length) : (offset + BLOCK_LENGTH);
+        if (begin < end){
+            std::memcpy(pBlock + (begin - offset), pData + (begin - dataOffset), static_cast<size_t>(end - begin));
+        }
+    }
+
+    // writes block blockIndex of the padded message to pBlock
+    void getBlock(const MultiBufferSHA1::Message& message, const size_t blockIndex, byte* pBlock){
+        const uint64_t totalLength = static_cast<uint64_t>(message.m_part1Length) + message.m_part2Length;
+        const uint64_t offset = static_cast<uint64_t>(blockIndex) * BLOCK_LENGTH;
+
+        std::memset(pBlock, 0, BLOCK_LENGTH);
+        copyIntoBlock(message.m_pPart1, message.m_part1Length, 0, offset, pBlock);
+        copyIntoBlock(message.m_pPart2, message.m_part2Length, message.m_part1Length, offset, pBlock);
+        if (totalLength >= offset && totalLength < offset + BLOCK_LENGTH){
+            pBlock[totalLength - offset] = 0x80;
+        }
+        if (blockIndex + 1 == getBlockCount(message)){
+            const uint64_t bitLength = totalLength * 8;
+            for (size_t i = 0; i < 8; ++i){
+                pBlock[BLOCK_LENGTH - 1 - i] = static_cast<byte>(bitLength >> (8 * i));
+            }
+        }
+    }
+
+    // big endian 32-bit load and store
+    inline uint32_t loadBigEndian(const byte* p){
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+    inline void storeBigEndian(byte* p, const uint32_t value){
+        p[0] = static_cast<byte>(value >> 24);
+        p[1] = static_cast<byte>(value >> 16);
+        p[2] = static_cast<byte>(value >> 8);
+        p[3] = static_cast<byte>(value);
+    }
+
+    //------------------------------------------------------------------
+    // lane implementations: V holds one 32-bit word of LANES messages
+    //   (uint32_t for scalar, a compiler vector type for SIMD); the code is
+    //   forced inline into entry points compiled for the matching instruction set
+
+    // rotates every lane of x left by bits (a macro so that no vector value crosses a function boundary)
+    #define MULTIBUFFERSHA1_ROTATE_LEFT(x, bits) (((x) << (bits)) | ((x) >> (32 - (bits))))
+
+    // one 20-round stage of the compression function
+    //   F selects the round function: 0 = choose, 1 and 3 = parity, 2 = majority
+    template<typename V, int F>
+    MULTIBUFFERSHA1_INLINE void compressStage(V& a, V& b, V& c, V& d, V& e, V (&w)[16], const int firstRound, const uint32_t k){
+        MULTIBUFFERSHA1_UNROLL
+        for (int t = firstRound; t < firstRound + 20; ++t){
+            if (t >= 16){
+                const V expanded = w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15];
+                w[t & 15] = MULTIBUFFERSHA1_ROTATE_LEFT(expanded, 1);
+            }
+            V f;
+            if (F == 0){
+                f = d ^ (b & (c ^ d));
+            }else if (F == 2){
+                f = (b & c) | (d & (b | c));
+            }else{
+                f = b ^ c ^ d;
+            }
+            const V temp = MULTIBUFFERSHA1_ROTATE_LEFT(a, 5) + f + e + k + w[t & 15];
+            e = d;
+            d = c;
+            c = MULTIBUFFERSHA1_ROTATE_LEFT(b, 30);
+            b = a;
+            a = temp;
+        }
+    }
+
+    // applies the compression function to one block of every lane
+    template<typename V>
+    MULTIBUFFERSHA1_INLINE void compressLanes(V (&state)[5], V (&w)[16]){
+        V a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        compressStage<V, 0>(a, b, c, d, e, w, 0, K0);
+        compressStage<V, 1>(a, b, c, d, e, w, 20, K1);
+        compressStage<V, 2>(a, b, c, d, e, w, 40, K2);
+        compressStage<V, 3>(a, b, c, d, e, w, 60, K3);
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+    }
+
+    // lane access for the scalar and vector types
+    MULTIBUFFERSHA1_INLINE uint32_t getLane(const uint32_t& value, const size_t){ return value; }
+    template<typename V>
+    MULTIBUFFERSHA1_INLINE uint32_t getLane(const V& value, const size_t lane){ return value[lane]; }
+
+    // hashes up to LANES messages, one per lane
+    //   lanes whose message is shorter than the longest one hash dummy blocks once done,
+    //   so that their digest is taken right after their own last block
+    template<typename V, size_t LANES>
+    MULTIBUFFERSHA1_INLINE void hashLanes(const MultiBufferSHA1::Message* pMessages, const size_t count, byte (*pDigests)[MultiBufferSHA1::DIGEST_LENGTH]){
+        size_t blockCounts[LANES];
+        size_t maxBlockCount = 0;
+        for (size_t lane = 0; lane < LANES; ++lane){
+            blockCounts[lane] = (lane < count) ? getBlockCount(pMessages[lane]) : 0;
+            if (blockCounts[lane] > maxBlockCount){
+                maxBlockCount = blockCounts[lane];
+            }
+        }
+
+        V state[5];
+        for (int i = 0; i < 5; ++i){
+            state[i] = V() + INITIAL_STATE[i];
+        }
+
+        uint32_t words[16][LANES];
+        byte block[BLOCK_LENGTH];
+        for (size_t blockIndex = 0; blockIndex < maxBlockCount; ++blockIndex){
+            // transpose one block of every lane into message schedule words
+            for (size_t lane = 0; lane < LANES; ++lane){
+                if (blockIndex < blockCounts[lane]){
+                    getBlock(pMessages[lane], blockIndex, block);
+                    for (size_t j = 0; j < 16; ++j){
+                        words[j][lane] = loadBigEndian(block + 4 * j);
+                    }
+                }else{
+                    for (size_t j = 0; j < 16; ++j){
+                        words[j][lane] = 0;
+                    }
+                }
+            }
+            V w[16];
+            std::memcpy(w, words, sizeof(w));
+
+            compressLanes<V>(state, w);
+
+            // collect the digests of lanes that just finished
+            for (size_t lane = 0; lane < count && lane < LANES; ++lane){
+                if (blockIndex + 1 == blockCounts[lane]){
+                    for (int i = 0; i < 5; ++i){
+                        storeBigEndian(pDigests[lane] + 4 * i, getLane(state[i], lane));
+                    }
+                }
+            }
+        }
+    }
+
+    // per-implementation entry points; each hashes up to getLaneCount() messages
+    typedef void (*HashFunction)(const MultiBufferSHA1::Message*, const size_t, byte (*)[MultiBufferSHA1::DIGEST_LENGTH]);
+
+    void hashScalar(const MultiBufferSHA1::Message* pMessages, const size_t count, byte (*pDigests)[MultiBufferSHA1::DIGEST_LENGTH]){
+        hashLanes<uint32_t, 1>(pMessages, count, pDigests);
+    }
+
+#if defined(MULTIBUFFERSHA1_VECTOR_LANES)
+    typedef uint32_t Lanes4 __attribute__((vector_size(16)));
+    typedef uint32_t Lanes8 __attribute__((vector_size(32)));
+    typedef uint32_t Lanes16 __attribute__((vector_size(64)));
+
+    MULTIBUFFERSHA1_TARGET("sse2") void hashSSE2(const MultiBufferSHA1::Message* pMessages, const size_t count, byte (*pDigests)[MultiBufferSHA1::DIGEST_LENGTH]){
+        hashLanes<Lanes4, 4>(pMessages, count, pDigests);
+    }
+    MULTIBUFFERSHA1_TARGET("avx2") void hashAVX2(const MultiBufferSHA1::Message* pMessages, const size_t count, byte (*pDigests)[MultiBufferSHA1::DIGEST_LENGTH]){
+        hashLanes<Lanes8, 8>(pMessages, count, pDigests);
+    }
+    MULTIBUFFERSHA1_TARGET("avx512f") void hashAVX512(const MultiBufferSHA1::Message* pMessages, const size_t count, byte (*pDigests)[MultiBufferSHA1::DIGEST_LENGTH]){
+        hashLanes<Lanes16, 16>(pMessages, count, pDigests);
+    }
+#endif
+
+    //------------------------------------------------------------------
+    // SHA extension implementation: four rounds per instruction, one message at a time
+
+#if defined(CPUFEATURES_X86)
+    // four-round group G (0-19) of the compression function
+    //   e[G % 2] carries E into the group, e[(G + 1) % 2] saves ABCD for the next group;
+    //   msg[G % 4] holds the group's message words, later groups' words are expanded as they become available
+    template<int G>
+    MULTIBUFFERSHA1_TARGET("sha,ssse3,sse4.1") MULTIBUFFERSHA1_INLINE void shaGroup(__m128i& abcd, __m128i (&e)[2], __m128i (&msg)[4]){
+        if (G == 0){
+            e[0] = _mm_add_epi32(e[0], msg[0]);
+        }else{
+            e[G % 2] = _mm_sha1nexte_epu32(e[G % 2], msg[G % 4]);
+        }
+        e[(G + 1) % 2] = abcd;
+        if (G >= 3 && G <= 18){
+            msg[(G + 1) % 4] = _mm_sha1msg2_epu32(msg[(G + 1) % 4], msg[G % 4]);
+        }
+        abcd = _mm_sha1rnds4_epu32(abcd, e[G % 2], G / 5);
+        if (G >= 1 && G <= 16){
+            msg[(G + 3) % 4] = _mm_sha1msg1_epu32(msg[(G + 3) % 4], msg[G % 4]);
+        }
+        if (G >= 2 && G <= 17){
+            msg[(G + 2) % 4] = _mm_xor_si128(msg[(G + 2) % 4], msg[G % 4]);
+        }
+    }
+
+    MULTIBUFFERSHA1_TARGET("sha,ssse3,sse4.1") void compressSHA(__m128i& abcd, __m128i& e0, const byte* pBlock){
+        const __m128i byteSwap = _mm_set_epi64x(0x0001020304050607LL, 0x08090A0B0C0D0E0FLL);
+        const __m128i abcdSave = abcd;
+        const __m128i e0Save = e0;
+
+        __m128i msg[4];
+        for (int i = 0; i < 4; ++i){
+            msg[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pBlock + 16 * i)), byteSwap);
+        }
+        __m128i e[2] = { e0, _mm_setzero_si128() };
+
+        shaGroup<0>(abcd, e, msg);  shaGroup<1>(abcd, e, msg);  shaGroup<2>(abcd, e, msg);  shaGroup<3>(abcd, e, msg);
+        shaGroup<4>(abcd, e, msg);  shaGroup<5>(abcd, e, msg);  shaGroup<6>(abcd, e, msg);  shaGroup<7>(abcd, e, msg);
+        shaGroup<8>(abcd, e, msg);  shaGroup<9>(abcd, e, msg);  shaGroup<10>(abcd, e, msg); shaGroup<11>(abcd, e, msg);
+        shaGroup<12>(abcd, e, msg); shaGroup<13>(abcd, e, msg); shaGroup<14>(abcd, e, msg); shaGroup<15>(abcd, e, msg);
+        shaGroup<16>(abcd, e, msg); shaGroup<17>(abcd, e, msg); shaGroup<18>(abcd, e, msg); shaGroup<19>(abcd, e, msg);
+
+        // group 19 saved the ABCD it started from in e[0]; its A rotated is the new E
+        e0 = _mm_sha1nexte_epu32(e[0], e0Save);
+        abcd = _mm_add_epi32(abcd, abcdSave);
+    }
+
+    MULTIBUFFERSHA1_TARGET("sha,ssse3,sse4.1") void hashSHA(const MultiBufferSHA1::Message* pMessages, const size_t count, byte (*pDigests)[MultiBufferSHA1::DIGEST_LENGTH]){
+        byte block[BLOCK_LENGTH];
+        for (size_t i = 0; i < count; ++i){
+            const MultiBufferSHA1::Message& message = pMessages[i];
+
+            // state as A B C D (high to low) and E in the top word
+            __m128i abcd = _mm_set_epi32(static_cast<int>(INITIAL_STATE[0]), static_cast<int>(INITIAL_STATE[1]),
+                                         static_cast<int>(INITIAL_STATE[2]), static_cast<int>(INITIAL_STATE[3]));
+            __m128i e0 = _mm_set_epi32(static_cast<int>(INITIAL_STATE[4]), 0, 0, 0);
+
+            const size_t blockCount = getBlockCount(message);
+            for (size_t blockIndex = 0; blockIndex < blockCount; ++blockIndex){
+                // whole blocks of part 1 are hashed in place
+                if ((blockIndex + 1) * BLOCK_LENGTH <= message.m_part1Length){
+                    compressSHA(abcd, e0, message.m_pPart1 + blockIndex * BLOCK_LENGTH);
+                }else{
+                    getBlock(message, blockIndex, block);
+                    compressSHA(abcd, e0, block);
+                }
+            }
+
+            storeBigEndian(pDigests[i], static_cast<uint32_t>(_mm_extract_epi32(abcd, 3)));
+            storeBigEndian(pDigests[i] + 4, static_cast<uint32_t>(_mm_extract_epi32(abcd, 2)));
+            storeBigEndian(pDigests[i] + 8, static_cast<uint32_t>(_mm_extract_epi32(abcd, 1)));
+            storeBigEndian(pDigests[i] + 12, static_cast<uint32_t>(_mm_extract_epi32(abcd, 0)));
+            storeBigEndian(pDigests[i] + 16, static_cast<uint32_t>(_mm_extract_epi32(e0, 3)));
+        }
+    }
+#endif
+
+    // returns the entry point of the given implementation
+    HashFunction getHashFunction(const MultiBufferSHA1::Implementation implementation){
+        switch (implementation){
+#if defined(MULTIBUFFERSHA1_VECTOR_LANES)
+            case MultiBufferSHA1::IMPLEMENTATION_SSE2:
+                return hashSSE2;
+            case MultiBufferSHA1::IMPLEMENTATION_AVX2:
+                return hashAVX2;
+            case MultiBufferSHA1::IMPLEMENTATION_AVX512:
+                return hashAVX512;
+#endif
+#if defined(CPUFEATURES_X86)
+            case MultiBufferSHA1::IMPLEMENTATION_SHA:
+                return hashSHA;
+#endif
+            default:
+                return hashScalar;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   hashes count messages with the fastest implementation supported by this CPU
+void MultiBufferSHA1::hash(const Message* pMessages, const size_t count, byte (*pDigests)[DIGEST_LENGTH]){
+    hash(getBestImplementation(), pMessages, count, pDigests);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   hashes count messages with the given implementation
+void MultiBufferSHA1::hash(const Implementation implementation, const Message* pMessages, const size_t count, byte (*pDigests)[DIGEST_LENGTH]){
+    const HashFunction hashFunction = getHashFunction(implementation);
+    const size_t laneCount = getLaneCount(implementation);
+    for (size_t first = 0; first < count; first += laneCount){
+        const size_t groupCount = ((count - first) < laneCount) ? (count - first) : laneCount;
+        hashFunction(pMessages + first, groupCount, pDigests + first);
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns true if the given implementation can run on this CPU
+bool MultiBufferSHA1::isSupported(const Implementation implementation){
+    switch (implementation){
+        case IMPLEMENTATION_SCALAR:
+            return true;
+#if defined(MULTIBUFFERSHA1_VECTOR_LANES)
+        case IMPLEMENTATION_SSE2:
+            return CpuFeatures::hasSSE2();
+        case IMPLEMENTATION_AVX2:
+            return CpuFeatures::hasAVX2();
+        case IMPLEMENTATION_AVX512:
+            return CpuFeatures::hasAVX512F();
+#endif
+#if defined(CPUFEATURES_X86)
+        case IMPLEMENTATION_SHA:
+            return CpuFeatures::hasSHA();
+#endif
+        default:
+            return false;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns the fastest implementation supported by this CPU
+MultiBufferSHA1::Implementation MultiBufferSHA1::getBestImplementation(){
+    static const Implementation bestImplementation = detectBestImplementation();
+    return bestImplementation;
+}
+
+//----------------------------------------------------------------------
+// PRIVATE STATIC
+//   probes the CPU for the fastest supported implementation
+MultiBufferSHA1::Implementation MultiBufferSHA1::detectBestImplementation(){
+    // 16 and 8 lanes outrun the SHA extensions on short messages; SSE2 lanes do not
+    const Implementation preferenceOrder[] = { IMPLEMENTATION_AVX512, IMPLEMENTATION_AVX2, IMPLEMENTATION_SHA, IMPLEMENTATION_SSE2 };
+    for (size_t i = 0; i < sizeof(preferenceOrder) / sizeof(preferenceOrder[0]); ++i){
+        if (isSupported(preferenceOrder[i]) == true){
+            return preferenceOrder[i];
+        }
+    }
+    return IMPLEMENTATION_SCALAR;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns the number of messages the given implementation hashes per step
+size_t MultiBufferSHA1::getLaneCount(const Implementation implementation){
+    switch (implementation){
+        case IMPLEMENTATION_SSE2:
+            return 4;
+        case IMPLEMENTATION_AVX2:
+            return 8;
+        case IMPLEMENTATION_AVX512:
+            return 16;
+        default:
+            return 1;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns a printable name for the given implementation
+const char* MultiBufferSHA1::getImplementationName(const Implementation implementation){
+    switch (implementation){
+        case IMPLEMENTATION_SCALAR:
+            return "scalar";
+        case IMPLEMENTATION_SSE2:
+            return "sse2";
+        case IMPLEMENTATION_AVX2:
+            return "avx2";
+        case IMPLEMENTATION_AVX512:
+            return "avx512";
+        case IMPLEMENTATION_SHA:
+            return "sha-ni";
+        default:
+            return "unknown";
+    }
+}
+
+//----------------------------------------------------------------------
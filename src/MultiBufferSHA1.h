@@ -0,0 +1,91 @@
+//----------------------------------------------------------------------
+// MultiBufferSHA1 - SHA-1 of many short, independent messages at once,
+//                   with SIMD and SHA extension code paths selected at
+//                   run time.
+//
+// The SIMD implementations hash one message per 32-bit lane (4 with
+// SSE2, 8 with AVX2, 16 with AVX-512), so a group of key gen results is
+// hashed in the time of one.  The SHA extension implementation hashes
+// one message at a time in hardware.  Every message is the concatenation
+// of two parts (key blob and challenge key) so that callers need not
+// copy them together first.
+//----------------------------------------------------------------------
+
+#ifndef MultiBufferSHA1H_Included
+#define MultiBufferSHA1H_Included
+
+//----------------------------------------------------------------------
+
+class MultiBufferSHA1;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class MultiBufferSHA1{
+    public:
+        // length of a SHA-1 digest in bytes
+        const static size_t DIGEST_LENGTH = 20;
+
+        // largest number of lanes of any implementation
+        const static size_t MAX_LANES = 16;
+
+        // hashing implementations
+        enum Implementation{
+            IMPLEMENTATION_SCALAR = 0,    // one message at a time
+            IMPLEMENTATION_SSE2,          // 4 messages per step
+            IMPLEMENTATION_AVX2,          // 8 messages per step
+            IMPLEMENTATION_AVX512,        // 16 messages per step
+            IMPLEMENTATION_SHA,           // one message at a time with the SHA extensions
+            IMPLEMENTATION_COUNT
+        };
+
+        // one message: part 1 followed by part 2 (either part may be empty)
+        class Message{
+            public:
+                const byte* m_pPart1;
+                size_t m_part1Length;
+                const byte* m_pPart2;
+                size_t m_part2Length;
+        };
+
+        // hashes count messages, writing the digest of pMessages[i] to pDigests[i]
+        //   uses the fastest implementation supported by this CPU
+        static void hash(const Message* pMessages, const size_t count, byte (*pDigests)[DIGEST_LENGTH]);
+
+        // as above, using the given implementation (must be supported by this CPU)
+        static void hash(const Implementation implementation, const Message* pMessages, const size_t count, byte (*pDigests)[DIGEST_LENGTH]);
+
+
+        // returns true if the given implementation can run on this CPU (and was compiled in)
+        static bool isSupported(const Implementation implementation);
+
+        // returns the fastest implementation supported by this CPU
+        static Implementation getBestImplementation();
+
+        // returns the number of messages the given implementation hashes per step
+        static size_t getLaneCount(const Implementation implementation);
+
+        // returns a printable name for the given implementation
+        static const char* getImplementationName(const Implementation implementation);
+
+    private:
+        // prevent copying and assignment
+        MultiBufferSHA1(const MultiBufferSHA1& src);
+        MultiBufferSHA1 operator=(const MultiBufferSHA1& rhs);
+
+        // prevent construction
+        MultiBufferSHA1();
+
+        // probes the CPU for the fastest supported implementation
+        static Implementation detectBestImplementation();
+};
+
+//----------------------------------------------------------------------
+
+#endif
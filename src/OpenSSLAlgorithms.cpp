@@ -0,0 +1,67 @@
+//----------------------------------------------------------------------
+// See OpenSSLAlgorithms.h
+//----------------------------------------------------------------------
+
+#include "OpenSSLAlgorithms.h"
+
+//----------------------------------------------------------------------
+
+#if defined(CKY_OPENSSL3_BACKEND)
+#include <memory> // unique_ptr
+
+namespace{
+    // frees a thread's RSA key import context when the thread exits
+    struct PkeyContextDeleter{
+        void operator()(EVP_PKEY_CTX* pContext) const { EVP_PKEY_CTX_free(pContext); }
+    };
+
+    // creates an RSA key import context bound to the fetched RSA key management
+    EVP_PKEY_CTX* createRSAFromDataContext(){
+        EVP_PKEY_CTX* pContext = EVP_PKEY_CTX_new_from_name(nullptr, "RSA", nullptr);
+        if (pContext != nullptr && EVP_PKEY_fromdata_init(pContext) != 1){
+            EVP_PKEY_CTX_free(pContext);
+            pContext = nullptr;
+        }
+        return pContext;
+    }
+}
+#endif
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns the SHA-1 digest implementation, or nullptr if it is unavailable
+const EVP_MD* OpenSSLAlgorithms::getSHA1(){
+#if defined(CKY_OPENSSL3_BACKEND)
+    // fetched once and never freed (worker threads may outlive main's statics)
+    static const EVP_MD* const sha1 = EVP_MD_fetch(nullptr, "SHA1", nullptr);
+    return sha1;
+#else
+    return EVP_sha1();
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns the SHA-256 digest implementation, or nullptr if it is unavailable
+const EVP_MD* OpenSSLAlgorithms::getSHA256(){
+#if defined(CKY_OPENSSL3_BACKEND)
+    // fetched once and never freed (worker threads may outlive main's statics)
+    static const EVP_MD* const sha256 = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    return sha256;
+#else
+    return EVP_sha256();
+#endif
+}
+
+#if defined(CKY_OPENSSL3_BACKEND)
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   returns the calling thread's RSA key import context, or nullptr on failure
+EVP_PKEY_CTX* OpenSSLAlgorithms::getRSAFromDataContext(){
+    // an EVP_PKEY_CTX may not be shared between threads, so each thread keeps its own
+    static thread_local std::unique_ptr<EVP_PKEY_CTX, PkeyContextDeleter> pContext(createRSAFromDataContext());
+    return pContext.get();
+}
+#endif
+
+//----------------------------------------------------------------------
@@ -0,0 +1,52 @@
+//----------------------------------------------------------------------
+// OpenSSLAlgorithms - Process-wide handles of the OpenSSL algorithms
+//                     used for verification, resolved once.
+//
+// With the OpenSSL 3 backend (CKY_OPENSSL3_BACKEND) the implementations
+// are fetched from the default provider on first use, so that later
+// calls skip the per-operation provider lookup of EVP_sha1() and of the
+// RSA key management.  With the legacy backend the built-in method
+// tables are returned.
+//----------------------------------------------------------------------
+
+#ifndef OpenSSLAlgorithmsH_Included
+#define OpenSSLAlgorithmsH_Included
+
+//----------------------------------------------------------------------
+
+class OpenSSLAlgorithms;
+
+//----------------------------------------------------------------------
+
+#include <openssl/evp.h>
+
+//----------------------------------------------------------------------
+
+class OpenSSLAlgorithms{
+    public:
+        // returns the SHA-1 digest implementation, or nullptr if it is unavailable
+        //   thread safe; the handle stays valid for the lifetime of the process
+        static const EVP_MD* getSHA1();
+
+        // returns the SHA-256 digest implementation, or nullptr if it is unavailable
+        //   thread safe; the handle stays valid for the lifetime of the process
+        static const EVP_MD* getSHA256();
+
+#if defined(CKY_OPENSSL3_BACKEND)
+        // returns the calling thread's RSA key import context (EVP_PKEY_fromdata_init done), or nullptr on failure
+        //   created on first use in each thread and freed when the thread exits; do not free
+        static EVP_PKEY_CTX* getRSAFromDataContext();
+#endif
+
+    private:
+        // prevent copying and assignment
+        OpenSSLAlgorithms(const OpenSSLAlgorithms& src);
+        OpenSSLAlgorithms operator=(const OpenSSLAlgorithms& rhs);
+
+        // prevent construction
+        OpenSSLAlgorithms();
+};
+
+//----------------------------------------------------------------------
+
+#endif
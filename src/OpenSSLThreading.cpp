@@ -0,0 +1,71 @@
+//----------------------------------------------------------------------
+// See OpenSSLThreading.h
+//----------------------------------------------------------------------
+
+#include "OpenSSLThreading.h"
+
+//----------------------------------------------------------------------
+
+#include <mutex>
+#include <thread>
+#include <functional> // std::hash
+
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+
+//----------------------------------------------------------------------
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+
+namespace{
+    // one mutex per OpenSSL lock - allocated once, never freed (worker threads may outlive main's statics)
+    std::mutex* g_opensslLocks = nullptr;
+
+    // guards one-time installation of the callbacks
+    std::once_flag g_initializeOnce;
+
+    // OpenSSL 1.0.x locking callback
+    void lockingCallback(int mode, int n, const char* file, int line){
+        (void)file;
+        (void)line;
+        if ((mode & CRYPTO_LOCK) != 0){
+            g_opensslLocks[n].lock();
+        }else{
+            g_opensslLocks[n].unlock();
+        }
+    }
+
+    // OpenSSL 1.0.x thread id callback
+    void threadIdCallback(CRYPTO_THREADID* id){
+        CRYPTO_THREADID_set_numeric(id, static_cast<unsigned long>(std::hash<std::thread::id>()(std::this_thread::get_id())));
+    }
+
+    // installs the callbacks (called exactly once)
+    void installCallbacks(){
+        g_opensslLocks = new std::mutex[CRYPTO_num_locks()];
+        CRYPTO_THREADID_set_callback(threadIdCallback);
+        CRYPTO_set_locking_callback(lockingCallback);
+    }
+}
+
+#endif
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   installs the locking and thread id callbacks required by OpenSSL 1.0.x
+void OpenSSLThreading::initialize(){
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    std::call_once(g_initializeOnce, installCallbacks);
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+//   releases the per-thread OpenSSL state (error queue) of the calling thread
+void OpenSSLThreading::cleanupThread(){
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    ERR_remove_thread_state(nullptr);
+#endif
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,37 @@
+//----------------------------------------------------------------------
+// Defines helper functions that make OpenSSL safe to use from several
+// threads at once.
+//----------------------------------------------------------------------
+
+#ifndef OpenSSLThreadingH_Included
+#define OpenSSLThreadingH_Included
+
+//----------------------------------------------------------------------
+
+class OpenSSLThreading;
+
+//----------------------------------------------------------------------
+
+class OpenSSLThreading{
+    public:
+        // installs the locking and thread id callbacks required by OpenSSL 1.0.x
+        //   safe to call more than once; a no-op on OpenSSL 1.1.0 and later
+        //   must be called before the first worker thread is started
+        static void initialize();
+
+        // releases the per-thread OpenSSL state (error queue) of the calling thread
+        //   called by each worker thread before it exits
+        static void cleanupThread();
+
+    private:
+        // prevent copying and assignment
+        OpenSSLThreading(const OpenSSLThreading& src);
+        OpenSSLThreading operator=(const OpenSSLThreading& rhs);
+
+        // prevent construction
+        OpenSSLThreading();
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,550 @@
+//----------------------------------------------------------------------
+// See ResultCache.h
+//----------------------------------------------------------------------
+
+#include "ResultCache.h"
+
+//----------------------------------------------------------------------
+
+#include "CRC32C.h"
+#include "Metrics.h"
+
+#include <chrono>
+#include <cstring>    // memcmp, memcpy
+#include <ctime>
+#include <iterator>   // prev
+#include <list>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <unordered_map>
+#include <utility>    // pair
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #define RESULTCACHE_MMAP
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    const char CACHE_MAGIC[8] = { 'C', 'K', 'Y', 'R', 'C', 'A', 'C', '1' };
+    const uint32_t CACHE_VERSION = 1;
+    const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    // time a slot must stay odd at one version before it is taken for the remains of a crashed writer
+    //   (a live writer holds a slot for a copy of at most one slot)
+    const std::chrono::milliseconds INTERRUPTED_WRITE_GRACE(50);
+
+    // persistent file header, padded to a slot so that slots never straddle a page
+    struct PersistentHeader{
+        char m_magic[8];                      // CACHE_MAGIC
+        uint32_t m_version;                   // CACHE_VERSION
+        uint32_t m_headerLength;              // sizeof(PersistentHeader)
+        uint32_t m_byteOrderMark;             // BYTE_ORDER_MARK in the writer's byte order
+        uint32_t m_slotLength;                // sizeof(PersistentSlot)
+        uint64_t m_slotCount;                 // a power of two, at least 2
+        uint64_t m_secret[2];                 // SipHash key of every process sharing the file
+        byte m_reserved[ResultCache::PERSISTENT_SLOT_LENGTH - 48];
+    };
+
+    // one persistent slot; empty while m_version is 0
+    struct PersistentSlot{
+        uint64_t m_version;                   // odd while being written
+        uint64_t m_key[2];
+        uint32_t m_payloadLength;
+        uint32_t m_checksum;                  // CRC-32C of the key and payload
+        uint32_t m_storedTime;                // low 32 bits of the Unix time of the write (expiry; picks the slot to replace)
+        uint32_t m_reserved;
+        byte m_payload[ResultCache::MAX_PERSISTENT_PAYLOAD];
+    };
+
+    static_assert(sizeof(PersistentHeader) == ResultCache::PERSISTENT_SLOT_LENGTH, "persistent header layout");
+    static_assert(sizeof(PersistentSlot) == ResultCache::PERSISTENT_SLOT_LENGTH, "persistent slot layout");
+
+    // SipHash-2-4 with a 128-bit digest, over data supplied in pieces
+    class SipHash128{
+        protected:
+            uint64_t m_v0, m_v1, m_v2, m_v3;
+            uint64_t m_tail;                  // bytes not yet forming a whole word
+            size_t m_tailLength;
+            uint64_t m_totalLength;
+
+            static uint64_t rotateLeft(const uint64_t value, const unsigned bits){ return (value << bits) | (value >> (64 - bits)); }
+
+            void round(){
+                this->m_v0 += this->m_v1; this->m_v1 = rotateLeft(this->m_v1, 13); this->m_v1 ^= this->m_v0; this->m_v0 = rotateLeft(this->m_v0, 32);
+                this->m_v2 += this->m_v3; this->m_v3 = rotateLeft(this->m_v3, 16); this->m_v3 ^= this->m_v2;
+                this->m_v0 += this->m_v3; this->m_v3 = rotateLeft(this->m_v3, 21); this->m_v3 ^= this->m_v0;
+                this->m_v2 += this->m_v1; this->m_v1 = rotateLeft(this->m_v1, 17); this->m_v1 ^= this->m_v2; this->m_v2 = rotateLeft(this->m_v2, 32);
+            }
+
+            void compress(const uint64_t word){
+                this->m_v3 ^= word;
+                this->round();
+                this->round();
+                this->m_v0 ^= word;
+            }
+
+        public:
+            explicit SipHash128(const uint64_t* pSecret) : m_v0(pSecret[0] ^ 0x736f6d6570736575ULL),
+                                                           m_v1(pSecret[1] ^ 0x646f72616e646f6dULL ^ 0xee),
+                                                           m_v2(pSecret[0] ^ 0x6c7967656e657261ULL),
+                                                           m_v3(pSecret[1] ^ 0x7465646279746573ULL),
+                                                           m_tail(0),
+                                                           m_tailLength(0),
+                                                           m_totalLength(0) {}
+
+            void update(const byte* pData, size_t length){
+                this->m_totalLength += length;
+                while (length > 0 && this->m_tailLength > 0){
+                    this->m_tail |= static_cast<uint64_t>(*pData++) << (8 * this->m_tailLength);
+                    --length;
+                    if (++this->m_tailLength == 8){
+                        this->compress(this->m_tail);
+                        this->m_tail = 0;
+                        this->m_tailLength = 0;
+                    }
+                }
+                // words are read in host byte order; digests are only compared on the same byte order
+                for (; length >= 8; pData += 8, length -= 8){
+                    uint64_t word;
+                    std::memcpy(&word, pData, sizeof(word));
+                    this->compress(word);
+                }
+                for (; length > 0; --length){
+                    this->m_tail |= static_cast<uint64_t>(*pData++) << (8 * this->m_tailLength);
+                    ++this->m_tailLength;
+                }
+            }
+
+            void finish(uint64_t* pDigest){
+                this->compress(this->m_tail | (this->m_totalLength << 56));
+                this->m_v2 ^= 0xee;
+                for (int i = 0; i < 4; ++i){
+                    this->round();
+                }
+                pDigest[0] = this->m_v0 ^ this->m_v1 ^ this->m_v2 ^ this->m_v3;
+                this->m_v1 ^= 0xdd;
+                for (int i = 0; i < 4; ++i){
+                    this->round();
+                }
+                pDigest[1] = this->m_v0 ^ this->m_v1 ^ this->m_v2 ^ this->m_v3;
+            }
+    };
+
+    // returns the checksum stored with a persistent entry
+    uint32_t computeSlotChecksum(const uint64_t* pKey, const byte* pPayload, const size_t payloadLength){
+        const uint32_t keyChecksum = CRC32C::compute(reinterpret_cast<const byte*>(pKey), 2 * sizeof(uint64_t));
+        return CRC32C::compute(pPayload, payloadLength, keyChecksum);
+    }
+
+    // hashes keys for the shard maps (keys are already uniformly distributed)
+    struct KeyHasher{
+        size_t operator()(const ResultCache::Key& key) const { return static_cast<size_t>(key.m_hash[0]); }
+    };
+}
+
+//----------------------------------------------------------------------
+// one memory shard: an LRU list and an index into it
+
+class ResultCache::Shard{
+    public:
+        // a cached response and the time it stops being served
+        class Entry{
+            public:
+                std::vector<byte> m_payload;
+                std::chrono::steady_clock::time_point m_expiry;
+        };
+
+        typedef std::list<std::pair<Key, Entry>> EntryList;
+
+        std::mutex m_mutex;
+        EntryList m_entries;                  // most recently used first
+        std::unordered_map<Key, EntryList::iterator, KeyHasher> m_index;
+        size_t m_capacity;                    // most entries held
+
+        Shard() : m_capacity(1) {}
+};
+
+//----------------------------------------------------------------------
+// the persistent file
+
+#if defined(RESULTCACHE_MMAP)
+
+class ResultCache::PersistentTier{
+    private:
+        // prevent copying and assignment
+        PersistentTier(const PersistentTier& src);
+        PersistentTier operator=(const PersistentTier& rhs);
+
+    protected:
+        void* m_pData;                        // whole file
+        size_t m_size;                        // byte length of the file
+        PersistentHeader* m_pHeader;
+        PersistentSlot* m_pSlots;
+        uint64_t m_slotCount;
+
+        // resets the slots left odd by writers that died mid-write, which would otherwise never be read or written again
+        //   a slot counts as abandoned if its version is still the same odd value after INTERRUPTED_WRITE_GRACE;
+        //   it is emptied while still odd and then given the next (even) version, so it is replaced first
+        void recoverInterruptedWrites(){
+            std::vector<std::pair<uint64_t, uint64_t>> oddSlots;      // slot index, version
+            for (uint64_t i = 0; i < this->m_slotCount; ++i){
+                const uint64_t version = __atomic_load_n(&this->m_pSlots[i].m_version, __ATOMIC_RELAXED);
+                if ((version & 1) != 0){
+                    oddSlots.push_back(std::make_pair(i, version));
+                }
+            }
+            if (oddSlots.empty() == true){
+                return;
+            }
+            std::this_thread::sleep_for(INTERRUPTED_WRITE_GRACE);
+            for (size_t i = 0; i < oddSlots.size(); ++i){
+                PersistentSlot& slot = this->m_pSlots[oddSlots[i].first];
+                uint64_t version = oddSlots[i].second;
+                if (__atomic_load_n(&slot.m_version, __ATOMIC_ACQUIRE) != version){
+                    continue;
+                }
+                slot.m_key[0] = 0;
+                slot.m_key[1] = 0;
+                slot.m_payloadLength = 0;
+                slot.m_checksum = 0;
+                slot.m_storedTime = 0;
+                // another process recovering the same slot at once publishes the same version; either is fine
+                __atomic_compare_exchange_n(&slot.m_version, &version, version + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+            }
+        }
+
+        // creates a cache file with slotCount slots and a new secret, unless another process creates it first
+        //   the file is completed under a temporary name and then linked into place, which fails if it exists
+        static void createFile(const std::string& filepath, const uint64_t slotCount){
+            const std::string tempFilepath = filepath + ".tmp." + std::to_string(static_cast<long long>(getpid()));
+            const int fd = open(tempFilepath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+            if (fd < 0){
+                throw std::runtime_error("Unable to create result cache file '" + tempFilepath + "'.");
+            }
+            PersistentHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.m_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+            header.m_version = CACHE_VERSION;
+            header.m_headerLength = sizeof(PersistentHeader);
+            header.m_byteOrderMark = BYTE_ORDER_MARK;
+            header.m_slotLength = sizeof(PersistentSlot);
+            header.m_slotCount = slotCount;
+            std::random_device randomDevice;
+            for (size_t i = 0; i < 2; ++i){
+                header.m_secret[i] = (static_cast<uint64_t>(randomDevice()) << 32) ^ randomDevice();
+            }
+            const off_t size = static_cast<off_t>(sizeof(PersistentHeader) + slotCount * sizeof(PersistentSlot));
+            const bool written = (write(fd, &header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)) && ftruncate(fd, size) == 0);
+            close(fd);
+            if (written == false){
+                unlink(tempFilepath.c_str());
+                throw std::runtime_error("Unable to write result cache file '" + tempFilepath + "'.");
+            }
+            const int linkResult = link(tempFilepath.c_str(), filepath.c_str());
+            const int linkError = errno;
+            unlink(tempFilepath.c_str());
+            if (linkResult != 0 && linkError != EEXIST){
+                throw std::runtime_error("Unable to create result cache file '" + filepath + "'.");
+            }
+        }
+
+    public:
+        // maps the cache file, creating it with slotCount slots (rounded up to a power of two) if missing
+        //   throws std::runtime_error if the file cannot be created, opened or mapped, or is not a cache file
+        PersistentTier(const std::string& filepath, const size_t slotCount) : m_pData(MAP_FAILED), m_size(0), m_pHeader(nullptr), m_pSlots(nullptr), m_slotCount(0){
+            int fd = open(filepath.c_str(), O_RDWR | O_CLOEXEC);
+            if (fd < 0 && errno == ENOENT){
+                uint64_t roundedSlotCount = 2;
+                while (roundedSlotCount < slotCount){
+                    roundedSlotCount *= 2;
+                }
+                createFile(filepath, roundedSlotCount);
+                fd = open(filepath.c_str(), O_RDWR | O_CLOEXEC);
+            }
+            if (fd < 0){
+                throw std::runtime_error("Unable to open result cache file '" + filepath + "'.");
+            }
+            struct stat fileStatus;
+            if (fstat(fd, &fileStatus) != 0 || S_ISREG(fileStatus.st_mode) == 0 || static_cast<size_t>(fileStatus.st_size) < sizeof(PersistentHeader)){
+                close(fd);
+                throw std::runtime_error("File '" + filepath + "' is not a result cache file.");
+            }
+            this->m_size = static_cast<size_t>(fileStatus.st_size);
+            this->m_pData = mmap(nullptr, this->m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            // the mapping stays valid after the descriptor is closed
+            close(fd);
+            if (this->m_pData == MAP_FAILED){
+                throw std::runtime_error("Unable to map result cache file '" + filepath + "'.");
+            }
+            // lookups hit random slots - do not read ahead
+            madvise(this->m_pData, this->m_size, MADV_RANDOM);
+
+            this->m_pHeader = static_cast<PersistentHeader*>(this->m_pData);
+            this->m_pSlots = reinterpret_cast<PersistentSlot*>(static_cast<byte*>(this->m_pData) + sizeof(PersistentHeader));
+            const PersistentHeader& header = *this->m_pHeader;
+            this->m_slotCount = header.m_slotCount;
+            if (std::memcmp(header.m_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || header.m_version != CACHE_VERSION ||
+                header.m_headerLength != sizeof(PersistentHeader) || header.m_slotLength != sizeof(PersistentSlot) ||
+                header.m_byteOrderMark != BYTE_ORDER_MARK || this->m_slotCount < 2 || (this->m_slotCount & (this->m_slotCount - 1)) != 0 ||
+                this->m_slotCount > (this->m_size - sizeof(PersistentHeader)) / sizeof(PersistentSlot)){
+                munmap(this->m_pData, this->m_size);
+                throw std::runtime_error("File '" + filepath + "' is not a result cache file (or was written with a different byte order).");
+            }
+
+            this->recoverInterruptedWrites();
+        }
+
+        // destructor - unmaps the file (the kernel writes it back; a cache needs no sync)
+        ~PersistentTier(){
+            munmap(this->m_pData, this->m_size);
+        }
+
+        // returns the hash secret of the file
+        const uint64_t* getSecret() const { return this->m_pHeader->m_secret; }
+
+        // returns the first of the two slots of a key's bucket
+        PersistentSlot* getBucket(const Key& key) const {
+            return &this->m_pSlots[key.m_hash[0] & (this->m_slotCount - 1) & ~static_cast<uint64_t>(1)];
+        }
+
+        // copies the response stored for key less than ttlSeconds ago, if any, to payload; ageSeconds receives its age
+        bool tryGet(const Key& key, const uint32_t ttlSeconds, std::vector<byte>& payload, uint32_t& ageSeconds) const {
+            const uint32_t now = static_cast<uint32_t>(std::time(nullptr));
+            PersistentSlot* const pBucket = this->getBucket(key);
+            for (size_t way = 0; way < 2; ++way){
+                const PersistentSlot& slot = pBucket[way];
+                const uint64_t version = __atomic_load_n(&slot.m_version, __ATOMIC_ACQUIRE);
+                if (version == 0 || (version & 1) != 0 || slot.m_key[0] != key.m_hash[0] || slot.m_key[1] != key.m_hash[1]){
+                    continue;
+                }
+                const size_t payloadLength = slot.m_payloadLength;
+                const uint32_t checksum = slot.m_checksum;
+                // stored times are the low 32 bits of the Unix time, so the age is their wrapping difference
+                const int32_t age = static_cast<int32_t>(now - slot.m_storedTime);
+                if (payloadLength > MAX_PERSISTENT_PAYLOAD || age < 0 || static_cast<uint32_t>(age) >= ttlSeconds){
+                    continue;
+                }
+                payload.assign(slot.m_payload, slot.m_payload + payloadLength);
+                // the copy only counts if no writer started on the slot meanwhile
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&slot.m_version, __ATOMIC_RELAXED) != version ||
+                    computeSlotChecksum(key.m_hash, payload.data(), payload.size()) != checksum){
+                    continue;
+                }
+                ageSeconds = static_cast<uint32_t>(age);
+                return true;
+            }
+            return false;
+        }
+
+        // stores a response in the bucket of key: over its earlier entry, in an empty slot or over the older entry
+        //   a response too long for a slot is skipped; so is one whose slot is being written by another process,
+        //   unless the other slot of the bucket is free to take it
+        void put(const Key& key, const std::vector<byte>& payload){
+            if (payload.size() > MAX_PERSISTENT_PAYLOAD){
+                return;
+            }
+            PersistentSlot* const pBucket = this->getBucket(key);
+            PersistentSlot* pSlot = nullptr;
+            for (size_t way = 0; way < 2 && pSlot == nullptr; ++way){
+                if (pBucket[way].m_key[0] == key.m_hash[0] && pBucket[way].m_key[1] == key.m_hash[1]){
+                    pSlot = &pBucket[way];
+                }
+            }
+            if (pSlot == nullptr){
+                pSlot = (__atomic_load_n(&pBucket[0].m_version, __ATOMIC_RELAXED) == 0 ||
+                         (__atomic_load_n(&pBucket[1].m_version, __ATOMIC_RELAXED) != 0 &&
+                          static_cast<int32_t>(pBucket[0].m_storedTime - pBucket[1].m_storedTime) <= 0)) ? &pBucket[0] : &pBucket[1];
+            }
+
+            uint64_t version = __atomic_load_n(&pSlot->m_version, __ATOMIC_RELAXED);
+            if ((version & 1) != 0){
+                // the slot is being written (or was left odd by a crashed writer) - try the other one
+                pSlot = (pSlot == &pBucket[0]) ? &pBucket[1] : &pBucket[0];
+                version = __atomic_load_n(&pSlot->m_version, __ATOMIC_RELAXED);
+            }
+            if ((version & 1) != 0 ||
+                __atomic_compare_exchange_n(&pSlot->m_version, &version, version + 1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == false){
+                return;
+            }
+            pSlot->m_key[0] = key.m_hash[0];
+            pSlot->m_key[1] = key.m_hash[1];
+            pSlot->m_payloadLength = static_cast<uint32_t>(payload.size());
+            pSlot->m_checksum = computeSlotChecksum(key.m_hash, payload.data(), payload.size());
+            pSlot->m_storedTime = static_cast<uint32_t>(std::time(nullptr));
+            if (payload.empty() == false){
+                std::memcpy(pSlot->m_payload, payload.data(), payload.size());
+            }
+            __atomic_store_n(&pSlot->m_version, version + 2, __ATOMIC_RELEASE);
+        }
+};
+
+#else
+
+class ResultCache::PersistentTier{
+    public:
+        PersistentTier(const std::string& filepath, const size_t slotCount){
+            (void)filepath;
+            (void)slotCount;
+            throw std::runtime_error("The persistent result cache is only supported on POSIX systems.");
+        }
+
+        const uint64_t* getSecret() const { return nullptr; }
+        bool tryGet(const Key&, const uint32_t, std::vector<byte>&, uint32_t&) const { return false; }
+        void put(const Key&, const std::vector<byte>&) {}
+};
+
+#endif
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor
+//   throws std::runtime_error if the persistent file cannot be created, opened or mapped
+ResultCache::ResultCache(const size_t capacity, const std::string& persistentFilepath, const uint32_t ttlSeconds) : m_ttlSeconds(ttlSeconds),
+                                                                                                                  m_pShards(new Shard[SHARD_COUNT]){
+    if (this->m_ttlSeconds == 0){
+        this->m_ttlSeconds = DEFAULT_TTL_SECONDS;
+    }
+    for (size_t i = 0; i < SHARD_COUNT; ++i){
+        this->m_pShards[i].m_capacity = (capacity + SHARD_COUNT - 1) / SHARD_COUNT;
+        if (this->m_pShards[i].m_capacity == 0){
+            this->m_pShards[i].m_capacity = 1;
+        }
+    }
+    for (size_t i = 0; i < LOOKUP_COUNT; ++i){
+        this->m_lookups[i].store(0, std::memory_order_relaxed);
+    }
+
+    // processes sharing a persistent file must hash alike, so its secret is used; otherwise a fresh one
+    if (persistentFilepath.empty() == false){
+        // the file outlives this process and may serve several; it is not made smaller than the default
+        this->m_pPersistent.reset(new PersistentTier(persistentFilepath, (capacity > DEFAULT_CAPACITY) ? capacity : static_cast<size_t>(DEFAULT_CAPACITY)));
+        this->m_secret[0] = this->m_pPersistent->getSecret()[0];
+        this->m_secret[1] = this->m_pPersistent->getSecret()[1];
+    }else{
+        std::random_device randomDevice;
+        for (size_t i = 0; i < 2; ++i){
+            this->m_secret[i] = (static_cast<uint64_t>(randomDevice()) << 32) ^ randomDevice();
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - unmaps the persistent file
+ResultCache::~ResultCache(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// returns the cache key of a request: SipHash-2-4 of (u32 iobuf length | iobuf | wrappedkey)
+ResultCache::Key ResultCache::computeKey(const byte* pIobuf, const size_t iobufLength, const byte* pWrappedKey, const size_t wrappedKeyLength) const {
+    // the iobuf length separates the two fields, so moving bytes from one to the other changes the key
+    const byte lengthBytes[4] = { static_cast<byte>((iobufLength >> 24) & 0xFF), static_cast<byte>((iobufLength >> 16) & 0xFF),
+                                  static_cast<byte>((iobufLength >> 8) & 0xFF), static_cast<byte>(iobufLength & 0xFF) };
+    SipHash128 hash(this->m_secret);
+    hash.update(lengthBytes, sizeof(lengthBytes));
+    hash.update(pIobuf, iobufLength);
+    hash.update(pWrappedKey, wrappedKeyLength);
+    Key key;
+    hash.finish(key.m_hash);
+    return key;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// looks up a response stored less than the time to live ago, copying it to payload if found
+bool ResultCache::tryGet(const Key& key, std::vector<byte>& payload){
+    Shard& shard = this->m_pShards[static_cast<size_t>(key.m_hash[1] % SHARD_COUNT)];
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> guard(shard.m_mutex);
+        const std::unordered_map<Key, Shard::EntryList::iterator, KeyHasher>::iterator it = shard.m_index.find(key);
+        if (it != shard.m_index.end()){
+            if (now < it->second->second.m_expiry){
+                // move to the front of the LRU list
+                shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, it->second);
+                payload = it->second->second.m_payload;
+                this->m_lookups[LOOKUP_HIT].fetch_add(1, std::memory_order_relaxed);
+                Metrics::countCacheLookup(LOOKUP_HIT);
+                return true;
+            }
+            // expired - the persistent tier holds the same or an older response, so it is done with too
+            shard.m_entries.erase(it->second);
+            shard.m_index.erase(it);
+            this->m_lookups[LOOKUP_MISS].fetch_add(1, std::memory_order_relaxed);
+            Metrics::countCacheLookup(LOOKUP_MISS);
+            return false;
+        }
+    }
+
+    uint32_t ageSeconds = 0;
+    if (this->m_pPersistent.get() != nullptr && this->m_pPersistent->tryGet(key, this->m_ttlSeconds, payload, ageSeconds) == true){
+        this->m_lookups[LOOKUP_PERSISTENT_HIT].fetch_add(1, std::memory_order_relaxed);
+        Metrics::countCacheLookup(LOOKUP_PERSISTENT_HIT);
+        // promote to the memory tier only (the persistent entry is already there), expiring when it does
+        std::lock_guard<std::mutex> guard(shard.m_mutex);
+        if (shard.m_index.find(key) == shard.m_index.end()){
+            if (shard.m_entries.size() >= shard.m_capacity){
+                shard.m_index.erase(shard.m_entries.back().first);
+                shard.m_entries.pop_back();
+            }
+            Shard::Entry entry;
+            entry.m_payload = payload;
+            entry.m_expiry = now + std::chrono::seconds(this->m_ttlSeconds - ageSeconds);
+            shard.m_entries.push_front(std::make_pair(key, entry));
+            shard.m_index[key] = shard.m_entries.begin();
+        }
+        return true;
+    }
+
+    this->m_lookups[LOOKUP_MISS].fetch_add(1, std::memory_order_relaxed);
+    Metrics::countCacheLookup(LOOKUP_MISS);
+    return false;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// stores a response, evicting the least recently used one of its shard when full
+void ResultCache::put(const Key& key, const std::vector<byte>& payload){
+    Shard& shard = this->m_pShards[static_cast<size_t>(key.m_hash[1] % SHARD_COUNT)];
+    const std::chrono::steady_clock::time_point expiry = std::chrono::steady_clock::now() + std::chrono::seconds(this->m_ttlSeconds);
+    {
+        std::lock_guard<std::mutex> guard(shard.m_mutex);
+        const std::unordered_map<Key, Shard::EntryList::iterator, KeyHasher>::iterator it = shard.m_index.find(key);
+        if (it != shard.m_index.end()){
+            shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, it->second);
+            it->second->second.m_payload = payload;
+            it->second->second.m_expiry = expiry;
+        }else if (shard.m_entries.size() >= shard.m_capacity){
+            // reuse the evicted node (and its payload buffer) rather than allocating
+            Shard::EntryList::iterator victim = std::prev(shard.m_entries.end());
+            shard.m_index.erase(victim->first);
+            shard.m_entries.splice(shard.m_entries.begin(), shard.m_entries, victim);
+            victim->first = key;
+            victim->second.m_payload.assign(payload.begin(), payload.end());
+            victim->second.m_expiry = expiry;
+            shard.m_index[key] = victim;
+        }else{
+            Shard::Entry entry;
+            entry.m_payload = payload;
+            entry.m_expiry = expiry;
+            shard.m_entries.push_front(std::make_pair(key, entry));
+            shard.m_index[key] = shard.m_entries.begin();
+        }
+    }
+
+    if (this->m_pPersistent.get() != nullptr){
+        this->m_pPersistent->put(key, payload);
+    }
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,136 @@
+//----------------------------------------------------------------------
+// ResultCache - Remembers the response to each verify request, keyed by
+//               a hash of the raw request bytes, so that a retried
+//               request is answered without decoding, parsing or RSA.
+//
+// Keys are 128-bit SipHash-2-4 digests of the iobuf and wrappedkey bytes
+// under a random secret, so inputs cannot be crafted to collide with a
+// cached request.  The memory tier is an LRU list split into shards, each
+// with its own lock.  The optional persistent tier is a memory-mapped file
+// of fixed-size slots, two per hash bucket, that keeps responses across
+// restarts and can be shared by several processes:
+//
+//   header (1024 bytes): magic "CKYRCAC1" | u32 version | u32 header length |
+//                        u32 byte order mark | u32 slot length | u64 slot count |
+//                        u64 hash secret[2]
+//   slots (1024 bytes):  u64 version | u64 key[2] | u32 payload length |
+//                        u32 CRC-32C | u32 stored time | u32 reserved | payload
+//
+// A slot's version is odd while a writer fills it (seqlock); a reader
+// treats a slot that changed while it was copied, or whose checksum does
+// not match (a write torn by a power loss), as a miss.  A slot another
+// writer is filling is left alone rather than waited for (the other slot
+// of the bucket is used instead).  Opening the file empties any slot left
+// odd by a writer that died mid-write.  Responses too long for a slot are
+// kept in memory only.
+//
+// The cache is meant for retries: a response is served for at most the
+// time to live given to the constructor (both tiers; the persistent tier
+// by its stored time), after which the request is processed again.  The persistent tier needs
+// shared mappings (POSIX); elsewhere asking for it throws.
+//----------------------------------------------------------------------
+
+#ifndef ResultCacheH_Included
+#define ResultCacheH_Included
+
+//----------------------------------------------------------------------
+
+class ResultCache;
+
+//----------------------------------------------------------------------
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>     // unique_ptr
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+//----------------------------------------------------------------------
+
+class ResultCache{
+    public:
+        // default number of responses held in memory (and slots of a new persistent file)
+        const static size_t DEFAULT_CAPACITY = 64 * 1024;
+
+        // default time a response is served for, in seconds
+        const static uint32_t DEFAULT_TTL_SECONDS = 300;
+
+        // number of independently locked memory shards
+        const static size_t SHARD_COUNT = 16;
+
+        // byte length of a persistent slot, and the longest response it holds
+        const static size_t PERSISTENT_SLOT_LENGTH = 1024;
+        const static size_t MAX_PERSISTENT_PAYLOAD = PERSISTENT_SLOT_LENGTH - 40;
+
+        // where a lookup was answered from
+        enum Lookup{
+            LOOKUP_HIT = 0,                   // memory tier
+            LOOKUP_PERSISTENT_HIT,            // persistent tier (the response is then kept in memory as well)
+            LOOKUP_MISS,
+            LOOKUP_COUNT
+        };
+
+        // cache key of one request
+        class Key{
+            public:
+                uint64_t m_hash[2];
+
+                bool operator==(const Key& rhs) const { return this->m_hash[0] == rhs.m_hash[0] && this->m_hash[1] == rhs.m_hash[1]; }
+        };
+
+        // one memory shard and the persistent file (defined in the implementation)
+        class Shard;
+        class PersistentTier;
+
+    private:
+        // prevent copying and assignment
+        ResultCache(const ResultCache& src);
+        ResultCache operator=(const ResultCache& rhs);
+
+    protected:
+        uint64_t m_secret[2];                             // SipHash key (that of the persistent file, if any)
+        uint32_t m_ttlSeconds;                            // time a response is served for
+        std::unique_ptr<Shard[]> m_pShards;               // memory tier
+        std::unique_ptr<PersistentTier> m_pPersistent;    // persistent tier (nullptr: none)
+        std::atomic<uint64_t> m_lookups[LOOKUP_COUNT];    // lookups by result since construction
+
+    public:
+        // constructor
+        //   capacity is the number of responses held in memory (at least one per shard)
+        //   persistentFilepath names the persistent tier file, or is empty; a missing file is created with
+        //   capacity slots, but no fewer than DEFAULT_CAPACITY
+        //   ttlSeconds is the time a response is served for after it was stored (0 selects DEFAULT_TTL_SECONDS)
+        //   slots of the persistent file left mid-write by a crashed process are reset (after a wait of 50 ms, if any)
+        //   throws std::runtime_error if the persistent file cannot be created, opened or mapped, or is not a cache file
+        explicit ResultCache(const size_t capacity = DEFAULT_CAPACITY, const std::string& persistentFilepath = std::string(),
+                             const uint32_t ttlSeconds = DEFAULT_TTL_SECONDS);
+
+        // destructor - unmaps the persistent file
+        virtual ~ResultCache();
+
+
+        // returns the cache key of a request
+        Key computeKey(const byte* pIobuf, const size_t iobufLength, const byte* pWrappedKey, const size_t wrappedKeyLength) const;
+
+        // looks up a response stored less than the time to live ago, copying it to payload if found; thread safe
+        //   counts the lookup (see getLookupCount and Metrics::countCacheLookup)
+        bool tryGet(const Key& key, std::vector<byte>& payload);
+
+        // stores a response, evicting the least recently used one of its shard when full; thread safe
+        void put(const Key& key, const std::vector<byte>& payload);
+
+
+        // getters
+        uint64_t getLookupCount(const Lookup lookup) const { return this->m_lookups[lookup].load(std::memory_order_relaxed); }
+        bool hasPersistentTier() const { return this->m_pPersistent.get() != nullptr; }
+        uint32_t getTTLSeconds() const { return this->m_ttlSeconds; }
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,233 @@
+//----------------------------------------------------------------------
+// See ResultWriter.h
+//----------------------------------------------------------------------
+
+#include "ResultWriter.h"
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+#include "HexUtilities.h"
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor - results are written to out in the given format
+ResultWriter::ResultWriter(std::ostream& out, const Format format) : m_out(out), m_format(format){
+    // room for a full buffer plus the line that pushes it over
+    this->m_buffer.reserve(BUFFER_SIZE + 4096);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - writes any buffered output
+ResultWriter::~ResultWriter(){
+    this->flush();
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// appends bytes as lowercase ASCII-hex
+void ResultWriter::appendHex(const std::vector<byte>& data){
+    const size_t offset = this->m_buffer.size();
+    this->m_buffer.resize(offset + 2 * data.size());
+    Encode_ASCIIHex(data.data(), data.size(), &this->m_buffer[offset]);
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// appends text as the contents of a JSON string (without the quotes)
+void ResultWriter::appendJSONEscaped(const std::string& text){
+    const char HEX_DIGITS[] = "0123456789abcdef";
+    for (std::string::const_iterator it = text.begin(); it != text.end(); it++){
+        const unsigned char c = static_cast<unsigned char>(*it);
+        if (c == '"' || c == '\\'){
+            this->m_buffer += '\\';
+            this->m_buffer += static_cast<char>(c);
+        }else if (c < 0x20){
+            this->m_buffer += "\\u00";
+            this->m_buffer += HEX_DIGITS[c >> 4];
+            this->m_buffer += HEX_DIGITS[c & 0x0F];
+        }else{
+            this->m_buffer += static_cast<char>(c);
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// appends text as a quoted CSV field (RFC 4180: embedded quotes are doubled)
+void ResultWriter::appendCSVQuoted(const std::string& text){
+    this->m_buffer += '"';
+    for (std::string::const_iterator it = text.begin(); it != text.end(); it++){
+        if (*it == '"'){
+            this->m_buffer += '"';
+        }
+        this->m_buffer += *it;
+    }
+    this->m_buffer += '"';
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// appends an unsigned decimal number
+void ResultWriter::appendNumber(const size_t value){
+    char digits[24];
+    size_t count = 0;
+    size_t remaining = value;
+    do{
+        digits[count++] = static_cast<char>('0' + remaining % 10);
+        remaining /= 10;
+    }while (remaining != 0);
+    while (count > 0){
+        this->m_buffer += digits[--count];
+    }
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// writes the buffer to the stream if it has grown past BUFFER_SIZE
+void ResultWriter::drainIfFull(){
+    if (this->m_buffer.size() >= BUFFER_SIZE){
+        this->m_out.write(this->m_buffer.data(), static_cast<std::streamsize>(this->m_buffer.size()));
+        this->m_buffer.clear();
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// writes the header line of the format (CSV only)
+void ResultWriter::writeHeader(){
+    if (this->m_format == FORMAT_CSV){
+        this->m_buffer += "line,outcome,verdict,key_length,exponent,modulus,proof,message\n";
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// writes one result
+void ResultWriter::write(const BatchVerifier::Result& result){
+    // outcome codes are never negative
+    const size_t outcome = static_cast<size_t>(result.m_outcome);
+
+    switch (this->m_format){
+        case FORMAT_JSONL:
+            this->m_buffer += "{\"line\":";
+            this->appendNumber(result.m_lineNumber);
+            this->m_buffer += ",\"outcome\":";
+            this->appendNumber(outcome);
+            this->m_buffer += ",\"verdict\":\"";
+            this->m_buffer += getVerdictName(result.m_outcome);
+            if (result.m_hasKeyData == true){
+                this->m_buffer += "\",\"key_length\":";
+                this->appendNumber(result.m_keyLengthBits);
+                this->m_buffer += ",\"exponent\":\"";
+                this->appendHex(result.m_exponent);
+                this->m_buffer += "\",\"modulus\":\"";
+                this->appendHex(result.m_modulus);
+                this->m_buffer += "\",\"proof\":\"";
+                this->appendHex(result.m_proof);
+                this->m_buffer += "\",\"message\":\"";
+            }else{
+                this->m_buffer += "\",\"key_length\":null,\"exponent\":null,\"modulus\":null,\"proof\":null,\"message\":\"";
+            }
+            this->appendJSONEscaped(result.m_message);
+            this->m_buffer += "\"}\n";
+            break;
+
+        case FORMAT_CSV:
+            this->appendNumber(result.m_lineNumber);
+            this->m_buffer += ',';
+            this->appendNumber(outcome);
+            this->m_buffer += ',';
+            this->m_buffer += getVerdictName(result.m_outcome);
+            this->m_buffer += ',';
+            if (result.m_hasKeyData == true){
+                this->appendNumber(result.m_keyLengthBits);
+                this->m_buffer += ',';
+                this->appendHex(result.m_exponent);
+                this->m_buffer += ',';
+                this->appendHex(result.m_modulus);
+                this->m_buffer += ',';
+                this->appendHex(result.m_proof);
+                this->m_buffer += ',';
+            }else{
+                this->m_buffer += ",,,,";
+            }
+            this->appendCSVQuoted(result.m_message);
+            this->m_buffer += '\n';
+            break;
+
+        default:
+            this->appendNumber(result.m_lineNumber);
+            this->m_buffer += '\t';
+            this->appendNumber(outcome);
+            this->m_buffer += '\t';
+            this->m_buffer += result.m_message;
+            this->m_buffer += '\n';
+            break;
+    }
+
+    this->drainIfFull();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// writes the header and every result, then flushes
+//   returns the highest outcome code of all results (0 if every record verified)
+int ResultWriter::writeAll(const std::vector<BatchVerifier::Result>& results){
+    this->writeHeader();
+
+    int worstOutcome = RETCODE_SUCCESS;
+    for (std::vector<BatchVerifier::Result>::const_iterator it = results.begin(); it != results.end(); it++){
+        const BatchVerifier::Result& result = *it;
+        this->write(result);
+        if (result.m_outcome > worstOutcome){
+            worstOutcome = result.m_outcome;
+        }
+    }
+    this->flush();
+    return worstOutcome;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// writes the buffered output to the stream and flushes it
+void ResultWriter::flush(){
+    if (this->m_buffer.empty() == false){
+        this->m_out.write(this->m_buffer.data(), static_cast<std::streamsize>(this->m_buffer.size()));
+        this->m_buffer.clear();
+    }
+    this->m_out.flush();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns a short name for an outcome code
+const char* ResultWriter::getVerdictName(const int outcome){
+    switch (outcome){
+        case RETCODE_SUCCESS:      return "verified";
+        case RETCODE_INPUT_ERROR:  return "input_error";
+        case RETCODE_PARSE_ERROR:  return "parse_error";
+        case RETCODE_VERIFY_ERROR: return "verify_error";
+        case RETCODE_WEAK_KEY:     return "weak_key";
+        default:                   return "error";
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// parses a format name ("text", "jsonl" or "csv"); returns false if it is unknown
+bool ResultWriter::tryParseFormat(const std::string& name, Format& format){
+    if (name == "text"){
+        format = FORMAT_TEXT;
+    }else if (name == "jsonl"){
+        format = FORMAT_JSONL;
+    }else if (name == "csv"){
+        format = FORMAT_CSV;
+    }else{
+        return false;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,107 @@
+//----------------------------------------------------------------------
+// ResultWriter - Writes batch verification results as text, JSON Lines
+//                or CSV.
+//
+// Lines are assembled in one reusable buffer, with hex fields encoded by
+// table lookup, and handed to the stream in large blocks; nothing is
+// flushed per record.  The JSONL and CSV formats include the key fields
+// of each result, which must have been captured (see
+// BatchVerifier::verifyAll) - results without key data leave them empty.
+//----------------------------------------------------------------------
+
+#ifndef ResultWriterH_Included
+#define ResultWriterH_Included
+
+//----------------------------------------------------------------------
+
+class ResultWriter;
+
+//----------------------------------------------------------------------
+
+#include <vector>
+#include <string>
+#include <ostream>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "BatchVerifier.h"
+
+//----------------------------------------------------------------------
+
+class ResultWriter{
+    public:
+        // output formats
+        enum Format{
+            FORMAT_TEXT = 0,                  // <line> TAB <outcome> TAB <message>
+            FORMAT_JSONL,                     // one JSON object per line
+            FORMAT_CSV,                       // header line, then one comma-separated line per result
+            FORMAT_COUNT
+        };
+
+        // bytes buffered before they are written to the stream
+        const static size_t BUFFER_SIZE = 1024 * 1024;
+
+    private:
+        // prevent copying and assignment
+        ResultWriter(const ResultWriter& src);
+        ResultWriter operator=(const ResultWriter& rhs);
+
+    protected:
+        std::ostream& m_out;                  // destination stream
+        Format m_format;                      // output format
+        std::string m_buffer;                 // pending output
+
+        // appends bytes as lowercase ASCII-hex
+        void appendHex(const std::vector<byte>& data);
+
+        // appends text as the contents of a JSON string (without the quotes)
+        void appendJSONEscaped(const std::string& text);
+
+        // appends text as a quoted CSV field
+        void appendCSVQuoted(const std::string& text);
+
+        // appends an unsigned decimal number
+        void appendNumber(const size_t value);
+
+        // writes the buffer to the stream if it has grown past BUFFER_SIZE
+        void drainIfFull();
+
+    public:
+        // constructor - results are written to out in the given format
+        ResultWriter(std::ostream& out, const Format format);
+
+        // destructor - writes any buffered output (see flush())
+        virtual ~ResultWriter();
+
+
+        // getter for the output format
+        Format getFormat() const { return this->m_format; }
+
+        // returns true if the format includes the key fields of each result
+        bool needsKeyData() const { return this->m_format != FORMAT_TEXT; }
+
+        // writes the header line of the format (CSV only; nothing for the others)
+        void writeHeader();
+
+        // writes one result
+        void write(const BatchVerifier::Result& result);
+
+        // writes the header and every result, then flushes
+        //   returns the highest outcome code of all results (0 if every record verified)
+        int writeAll(const std::vector<BatchVerifier::Result>& results);
+
+        // writes the buffered output to the stream and flushes it
+        void flush();
+
+
+        // returns a short name for an outcome code ("verified", "input_error", ...)
+        static const char* getVerdictName(const int outcome);
+
+        // parses a format name ("text", "jsonl" or "csv"); returns false if it is unknown
+        static bool tryParseFormat(const std::string& name, Format& format);
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,460 @@
+//----------------------------------------------------------------------
+// See SharedFactorScan.h
+//----------------------------------------------------------------------
+
+#include "SharedFactorScan.h"
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+
+#if defined(CKY_HAVE_GMP)
+    #include <gmp.h>
+
+    #include <algorithm>  // min, sort
+    #include <chrono>
+    #include <cstdint>
+    #include <cstdio>     // remove
+    #include <cstdlib>    // getenv
+    #include <fstream>
+    #include <memory>     // unique_ptr
+    #include <random>
+    #include <sstream>
+
+    #include "CoolkeyRSAKeyGenResultView.h"
+    #include "VerificationWorkerPool.h"
+#endif
+
+//----------------------------------------------------------------------
+
+#if defined(CKY_HAVE_GMP)
+namespace{
+    // manifest records loaded per step while collecting the moduli
+    const size_t COLLECT_BATCH_RECORDS = 4096;
+
+    // partner lines listed per reported key
+    const size_t MAX_LISTED_LINES = 10;
+
+    // a GMP integer with automatic lifetime
+    class Bignum{
+        private:
+            // prevent copying and assignment
+            Bignum(const Bignum& src);
+            Bignum operator=(const Bignum& rhs);
+
+        public:
+            mpz_t m_value;
+
+            Bignum(){ mpz_init(this->m_value); }
+            ~Bignum(){ mpz_clear(this->m_value); }
+
+            // bytes taken by the value's limbs
+            size_t getByteSize() const { return mpz_size(this->m_value) * sizeof(mp_limb_t); }
+    };
+    typedef std::unique_ptr<Bignum> BignumPtr;
+
+    // one tree level in a spill file: a sequence of non-negative values, each stored as its limb
+    //   count followed by its limbs (host byte order - the files never leave this process)
+    //   written once from the start, then read from the start; the file is removed on destruction
+    class LevelFile{
+        private:
+            // prevent copying and assignment
+            LevelFile(const LevelFile& src);
+            LevelFile operator=(const LevelFile& rhs);
+
+        protected:
+            std::string m_filepath;
+            std::ofstream m_writer;
+            std::ifstream m_reader;
+            uint64_t m_count;                    // values written
+
+        public:
+            // creates (or truncates) the file
+            //   throws std::runtime_error if it cannot be created
+            explicit LevelFile(const std::string& filepath) : m_filepath(filepath),
+                                                              m_count(0){
+                this->m_writer.open(filepath.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+                if (this->m_writer.good() == false){
+                    throw std::runtime_error("Unable to create spill file '" + filepath + "'.");
+                }
+            }
+
+            ~LevelFile(){
+                this->m_writer.close();
+                this->m_reader.close();
+                std::remove(this->m_filepath.c_str());
+            }
+
+            uint64_t getCount() const { return this->m_count; }
+
+            // appends a value
+            //   throws std::runtime_error on write failure
+            void append(const mpz_t value){
+                const uint64_t limbCount = mpz_size(value);
+                this->m_writer.write(reinterpret_cast<const char*>(&limbCount), sizeof(limbCount));
+                if (limbCount > 0){
+                    this->m_writer.write(reinterpret_cast<const char*>(mpz_limbs_read(value)),
+                                         static_cast<std::streamsize>(limbCount * sizeof(mp_limb_t)));
+                }
+                if (this->m_writer.good() == false){
+                    throw std::runtime_error("Unable to write spill file '" + this->m_filepath + "'.");
+                }
+                ++this->m_count;
+            }
+
+            // finishes writing (once) and starts reading from the first value; may be called again to reread
+            //   throws std::runtime_error if the file cannot be completed or reopened
+            void startReading(){
+                if (this->m_writer.is_open() == true){
+                    this->m_writer.close();
+                    if (this->m_writer.fail() == true){
+                        throw std::runtime_error("Unable to write spill file '" + this->m_filepath + "'.");
+                    }
+                }
+                this->m_reader.close();
+                this->m_reader.clear();
+                this->m_reader.open(this->m_filepath.c_str(), std::ios::in | std::ios::binary);
+                if (this->m_reader.good() == false){
+                    throw std::runtime_error("Unable to read spill file '" + this->m_filepath + "'.");
+                }
+            }
+
+            // reads the next value
+            //   throws std::runtime_error if the file is short
+            void read(mpz_t value){
+                uint64_t limbCount = 0;
+                this->m_reader.read(reinterpret_cast<char*>(&limbCount), sizeof(limbCount));
+                if (this->m_reader.good() == true && limbCount > 0){
+                    mp_limb_t* const pLimbs = mpz_limbs_write(value, static_cast<mp_size_t>(limbCount));
+                    this->m_reader.read(reinterpret_cast<char*>(pLimbs), static_cast<std::streamsize>(limbCount * sizeof(mp_limb_t)));
+                    mpz_limbs_finish(value, static_cast<mp_size_t>(limbCount));
+                }else{
+                    mpz_set_ui(value, 0);
+                }
+                if (this->m_reader.good() == false){
+                    throw std::runtime_error("Unable to read spill file '" + this->m_filepath + "'.");
+                }
+            }
+    };
+
+    // returns the directory for spill files when none is given
+    std::string GetTemporaryDirectory(){
+        const char* const names[] = { "TMPDIR", "TEMP", "TMP" };
+        for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i){
+            const char* const pValue = std::getenv(names[i]);
+            if (pValue != nullptr && pValue[0] != '\0'){
+                return pValue;
+            }
+        }
+#if defined(_WIN32)
+        return ".";
+#else
+        return "/tmp";
+#endif
+    }
+
+    // returns a spill file path prefix that no other scan uses
+    std::string MakeSpillPrefix(const std::string& directory){
+        std::random_device device;
+        const uint64_t token = (static_cast<uint64_t>(device()) << 32) ^ device() ^
+                               static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        std::ostringstream prefix;
+        prefix << directory;
+        if (directory.empty() == false && directory[directory.size() - 1] != '/' && directory[directory.size() - 1] != '\\'){
+            prefix << '/';
+        }
+        prefix << "cky_scan_" << std::hex << token << '_';
+        return prefix.str();
+    }
+
+    // returns "3, 8, 12" for a list of line numbers, shortened after MAX_LISTED_LINES
+    std::string FormatLines(const std::vector<size_t>& lineNumbers){
+        std::ostringstream text;
+        const size_t listed = std::min(lineNumbers.size(), MAX_LISTED_LINES);
+        for (size_t i = 0; i < listed; ++i){
+            text << ((i == 0) ? "" : ", ") << lineNumbers[i];
+        }
+        if (listed < lineNumbers.size()){
+            text << " and " << (lineNumbers.size() - listed) << " more";
+        }
+        return text.str();
+    }
+
+    // builds the product tree of the values in level (bottom up), one spill file per level
+    //   levels[0] is the leaf level; the last level holds the product of all leaves
+    //   nodes are read in batches of about batchBytes and multiplied in parallel
+    void BuildProductTree(std::vector<std::unique_ptr<LevelFile>>& levels, const std::string& spillPrefix,
+                          const size_t batchBytes, const VerificationWorkerPool& workerPool){
+        while (levels.back()->getCount() > 1){
+            LevelFile& below = *levels.back();
+            std::ostringstream filepath;
+            filepath << spillPrefix << "product_" << levels.size();
+            std::unique_ptr<LevelFile> pAbove(new LevelFile(filepath.str()));
+
+            below.startReading();
+            uint64_t remaining = below.getCount();
+            while (remaining > 0){
+                // read whole pairs; an odd last node is carried up unchanged
+                std::vector<BignumPtr> nodes;
+                size_t bytes = 0;
+                while (remaining > 0 && (nodes.empty() == true || bytes < batchBytes)){
+                    for (size_t i = 0; i < 2 && remaining > 0; ++i, --remaining){
+                        nodes.push_back(BignumPtr(new Bignum()));
+                        below.read(nodes.back()->m_value);
+                        bytes += nodes.back()->getByteSize();
+                    }
+                }
+
+                // each item multiplies one pair into its first node
+                workerPool.run((nodes.size() + 1) / 2, [&nodes](const size_t itemIndex, const size_t){
+                    if (2 * itemIndex + 1 < nodes.size()){
+                        mpz_mul(nodes[2 * itemIndex]->m_value, nodes[2 * itemIndex]->m_value, nodes[2 * itemIndex + 1]->m_value);
+                    }
+                });
+                for (size_t i = 0; i < nodes.size(); i += 2){
+                    pAbove->append(nodes[i]->m_value);
+                }
+            }
+            levels.push_back(std::move(pAbove));
+        }
+    }
+}
+#endif
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor
+//   throws std::runtime_error if built without GMP
+SharedFactorScan::SharedFactorScan(const std::string& spillDirectory, const size_t memoryLimit) : m_spillDirectory(spillDirectory),
+                                                                                                 m_memoryLimit(memoryLimit){
+    if (isAvailable() == false){
+        throw std::runtime_error("Shared factor scan is unavailable: built without GMP.");
+    }
+#if defined(CKY_HAVE_GMP)
+    if (this->m_spillDirectory.empty() == true){
+        this->m_spillDirectory = GetTemporaryDirectory();
+    }
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - nothing to do at present
+SharedFactorScan::~SharedFactorScan(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns true if the scan was compiled in (CKY_HAVE_GMP)
+bool SharedFactorScan::isAvailable(){
+#if defined(CKY_HAVE_GMP)
+    return true;
+#else
+    return false;
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// collects the modulus of every manifest record and finds those that share a prime factor with another
+//   returns the reported records in manifest order
+//   throws std::runtime_error if the spill files cannot be written or read
+std::vector<SharedFactorScan::Result> SharedFactorScan::scan(const BatchVerifier& manifest, const size_t threadCount) const {
+#if defined(CKY_HAVE_GMP)
+    std::vector<Result> reports;
+    const VerificationWorkerPool workerPool(threadCount);
+    const std::string spillPrefix(MakeSpillPrefix(this->m_spillDirectory));
+    // a step holds its input batch, its output and temporaries of about the same size
+    const size_t batchBytes = std::max(this->m_memoryLimit / 4, static_cast<size_t>(1));
+
+    // step 1: collect the moduli as the leaves of the tree, in manifest order
+    std::vector<std::unique_ptr<LevelFile>> levels;
+    levels.push_back(std::unique_ptr<LevelFile>(new LevelFile(spillPrefix + "product_0")));
+    std::vector<size_t> leafLineNumbers;
+    const std::vector<BatchVerifier::Record>& records = manifest.getRecords();
+    for (size_t first = 0; first < records.size(); first += COLLECT_BATCH_RECORDS){
+        const size_t count = std::min(COLLECT_BATCH_RECORDS, records.size() - first);
+        std::unique_ptr<Bignum[]> moduli(new Bignum[count]);
+        std::vector<Result> results(count);
+        workerPool.run(count, [&records, &moduli, &results, first](const size_t itemIndex, const size_t){
+            const BatchVerifier::Record& record = records[first + itemIndex];
+            Result& result = results[itemIndex];
+            result.m_lineNumber = record.m_lineNumber;
+            result.m_outcome = RETCODE_SUCCESS;
+
+            std::vector<byte> iobuf_data;
+            try{
+                if (record.m_fieldCount < 1 || record.m_fieldCount > 2){
+                    throw std::runtime_error("Malformed manifest line; expected <iobuf> [<wrappedkey>].");
+                }
+                iobuf_data = BatchVerifier::loadField(record.m_fields[0]);
+            }catch (std::runtime_error& ex){
+                result.m_outcome = RETCODE_INPUT_ERROR;
+                result.m_message = (ex.what() == nullptr) ? "<null>" : ex.what();
+                return;
+            }
+
+            CoolkeyRSAKeyGenResultView view;
+            const CoolkeyStatus parseStatus = view.tryParse(iobuf_data.data(), iobuf_data.size());
+            if (parseStatus.isOk() == false){
+                result.m_outcome = RETCODE_PARSE_ERROR;
+                result.m_message = parseStatus.getMessage();
+                return;
+            }
+            const CoolkeyRSAKeyBlobView& blob = view.getBlob();
+            mpz_import(moduli[itemIndex].m_value, blob.getModulusLength(), 1, 1, 1, 0, blob.getModulusData());
+            if (mpz_cmp_ui(moduli[itemIndex].m_value, 1) <= 0){
+                result.m_outcome = RETCODE_PARSE_ERROR;
+                result.m_message = "Modulus is not a valid RSA modulus.";
+            }
+        });
+        for (size_t i = 0; i < count; ++i){
+            if (results[i].m_outcome == RETCODE_SUCCESS){
+                levels[0]->append(moduli[i].m_value);
+                leafLineNumbers.push_back(results[i].m_lineNumber);
+            }else{
+                reports.push_back(results[i]);
+            }
+        }
+    }
+
+    // a single key cannot share a factor
+    std::vector<size_t> weakLeaves;
+    std::vector<BignumPtr> weakModuli;
+    if (leafLineNumbers.size() >= 2){
+        // step 2: product tree, bottom up
+        BuildProductTree(levels, spillPrefix, batchBytes, workerPool);
+
+        // step 3: remainder tree, top down - each node's remainder is its parent's modulo the node squared
+        //   the remainders of the root level are the root itself; the leaf level is reduced to
+        //   gcd(N, (P mod N^2) / N) = gcd(N, product of all other moduli) on the fly
+        std::unique_ptr<LevelFile> pParents(std::move(levels.back()));
+        levels.pop_back();
+        pParents->startReading();
+        while (levels.empty() == false){
+            const bool leafLevel = (levels.size() == 1);
+            LevelFile& children = *levels.back();
+            std::unique_ptr<LevelFile> pRemainders;
+            if (leafLevel == false){
+                std::ostringstream filepath;
+                filepath << spillPrefix << "remainder_" << (levels.size() - 1);
+                pRemainders.reset(new LevelFile(filepath.str()));
+            }
+
+            children.startReading();
+            uint64_t remainingChildren = children.getCount();
+            while (remainingChildren > 0){
+                // read parents with their (one or two) children
+                std::vector<BignumPtr> parents;
+                std::vector<BignumPtr> nodes;
+                std::vector<size_t> parentIndexes;
+                size_t bytes = 0;
+                while (remainingChildren > 0 && (parents.empty() == true || bytes < batchBytes)){
+                    parents.push_back(BignumPtr(new Bignum()));
+                    pParents->read(parents.back()->m_value);
+                    bytes += parents.back()->getByteSize();
+                    for (size_t i = 0; i < 2 && remainingChildren > 0; ++i, --remainingChildren){
+                        nodes.push_back(BignumPtr(new Bignum()));
+                        children.read(nodes.back()->m_value);
+                        parentIndexes.push_back(parents.size() - 1);
+                        bytes += nodes.back()->getByteSize();
+                    }
+                }
+
+                // each item reduces its parent's remainder modulo its node squared; leaves keep their modulus
+                std::vector<BignumPtr> remainders(nodes.size());
+                std::vector<char> weak(nodes.size(), 0);
+                workerPool.run(nodes.size(), [&parents, &nodes, &parentIndexes, &remainders, &weak, leafLevel](const size_t itemIndex, const size_t){
+                    const mpz_t& node = nodes[itemIndex]->m_value;
+                    Bignum square;
+                    mpz_mul(square.m_value, node, node);
+                    BignumPtr pRemainder(new Bignum());
+                    mpz_mod(pRemainder->m_value, parents[parentIndexes[itemIndex]]->m_value, square.m_value);
+                    if (leafLevel == true){
+                        mpz_divexact(pRemainder->m_value, pRemainder->m_value, node);
+                        mpz_gcd(pRemainder->m_value, pRemainder->m_value, node);
+                        weak[itemIndex] = (mpz_cmp_ui(pRemainder->m_value, 1) != 0) ? 1 : 0;
+                    }else{
+                        remainders[itemIndex] = std::move(pRemainder);
+                    }
+                });
+
+                const size_t firstIndex = static_cast<size_t>(children.getCount() - remainingChildren) - nodes.size();
+                for (size_t i = 0; i < nodes.size(); ++i){
+                    if (leafLevel == false){
+                        pRemainders->append(remainders[i]->m_value);
+                    }else if (weak[i] != 0){
+                        weakLeaves.push_back(firstIndex + i);
+                        weakModuli.push_back(std::move(nodes[i]));
+                    }
+                }
+            }
+
+            // the level above is no longer needed
+            levels.pop_back();
+            pParents = std::move(pRemainders);
+            if (pParents.get() != nullptr){
+                pParents->startReading();
+            }
+        }
+    }
+
+    // step 4: name the partners of every weak key; only weak keys can share a factor with each other
+    std::vector<Result> weakResults(weakLeaves.size());
+    workerPool.run(weakLeaves.size(), [&weakLeaves, &weakModuli, &weakResults, &leafLineNumbers](const size_t itemIndex, const size_t){
+        std::vector<size_t> identicalLines;
+        std::vector<size_t> sharingLines;
+        Bignum divisor;
+        for (size_t j = 0; j < weakLeaves.size(); ++j){
+            if (j == itemIndex){
+                continue;
+            }
+            if (mpz_cmp(weakModuli[itemIndex]->m_value, weakModuli[j]->m_value) == 0){
+                identicalLines.push_back(leafLineNumbers[weakLeaves[j]]);
+                continue;
+            }
+            mpz_gcd(divisor.m_value, weakModuli[itemIndex]->m_value, weakModuli[j]->m_value);
+            if (mpz_cmp_ui(divisor.m_value, 1) != 0){
+                sharingLines.push_back(leafLineNumbers[weakLeaves[j]]);
+            }
+        }
+
+        std::string message;
+        if (identicalLines.empty() == false){
+            message = "Modulus is identical to that of line(s) " + FormatLines(identicalLines);
+            message += (sharingLines.empty() == false) ? " and" : ".";
+        }
+        if (sharingLines.empty() == false){
+            message += (message.empty() == true) ? "Modulus" : "";
+            message += " shares a prime factor with line(s) " + FormatLines(sharingLines) + "; its private key can be computed.";
+        }
+        if (message.empty() == true){
+            message = "Modulus shares a prime factor with another key.";
+        }
+
+        Result& result = weakResults[itemIndex];
+        result.m_lineNumber = leafLineNumbers[weakLeaves[itemIndex]];
+        result.m_outcome = RETCODE_WEAK_KEY;
+        result.m_message = message;
+    });
+
+    reports.insert(reports.end(), weakResults.begin(), weakResults.end());
+    std::sort(reports.begin(), reports.end(), [](const Result& a, const Result& b){ return a.m_lineNumber < b.m_lineNumber; });
+    return reports;
+#else
+    (void)manifest;
+    (void)threadCount;
+    throw std::runtime_error("Shared factor scan is unavailable: built without GMP.");
+#endif
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// scans the manifest, writing one result line per reported record to out
+//   returns the highest outcome code reported (0 if no key shares a factor)
+int SharedFactorScan::run(const BatchVerifier& manifest, std::ostream& out, const size_t threadCount) const {
+    return BatchVerifier::writeResults(this->scan(manifest, threadCount), out);
+}
+
+//----------------------------------------------------------------------
@@ -0,0 +1,87 @@
+//----------------------------------------------------------------------
+// SharedFactorScan - Finds the keys of a batch of enrollment results
+//                    whose moduli share a prime factor with another
+//                    key's (as cards with a broken RNG produce).
+//
+// Batch GCD: a product tree of all moduli is built bottom up and a
+// remainder tree (the product modulo each node squared) top down; each
+// leaf then yields gcd(N, product of all other moduli) with no pairwise
+// work.  The few keys found are compared pairwise to name their partners.
+//
+// Tree levels are streamed through spill files in a temporary directory,
+// so memory holds one bounded batch of nodes per step; only the steps at
+// the root, whose few nodes are as large as all moduli together, need a
+// few times that size regardless.  The nodes of a batch are multiplied or
+// reduced in parallel.  Needs GMP (CKY_HAVE_GMP) for subquadratic
+// multiplication and division.
+//----------------------------------------------------------------------
+
+#ifndef SharedFactorScanH_Included
+#define SharedFactorScanH_Included
+
+//----------------------------------------------------------------------
+
+class SharedFactorScan;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "BatchVerifier.h"
+
+//----------------------------------------------------------------------
+
+class SharedFactorScan{
+    public:
+        // default bound of the tree nodes held in memory per step
+        const static size_t DEFAULT_MEMORY_LIMIT = 512 * 1024 * 1024;
+
+        // outcome of one reported record (same form as a batch result)
+        typedef BatchVerifier::Result Result;
+
+    private:
+        // prevent copying and assignment
+        SharedFactorScan(const SharedFactorScan& src);
+        SharedFactorScan operator=(const SharedFactorScan& rhs);
+
+    protected:
+        std::string m_spillDirectory;            // directory of the tree level files
+        size_t m_memoryLimit;                    // bound of the tree nodes held in memory per step (bytes)
+
+    public:
+        // constructor
+        //   an empty spillDirectory selects the system temporary directory (TMPDIR, TEMP or /tmp)
+        //   throws std::runtime_error if built without GMP
+        explicit SharedFactorScan(const std::string& spillDirectory = std::string(), const size_t memoryLimit = DEFAULT_MEMORY_LIMIT);
+
+        // destructor
+        virtual ~SharedFactorScan();
+
+
+        // returns true if the scan was compiled in (CKY_HAVE_GMP)
+        static bool isAvailable();
+
+        // collects the modulus of every manifest record and finds those that share a prime factor
+        //   with another, spreading the work across threadCount threads (0 selects one per hardware thread)
+        //   only the iobuf field of a record is used; the wrappedkey field may be left out
+        //   returns, in manifest order, RETCODE_WEAK_KEY for every key that shares a factor (or its
+        //   whole modulus) and RETCODE_INPUT_ERROR / RETCODE_PARSE_ERROR for records without a modulus
+        //   throws std::runtime_error if the spill files cannot be written or read
+        std::vector<Result> scan(const BatchVerifier& manifest, const size_t threadCount = 1) const;
+
+        // scans the manifest, writing one result line per reported record to out
+        //   line format: <manifest line number> TAB <outcome code> TAB <message>
+        //   returns the highest outcome code reported (0 if no key shares a factor)
+        int run(const BatchVerifier& manifest, std::ostream& out, const size_t threadCount = 1) const;
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,53 @@
+//----------------------------------------------------------------------
+// TextView - Non-owning view of a run of characters (a C++11 stand-in
+//            for std::string_view).  Used to hand slices of mapped
+//            input files to the parsers without copying them into
+//            std::string objects.
+//----------------------------------------------------------------------
+
+#ifndef TextViewH_Included
+#define TextViewH_Included
+
+//----------------------------------------------------------------------
+
+class TextView;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <string>
+
+//----------------------------------------------------------------------
+
+class TextView{
+    protected:
+        const char* m_pData;                  // borrowed characters - must outlive this
+        size_t m_length;                      // number of characters
+
+    public:
+        // constructor - empty view
+        TextView() : m_pData(nullptr), m_length(0) {}
+
+        // constructor - view of length characters at pData
+        TextView(const char* pData, const size_t length) : m_pData(pData), m_length(length) {}
+
+        // constructor - view of the contents of str (which must outlive this)
+        TextView(const std::string& str) : m_pData(str.data()), m_length(str.length()) {}
+
+
+        // getters for the viewed characters
+        const char* data() const { return this->m_pData; }
+        size_t size() const { return this->m_length; }
+        bool empty() const { return this->m_length == 0; }
+        char operator[](const size_t index) const { return this->m_pData[index]; }
+
+        // returns the view of length characters from offset (offset + length must not exceed size())
+        TextView substr(const size_t offset, const size_t length) const { return TextView(this->m_pData + offset, length); }
+
+        // returns a copy of the viewed characters
+        std::string toString() const { return std::string(this->m_pData, this->m_length); }
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,158 @@
+//----------------------------------------------------------------------
+// See TraceRecorder.h
+//----------------------------------------------------------------------
+
+#include "TraceRecorder.h"
+
+//----------------------------------------------------------------------
+
+#include <fstream>
+#include <iomanip>
+#include <memory>     // unique_ptr
+#include <mutex>
+#include <vector>
+
+//----------------------------------------------------------------------
+
+std::atomic<bool> TraceRecorder::s_enabled(false);
+thread_local uint64_t TraceRecorder::s_recordId = 0;
+
+namespace{
+    // one recorded span; times are nanoseconds since enable()
+    struct Span{
+        const char* m_pName;
+        uint64_t m_recordId;
+        uint64_t m_recordCount;
+        int64_t m_start;
+        int64_t m_duration;
+    };
+
+    // the spans of one thread: a ring buffer holding the most recent spans
+    //   only the owning thread writes it; it is read once recording has finished
+    struct ThreadSpans{
+        std::vector<Span> m_spans;      // capacity fixed on creation
+        uint64_t m_recorded;            // spans recorded in total (m_spans holds the last of them)
+    };
+
+    // settings made by enable()
+    std::chrono::steady_clock::time_point g_epoch;
+    size_t g_spansPerThread = TraceRecorder::DEFAULT_SPANS_PER_THREAD;
+
+    // every thread's spans, in order of each thread's first span
+    //   (never destroyed - worker threads may still be recording while main's statics are destroyed)
+    std::mutex& getRegistryMutex(){
+        static std::mutex* const pMutex = new std::mutex();
+        return *pMutex;
+    }
+    std::vector<std::unique_ptr<ThreadSpans>>& getRegistry(){
+        static std::vector<std::unique_ptr<ThreadSpans>>* const pRegistry = new std::vector<std::unique_ptr<ThreadSpans>>();
+        return *pRegistry;
+    }
+
+    // returns the calling thread's spans, registering them on first use
+    ThreadSpans& getThreadSpans(){
+        static thread_local ThreadSpans* pSpans = nullptr;
+        if (pSpans == nullptr){
+            std::unique_ptr<ThreadSpans> pNew(new ThreadSpans());
+            pNew->m_spans.resize(g_spansPerThread);
+            pNew->m_recorded = 0;
+            std::lock_guard<std::mutex> lock(getRegistryMutex());
+            getRegistry().push_back(std::move(pNew));
+            pSpans = getRegistry().back().get();
+        }
+        return *pSpans;
+    }
+
+    // writes nanoseconds as the microseconds (with three decimals) of trace timestamps
+    void writeMicroseconds(std::ostream& out, const int64_t nanoseconds){
+        const int64_t value = (nanoseconds < 0) ? 0 : nanoseconds;
+        out << (value / 1000) << '.' << std::setw(3) << std::setfill('0') << (value % 1000);
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// starts recording spans; trace timestamps count from this call
+void TraceRecorder::enable(const size_t spansPerThread){
+    if (isEnabled() == true){
+        return;
+    }
+    g_epoch = std::chrono::steady_clock::now();
+    g_spansPerThread = (spansPerThread == 0) ? 1 : spansPerThread;
+    s_enabled.store(true, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// records a span of the calling thread
+void TraceRecorder::recordSpan(const char* pName, const std::chrono::steady_clock::time_point start,
+                               const std::chrono::steady_clock::time_point end, const uint64_t recordCount){
+    ThreadSpans& spans = getThreadSpans();
+    Span& span = spans.m_spans[static_cast<size_t>(spans.m_recorded % spans.m_spans.size())];
+    span.m_pName = pName;
+    span.m_recordId = s_recordId;
+    span.m_recordCount = recordCount;
+    span.m_start = std::chrono::duration_cast<std::chrono::nanoseconds>(start - g_epoch).count();
+    span.m_duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    ++spans.m_recorded;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// writes every recorded span to out as a Chrome trace-event JSON object
+//   spans are complete ("X") events in microseconds; each recording thread is one track
+void TraceRecorder::writeChromeTrace(std::ostream& out){
+    const std::ios::fmtflags savedFlags = out.flags();
+    const char savedFill = out.fill();
+
+    std::lock_guard<std::mutex> lock(getRegistryMutex());
+    const std::vector<std::unique_ptr<ThreadSpans>>& registry = getRegistry();
+    uint64_t droppedSpans = 0;
+    bool first = true;
+    out << "{\"traceEvents\":[";
+    for (size_t thread = 0; thread < registry.size(); ++thread){
+        const ThreadSpans& spans = *registry[thread];
+        const size_t threadId = thread + 1;
+        out << (first == true ? "\n" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadId
+            << ",\"args\":{\"name\":\"thread " << threadId << "\"}}";
+        first = false;
+
+        // oldest kept span first
+        const uint64_t capacity = spans.m_spans.size();
+        const uint64_t kept = (spans.m_recorded < capacity) ? spans.m_recorded : capacity;
+        droppedSpans += spans.m_recorded - kept;
+        for (uint64_t i = spans.m_recorded - kept; i < spans.m_recorded; ++i){
+            const Span& span = spans.m_spans[static_cast<size_t>(i % capacity)];
+            out << ",\n{\"name\":\"" << span.m_pName << "\",\"cat\":\"cky\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadId << ",\"ts\":";
+            writeMicroseconds(out, span.m_start);
+            out << ",\"dur\":";
+            writeMicroseconds(out, span.m_duration);
+            out << ",\"args\":{\"record\":" << span.m_recordId;
+            if (span.m_recordCount > 1){
+                out << ",\"records\":" << span.m_recordCount;
+            }
+            out << "}}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"droppedSpans\":\"" << droppedSpans << "\"}}\n";
+
+    out.flags(savedFlags);
+    out.fill(savedFill);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// writes the trace to filepath
+//   returns false if the file cannot be written
+bool TraceRecorder::tryWriteChromeTraceFile(const std::string& filepath){
+    std::ofstream file(filepath.c_str(), std::ios::out | std::ios::trunc);
+    if (file.good() == false){
+        return false;
+    }
+    writeChromeTrace(file);
+    file.flush();
+    return file.good();
+}
+
+//----------------------------------------------------------------------
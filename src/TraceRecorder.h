@@ -0,0 +1,79 @@
+//----------------------------------------------------------------------
+// TraceRecorder - Records the stage spans timed by StageTimer (see
+//                 Metrics.h), tagged with the record being processed,
+//                 and writes them as Chrome trace-event JSON for
+//                 chrome://tracing or Perfetto.
+//
+// Tracing is off until enable() is called; until then recording a span
+// costs one predictable branch.  Each thread appends to its own ring
+// buffer, keeping its most recent spans, without locks.  Stage spans are
+// recorded whether or not metrics are compiled in (CKY_METRICS).
+//----------------------------------------------------------------------
+
+#ifndef TraceRecorderH_Included
+#define TraceRecorderH_Included
+
+//----------------------------------------------------------------------
+
+class TraceRecorder;
+
+//----------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <ostream>
+
+//----------------------------------------------------------------------
+
+class TraceRecorder{
+    public:
+        // spans kept per thread; older spans are overwritten
+        const static size_t DEFAULT_SPANS_PER_THREAD = 64 * 1024;
+
+    private:
+        // prevent copying and assignment
+        TraceRecorder(const TraceRecorder& src);
+        TraceRecorder operator=(const TraceRecorder& rhs);
+
+        // prevent construction
+        TraceRecorder();
+
+    protected:
+        static std::atomic<bool> s_enabled;           // set once by enable()
+        static thread_local uint64_t s_recordId;      // record the calling thread is processing
+
+    public:
+        // returns true once tracing has been enabled
+        static bool isEnabled(){ return s_enabled.load(std::memory_order_relaxed); }
+
+        // starts recording spans; trace timestamps count from this call
+        //   call before the threads that record spans are started
+        static void enable(const size_t spansPerThread = DEFAULT_SPANS_PER_THREAD);
+
+        // tags the calling thread's following spans with a record id (manifest line or request number)
+        static void setRecordId(const uint64_t recordId){
+            if (isEnabled() == true){
+                s_recordId = recordId;
+            }
+        }
+
+        // records a span of the calling thread
+        //   recordCount > 1 marks a span shared by a group of records starting at the current record
+        static void recordSpan(const char* pName, const std::chrono::steady_clock::time_point start,
+                               const std::chrono::steady_clock::time_point end, const uint64_t recordCount);
+
+        // writes every recorded span to out as a Chrome trace-event JSON object
+        //   call once the recording threads have finished
+        static void writeChromeTrace(std::ostream& out);
+
+        // writes the trace to filepath
+        //   returns false if the file cannot be written; never throws except for std::bad_alloc
+        static bool tryWriteChromeTraceFile(const std::string& filepath);
+};
+
+//----------------------------------------------------------------------
+
+#endif
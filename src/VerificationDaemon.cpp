@@ -0,0 +1,551 @@
+//----------------------------------------------------------------------
+// See VerificationDaemon.h
+//----------------------------------------------------------------------
+
+#include "VerificationDaemon.h"
+
+//----------------------------------------------------------------------
+
+#include "CKYStartEnrollmentOutputProcessor.h"
+#include "CoolkeyRSAKeyGenResultView.h"
+#include "Metrics.h"
+#include "MultiBufferSHA1.h"
+#include "TextView.h"
+#include "TraceRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <map>
+#include <memory>     // unique_ptr
+
+#if defined(__linux__)
+    #include <cerrno>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <sys/epoll.h>
+    #include <sys/socket.h>
+    #include <sys/stat.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------
+
+namespace{
+    // set by requestStop() / signal handlers, polled by the event loop
+    volatile std::sig_atomic_t g_stopRequested = 0;
+
+    // signal handler for SIGINT and SIGTERM
+    extern "C" void stopSignalHandler(int signalNumber){
+        (void)signalNumber;
+        g_stopRequested = 1;
+    }
+
+    // appends big endian integers to a byte vector
+    void appendUint16(std::vector<byte>& out, const size_t value){
+        out.push_back(static_cast<byte>((value >> 8) & 0xFF));
+        out.push_back(static_cast<byte>(value & 0xFF));
+    }
+    void appendUint32(std::vector<byte>& out, const size_t value){
+        out.push_back(static_cast<byte>((value >> 24) & 0xFF));
+        out.push_back(static_cast<byte>((value >> 16) & 0xFF));
+        out.push_back(static_cast<byte>((value >> 8) & 0xFF));
+        out.push_back(static_cast<byte>(value & 0xFF));
+    }
+
+    // reads a big endian 32-bit integer
+    uint32_t readUint32(const byte* pData){
+        return (static_cast<uint32_t>(pData[0]) << 24) | (static_cast<uint32_t>(pData[1]) << 16) |
+               (static_cast<uint32_t>(pData[2]) << 8) | static_cast<uint32_t>(pData[3]);
+    }
+
+    // message of a verified request
+    const char g_successMessage[] = "Successfully validated RSA key gen result!";
+
+    // builds a response payload into payload, replacing its contents (its capacity is reused)
+    void buildResponse(const int outcome, const CoolkeyRSAKeyBlobView* pBlob, const TextView& message, std::vector<byte>& payload){
+        payload.clear();
+        payload.reserve(1 + 4 + 2 + 2 + 2 + message.size() + ((pBlob == nullptr) ? 0 : (pBlob->getExponentLength() + pBlob->getModulusLength())));
+        payload.push_back(static_cast<byte>(outcome));
+        if (pBlob != nullptr){
+            appendUint16(payload, pBlob->getKeyLengthBits());
+            payload.push_back(pBlob->getKeyEncoding());
+            payload.push_back(pBlob->getKeyType());
+            appendUint16(payload, pBlob->getExponentLength());
+            payload.insert(payload.end(), pBlob->getExponentData(), pBlob->getExponentData() + pBlob->getExponentLength());
+            appendUint16(payload, pBlob->getModulusLength());
+            payload.insert(payload.end(), pBlob->getModulusData(), pBlob->getModulusData() + pBlob->getModulusLength());
+        }else{
+            appendUint16(payload, 0);
+            payload.push_back(0);
+            payload.push_back(0);
+            appendUint16(payload, 0);
+            appendUint16(payload, 0);
+        }
+        const size_t messageLength = std::min<size_t>(message.size(), 0xFFFF);
+        appendUint16(payload, messageLength);
+        payload.insert(payload.end(), message.data(), message.data() + messageLength);
+    }
+}
+
+//----------------------------------------------------------------------
+// one connected client
+
+class VerificationDaemon::Connection{
+    public:
+        int m_fd;                                // client socket
+        std::vector<byte> m_inBuffer;            // received bytes not yet processed
+        std::vector<byte> m_outBuffer;           // response bytes not yet sent
+        size_t m_outOffset;                      // bytes of m_outBuffer already sent
+        uint32_t m_registeredEvents;             // events currently registered with epoll
+        bool m_peerClosed;                       // client shut down its sending side
+        bool m_closeAfterFlush;                  // protocol error - close once responses are sent
+
+        explicit Connection(const int fd) : m_fd(fd), m_outOffset(0), m_registeredEvents(0), m_peerClosed(false), m_closeAfterFlush(false) {}
+};
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// parses and verifies one request, producing the response payload (without length prefix)
+void VerificationDaemon::processRequest(CoolkeyRSAVerifier& verifier,
+                                        const byte* pIobuf, const size_t iobufLength,
+                                        const byte* pWrappedKey, const size_t wrappedKeyLength,
+                                        std::vector<byte>& payload, KeyFingerprintIndex* pKeyIndex, bool* pCacheable){
+    // parse in place - the view points into the request buffer
+    CoolkeyRSAKeyGenResultView view;
+    StageTimer parseTimer(Metrics::STAGE_PARSE);
+    const CoolkeyStatus parseStatus = view.tryParse(pIobuf, iobufLength);
+    parseTimer.stop();
+    if (parseStatus.isOk() == false){
+        buildResponse(RETCODE_PARSE_ERROR, nullptr, parseStatus.getMessage(), payload);
+        return;
+    }
+
+    // hash (key blob + wrapped key) as the batch modes do - re-initializing an EVP digest
+    //   context allocates under OpenSSL 3 - then verify the proof straight from the request buffer
+    MultiBufferSHA1::Message message;
+    message.m_pPart1 = view.getBlob().getBlobData();
+    message.m_part1Length = view.getBlob().getBlobSize();
+    message.m_pPart2 = pWrappedKey;
+    message.m_part2Length = wrappedKeyLength;
+    byte digest[1][MultiBufferSHA1::DIGEST_LENGTH];
+    StageTimer digestTimer(Metrics::STAGE_DIGEST);
+    MultiBufferSHA1::hash(&message, 1, digest);
+    digestTimer.stop();
+    const CoolkeyStatus verifyStatus = verifier.verifyDigest(view.getBlob(), view.getProofData(), view.getProofSize(), digest[0]);
+    if (verifyStatus.isOk() == false){
+        buildResponse(RETCODE_VERIFY_ERROR, &view.getBlob(), verifyStatus.getMessage(), payload);
+        return;
+    }
+
+    // reject a key seen before; the lookup is lock free and a new key takes one short locked insert
+    if (pKeyIndex != nullptr){
+        byte fingerprint[KeyFingerprintIndex::FINGERPRINT_LENGTH];
+        if (KeyFingerprintIndex::tryComputeFingerprint(view.getBlob(), fingerprint) == false){
+            if (pCacheable != nullptr){
+                *pCacheable = false;
+            }
+            buildResponse(RETCODE_VERIFY_ERROR, &view.getBlob(), std::string("Unable to compute key fingerprint."), payload);
+            return;
+        }
+        KeyFingerprintIndex::Entry entry;
+        try{
+            if (pKeyIndex->findOrInsert(fingerprint, entry) == true){
+                buildResponse(RETCODE_WEAK_KEY, &view.getBlob(), KeyFingerprintIndex::describeDuplicate(entry), payload);
+                return;
+            }
+        }catch (std::runtime_error& ex){
+            if (pCacheable != nullptr){
+                *pCacheable = false;
+            }
+            buildResponse(RETCODE_VERIFY_ERROR, &view.getBlob(), std::string("Unable to record key: ") + ((ex.what() == nullptr) ? "<null>" : ex.what()), payload);
+            return;
+        }
+        // the key is now recorded, so the same request sent again must be answered with outcome 40
+        if (pCacheable != nullptr){
+            *pCacheable = false;
+        }
+    }
+
+    buildResponse(RETCODE_SUCCESS, &view.getBlob(), TextView(g_successMessage, sizeof(g_successMessage) - 1), payload);
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// asks run() to return (async-signal-safe)
+void VerificationDaemon::requestStop(){
+    g_stopRequested = 1;
+}
+
+#if defined(__linux__)
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor creates the listening socket at socketPath
+//   throws std::runtime_error if the socket cannot be created
+VerificationDaemon::VerificationDaemon(const std::string& socketPath, std::ostream& log, const std::string& metricsPath,
+                                       KeyFingerprintIndex* pKeyIndex, ResultCache* pResultCache) : m_socketPath(socketPath),
+                                                                                                   m_listenFd(-1),
+                                                                                                   m_epollFd(-1),
+                                                                                                   m_log(log),
+                                                                                                   m_metricsPath(metricsPath),
+                                                                                                   m_pKeyIndex(pKeyIndex),
+                                                                                                   m_pResultCache(pResultCache),
+                                                                                                   m_totalRequests(0){
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.empty() == true || socketPath.length() >= sizeof(address.sun_path)){
+        throw std::runtime_error("Invalid socket path.");
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.length() + 1);
+
+    try{
+        // replace a stale socket left behind by an earlier instance (but never a regular file)
+        struct stat socketStat;
+        if (lstat(socketPath.c_str(), &socketStat) == 0 && S_ISSOCK(socketStat.st_mode)){
+            unlink(socketPath.c_str());
+        }
+
+        this->m_listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (this->m_listenFd < 0){
+            throw std::runtime_error("Unable to create listening socket.");
+        }
+        if (bind(this->m_listenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0){
+            throw std::runtime_error("Unable to bind listening socket to '" + socketPath + "': " + std::strerror(errno));
+        }
+        if (listen(this->m_listenFd, SOMAXCONN) != 0){
+            throw std::runtime_error("Unable to listen on socket.");
+        }
+
+        this->m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+        if (this->m_epollFd < 0){
+            throw std::runtime_error("Unable to create epoll instance.");
+        }
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;  // nullptr identifies the listening socket
+        if (epoll_ctl(this->m_epollFd, EPOLL_CTL_ADD, this->m_listenFd, &event) != 0){
+            throw std::runtime_error("Unable to register listening socket with epoll.");
+        }
+    }catch (...){
+        if (this->m_epollFd >= 0){
+            close(this->m_epollFd);
+        }
+        if (this->m_listenFd >= 0){
+            close(this->m_listenFd);
+            unlink(socketPath.c_str());
+        }
+        throw;
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - closes the socket and removes the socket file
+VerificationDaemon::~VerificationDaemon(){
+    close(this->m_epollFd);
+    close(this->m_listenFd);
+    unlink(this->m_socketPath.c_str());
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// serves requests until requestStop() is called or SIGINT/SIGTERM is received
+void VerificationDaemon::run(){
+    // stop cleanly on SIGINT/SIGTERM; report broken client connections through send() instead of SIGPIPE
+    struct sigaction stopAction;
+    std::memset(&stopAction, 0, sizeof(stopAction));
+    stopAction.sa_handler = stopSignalHandler;
+    sigemptyset(&stopAction.sa_mask);
+    sigaction(SIGINT, &stopAction, nullptr);
+    sigaction(SIGTERM, &stopAction, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    this->m_log << "Listening on " << this->m_socketPath << std::endl;
+
+    std::map<int, std::unique_ptr<Connection>> connections;
+    const int MAX_EVENTS = 256;
+    epoll_event events[MAX_EVENTS];
+    std::chrono::steady_clock::time_point lastReport = std::chrono::steady_clock::now();
+
+    while (g_stopRequested == 0){
+        const int eventCount = epoll_wait(this->m_epollFd, events, MAX_EVENTS, 1000);
+        if (eventCount < 0 && errno != EINTR){
+            throw std::runtime_error("epoll_wait failed.");
+        }
+
+        for (int i = 0; i < eventCount; ++i){
+            if (events[i].data.ptr == nullptr){
+                // new connections on the listening socket
+                for (;;){
+                    const int clientFd = accept4(this->m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                    if (clientFd < 0){
+                        break;  // EAGAIN, or a transient error such as EMFILE - retried on the next event
+                    }
+                    std::unique_ptr<Connection> pConnection(new Connection(clientFd));
+                    epoll_event event;
+                    std::memset(&event, 0, sizeof(event));
+                    event.events = EPOLLIN;
+                    event.data.ptr = pConnection.get();
+                    if (epoll_ctl(this->m_epollFd, EPOLL_CTL_ADD, clientFd, &event) != 0){
+                        close(clientFd);
+                        continue;
+                    }
+                    pConnection->m_registeredEvents = EPOLLIN;
+                    connections[clientFd] = std::move(pConnection);
+                }
+            }else{
+                Connection& connection = *static_cast<Connection*>(events[i].data.ptr);
+                if (this->serviceConnection(connection, events[i].events) == false){
+                    const int clientFd = connection.m_fd;
+                    epoll_ctl(this->m_epollFd, EPOLL_CTL_DEL, clientFd, nullptr);
+                    close(clientFd);
+                    connections.erase(clientFd);
+                }
+            }
+        }
+
+        // periodic latency report
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastReport).count() >= REPORT_INTERVAL_SECONDS){
+            this->reportLatency();
+            this->writeMetrics();
+            this->flushKeyIndex();
+            lastReport = now;
+        }
+    }
+
+    // shut down: drop remaining clients and write the final report
+    for (std::map<int, std::unique_ptr<Connection>>::iterator it = connections.begin(); it != connections.end(); it++){
+        close(it->first);
+    }
+    this->reportLatency();
+    this->writeMetrics();
+    this->flushKeyIndex();
+    this->m_log << "Stopped after " << this->m_totalRequests << " requests." << std::endl;
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// reads from, processes and writes to a connection; returns false once it should be closed
+bool VerificationDaemon::serviceConnection(Connection& connection, const uint32_t events){
+    // stop reading while a slow client has this much unsent response data
+    const size_t MAX_PENDING_OUTPUT = 1024 * 1024;
+
+    // bytes read per event - one maximum-size frame; the rest waits for the next (level-triggered) event
+    const size_t MAX_READ_PER_EVENT = 8 + 2 * static_cast<size_t>(MAX_FIELD_LENGTH);
+
+    if ((events & (EPOLLERR | EPOLLHUP)) != 0 && (events & EPOLLIN) == 0){
+        return false;
+    }
+
+    // read up to the per-event budget, unless the client is not collecting its responses
+    const size_t pendingBeforeRead = connection.m_outBuffer.size() - connection.m_outOffset;
+    if ((events & EPOLLIN) != 0 && connection.m_closeAfterFlush == false && pendingBeforeRead < MAX_PENDING_OUTPUT){
+        byte readBuffer[64 * 1024];
+        size_t budget = MAX_READ_PER_EVENT;
+        while (budget > 0){
+            const ssize_t bytesRead = read(connection.m_fd, readBuffer, std::min(budget, sizeof(readBuffer)));
+            if (bytesRead > 0){
+                connection.m_inBuffer.insert(connection.m_inBuffer.end(), readBuffer, readBuffer + bytesRead);
+                budget -= static_cast<size_t>(bytesRead);
+            }else if (bytesRead == 0){
+                connection.m_peerClosed = true;
+                break;
+            }else if (errno == EINTR){
+                continue;
+            }else if (errno == EAGAIN || errno == EWOULDBLOCK){
+                break;
+            }else{
+                return false;
+            }
+        }
+    }
+
+    // process every complete request frame
+    size_t consumed = 0;
+    while (connection.m_closeAfterFlush == false && (connection.m_inBuffer.size() - consumed) >= 8){
+        const byte* const pFrame = connection.m_inBuffer.data() + consumed;
+        const uint32_t iobufLength = readUint32(pFrame);
+        const uint32_t wrappedKeyLength = readUint32(pFrame + 4);
+
+        std::vector<byte>& payload = this->m_payload;
+        if (iobufLength > MAX_FIELD_LENGTH || wrappedKeyLength > MAX_FIELD_LENGTH){
+            // cannot resynchronize with this client - answer and close
+            buildResponse(RETCODE_INPUT_ERROR, nullptr, std::string("Request field length exceeds maximum."), payload);
+            connection.m_closeAfterFlush = true;
+            consumed = connection.m_inBuffer.size();
+        }else{
+            const size_t frameLength = 8 + static_cast<size_t>(iobufLength) + wrappedKeyLength;
+            if ((connection.m_inBuffer.size() - consumed) < frameLength){
+                break;
+            }
+            TraceRecorder::setRecordId(this->m_totalRequests + 1);
+            const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            bool cached = false;
+            ResultCache::Key cacheKey;
+            if (this->m_pResultCache != nullptr){
+                cacheKey = this->m_pResultCache->computeKey(pFrame + 8, iobufLength, pFrame + 8 + iobufLength, wrappedKeyLength);
+                cached = this->m_pResultCache->tryGet(cacheKey, payload);
+            }
+            if (cached == false){
+                bool cacheable = true;
+                processRequest(this->m_verifier, pFrame + 8, iobufLength, pFrame + 8 + iobufLength, wrappedKeyLength, payload,
+                               this->m_pKeyIndex, &cacheable);
+                if (this->m_pResultCache != nullptr && cacheable == true){
+                    this->m_pResultCache->put(cacheKey, payload);
+                }
+            }
+            const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            this->m_latencySamples.push_back(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+            Metrics::recordLatency(Metrics::STAGE_REQUEST, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            if (TraceRecorder::isEnabled() == true){
+                TraceRecorder::recordSpan(Metrics::getStageName(Metrics::STAGE_REQUEST), start, end, 1);
+            }
+            ++this->m_totalRequests;
+            consumed += frameLength;
+        }
+        Metrics::countOutcome(payload[0]);
+
+        appendUint32(connection.m_outBuffer, payload.size());
+        connection.m_outBuffer.insert(connection.m_outBuffer.end(), payload.begin(), payload.end());
+    }
+    connection.m_inBuffer.erase(connection.m_inBuffer.begin(), connection.m_inBuffer.begin() + consumed);
+
+    // send as much as the socket accepts
+    while (connection.m_outOffset < connection.m_outBuffer.size()){
+        const ssize_t bytesSent = send(connection.m_fd, connection.m_outBuffer.data() + connection.m_outOffset,
+                                       connection.m_outBuffer.size() - connection.m_outOffset, MSG_NOSIGNAL);
+        if (bytesSent > 0){
+            connection.m_outOffset += static_cast<size_t>(bytesSent);
+        }else if (bytesSent < 0 && errno == EINTR){
+            continue;
+        }else if (bytesSent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+            break;
+        }else{
+            return false;
+        }
+    }
+    const size_t pendingOutput = connection.m_outBuffer.size() - connection.m_outOffset;
+    if (pendingOutput == 0){
+        connection.m_outBuffer.clear();
+        connection.m_outOffset = 0;
+        if (connection.m_closeAfterFlush == true || connection.m_peerClosed == true){
+            return false;
+        }
+    }
+
+    // wait for writability while output is pending; stop reading while too much is pending
+    uint32_t wantedEvents = 0;
+    if (pendingOutput < MAX_PENDING_OUTPUT && connection.m_peerClosed == false && connection.m_closeAfterFlush == false){
+        wantedEvents |= EPOLLIN;
+    }
+    if (pendingOutput > 0){
+        wantedEvents |= EPOLLOUT;
+    }
+    if (wantedEvents != connection.m_registeredEvents){
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = wantedEvents;
+        event.data.ptr = &connection;
+        if (epoll_ctl(this->m_epollFd, EPOLL_CTL_MOD, connection.m_fd, &event) != 0){
+            return false;
+        }
+        connection.m_registeredEvents = wantedEvents;
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// writes the latency percentiles of the current samples to the log and clears them
+void VerificationDaemon::reportLatency(){
+    if (this->m_latencySamples.empty() == true){
+        return;
+    }
+    std::vector<uint32_t>& samples = this->m_latencySamples;
+    std::sort(samples.begin(), samples.end());
+    const uint32_t p50 = samples[((samples.size() - 1) * 50) / 100];
+    const uint32_t p99 = samples[((samples.size() - 1) * 99) / 100];
+    this->m_log << "requests: " << samples.size()
+                << "  latency p50: " << p50 << " us"
+                << "  p99: " << p99 << " us"
+                << "  max: " << samples.back() << " us";
+    if (this->m_pResultCache != nullptr){
+        // cache counts are totals since start
+        this->m_log << "  cache hits: " << (this->m_pResultCache->getLookupCount(ResultCache::LOOKUP_HIT) +
+                                            this->m_pResultCache->getLookupCount(ResultCache::LOOKUP_PERSISTENT_HIT))
+                    << " (persistent " << this->m_pResultCache->getLookupCount(ResultCache::LOOKUP_PERSISTENT_HIT) << ")"
+                    << "  misses: " << this->m_pResultCache->getLookupCount(ResultCache::LOOKUP_MISS);
+    }
+    this->m_log << std::endl;
+    samples.clear();
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// rewrites the metrics file, if any, logging failures
+void VerificationDaemon::writeMetrics(){
+    if (this->m_metricsPath.empty() == false && Metrics::tryWritePrometheusFile(this->m_metricsPath) == false){
+        this->m_log << "Unable to write metrics file '" << this->m_metricsPath << "'." << std::endl;
+    }
+}
+
+//----------------------------------------------------------------------
+// PROTECTED
+// flushes the key index, if any, logging failures
+void VerificationDaemon::flushKeyIndex(){
+    if (this->m_pKeyIndex != nullptr && this->m_pKeyIndex->flush() == false){
+        this->m_log << "Unable to flush key index '" << this->m_pKeyIndex->getFilepath() << "'." << std::endl;
+    }
+}
+
+#else
+
+//----------------------------------------------------------------------
+// non-Linux platforms: daemon mode is not available
+
+VerificationDaemon::VerificationDaemon(const std::string& socketPath, std::ostream& log, const std::string& metricsPath,
+                                       KeyFingerprintIndex* pKeyIndex, ResultCache* pResultCache) : m_socketPath(socketPath),
+                                                                                                   m_listenFd(-1),
+                                                                                                   m_epollFd(-1),
+                                                                                                   m_log(log),
+                                                                                                   m_metricsPath(metricsPath),
+                                                                                                   m_pKeyIndex(pKeyIndex),
+                                                                                                   m_pResultCache(pResultCache),
+                                                                                                   m_totalRequests(0){
+    throw std::runtime_error("Daemon mode is only supported on Linux.");
+}
+
+VerificationDaemon::~VerificationDaemon(){
+
+}
+
+void VerificationDaemon::run(){
+
+}
+
+bool VerificationDaemon::serviceConnection(Connection& connection, const uint32_t events){
+    (void)connection;
+    (void)events;
+    return false;
+}
+
+void VerificationDaemon::reportLatency(){
+
+}
+
+void VerificationDaemon::writeMetrics(){
+
+}
+
+void VerificationDaemon::flushKeyIndex(){
+
+}
+
+#endif
+
+//----------------------------------------------------------------------
@@ -0,0 +1,145 @@
+//----------------------------------------------------------------------
+// VerificationDaemon - Long-running verification service listening on a
+//                      local Unix domain socket (Linux only).
+//
+// A single epoll event loop serves any number of concurrent client
+// connections.  Each connection carries a sequence of request frames;
+// every request receives exactly one response frame, in request order.
+// All integers are big endian.
+//
+// Request frame:
+//   u32 iobuf length | u32 wrappedkey length | iobuf bytes | wrappedkey bytes
+//
+// Response frame:
+//   u32 payload length | payload
+// Response payload:
+//   u8  outcome code (RETCODE_* - 0 verified, 10 bad request, 20 parse error, 30 verify error,
+//                     40 key already recorded in the key index)
+//   u16 key length in bits | u8 key encoding | u8 key type
+//   u16 exponent length | exponent bytes
+//   u16 modulus length  | modulus bytes
+//   u16 message length  | message text (no terminator)
+// Key fields are zero/empty when the key gen result could not be parsed.
+// A request whose lengths exceed MAX_FIELD_LENGTH is answered with outcome
+// 10 and the connection is closed.
+//
+// Each readiness event reads at most one maximum-size frame from a
+// connection, and a connection holding 1 MiB of unsent responses is not
+// read until the client collects them, so one busy client can neither
+// starve the others nor grow the daemon's buffers without bound.
+//
+// With a key index (see KeyFingerprintIndex.h) the key of every verified
+// request is looked up and, if new, recorded; the index is flushed with
+// every latency report.
+//
+// With a result cache (see ResultCache.h) a request whose iobuf and
+// wrappedkey bytes were seen within the cache's time to live is answered
+// with the stored response, skipping parsing and verification.  Responses
+// that recorded a new key in the key index are not cached, so a replayed
+// request is always checked against the index; nor are responses to
+// failures that may be transient (key index I/O errors).
+//----------------------------------------------------------------------
+
+#ifndef VerificationDaemonH_Included
+#define VerificationDaemonH_Included
+
+//----------------------------------------------------------------------
+
+class VerificationDaemon;
+
+//----------------------------------------------------------------------
+
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <stdexcept>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "CoolkeyRSAVerifier.h"
+#include "KeyFingerprintIndex.h"
+#include "ResultCache.h"
+
+//----------------------------------------------------------------------
+
+class VerificationDaemon{
+    public:
+        // largest accepted iobuf or wrappedkey field
+        //   (a key gen result holds two 16-bit length-prefixed fields)
+        const static uint32_t MAX_FIELD_LENGTH = 2 * (2 + 0xFFFF);
+
+        // seconds between latency reports written to the log stream (and metrics file rewrites)
+        const static int REPORT_INTERVAL_SECONDS = 60;
+
+        // one connected client (defined in the implementation)
+        class Connection;
+
+    private:
+        // prevent copying and assignment
+        VerificationDaemon(const VerificationDaemon& src);
+        VerificationDaemon operator=(const VerificationDaemon& rhs);
+
+    protected:
+        std::string m_socketPath;                // path of the listening socket
+        int m_listenFd;                          // listening socket              - created in constructor
+        int m_epollFd;                           // epoll instance                - created in constructor
+        std::ostream& m_log;                     // destination of status and latency reports
+        std::string m_metricsPath;               // Prometheus text file rewritten with every report (empty: none)
+        CoolkeyRSAVerifier m_verifier;           // reused for every request (the event loop is single threaded)
+        KeyFingerprintIndex* m_pKeyIndex;        // index of the keys seen (nullptr: none) - not owned
+        ResultCache* m_pResultCache;             // responses to earlier requests (nullptr: none) - not owned
+        std::vector<byte> m_payload;             // response being built, reused for every request
+
+        std::vector<uint32_t> m_latencySamples;  // request latencies (microseconds) since last report
+        uint64_t m_totalRequests;                // requests served since start
+
+        // reads from, processes and writes to a connection; returns false once it should be closed
+        bool serviceConnection(Connection& connection, const uint32_t events);
+
+        // writes the latency percentiles of the current samples to the log and clears them
+        void reportLatency();
+
+        // rewrites the metrics file, if any, logging failures
+        void writeMetrics();
+
+        // flushes the key index, if any, logging failures
+        void flushKeyIndex();
+
+    public:
+        // constructor creates the listening socket at socketPath
+        //   an existing socket file at socketPath is replaced
+        //   metricsPath names a Prometheus text file for the stage metrics (see Metrics.h), or is empty
+        //   pKeyIndex and pResultCache, if set, must outlive the daemon
+        //   throws std::runtime_error if the socket cannot be created (or on non-Linux platforms)
+        VerificationDaemon(const std::string& socketPath, std::ostream& log, const std::string& metricsPath = std::string(),
+                           KeyFingerprintIndex* pKeyIndex = nullptr, ResultCache* pResultCache = nullptr);
+
+        // destructor - closes the socket and removes the socket file
+        virtual ~VerificationDaemon();
+
+
+        // serves requests until requestStop() is called or SIGINT/SIGTERM is received
+        //   throws std::runtime_error on fatal event loop errors
+        void run();
+
+        // asks run() to return (async-signal-safe)
+        static void requestStop();
+
+
+        // parses and verifies one request with verifier, writing the response payload (without length prefix)
+        //   to payload, whose previous contents are replaced but whose capacity is reused
+        //   a verified key is looked up in (and, if new, recorded to) pKeyIndex, if set
+        //   *pCacheable, if given, is cleared when the response reports a failure that may be transient or
+        //   recorded a new key in pKeyIndex (a repeated request must then find the key)
+        //   never throws except for std::bad_alloc
+        static void processRequest(CoolkeyRSAVerifier& verifier,
+                                   const byte* pIobuf, const size_t iobufLength,
+                                   const byte* pWrappedKey, const size_t wrappedKeyLength,
+                                   std::vector<byte>& payload, KeyFingerprintIndex* pKeyIndex = nullptr, bool* pCacheable = nullptr);
+};
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,172 @@
+//----------------------------------------------------------------------
+// See VerificationWorkerPool.h
+//----------------------------------------------------------------------
+
+#include "VerificationWorkerPool.h"
+
+//----------------------------------------------------------------------
+
+#include "OpenSSLThreading.h"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>      // unique_ptr
+#include <exception>   // exception_ptr
+
+//----------------------------------------------------------------------
+
+namespace{
+    // one worker's shard of item indices: [front, back) packed into a single word
+    //   so that the owner (taking from the front) and thieves (taking from the back)
+    //   can both update it with a single compare-and-swap
+    class Shard{
+        public:
+            std::atomic<uint64_t> m_range;
+            char m_padding[64 - sizeof(std::atomic<uint64_t>)];  // keep shards on separate cache lines
+
+            static uint64_t pack(const uint64_t front, const uint64_t back){ return (front << 32) | back; }
+            static uint64_t front(const uint64_t range){ return range >> 32; }
+            static uint64_t back(const uint64_t range){ return range & 0xFFFFFFFFu; }
+    };
+
+    // takes one item from the front of the shard; returns false if the shard is empty
+    bool takeFront(Shard& shard, size_t& itemIndex){
+        uint64_t range = shard.m_range.load();
+        while (Shard::front(range) < Shard::back(range)){
+            if (shard.m_range.compare_exchange_weak(range, Shard::pack(Shard::front(range) + 1, Shard::back(range))) == true){
+                itemIndex = static_cast<size_t>(Shard::front(range));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // steals the back half of the fullest shard into the (empty) shard of the thief
+    //   returns false once every shard is empty
+    bool stealHalf(Shard* shards, const size_t shardCount, const size_t thiefIndex){
+        for (;;){
+            // find the shard with the most remaining items
+            size_t victimIndex = shardCount;
+            uint64_t victimRemaining = 0;
+            for (size_t i = 0; i < shardCount; ++i){
+                const uint64_t range = shards[i].m_range.load();
+                const uint64_t remaining = Shard::back(range) - Shard::front(range);
+                if (Shard::front(range) < Shard::back(range) && remaining > victimRemaining){
+                    victimIndex = i;
+                    victimRemaining = remaining;
+                }
+            }
+            if (victimIndex == shardCount){
+                return false;
+            }
+
+            // try to move the back half of the victim's range to the thief
+            uint64_t range = shards[victimIndex].m_range.load();
+            const uint64_t front = Shard::front(range);
+            const uint64_t back = Shard::back(range);
+            if (front >= back){
+                continue;
+            }
+            const uint64_t newBack = back - ((back - front + 1) / 2);
+            if (shards[victimIndex].m_range.compare_exchange_strong(range, Shard::pack(front, newBack)) == true){
+                // an empty shard is never modified by other threads, so a plain store is enough
+                shards[thiefIndex].m_range.store(Shard::pack(newBack, back));
+                return true;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// constructor
+//   threadCount of 0 selects getDefaultThreadCount()
+VerificationWorkerPool::VerificationWorkerPool(const size_t threadCount) : m_threadCount(threadCount){
+    if (this->m_threadCount == 0){
+        this->m_threadCount = getDefaultThreadCount();
+    }
+    OpenSSLThreading::initialize();
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// destructor - nothing to do at present
+VerificationWorkerPool::~VerificationWorkerPool(){
+
+}
+
+//----------------------------------------------------------------------
+// PUBLIC STATIC
+// returns the number of hardware threads (at least 1)
+size_t VerificationWorkerPool::getDefaultThreadCount(){
+    const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    return (hardwareThreads == 0) ? 1 : hardwareThreads;
+}
+
+//----------------------------------------------------------------------
+// PUBLIC
+// calls work for every item index in [0, itemCount) and blocks until all items are done
+void VerificationWorkerPool::run(const size_t itemCount, const WorkFunction& work) const {
+    if (static_cast<uint64_t>(itemCount) > 0xFFFFFFFFu){
+        throw std::runtime_error("Too many items for worker pool run.");
+    }
+    if (itemCount == 0){
+        return;
+    }
+
+    // never start more threads than there are items
+    const size_t workerCount = (this->m_threadCount < itemCount) ? this->m_threadCount : itemCount;
+
+    // split items into one contiguous shard per worker
+    std::unique_ptr<Shard[]> shards(new Shard[workerCount]);
+    for (size_t i = 0; i < workerCount; ++i){
+        const uint64_t front = (static_cast<uint64_t>(itemCount) * i) / workerCount;
+        const uint64_t back = (static_cast<uint64_t>(itemCount) * (i + 1)) / workerCount;
+        shards[i].m_range.store(Shard::pack(front, back));
+    }
+
+    // first exception thrown by any work item
+    std::mutex exceptionMutex;
+    std::exception_ptr firstException;
+
+    // worker thread body
+    Shard* const pShards = shards.get();
+    auto workerBody = [&work, pShards, workerCount, &exceptionMutex, &firstException](const size_t workerIndex){
+        size_t itemIndex;
+        for (;;){
+            while (takeFront(pShards[workerIndex], itemIndex) == true){
+                try{
+                    work(itemIndex, workerIndex);
+                }catch (...){
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    if (!firstException){
+                        firstException = std::current_exception();
+                    }
+                }
+            }
+            if (stealHalf(pShards, workerCount, workerIndex) == false){
+                break;
+            }
+        }
+        OpenSSLThreading::cleanupThread();
+    };
+
+    // the calling thread acts as worker 0
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (size_t i = 1; i < workerCount; ++i){
+        threads.push_back(std::thread(workerBody, i));
+    }
+    workerBody(0);
+    for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); it++){
+        it->join();
+    }
+
+    if (firstException){
+        std::rethrow_exception(firstException);
+    }
+}
+
+//----------------------------------------------------------------------
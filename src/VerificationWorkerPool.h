@@ -0,0 +1,68 @@
+//----------------------------------------------------------------------
+// VerificationWorkerPool - Spreads independent units of work (parsing
+//                          and verifying key gen results) across a
+//                          configurable number of threads.
+//
+// Each run divides the items into one contiguous shard per worker.
+// A worker takes items from the front of its own shard; once its shard
+// is empty it steals the back half of the largest remaining shard, so
+// one slow or malformed item never holds back the rest of its shard.
+//----------------------------------------------------------------------
+
+#ifndef VerificationWorkerPoolH_Included
+#define VerificationWorkerPoolH_Included
+
+//----------------------------------------------------------------------
+
+class VerificationWorkerPool;
+
+//----------------------------------------------------------------------
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+
+//----------------------------------------------------------------------
+
+class VerificationWorkerPool{
+    public:
+        // unit of work: called once for every item index in [0, itemCount)
+        //   workerIndex is in [0, getThreadCount()) and identifies the calling thread,
+        //   so callers can keep per-thread state (e.g. OpenSSL contexts) in an array
+        typedef std::function<void(size_t itemIndex, size_t workerIndex)> WorkFunction;
+
+    private:
+        // prevent copying and assignment
+        VerificationWorkerPool(const VerificationWorkerPool& src);
+        VerificationWorkerPool operator=(const VerificationWorkerPool& rhs);
+
+    protected:
+        size_t m_threadCount;                  // number of worker threads used per run
+
+    public:
+        // constructor
+        //   threadCount of 0 selects getDefaultThreadCount()
+        explicit VerificationWorkerPool(const size_t threadCount = 0);
+
+        // destructor
+        virtual ~VerificationWorkerPool();
+
+
+        // getter for number of worker threads
+        size_t getThreadCount() const { return this->m_threadCount; }
+
+        // returns the number of hardware threads (at least 1)
+        static size_t getDefaultThreadCount();
+
+
+        // calls work for every item index in [0, itemCount) and blocks until all items are done
+        //   items are processed in no particular order - callers store results by item index
+        //   if work throws, the remaining items are still processed and the first exception is rethrown
+        //   item counts are limited to 2^32 - 1
+        void run(const size_t itemCount, const WorkFunction& work) const;
+};
+
+//----------------------------------------------------------------------
+
+#endif
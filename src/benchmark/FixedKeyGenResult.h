@@ -0,0 +1,151 @@
+//----------------------------------------------------------------------
+// FixedKeyGenResult - Coolkey RSA key generation result of one key size,
+//                     copied into fixed-capacity storage.
+//
+// The record holds the parsed part of the key gen result (blob length,
+// key blob, proof length, proof) in a std::array sized for KEY_BITS,
+// plus the offsets and lengths of its fields.  It owns no pointers and
+// no heap memory: it is trivially copyable, records of one size can be
+// kept in contiguous arrays, and parsing one allocates nothing.  Results
+// that do not fit (other key sizes, long exponents) stay with
+// CoolkeyRSAKeyGenResultView; see KeyGenResultDispatcher.
+//
+// Used by the records benchmark only, as the contiguous-array baseline
+// for the in-place views; it is not part of the library.
+//----------------------------------------------------------------------
+
+#ifndef FixedKeyGenResultH_Included
+#define FixedKeyGenResultH_Included
+
+//----------------------------------------------------------------------
+
+template<size_t KEY_BITS> class FixedKeyGenResult;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <type_traits>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "../CoolkeyRSAKeyGenResultView.h"
+#include "../CoolkeyStatus.h"
+
+//----------------------------------------------------------------------
+
+template<size_t KEY_BITS>
+class FixedKeyGenResult{
+    public:
+        // capacity of each field in bytes
+        const static size_t MODULUS_CAPACITY = KEY_BITS / 8;
+        const static size_t EXPONENT_CAPACITY = 8;
+        const static size_t PROOF_CAPACITY = KEY_BITS / 8;
+
+        // key blob: encoding, key type, key length, modulus length, modulus, exponent length, exponent
+        const static size_t BLOB_HEADER_LENGTH = 1 + 1 + 2 + 2;
+        const static size_t BLOB_CAPACITY = BLOB_HEADER_LENGTH + MODULUS_CAPACITY + 2 + EXPONENT_CAPACITY;
+
+        // key gen result: blob length, key blob, proof length, proof
+        const static size_t CAPACITY = 2 + BLOB_CAPACITY + 2 + PROOF_CAPACITY;
+
+    protected:
+        std::array<byte, CAPACITY> m_data;    // parsed part of the key gen result          - set by assign()
+        uint16_t m_size;                      // byte length of m_data in use                - set by assign()
+        uint16_t m_blobSize;                  // byte length of key blob (at offset 2)       - set by assign()
+        uint16_t m_modulusLength;             // byte length of modulus field                - set by assign()
+        uint16_t m_exponentLength;            // byte length of exponent field               - set by assign()
+        uint16_t m_proofSize;                 // byte length of proof (at the end of m_data) - set by assign()
+
+        // offsets of the fields within m_data
+        size_t getBlobOffset() const { return 2; }
+        size_t getModulusOffset() const { return 2 + BLOB_HEADER_LENGTH; }
+        size_t getExponentOffset() const { return this->getModulusOffset() + this->m_modulusLength + 2; }
+        size_t getProofOffset() const { return 2 + this->m_blobSize + 2; }
+
+    public:
+        // constructor - creates an empty record; call tryParse() or assign() to fill it in
+        FixedKeyGenResult() : m_size(0), m_blobSize(0), m_modulusLength(0), m_exponentLength(0), m_proofSize(0){
+
+        }
+
+        // returns true if a parsed key gen result is of this key size and fits this record
+        //   the key length header must be KEY_BITS and each field within its capacity
+        static bool fits(const CoolkeyRSAKeyGenResultView& view){
+            const CoolkeyRSAKeyBlobView& blob = view.getBlob();
+            return blob.getKeyLengthBits() == KEY_BITS &&
+                   blob.getModulusLength() <= MODULUS_CAPACITY &&
+                   blob.getExponentLength() <= EXPONENT_CAPACITY &&
+                   view.getProofSize() <= PROOF_CAPACITY;
+        }
+
+        // copies a parsed key gen result for which fits() is true; allocates nothing
+        //   trailing data that the view was parsed with (extraDataOkay) is not copied
+        void assign(const CoolkeyRSAKeyGenResultView& view){
+            const CoolkeyRSAKeyBlobView& blob = view.getBlob();
+            this->m_blobSize = static_cast<uint16_t>(blob.getBlobSize());
+            this->m_modulusLength = static_cast<uint16_t>(blob.getModulusLength());
+            this->m_exponentLength = static_cast<uint16_t>(blob.getExponentLength());
+            this->m_proofSize = static_cast<uint16_t>(view.getProofSize());
+            this->m_size = static_cast<uint16_t>(2 + this->m_blobSize + 2 + this->m_proofSize);
+
+            byte* pData = this->m_data.data();
+            pData[0] = static_cast<byte>(this->m_blobSize >> 8);
+            pData[1] = static_cast<byte>(this->m_blobSize);
+            std::memcpy(pData + 2, blob.getBlobData(), this->m_blobSize);
+            pData[2 + this->m_blobSize] = static_cast<byte>(this->m_proofSize >> 8);
+            pData[2 + this->m_blobSize + 1] = static_cast<byte>(this->m_proofSize);
+            std::memcpy(pData + this->getProofOffset(), view.getProofData(), this->m_proofSize);
+        }
+
+        // parses the key gen result at pData and copies it into this record; allocates nothing
+        //   returns the parse status of CoolkeyRSAKeyGenResultView::tryParse(); a well-formed result
+        //   that does not fit this record (see fits()) leaves it unchanged and sets fitted to false
+        CoolkeyStatus tryParse(const byte* pData, const size_t size, bool& fitted, const bool extraDataOkay = false){
+            CoolkeyRSAKeyGenResultView view;
+            const CoolkeyStatus status = view.tryParse(pData, size, extraDataOkay);
+            fitted = (status.isOk() == true && fits(view) == true);
+            if (fitted == true){
+                this->assign(view);
+            }
+            return status;
+        }
+
+        // returns a view of this record (parsed in place; the record must outlive it)
+        CoolkeyRSAKeyGenResultView getView() const {
+            CoolkeyRSAKeyGenResultView view;
+            view.tryParse(this->m_data.data(), this->m_size);
+            return view;
+        }
+
+
+        // getters for the stored key gen result
+        size_t getSize() const { return this->m_size; }
+        const byte* getData() const { return this->m_data.data(); }
+
+        // getters for raw blob data
+        size_t getBlobSize() const { return this->m_blobSize; }
+        const byte* getBlobData() const { return this->m_data.data() + this->getBlobOffset(); }
+
+        // getters for key blob fields
+        size_t getKeyLengthBits() const { return KEY_BITS; }
+        const byte* getModulusData() const { return this->m_data.data() + this->getModulusOffset(); }
+        size_t getModulusLength() const { return this->m_modulusLength; }
+        const byte* getExponentData() const { return this->m_data.data() + this->getExponentOffset(); }
+        size_t getExponentLength() const { return this->m_exponentLength; }
+
+        // getters for raw proof data
+        size_t getProofSize() const { return this->m_proofSize; }
+        const byte* getProofData() const { return this->m_data.data() + this->getProofOffset(); }
+};
+
+#if !defined(__GNUC__) || defined(__clang__) || (__GNUC__ >= 5)
+static_assert(std::is_trivially_copyable<FixedKeyGenResult<2048> >::value, "fixed key gen results must be trivially copyable");
+#endif
+
+//----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,87 @@
+//----------------------------------------------------------------------
+// KeyGenResultDispatcher - Parses Coolkey RSA key generation results
+//                          into the FixedKeyGenResult specialization
+//                          selected by their key length header.
+//
+// 1024 and 2048 bit keys (nearly every card) are copied into
+// FixedKeyGenResult<1024> or FixedKeyGenResult<2048>; any other key
+// size, or a field too long for its fixed capacity, is handed on as the
+// in-place CoolkeyRSAKeyGenResultView (the generic path).  Nothing is
+// allocated either way.
+//----------------------------------------------------------------------
+
+#ifndef KeyGenResultDispatcherH_Included
+#define KeyGenResultDispatcherH_Included
+
+//----------------------------------------------------------------------
+
+class KeyGenResultDispatcher;
+
+//----------------------------------------------------------------------
+
+#include <cstddef>
+
+typedef unsigned char byte;
+typedef unsigned char BYTE;
+
+#include "../CoolkeyRSAKeyGenResultView.h"
+#include "../CoolkeyStatus.h"
+#include "FixedKeyGenResult.h"
+
+//----------------------------------------------------------------------
+
+class KeyGenResultDispatcher{
+    public:
+        // parses the key gen result at pData and passes it to visitor as
+        //   const FixedKeyGenResult<1024>&, const FixedKeyGenResult<2048>&, or (generic path)
+        //   const CoolkeyRSAKeyGenResultView& borrowing pData
+        //   the record passed is a temporary: visitor copies it if it is to be kept
+        //   returns the parse status; visitor is not called if parsing fails
+        template<typename Visitor>
+        static CoolkeyStatus tryParse(const byte* pData, const size_t size, Visitor& visitor, const bool extraDataOkay = false){
+            CoolkeyRSAKeyGenResultView view;
+            const CoolkeyStatus status = view.tryParse(pData, size, extraDataOkay);
+            if (status.isOk() == false){
+                return status;
+            }
+
+            switch (view.getBlob().getKeyLengthBits()){
+                case 1024:
+                    if (FixedKeyGenResult<1024>::fits(view) == true){
+                        dispatchFixed<1024>(view, visitor);
+                        return status;
+                    }
+                    break;
+                case 2048:
+                    if (FixedKeyGenResult<2048>::fits(view) == true){
+                        dispatchFixed<2048>(view, visitor);
+                        return status;
+                    }
+                    break;
+                default:
+                    break;
+            }
+            visitor(static_cast<const CoolkeyRSAKeyGenResultView&>(view));
+            return status;
+        }
+
+    private:
+        // prevent copying and assignment
+        KeyGenResultDispatcher(const KeyGenResultDispatcher& src);
+        KeyGenResultDispatcher operator=(const KeyGenResultDispatcher& rhs);
+
+        // prevent construction
+        KeyGenResultDispatcher();
+
+        // copies view into a FixedKeyGenResult<KEY_BITS> and passes that to visitor
+        template<size_t KEY_BITS, typename Visitor>
+        static void dispatchFixed(const CoolkeyRSAKeyGenResultView& view, Visitor& visitor){
+            FixedKeyGenResult<KEY_BITS> record;
+            record.assign(view);
+            visitor(static_cast<const FixedKeyGenResult<KEY_BITS>&>(record));
+        }
+};
+
+//----------------------------------------------------------------------
+
+#endif